@@ -0,0 +1,134 @@
+#pragma once
+
+#include "FrameGraph.h"
+#include "JitterSequence.h"
+#include "QualityPreset.h"
+#include "SceneGeometry.h"
+
+#include <memory>
+#include <vector>
+
+namespace scaling
+{
+	enum class ImageFormat
+	{
+		Bgra8,			// Color. DXGI_FORMAT_B8G8R8A8_UNORM
+		Depth32,		// DXGI_FORMAT_D32_FLOAT
+		Luma,			// Input to motion estimation. NV12 on the GPU, where the video hardware wants it; the CPU only keeps the luma plane.
+		MotionVectors	// Per-pixel motion in quarter pixels, pointing from the current frame to the previous one. DXGI_FORMAT_R16G16_SINT
+	};
+
+	// How a pass uses an image, for working out the barriers between passes. Each device has a state for each.
+	enum class ImageAccess
+	{
+		RenderTarget,
+		DepthWrite,
+		PixelShaderRead,
+		NonPixelShaderRead,	// By compute shaders, and by upscalers that take their inputs as textures
+		UnorderedAccess,
+		VideoEncodeRead,
+		VideoEncodeWrite
+	};
+
+	// A 2D image owned by a device. Only meaningful to the device that created it.
+	class IImage
+	{
+	public:
+		virtual ~IImage() {}
+
+		virtual ImageFormat GetFormat() const = 0;
+		virtual int GetWidth() const = 0;
+		virtual int GetHeight() const = 0;
+	};
+
+	// Runs the passes that come before upscaling. Passes operate on a renderSize sub-rect at the top left of
+	// their images, so that the render size can change without reallocating anything.
+	//
+	// Passes are recorded between BeginFrame and EndFrame. A device may run them as they're recorded, or
+	// queue them and run them at EndFrame, so images should only be read back after EndFrame.
+	class IDevice
+	{
+	public:
+		virtual ~IDevice() {}
+
+		virtual std::unique_ptr<IImage> CreateImage(ImageFormat format, int width, int height) = 0;
+
+		// What CreateImage would allocate for the image.
+		virtual ResourceFootprint GetImageFootprint(ImageFormat format, int width, int height) const = 0;
+
+		// The device's resource states, as bit masks like D3D12_RESOURCE_STATES: the one CreateImage leaves
+		// images of the format in, the one for each way a pass uses an image, and the read states, which an
+		// image can be in several of at once. For ResourceStateTracker and FrameGraph.
+		virtual uint32_t GetRestingState(ImageFormat format) const = 0;
+		virtual uint32_t GetImageState(ImageAccess access) const = 0;
+		virtual uint32_t GetReadStates() const = 0;
+
+		// What pass 1 draws: the scene's mesh once for every instance. The cube, and a single instance of it at
+		// the origin, unless these are called. Not between BeginFrame and EndFrame.
+		virtual void SetSceneMesh(SceneMeshView const& mesh) = 0;
+		virtual void SetSceneInstances(std::vector<SceneInstance> const& instances) = 0;
+
+		virtual void BeginFrame() = 0;
+		virtual void EndFrame() = 0;
+
+		// How many frames the device can have recorded that haven't finished running, and which of them the
+		// current one is, from 0 to GetFrameCount() - 1. What a frame writes for later passes to read is kept
+		// at least once per frame in flight, so that a frame never overwrites what an earlier one may still be
+		// reading.
+		virtual int GetFrameCount() const = 0;
+		virtual int GetFrameIndex() const = 0;
+
+		// Pass 1: clears color and depth, and draws the scene. When motionVectors is given, also writes the
+		// exact motion of every pixel since the frame drawn with previousConstants; pixels with nothing drawn
+		// get no motion.
+		virtual void RenderScene(
+			SceneConstants const& constants,
+			SceneConstants const& previousConstants,
+			RenderSize renderSize,
+			IImage& color,
+			IImage& depth,
+			IImage* motionVectors) = 0;
+
+		// Prepares a color image for motion estimation.
+		virtual void ConvertToLuma(IImage& color, RenderSize renderSize, IImage& luma) = 0;
+
+		// Estimates how the content of previous moved to get to current.
+		virtual void EstimateMotion(IImage& current, IImage& previous, RenderSize renderSize, IImage& motionVectors) = 0;
+
+		// Whether motion estimation runs on a queue of its own, alongside the other passes. If so, the passes
+		// that read its motion vectors call WaitForMotionEstimation first, in a later frame, so that the
+		// passes in between can run alongside it.
+		virtual bool HasVideoQueue() const = 0;
+
+		// The passes recorded after this wait for the last frame's motion estimation. Only with a video queue.
+		virtual void WaitForMotionEstimation() = 0;
+	};
+
+	struct UpscaleInputs
+	{
+		IImage* color;
+		IImage* depth;
+		IImage* motionVectors;
+		RenderSize renderSize;
+		JitterOffset jitter;
+		bool reset; // Discards history, for instance after a camera cut.
+	};
+
+	// Scales the output of pass 1 up to the output size. Recorded between the device's BeginFrame and EndFrame.
+	class IUpscaler
+	{
+	public:
+		virtual ~IUpscaler() {}
+
+		// Whether the upscaler accumulates jittered frames, and so wants motion vectors and jitter.
+		virtual bool IsTemporal() const = 0;
+
+		// May recreate internal state. Nothing the upscaler has recorded may still be running.
+		virtual void SetQualityPreset(QualityPreset preset) = 0;
+
+		// What the upscaler would like to render at for the current preset.
+		virtual RenderSize GetOptimalInputSize(int outputWidth, int outputHeight) = 0;
+
+		virtual void Upscale(UpscaleInputs const& inputs, IImage& output) = 0;
+	};
+}
@@ -1,16 +1,29 @@
 #pragma once
 
-// A constant buffer that stores the three basic column-major matrices for composing geometry.
+// A constant buffer that stores the column-major matrices for composing geometry.
 cbuffer ModelViewProjectionConstantBuffer : register(b0)
 {
-	matrix model;
-	matrix view;
-	matrix projection;
+	// Model, view and projection, multiplied together once per frame rather than once per vertex.
+	matrix modelViewProjection;
+
+	// Model, view and the projection without jitter, multiplied together, for this frame and the last one.
+	// Pass 1 measures motion vectors with them.
+	matrix currentMotion;
+	matrix previousMotion;
+	float2 motionVectorScale; // From a difference in normalized device coordinates to quarter pixels
+
+	// How far the scene has turned, this frame and the last one, which is what instances spin by.
+	float sceneAngle;
+	float previousSceneAngle;
 };
 
 struct DrawConstantsType
 {
 	int samplerIndex;
+	float sharpness; // 0 turns sharpening off
+	float2 outputTexelSize;
+	float2 inputUvScale; // Maps the quad's uv onto the part of the input that was rendered to
+	float2 inputUvMax; // Keeps linear filtering from reaching past that part
 };
 ConstantBuffer<DrawConstantsType> drawConstants : register(b3);
 
@@ -0,0 +1,193 @@
+#include "CpuBackend.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstddef>
+
+using namespace scaling;
+
+namespace
+{
+	// Same as the clear color of pass 1.
+	const uint32_t c_clearColor = PackBgra8(0.3f, 0.58f, 0.93f, 1.0f);
+}
+
+CpuDevice::CpuDevice(JobSystem* jobs, int frameCount)
+	: m_cubeMesh(CreateCubeMesh())
+	, m_sceneMesh(GetMeshView(m_cubeMesh))
+	, m_sceneInstances(CreateInstancedScene(1))
+	, m_jobs(jobs)
+	, m_rasterizer(jobs)
+	, m_frameCount(frameCount)
+	, m_frameIndex(0)
+{
+	assert(frameCount > 0);
+}
+
+std::unique_ptr<IImage> CpuDevice::CreateImage(ImageFormat format, int width, int height)
+{
+	switch (format)
+	{
+	case ImageFormat::Bgra8: return std::unique_ptr<IImage>(new CpuBgra8Image(format, width, height));
+	case ImageFormat::Depth32: return std::unique_ptr<IImage>(new CpuDepth32Image(format, width, height));
+	case ImageFormat::Luma: return std::unique_ptr<IImage>(new CpuLumaImage(format, width, height));
+	case ImageFormat::MotionVectors: return std::unique_ptr<IImage>(new CpuMotionVectorImage(format, width, height));
+	default:
+		assert(false);
+		return nullptr;
+	}
+}
+
+// Each image is one array of pixels, aligned like any other allocation.
+ResourceFootprint CpuDevice::GetImageFootprint(ImageFormat format, int width, int height) const
+{
+	uint64_t pixelSize = 0;
+	switch (format)
+	{
+	case ImageFormat::Bgra8: pixelSize = sizeof(uint32_t); break;
+	case ImageFormat::Depth32: pixelSize = sizeof(float); break;
+	case ImageFormat::Luma: pixelSize = sizeof(uint8_t); break;
+	case ImageFormat::MotionVectors: pixelSize = sizeof(MotionVector); break;
+	default: assert(false);
+	}
+	return ResourceFootprint{ pixelSize * static_cast<uint64_t>(width) * static_cast<uint64_t>(height), alignof(std::max_align_t) };
+}
+
+uint32_t CpuDevice::GetRestingState(ImageFormat format) const
+{
+	switch (format)
+	{
+	case ImageFormat::Bgra8: return GetImageState(ImageAccess::PixelShaderRead) | GetImageState(ImageAccess::NonPixelShaderRead);
+	case ImageFormat::Depth32: return GetImageState(ImageAccess::DepthWrite);
+	default: return 0;
+	}
+}
+
+// Like the GPU's, the shader reads.
+uint32_t CpuDevice::GetReadStates() const
+{
+	return GetImageState(ImageAccess::PixelShaderRead) | GetImageState(ImageAccess::NonPixelShaderRead);
+}
+
+void CpuDevice::RenderScene(
+	SceneConstants const& constants,
+	SceneConstants const& previousConstants,
+	RenderSize renderSize,
+	IImage& color,
+	IImage& depth,
+	IImage* motionVectors)
+{
+	assert(color.GetFormat() == ImageFormat::Bgra8 && depth.GetFormat() == ImageFormat::Depth32);
+	assert(!motionVectors || motionVectors->GetFormat() == ImageFormat::MotionVectors);
+
+	ImageBgra8& colorPixels = GetCpuImage<uint32_t>(color);
+	ImageD32& depthPixels = GetCpuImage<float>(depth);
+
+	ImageMotionVectors* motionPixels = motionVectors ? &GetCpuImage<MotionVector>(*motionVectors) : nullptr;
+
+	Float4x4 modelViewProjection = GetModelViewProjection(constants);
+	Float4x4 currentMotion = GetUnjitteredModelViewProjection(constants);
+	Float4x4 previousMotion = GetUnjitteredModelViewProjection(previousConstants);
+
+	size_t instanceCount = m_sceneInstances.size();
+	m_instanceTransforms.resize(instanceCount);
+	m_instanceMotion.resize(motionPixels ? instanceCount : 0);
+	for (size_t i = 0; i < instanceCount; ++i)
+	{
+		SceneInstance const& instance = m_sceneInstances[i];
+		Float4x4 instanceModel = GetInstanceModel(instance, constants.sceneAngle);
+		m_instanceTransforms[i] = MatrixMultiply(instanceModel, modelViewProjection);
+		if (motionPixels)
+		{
+			m_instanceMotion[i].current = MatrixMultiply(instanceModel, currentMotion);
+			m_instanceMotion[i].previous = MatrixMultiply(GetInstanceModel(instance, previousConstants.sceneAngle), previousMotion);
+			m_instanceMotion[i].motionVectors = motionPixels;
+		}
+	}
+
+	m_rasterizer.Clear(colorPixels, depthPixels, renderSize, c_clearColor, 1.0f, motionPixels);
+	for (size_t i = 0; i < m_sceneMesh.chunkCount; ++i)
+	{
+		MeshChunk const& chunk = m_sceneMesh.chunks[i];
+		m_rasterizer.DrawIndexedInstanced(
+			m_sceneMesh.vertices + chunk.firstVertex,
+			static_cast<int>(chunk.vertexCount),
+			m_sceneMesh.indices + chunk.firstIndex,
+			static_cast<int>(chunk.indexCount),
+			m_instanceTransforms.data(),
+			static_cast<int>(instanceCount),
+			renderSize,
+			colorPixels,
+			depthPixels,
+			motionPixels ? m_instanceMotion.data() : nullptr);
+	}
+}
+
+void CpuDevice::ConvertToLuma(IImage& color, RenderSize renderSize, IImage& luma)
+{
+	assert(color.GetFormat() == ImageFormat::Bgra8 && luma.GetFormat() == ImageFormat::Luma);
+	CpuConvertToLuma(GetCpuImage<uint32_t>(color), renderSize, GetCpuImage<uint8_t>(luma), m_jobs);
+}
+
+void CpuDevice::EstimateMotion(IImage& current, IImage& previous, RenderSize renderSize, IImage& motionVectors)
+{
+	assert(current.GetFormat() == ImageFormat::Luma && previous.GetFormat() == ImageFormat::Luma);
+	assert(motionVectors.GetFormat() == ImageFormat::MotionVectors);
+	m_motionEstimator.Estimate(GetCpuImage<uint8_t>(current), GetCpuImage<uint8_t>(previous), renderSize, GetCpuImage<MotionVector>(motionVectors), m_jobs);
+}
+
+CpuUpscaler::CpuUpscaler(CpuFilter filter, float sharpness, JobSystem* jobs)
+	: m_filter(filter)
+	, m_sharpness(sharpness)
+	, m_jobs(jobs)
+	, m_qualityPreset(QualityPreset::UltraQuality)
+{
+}
+
+RenderSize CpuUpscaler::GetOptimalInputSize(int outputWidth, int outputHeight)
+{
+	return CpuGetOptimalInputSize(m_qualityPreset, outputWidth, outputHeight);
+}
+
+void CpuUpscaler::Upscale(UpscaleInputs const& inputs, IImage& output)
+{
+	ImageBgra8 const& color = GetCpuImage<uint32_t>(*inputs.color);
+	ImageBgra8& destination = GetCpuImage<uint32_t>(output);
+	RenderSize renderSize = inputs.renderSize;
+
+	if (renderSize.width == color.GetWidth() && renderSize.height == color.GetHeight())
+	{
+		CpuUpscale(color, destination, m_filter, m_sharpness, m_jobs, &m_state);
+		return;
+	}
+
+	// CpuUpscale scales whole images, so the rendered part is copied out first.
+	m_renderedInput.Resize(renderSize.width, renderSize.height);
+	for (int y = 0; y < renderSize.height; ++y)
+	{
+		std::copy(color.GetRow(y), color.GetRow(y) + renderSize.width, m_renderedInput.GetRow(y));
+	}
+	CpuUpscale(m_renderedInput, destination, m_filter, m_sharpness, m_jobs, &m_state);
+}
+
+CpuTemporalUpscaler::CpuTemporalUpscaler(JobSystem* jobs)
+	: m_jobs(jobs)
+	, m_qualityPreset(QualityPreset::UltraQuality)
+	, m_seconds(0.0)
+{
+}
+
+RenderSize CpuTemporalUpscaler::GetOptimalInputSize(int outputWidth, int outputHeight)
+{
+	return GetPresetRenderSize(m_qualityPreset, outputWidth, outputHeight);
+}
+
+void CpuTemporalUpscaler::Upscale(UpscaleInputs const& inputs, IImage& output)
+{
+	assert(inputs.motionVectors && inputs.motionVectors->GetFormat() == ImageFormat::MotionVectors);
+	auto start = std::chrono::steady_clock::now();
+	m_scaler.Upscale(GetCpuImage<uint32_t>(*inputs.color), GetCpuImage<float>(*inputs.depth), GetCpuImage<MotionVector>(*inputs.motionVectors), inputs.renderSize,
+		inputs.jitter, inputs.reset, GetCpuImage<uint32_t>(output), m_jobs);
+	m_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
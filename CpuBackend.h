@@ -0,0 +1,160 @@
+#pragma once
+
+#include "Backend.h"
+#include "CpuColorConversion.h"
+#include "CpuMotionEstimator.h"
+#include "CpuScaler.h"
+#include "CpuTemporalScaler.h"
+#include "SoftwareRasterizer.h"
+
+#include <cassert>
+
+namespace scaling
+{
+	// An image in system memory.
+	template<typename TPixel>
+	class CpuTypedImage : public IImage
+	{
+	public:
+		CpuTypedImage(ImageFormat format, int width, int height) : m_format(format), m_image(width, height) {}
+
+		ImageFormat GetFormat() const override	{ return m_format; }
+		int GetWidth() const override			{ return m_image.GetWidth(); }
+		int GetHeight() const override			{ return m_image.GetHeight(); }
+
+		CpuImage<TPixel>&		GetImage()			{ return m_image; }
+		CpuImage<TPixel> const& GetImage() const	{ return m_image; }
+
+	private:
+		ImageFormat m_format;
+		CpuImage<TPixel> m_image;
+	};
+
+	typedef CpuTypedImage<uint32_t> CpuBgra8Image;
+	typedef CpuTypedImage<float> CpuDepth32Image;
+	typedef CpuTypedImage<uint8_t> CpuLumaImage;
+	typedef CpuTypedImage<MotionVector> CpuMotionVectorImage;
+
+	// Gets the pixels of an image created by CpuDevice.
+	template<typename TPixel>
+	CpuImage<TPixel>& GetCpuImage(IImage& image)
+	{
+		return static_cast<CpuTypedImage<TPixel>&>(image).GetImage();
+	}
+
+	// Runs every pass as it's recorded, spreading each one over the job system when it's given one. Pass 1,
+	// luma conversion and motion estimation share no state, so each can run on a thread of its own at the
+	// same time as the others, as CpuStagedPipeline does; they still share the one job system.
+	class CpuDevice : public IDevice
+	{
+	public:
+		// Everything runs as it's recorded, so nothing is ever in flight. The frame count only sets how many
+		// copies of their per-frame images users keep, so that the same rings as on the GPU can be exercised.
+		explicit CpuDevice(JobSystem* jobs = nullptr, int frameCount = 1);
+
+		// On unless this is called.
+		void SetHierarchicalDepthEnabled(bool isEnabled) { m_rasterizer.SetHierarchicalDepthEnabled(isEnabled); }
+
+		// For the last RenderScene.
+		RasterizerStats const& GetRasterizerStats() const { return m_rasterizer.GetStats(); }
+
+		std::unique_ptr<IImage> CreateImage(ImageFormat format, int width, int height) override;
+		ResourceFootprint GetImageFootprint(ImageFormat format, int width, int height) const override;
+
+		// Every pass has finished by the time the next is recorded, so nothing needs barriers. Each access
+		// still has a state of its own, so that frames planned for the CPU have the same barriers as the GPU's.
+		uint32_t GetRestingState(ImageFormat format) const override;
+		uint32_t GetImageState(ImageAccess access) const override { return 1u << static_cast<int>(access); }
+		uint32_t GetReadStates() const override;
+
+		// Draws straight from the mesh's memory, so the mesh must outlive its use.
+		void SetSceneMesh(SceneMeshView const& mesh) override { m_sceneMesh = mesh; }
+		void SetSceneInstances(std::vector<SceneInstance> const& instances) override { m_sceneInstances = instances; }
+
+		void BeginFrame() override {}
+		void EndFrame() override { m_frameIndex = (m_frameIndex + 1) % m_frameCount; }
+
+		int GetFrameCount() const override { return m_frameCount; }
+		int GetFrameIndex() const override { return m_frameIndex; }
+
+		void RenderScene(
+			SceneConstants const& constants,
+			SceneConstants const& previousConstants,
+			RenderSize renderSize,
+			IImage& color,
+			IImage& depth,
+			IImage* motionVectors) override;
+		void ConvertToLuma(IImage& color, RenderSize renderSize, IImage& luma) override;
+		void EstimateMotion(IImage& current, IImage& previous, RenderSize renderSize, IImage& motionVectors) override;
+
+		bool HasVideoQueue() const override { return false; }
+		void WaitForMotionEstimation() override {}
+
+	private:
+		SceneMesh m_cubeMesh;
+		SceneMeshView m_sceneMesh;
+		std::vector<SceneInstance> m_sceneInstances;
+
+		// Per instance, rebuilt every frame.
+		std::vector<Float4x4> m_instanceTransforms;
+		std::vector<SoftwareRasterizer::MotionOutput> m_instanceMotion;
+
+		JobSystem* m_jobs;
+		SoftwareRasterizer m_rasterizer;
+		CpuMotionEstimator m_motionEstimator;
+
+		int m_frameCount;
+		int m_frameIndex;
+	};
+
+	// Point or linear scaling with CpuUpscale, followed by optional sharpening.
+	class CpuUpscaler : public IUpscaler
+	{
+	public:
+		CpuUpscaler(CpuFilter filter, float sharpness = 0.0f, JobSystem* jobs = nullptr);
+
+		void SetSharpness(float sharpness) { m_sharpness = sharpness; }
+
+		// Summed over every Upscale. Sharpening is CPU time, summed over the workers.
+		double GetUpscaleSeconds() const { return m_state.seconds; }
+		double GetSharpenSeconds() const { return m_state.sharpenSeconds; }
+
+		bool IsTemporal() const override { return false; }
+		void SetQualityPreset(QualityPreset preset) override { m_qualityPreset = preset; }
+		RenderSize GetOptimalInputSize(int outputWidth, int outputHeight) override;
+		void Upscale(UpscaleInputs const& inputs, IImage& output) override;
+
+	private:
+		CpuFilter m_filter;
+		float m_sharpness;
+		JobSystem* m_jobs;
+		QualityPreset m_qualityPreset;
+
+		// Holds the rendered part of the input when it doesn't cover the whole image.
+		ImageBgra8 m_renderedInput;
+
+		CpuUpscaleState m_state;
+	};
+
+	// Temporal upscaling with CpuTemporalScaler, so that headless runs take the temporal paths: jitter,
+	// motion vectors rendered or estimated, and history.
+	class CpuTemporalUpscaler : public IUpscaler
+	{
+	public:
+		explicit CpuTemporalUpscaler(JobSystem* jobs = nullptr);
+
+		// Summed over every Upscale.
+		double GetUpscaleSeconds() const { return m_seconds; }
+
+		bool IsTemporal() const override { return true; }
+		void SetQualityPreset(QualityPreset preset) override { m_qualityPreset = preset; }
+		RenderSize GetOptimalInputSize(int outputWidth, int outputHeight) override;
+		void Upscale(UpscaleInputs const& inputs, IImage& output) override;
+
+	private:
+		JobSystem* m_jobs;
+		QualityPreset m_qualityPreset;
+		CpuTemporalScaler m_scaler;
+		double m_seconds;
+	};
+}
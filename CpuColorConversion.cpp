@@ -0,0 +1,72 @@
+#include "CpuColorConversion.h"
+
+#include <emmintrin.h>
+
+using namespace scaling;
+
+namespace
+{
+	// The shader's weights in 8.8 fixed point: 0.256788, 0.504129, 0.097906.
+	const int c_weightR = 66;
+	const int c_weightG = 129;
+	const int c_weightB = 25;
+
+	// Rows converted by each job, whole rows at a time.
+	const int c_rowsPerJob = 32;
+
+	inline uint8_t LumaOf(uint32_t pixel)
+	{
+		int b = pixel & 0xFF;
+		int g = (pixel >> 8) & 0xFF;
+		int r = (pixel >> 16) & 0xFF;
+		int y = (c_weightR * r + c_weightG * g + c_weightB * b + 128) >> 8;
+		return static_cast<uint8_t>(y > 255 ? 255 : y);
+	}
+
+	void ConvertRowsToLuma(ImageBgra8 const& color, int firstRow, int endRow, int width, ImageLuma8& luma)
+	{
+		// Each pixel is b, g, r, a as 16-bit lanes. One multiply-add per pair of lanes, then the two halves are summed.
+		__m128i const weights = _mm_setr_epi16(c_weightB, c_weightG, c_weightR, 0, c_weightB, c_weightG, c_weightR, 0);
+		__m128i const zero = _mm_setzero_si128();
+		__m128i const rounding = _mm_set1_epi32(128);
+
+		for (int y = firstRow; y < endRow; ++y)
+		{
+			uint32_t const* in = color.GetRow(y);
+			uint8_t* out = luma.GetRow(y);
+
+			int x = 0;
+			for (; x + 4 <= width; x += 4)
+			{
+				__m128i pixels = _mm_loadu_si128(reinterpret_cast<__m128i const*>(in + x));
+				__m128i sums01 = _mm_madd_epi16(_mm_unpacklo_epi8(pixels, zero), weights); // b+g, r+0 for pixels 0 and 1
+				__m128i sums23 = _mm_madd_epi16(_mm_unpackhi_epi8(pixels, zero), weights);
+
+				// Add each pixel's two partial sums together.
+				__m128i evens = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(sums01), _mm_castsi128_ps(sums23), _MM_SHUFFLE(2, 0, 2, 0)));
+				__m128i odds = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(sums01), _mm_castsi128_ps(sums23), _MM_SHUFFLE(3, 1, 3, 1)));
+				__m128i values = _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(evens, odds), rounding), 8);
+
+				values = _mm_packs_epi32(values, values);
+				values = _mm_packus_epi16(values, values);
+				int packed = _mm_cvtsi128_si32(values);
+				out[x + 0] = static_cast<uint8_t>(packed);
+				out[x + 1] = static_cast<uint8_t>(packed >> 8);
+				out[x + 2] = static_cast<uint8_t>(packed >> 16);
+				out[x + 3] = static_cast<uint8_t>(packed >> 24);
+			}
+			for (; x < width; ++x)
+			{
+				out[x] = LumaOf(in[x]);
+			}
+		}
+	}
+}
+
+void scaling::CpuConvertToLuma(ImageBgra8 const& color, RenderSize renderSize, ImageLuma8& luma, JobSystem* jobs)
+{
+	ForEachTile(jobs, renderSize.width, renderSize.height, renderSize.width, c_rowsPerJob, [&](Tile const& rows, int)
+	{
+		ConvertRowsToLuma(color, rows.y, rows.y + rows.height, renderSize.width, luma);
+	});
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include "CpuImage.h"
+#include "JobSystem.h"
+#include "QualityPreset.h"
+
+namespace scaling
+{
+	typedef CpuImage<uint8_t> ImageLuma8;
+
+	// Computes the luma of the renderSize sub-rect of color, with the same weights as Pass2_RgbToYuvCS.hlsl.
+	// This is all that motion estimation reads, so chroma isn't computed. Bands of rows are converted in
+	// parallel when there's a job system.
+	void CpuConvertToLuma(ImageBgra8 const& color, RenderSize renderSize, ImageLuma8& luma, JobSystem* jobs = nullptr);
+}
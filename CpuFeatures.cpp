@@ -0,0 +1,35 @@
+#include "CpuFeatures.h"
+
+#if defined(_MSC_VER)
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+
+bool scaling::IsAvx2Supported()
+{
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7)
+	{
+		return false;
+	}
+
+	// FMA, AVX, and the OS saving the AVX registers on context switches.
+	const int fmaBit = 1 << 12;
+	const int osxsaveBit = 1 << 27;
+	const int avxBit = 1 << 28;
+	__cpuid(info, 1);
+	if ((info[2] & (fmaBit | osxsaveBit | avxBit)) != (fmaBit | osxsaveBit | avxBit) || (_xgetbv(0) & 0x6) != 0x6)
+	{
+		return false;
+	}
+
+	const int avx2Bit = 1 << 5;
+	__cpuidex(info, 7, 0);
+	return (info[1] & avx2Bit) != 0;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+}
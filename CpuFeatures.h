@@ -0,0 +1,10 @@
+#pragma once
+
+namespace scaling
+{
+	// Whether the CPU, and the OS, support AVX2 and FMA, which SoftwareRasterizer.cpp, VertexTransform.cpp
+	// and CpuSharpen.cpp are built for. Built that way, the compiler uses them wherever it likes, including
+	// in inline functions from headers that the linker may pick for other files too, so there's no falling
+	// back to another path once they're running. The entry points check this first, and stop.
+	bool IsAvx2Supported();
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace scaling
+{
+	// A 2D image in system memory. Rows are stored top to bottom with no padding between them.
+	template<typename TPixel>
+	class CpuImage
+	{
+	public:
+		CpuImage() : m_width(0), m_height(0) {}
+		CpuImage(int width, int height) : m_width(0), m_height(0) { Resize(width, height); }
+
+		void Resize(int width, int height)
+		{
+			m_width = width;
+			m_height = height;
+			m_pixels.resize(static_cast<size_t>(width) * static_cast<size_t>(height));
+		}
+
+		int				GetWidth() const			{ return m_width; }
+		int				GetHeight() const			{ return m_height; }
+		size_t			GetPixelCount() const		{ return m_pixels.size(); }
+
+		TPixel*			GetData()					{ return m_pixels.data(); }
+		TPixel const*	GetData() const				{ return m_pixels.data(); }
+		TPixel*			GetRow(int y)				{ return m_pixels.data() + static_cast<size_t>(y) * m_width; }
+		TPixel const*	GetRow(int y) const			{ return m_pixels.data() + static_cast<size_t>(y) * m_width; }
+
+		TPixel&			At(int x, int y)			{ return GetRow(y)[x]; }
+		TPixel const&	At(int x, int y) const		{ return GetRow(y)[x]; }
+
+	private:
+		int m_width;
+		int m_height;
+		std::vector<TPixel> m_pixels;
+	};
+
+	// Same layout as DXGI_FORMAT_B8G8R8A8_UNORM, the format of the pass 1 target and the swap chain.
+	typedef CpuImage<uint32_t> ImageBgra8;
+
+	// Same layout as DXGI_FORMAT_D32_FLOAT.
+	typedef CpuImage<float> ImageD32;
+
+	// Same layout as DXGI_FORMAT_R16G16_SINT, in quarter pixels like the output of the video motion estimator.
+	struct MotionVector
+	{
+		int16_t x;
+		int16_t y;
+	};
+
+	typedef CpuImage<MotionVector> ImageMotionVectors;
+}
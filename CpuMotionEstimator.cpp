@@ -0,0 +1,202 @@
+#include "CpuMotionEstimator.h"
+
+#include <algorithm>
+#include <climits>
+#include <emmintrin.h>
+
+using namespace scaling;
+
+namespace
+{
+	const int c_blockSize = CpuMotionEstimator::c_blockSize;
+
+	// How far, in full pixels, the refinement search looks around the best predictor.
+	const int c_refineRange = 4;
+
+	// Predictors are limited to this, in full pixels.
+	const int c_maxMotion = 64;
+
+	// Blocks along a row that each job estimates.
+	const int c_blocksPerJob = 8;
+
+	// Sum of absolute differences between the 16x16 blocks at the given positions. Both must be entirely inside their images.
+	inline int BlockSad(ImageLuma8 const& current, int cx, int cy, ImageLuma8 const& previous, int px, int py)
+	{
+		__m128i sum = _mm_setzero_si128();
+		for (int row = 0; row < c_blockSize; ++row)
+		{
+			__m128i a = _mm_loadu_si128(reinterpret_cast<__m128i const*>(current.GetRow(cy + row) + cx));
+			__m128i b = _mm_loadu_si128(reinterpret_cast<__m128i const*>(previous.GetRow(py + row) + px));
+			sum = _mm_add_epi64(sum, _mm_sad_epu8(a, b));
+		}
+		return _mm_cvtsi128_si32(sum) + _mm_cvtsi128_si32(_mm_srli_si128(sum, 8));
+	}
+
+	// Offset of the minimum of the parabola through (-1, minus), (0, center), (1, plus), in quarter pixels.
+	inline int SubPixelOffset(int minus, int center, int plus)
+	{
+		int curvature = minus - 2 * center + plus;
+		if (curvature <= 0)
+		{
+			return 0;
+		}
+		// (minus - plus) / (2 * curvature) pixels, rounded to the nearest quarter.
+		int numerator = 4 * (minus - plus);
+		int denominator = 2 * curvature;
+		int quarters = (numerator >= 0 ? numerator + denominator / 2 : numerator - denominator / 2) / denominator;
+		return std::min(std::max(quarters, -2), 2);
+	}
+}
+
+void CpuMotionEstimator::Estimate(ImageLuma8 const& current, ImageLuma8 const& previous, RenderSize renderSize, ImageMotionVectors& motionVectors, JobSystem* jobs)
+{
+	int width = renderSize.width;
+	int height = renderSize.height;
+	if (width < c_blockSize || height < c_blockSize)
+	{
+		for (int y = 0; y < height; ++y)
+		{
+			std::fill(motionVectors.GetRow(y), motionVectors.GetRow(y) + width, MotionVector{ 0, 0 });
+		}
+		return;
+	}
+
+	int blocksX = (width + c_blockSize - 1) / c_blockSize;
+	int blocksY = (height + c_blockSize - 1) / c_blockSize;
+	if (blocksX != m_blocksX || blocksY != m_blocksY)
+	{
+		// The render size changed, so last frame's vectors don't line up with these blocks.
+		m_blocksX = blocksX;
+		m_blocksY = blocksY;
+		m_previousBlockVectors.assign(static_cast<size_t>(blocksX) * blocksY, MotionVector{ 0, 0 });
+	}
+
+	std::vector<MotionVector> blockVectors(m_previousBlockVectors.size());
+	int maxX = width - c_blockSize;
+	int maxY = height - c_blockSize;
+
+	auto estimateBlock = [&](int bx, int by)
+	{
+		// Blocks that hang over the right or bottom edge are matched as if they were moved inside.
+		int cx = std::min(bx * c_blockSize, maxX);
+		int cy = std::min(by * c_blockSize, maxY);
+
+		auto cost = [&](int dx, int dy)
+		{
+			int px = cx + dx;
+			int py = cy + dy;
+			if (px < 0 || py < 0 || px > maxX || py > maxY)
+			{
+				return INT_MAX;
+			}
+			return BlockSad(current, cx, cy, previous, px, py);
+		};
+
+		MotionVector candidates[4] = { { 0, 0 }, { 0, 0 }, { 0, 0 }, m_previousBlockVectors[by * blocksX + bx] };
+		if (bx > 0) candidates[1] = blockVectors[by * blocksX + bx - 1];
+		if (by > 0) candidates[2] = blockVectors[(by - 1) * blocksX + bx];
+
+		int bestX = 0;
+		int bestY = 0;
+		int bestCost = cost(0, 0);
+		for (MotionVector const& candidate : candidates)
+		{
+			int dx = std::min(std::max(static_cast<int>(candidate.x), -c_maxMotion), c_maxMotion);
+			int dy = std::min(std::max(static_cast<int>(candidate.y), -c_maxMotion), c_maxMotion);
+			int candidateCost = cost(dx, dy);
+			if (candidateCost < bestCost)
+			{
+				bestCost = candidateCost;
+				bestX = dx;
+				bestY = dy;
+			}
+		}
+
+		int centerX = bestX;
+		int centerY = bestY;
+		for (int dy = -c_refineRange; dy <= c_refineRange; ++dy)
+		{
+			for (int dx = -c_refineRange; dx <= c_refineRange; ++dx)
+			{
+				int candidateCost = cost(centerX + dx, centerY + dy);
+				if (candidateCost < bestCost)
+				{
+					bestCost = candidateCost;
+					bestX = centerX + dx;
+					bestY = centerY + dy;
+				}
+			}
+		}
+
+		blockVectors[by * blocksX + bx] = MotionVector{ static_cast<int16_t>(bestX), static_cast<int16_t>(bestY) };
+
+		int quarterX = bestX * 4;
+		int quarterY = bestY * 4;
+		int left = cost(bestX - 1, bestY);
+		int right = cost(bestX + 1, bestY);
+		int up = cost(bestX, bestY - 1);
+		int down = cost(bestX, bestY + 1);
+		if (left != INT_MAX && right != INT_MAX)
+		{
+			quarterX += SubPixelOffset(left, bestCost, right);
+		}
+		if (up != INT_MAX && down != INT_MAX)
+		{
+			quarterY += SubPixelOffset(up, bestCost, down);
+		}
+
+		MotionVector vector = { static_cast<int16_t>(quarterX), static_cast<int16_t>(quarterY) };
+		int x0 = bx * c_blockSize;
+		int y0 = by * c_blockSize;
+		int x1 = std::min(x0 + c_blockSize, width);
+		int y1 = std::min(y0 + c_blockSize, height);
+		for (int y = y0; y < y1; ++y)
+		{
+			std::fill(motionVectors.GetRow(y) + x0, motionVectors.GetRow(y) + x1, vector);
+		}
+	};
+
+	if (!jobs)
+	{
+		for (int by = 0; by < blocksY; ++by)
+		{
+			for (int bx = 0; bx < blocksX; ++bx)
+			{
+				estimateBlock(bx, by);
+			}
+		}
+	}
+	else
+	{
+		// A block starts from the vectors of the blocks to its left and above, so each job waits for the jobs
+		// to its left and above, and they sweep across the image as a wavefront. The vectors are the same
+		// as in order.
+		int groupsX = (blocksX + c_blocksPerJob - 1) / c_blocksPerJob;
+		JobGraph graph;
+		for (int by = 0; by < blocksY; ++by)
+		{
+			for (int group = 0; group < groupsX; ++group)
+			{
+				int job = graph.Add([&, by, group](int)
+				{
+					int endX = std::min((group + 1) * c_blocksPerJob, blocksX);
+					for (int bx = group * c_blocksPerJob; bx < endX; ++bx)
+					{
+						estimateBlock(bx, by);
+					}
+				});
+				if (group > 0)
+				{
+					graph.AddDependency(job - 1, job);
+				}
+				if (by > 0)
+				{
+					graph.AddDependency(job - groupsX, job);
+				}
+			}
+		}
+		jobs->Run(graph);
+	}
+
+	m_previousBlockVectors.swap(blockVectors);
+}
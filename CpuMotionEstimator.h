@@ -0,0 +1,31 @@
+#pragma once
+
+#include "CpuColorConversion.h"
+#include "JobSystem.h"
+
+#include <vector>
+
+namespace scaling
+{
+	// Block-matching motion estimation on the CPU, standing in for ID3D12VideoMotionEstimator. Works on 16x16
+	// blocks, like the D3D12 path's D3D12_VIDEO_MOTION_ESTIMATOR_SEARCH_BLOCK_SIZE_16X16.
+	//
+	// Each block tries a few predictors (no motion, its left and upper neighbors, and its own vector from the
+	// previous frame), refines the best one with a small full-pixel search, and then to a quarter pixel by
+	// fitting a parabola to the neighboring costs. Blocks are visited in a fixed order, so the result only
+	// depends on the input.
+	class CpuMotionEstimator
+	{
+	public:
+		static const int c_blockSize = 16;
+
+		// Vectors point from a pixel in current to where its content was in previous. Every pixel of a block
+		// gets the block's vector. With a job system, blocks are estimated in parallel, with the same result.
+		void Estimate(ImageLuma8 const& current, ImageLuma8 const& previous, RenderSize renderSize, ImageMotionVectors& motionVectors, JobSystem* jobs = nullptr);
+
+	private:
+		int m_blocksX = 0;
+		int m_blocksY = 0;
+		std::vector<MotionVector> m_previousBlockVectors; // Full pixels
+	};
+}
@@ -0,0 +1,412 @@
+#include "CpuScaler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <utility>
+#include <emmintrin.h>
+
+using namespace scaling;
+
+namespace
+{
+	// One destination sample of a separable linear filter: blends source texels index and index+1,
+	// with weight/256 going to the second one.
+	struct LinearTap
+	{
+		int index;
+		int weight;
+	};
+
+	constexpr int FloorDiv(int a, int b)
+	{
+		return (a >= 0) ? (a / b) : -((-a + b - 1) / b);
+	}
+
+	// Destination sample x sits at source position (x + 0.5) * srcSize / dstSize - 0.5. This is evaluated in
+	// integers so that the generic loop and the specialized kernels round identically.
+	constexpr LinearTap ComputeLinearTap(int x, int srcSize, int dstSize)
+	{
+		int numerator = (2 * x + 1) * srcSize - dstSize;
+		int denominator = 2 * dstSize;
+		int base = FloorDiv(numerator, denominator);
+		int remainder = numerator - base * denominator;
+		int weight = (remainder * 256 + dstSize) / denominator;
+		return weight == 256 ? LinearTap{ base + 1, 0 } : LinearTap{ base, weight };
+	}
+
+	inline uint32_t LerpPixel(uint32_t a, uint32_t b, int weight)
+	{
+		uint32_t result = 0;
+		for (int shift = 0; shift < 32; shift += 8)
+		{
+			uint32_t ca = (a >> shift) & 0xFF;
+			uint32_t cb = (b >> shift) & 0xFF;
+			uint32_t c = (ca * (256 - weight) + cb * weight + 128) >> 8;
+			result |= c << shift;
+		}
+		return result;
+	}
+
+	// Blends 8 channels (two pixels) held as 16-bit lanes.
+	inline __m128i LerpLanes(__m128i a, __m128i b, __m128i weightA, __m128i weightB)
+	{
+		__m128i sum = _mm_add_epi16(_mm_mullo_epi16(a, weightA), _mm_mullo_epi16(b, weightB));
+		sum = _mm_add_epi16(sum, _mm_set1_epi16(128));
+		return _mm_srli_epi16(sum, 8);
+	}
+
+	void LerpRows(uint32_t const* row0, uint32_t const* row1, int weight, int width, uint32_t* out)
+	{
+		if (weight == 0)
+		{
+			memcpy(out, row0, width * sizeof(uint32_t));
+			return;
+		}
+
+		__m128i const zero = _mm_setzero_si128();
+		__m128i const weight0 = _mm_set1_epi16(static_cast<short>(256 - weight));
+		__m128i const weight1 = _mm_set1_epi16(static_cast<short>(weight));
+
+		int x = 0;
+		for (; x + 4 <= width; x += 4)
+		{
+			__m128i a = _mm_loadu_si128(reinterpret_cast<__m128i const*>(row0 + x));
+			__m128i b = _mm_loadu_si128(reinterpret_cast<__m128i const*>(row1 + x));
+			__m128i lo = LerpLanes(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero), weight0, weight1);
+			__m128i hi = LerpLanes(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero), weight0, weight1);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), _mm_packus_epi16(lo, hi));
+		}
+		for (; x < width; ++x)
+		{
+			out[x] = LerpPixel(row0[x], row1[x], weight);
+		}
+	}
+
+	std::vector<LinearTap> BuildLinearTaps(int srcSize, int dstSize)
+	{
+		std::vector<LinearTap> taps(dstSize);
+		for (int x = 0; x < dstSize; ++x)
+		{
+			taps[x] = ComputeLinearTap(x, srcSize, dstSize);
+		}
+		return taps;
+	}
+
+	// Horizontal pass of the generic polyphase loop: one table lookup and two clamped loads per output.
+	void ResampleRowGeneric(uint32_t const* src, int srcWidth, LinearTap const* taps, int begin, int end, uint32_t* dst)
+	{
+		for (int x = begin; x < end; ++x)
+		{
+			int i0 = std::min(std::max(taps[x].index, 0), srcWidth - 1);
+			int i1 = std::min(std::max(taps[x].index + 1, 0), srcWidth - 1);
+			dst[x] = LerpPixel(src[i0], src[i1], taps[x].weight);
+		}
+	}
+
+	struct GenericRowKernel
+	{
+		static void Run(uint32_t const* src, int srcWidth, LinearTap const* taps, int dstWidth, uint32_t* dst)
+		{
+			ResampleRowGeneric(src, srcWidth, taps, 0, dstWidth, dst);
+		}
+	};
+
+	// Horizontal pass for a fixed ratio of Num destination pixels per Den source pixels. The phase offsets and
+	// weights repeat every Num outputs, so they are compile-time constants here. Outputs are produced four at
+	// a time (one SSE register of BGRA8 pixels), over a super-block of Blocks repetitions of the phase pattern.
+	template<int Num, int Den>
+	struct RatioRowKernel
+	{
+		static constexpr int Blocks = (Num % 4 == 0) ? 1 : (Num % 2 == 0) ? 2 : 4;
+		static constexpr int Outputs = Blocks * Num;
+		static constexpr int Groups = Outputs / 4;
+		static constexpr int SourceStride = Blocks * Den;
+
+		static_assert(Num >= Den, "Only upscaling ratios are specialized");
+
+		static constexpr LinearTap OutputTap(int j)
+		{
+			return LinearTap{ (j / Num) * Den + ComputeLinearTap(j % Num, Den, Num).index, ComputeLinearTap(j % Num, Den, Num).weight };
+		}
+
+		static constexpr int GroupBase(int g) { return OutputTap(g * 4).index; }
+
+		static constexpr int Lane(int j) { return OutputTap(j).index - GroupBase(j / 4); }
+
+		static constexpr int Shuffle(int g)
+		{
+			return Lane(g * 4 + 0) | (Lane(g * 4 + 1) << 2) | (Lane(g * 4 + 2) << 4) | (Lane(g * 4 + 3) << 6);
+		}
+
+		static constexpr int MinSourceOffset() { return GroupBase(0); }
+
+		// Each group reads four texels starting at its base, and four more starting one past it.
+		static constexpr int MaxSourceOffset() { return GroupBase(Groups - 1) + 4; }
+
+		template<int G>
+		static void RunGroup(uint32_t const* src, uint32_t* dst)
+		{
+			static_assert(Lane(G * 4 + 3) <= 3, "Group does not fit in one register");
+			constexpr int shuffle = Shuffle(G);
+			constexpr int w0 = OutputTap(G * 4 + 0).weight;
+			constexpr int w1 = OutputTap(G * 4 + 1).weight;
+			constexpr int w2 = OutputTap(G * 4 + 2).weight;
+			constexpr int w3 = OutputTap(G * 4 + 3).weight;
+
+			__m128i const zero = _mm_setzero_si128();
+			__m128i const weightLo1 = _mm_set_epi16(w1, w1, w1, w1, w0, w0, w0, w0);
+			__m128i const weightHi1 = _mm_set_epi16(w3, w3, w3, w3, w2, w2, w2, w2);
+			__m128i const weightLo0 = _mm_sub_epi16(_mm_set1_epi16(256), weightLo1);
+			__m128i const weightHi0 = _mm_sub_epi16(_mm_set1_epi16(256), weightHi1);
+
+			__m128i left = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + GroupBase(G)));
+			__m128i right = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + GroupBase(G) + 1));
+			left = _mm_shuffle_epi32(left, shuffle);
+			right = _mm_shuffle_epi32(right, shuffle);
+
+			__m128i lo = LerpLanes(_mm_unpacklo_epi8(left, zero), _mm_unpacklo_epi8(right, zero), weightLo0, weightLo1);
+			__m128i hi = LerpLanes(_mm_unpackhi_epi8(left, zero), _mm_unpackhi_epi8(right, zero), weightHi0, weightHi1);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + G * 4), _mm_packus_epi16(lo, hi));
+		}
+
+		template<int... G>
+		static void RunSuperBlock(uint32_t const* src, uint32_t* dst, std::integer_sequence<int, G...>)
+		{
+			(RunGroup<G>(src, dst), ...);
+		}
+
+		static void Run(uint32_t const* src, int srcWidth, LinearTap const* taps, int dstWidth, uint32_t* dst)
+		{
+			// Super-blocks whose loads all fall inside the row run unrolled; the clamped edges use the generic loop.
+			int firstBlock = (-MinSourceOffset() + SourceStride - 1) / SourceStride;
+			int lastBlock = FloorDiv(srcWidth - 1 - MaxSourceOffset(), SourceStride);
+			lastBlock = std::min(lastBlock, dstWidth / Outputs - 1);
+
+			if (lastBlock < firstBlock)
+			{
+				ResampleRowGeneric(src, srcWidth, taps, 0, dstWidth, dst);
+				return;
+			}
+
+			ResampleRowGeneric(src, srcWidth, taps, 0, firstBlock * Outputs, dst);
+			for (int block = firstBlock; block <= lastBlock; ++block)
+			{
+				RunSuperBlock(src + block * SourceStride, dst + block * Outputs, std::make_integer_sequence<int, Groups>());
+			}
+			ResampleRowGeneric(src, srcWidth, taps, (lastBlock + 1) * Outputs, dstWidth, dst);
+		}
+	};
+
+	int const c_rowsPerJob = 32;
+
+	// Hands each destination row to produceRow, along with the worker producing it. With sharpening on, rows
+	// are produced into a three-row window and sharpened on their way into dst, so the upscaled image is never
+	// read back in a separate pass. With a job system, bands of rows are written in parallel, each band
+	// producing the rows either side of it again for its own window.
+	template<typename TProduceRow>
+	void WriteRows(ImageBgra8& dst, float sharpness, JobSystem* jobs, CpuUpscaleState& state, TProduceRow const& produceRow)
+	{
+		int width = dst.GetWidth();
+		int height = dst.GetHeight();
+		int rowsPerJob = jobs ? c_rowsPerJob : height;
+
+		size_t workerCount = jobs ? jobs->GetWorkerIndexCount() : 1;
+		if (sharpness > 0.0f)
+		{
+			state.sharpenWeights.SetSharpness(sharpness);
+			state.sharpenWindows.resize(workerCount);
+			state.workerSharpenSeconds.assign(workerCount, 0.0);
+		}
+
+		ForEachTile(jobs, width, height, width, rowsPerJob, [&](Tile const& band, int worker)
+		{
+			int endRow = band.y + band.height;
+			if (sharpness <= 0.0f)
+			{
+				for (int y = band.y; y < endRow; ++y)
+				{
+					produceRow(y, dst.GetRow(y), worker);
+				}
+				return;
+			}
+
+			std::vector<uint32_t>& window = state.sharpenWindows[worker];
+			window.resize(3 * static_cast<size_t>(width));
+			auto windowRow = [&](int y) { return window.data() + (y % 3) * static_cast<size_t>(width); };
+
+			int producedRow = std::max(band.y - 1, 0);
+			produceRow(producedRow, windowRow(producedRow), worker);
+			for (int y = band.y; y < endRow; ++y)
+			{
+				while (producedRow < std::min(y + 1, height - 1))
+				{
+					++producedRow;
+					produceRow(producedRow, windowRow(producedRow), worker);
+				}
+				uint32_t const* above = windowRow(std::max(y - 1, 0));
+				uint32_t const* below = windowRow(std::min(y + 1, height - 1));
+
+				auto sharpenStart = std::chrono::steady_clock::now();
+				CpuSharpenRow(above, windowRow(y), below, width, state.sharpenWeights, dst.GetRow(y));
+				state.workerSharpenSeconds[worker] += std::chrono::duration<double>(std::chrono::steady_clock::now() - sharpenStart).count();
+			}
+		});
+
+		for (double seconds : state.workerSharpenSeconds)
+		{
+			state.sharpenSeconds += seconds;
+		}
+		state.workerSharpenSeconds.clear();
+	}
+
+	template<typename TRowKernel>
+	void UpscaleLinear(ImageBgra8 const& src, ImageBgra8& dst, float sharpness, JobSystem* jobs, CpuUpscaleState& state)
+	{
+		int srcWidth = src.GetWidth();
+		int srcHeight = src.GetHeight();
+		int dstWidth = dst.GetWidth();
+		int dstHeight = dst.GetHeight();
+
+		std::vector<LinearTap> columnTaps = BuildLinearTaps(srcWidth, dstWidth);
+		state.blendedRows.resize(jobs ? jobs->GetWorkerIndexCount() : 1);
+
+		WriteRows(dst, sharpness, jobs, state, [&](int y, uint32_t* out, int worker)
+		{
+			std::vector<uint32_t>& blendedRow = state.blendedRows[worker];
+			blendedRow.resize(srcWidth);
+
+			LinearTap rowTap = ComputeLinearTap(y, srcHeight, dstHeight);
+			int y0 = std::min(std::max(rowTap.index, 0), srcHeight - 1);
+			int y1 = std::min(std::max(rowTap.index + 1, 0), srcHeight - 1);
+
+			LerpRows(src.GetRow(y0), src.GetRow(y1), rowTap.weight, srcWidth, blendedRow.data());
+			TRowKernel::Run(blendedRow.data(), srcWidth, columnTaps.data(), dstWidth, out);
+		});
+	}
+
+	void UpscalePoint(ImageBgra8 const& src, ImageBgra8& dst, float sharpness, JobSystem* jobs, CpuUpscaleState& state)
+	{
+		int srcWidth = src.GetWidth();
+		int srcHeight = src.GetHeight();
+		int dstWidth = dst.GetWidth();
+		int dstHeight = dst.GetHeight();
+
+		std::vector<int> columns(dstWidth);
+		for (int x = 0; x < dstWidth; ++x)
+		{
+			columns[x] = std::min(((2 * x + 1) * srcWidth) / (2 * dstWidth), srcWidth - 1);
+		}
+
+		WriteRows(dst, sharpness, jobs, state, [&](int y, uint32_t* out, int)
+		{
+			int sy = std::min(((2 * y + 1) * srcHeight) / (2 * dstHeight), srcHeight - 1);
+			uint32_t const* srcRow = src.GetRow(sy);
+			for (int x = 0; x < dstWidth; ++x)
+			{
+				out[x] = srcRow[columns[x]];
+			}
+		});
+	}
+
+	template<int Num, int Den>
+	bool IsRatio(int srcSize, int dstSize)
+	{
+		return dstSize * Den == srcSize * Num;
+	}
+}
+
+RenderSize scaling::CpuGetOptimalInputSize(QualityPreset preset, int displayWidth, int displayHeight)
+{
+	struct SpecializedRatio
+	{
+		int num;
+		int den;
+	};
+	const SpecializedRatio specializedRatios[] = { { 2, 1 }, { 3, 2 }, { 4, 3 } };
+
+	// How far, relative to the preset's ratio, a specialized one may be and still be used instead.
+	const float tolerance = 0.05f;
+
+	float presetRatio = GetUpscaleRatio(preset);
+	for (SpecializedRatio const& ratio : specializedRatios)
+	{
+		float candidate = static_cast<float>(ratio.num) / ratio.den;
+		if (std::abs(candidate - presetRatio) > presetRatio * tolerance || displayWidth % ratio.num != 0)
+		{
+			continue;
+		}
+
+		RenderSize size;
+		size.width = displayWidth / ratio.num * ratio.den;
+		size.height = (displayHeight * ratio.den + ratio.num / 2) / ratio.num;
+		if (size.width % 2 == 0)
+		{
+			return ClampRenderSize(size, displayWidth, displayHeight);
+		}
+	}
+
+	return GetPresetRenderSize(preset, displayWidth, displayHeight);
+}
+
+char const* scaling::CpuGetLinearKernelName(int srcWidth, int dstWidth)
+{
+	if (IsRatio<2, 1>(srcWidth, dstWidth))
+	{
+		return "2x";
+	}
+	if (IsRatio<3, 2>(srcWidth, dstWidth))
+	{
+		return "1.5x";
+	}
+	if (IsRatio<4, 3>(srcWidth, dstWidth))
+	{
+		return "4/3x";
+	}
+	return nullptr;
+}
+
+void scaling::CpuUpscaleLinearGeneric(ImageBgra8 const& src, ImageBgra8& dst)
+{
+	CpuUpscaleState state;
+	UpscaleLinear<GenericRowKernel>(src, dst, 0.0f, nullptr, state);
+}
+
+void scaling::CpuUpscale(ImageBgra8 const& src, ImageBgra8& dst, CpuFilter filter, float sharpness, JobSystem* jobs, CpuUpscaleState* state)
+{
+	if (src.GetWidth() == 0 || src.GetHeight() == 0 || dst.GetWidth() == 0 || dst.GetHeight() == 0)
+	{
+		return;
+	}
+
+	CpuUpscaleState localState;
+	CpuUpscaleState& usedState = state ? *state : localState;
+	auto start = std::chrono::steady_clock::now();
+
+	int srcWidth = src.GetWidth();
+	int dstWidth = dst.GetWidth();
+
+	if (filter == CpuFilter::Point)
+	{
+		UpscalePoint(src, dst, sharpness, jobs, usedState);
+	}
+	else if (IsRatio<2, 1>(srcWidth, dstWidth))
+	{
+		UpscaleLinear<RatioRowKernel<2, 1>>(src, dst, sharpness, jobs, usedState);
+	}
+	else if (IsRatio<3, 2>(srcWidth, dstWidth))
+	{
+		UpscaleLinear<RatioRowKernel<3, 2>>(src, dst, sharpness, jobs, usedState);
+	}
+	else if (IsRatio<4, 3>(srcWidth, dstWidth))
+	{
+		UpscaleLinear<RatioRowKernel<4, 3>>(src, dst, sharpness, jobs, usedState);
+	}
+	else
+	{
+		UpscaleLinear<GenericRowKernel>(src, dst, sharpness, jobs, usedState);
+	}
+
+	usedState.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
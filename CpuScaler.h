@@ -0,0 +1,54 @@
+#pragma once
+
+#include "CpuImage.h"
+#include "CpuSharpen.h"
+#include "JobSystem.h"
+#include "QualityPreset.h"
+
+#include <vector>
+
+namespace scaling
+{
+	enum class CpuFilter
+	{
+		Point,
+		Linear
+	};
+
+	// Scales src to the size of dst. Sample positions follow the same pixel-center convention as the
+	// pass 2 samplers; edges are clamped.
+	//
+	// Linear filtering picks a kernel specialized for 2x, 1.5x or 4/3x when the ratio between the two
+	// widths is one of those, and falls back to the generic polyphase loop otherwise.
+	//
+	// What CpuUpscale keeps from one call to the next: the rows each worker works in, so that once they've
+	// grown to the image's width a call allocates nothing, the sharpening weights for the last sharpness,
+	// and the time the calls took.
+	struct CpuUpscaleState
+	{
+		double seconds = 0.0;
+		double sharpenSeconds = 0.0;	// Summed over the workers as well, so it's CPU time
+		CpuSharpenWeights sharpenWeights;
+
+		// Per worker.
+		std::vector<std::vector<uint32_t>> blendedRows;
+		std::vector<std::vector<uint32_t>> sharpenWindows;
+		std::vector<double> workerSharpenSeconds;
+	};
+
+	// A non-zero sharpness runs contrast-adaptive sharpening (see CpuSharpen.h) as part of the final write.
+	// With a job system, bands of rows are scaled in parallel.
+	void CpuUpscale(ImageBgra8 const& src, ImageBgra8& dst, CpuFilter filter, float sharpness = 0.0f, JobSystem* jobs = nullptr, CpuUpscaleState* state = nullptr);
+
+	// Always runs the generic polyphase loop, on the calling thread. Headless runs compare the specialized
+	// kernels against it, which must give the same output.
+	void CpuUpscaleLinearGeneric(ImageBgra8 const& src, ImageBgra8& dst);
+
+	// The specialized kernel that linear filtering picks between the two widths, such as "4/3x", or nullptr
+	// when it falls back to the generic loop.
+	char const* CpuGetLinearKernelName(int srcWidth, int dstWidth);
+
+	// The input size that CpuUpscale runs best at for a preset. Prefers a ratio that one of the specialized
+	// kernels handles, when there's one close to the preset's and it divides the display width exactly.
+	RenderSize CpuGetOptimalInputSize(QualityPreset preset, int displayWidth, int displayHeight);
+}
@@ -0,0 +1,175 @@
+#include "CpuSharpen.h"
+
+#include <algorithm>
+#include <cmath>
+#include <immintrin.h>
+
+using namespace scaling;
+
+namespace
+{
+	// Sharpening written as c + k * (n + s + w + e - 4c), with k = w / (1 + 4w) for the GPU's weight w. The
+	// minimum, maximum and the sum of the neighbors are taken on the bytes of eight pixels at once. k depends
+	// on the minimum and maximum alone, through the headroom h and the maximum m, so it's looked up per
+	// channel: with the amplitude sqrt(h / m), k = peak * sqrt(h) / (sqrt(m) + 4 * peak * sqrt(h)). The
+	// headroom is at most 127, so the table has 128 x 256 entries. k is applied in 16-bit fixed point, so
+	// results are within a level of the GPU's.
+	const float c_weightScale = 4096.0f; // k's fixed point
+	const int c_maxHeadroom = 127;
+
+	inline float PeakWeight(float sharpness)
+	{
+		sharpness = std::min(std::max(sharpness, 0.0f), 1.0f);
+		return -1.0f / (8.0f + (5.0f - 8.0f) * sharpness);
+	}
+
+	inline __m256i Load(uint32_t const* pixels)
+	{
+		return _mm256_loadu_si256(reinterpret_cast<__m256i const*>(pixels));
+	}
+
+	// Pixels 0, 1, 4 and 5 of the eight, or 2, 3, 6 and 7, since AVX2 unpacks within each half.
+	inline __m256i Widen(__m256i bytes, bool isHigh)
+	{
+		__m256i const zero = _mm256_setzero_si256();
+		return isHigh ? _mm256_unpackhi_epi8(bytes, zero) : _mm256_unpacklo_epi8(bytes, zero);
+	}
+
+	// k for the channels of the pixels that Widen gives.
+	inline __m256i GetWeights(__m256i headroom, __m256i maximum, int16_t const* table, bool isHigh)
+	{
+		__m256i indices = isHigh ? _mm256_unpackhi_epi8(maximum, headroom) : _mm256_unpacklo_epi8(maximum, headroom);
+
+		// Each gather reads 32 bits at an entry, of which the entry is the low half.
+		__m256i weights[2];
+		for (int half = 0; half < 2; ++half)
+		{
+			__m256i const zero = _mm256_setzero_si256();
+			__m256i halfIndices = half != 0 ? _mm256_unpackhi_epi16(indices, zero) : _mm256_unpacklo_epi16(indices, zero);
+			__m256i gathered = _mm256_i32gather_epi32(reinterpret_cast<int const*>(table), halfIndices, 2);
+			weights[half] = _mm256_srai_epi32(_mm256_slli_epi32(gathered, 16), 16);
+		}
+		return _mm256_packs_epi32(weights[0], weights[1]);
+	}
+
+	// The sharpened channels of the pixels that Widen gives, as words.
+	inline __m256i SharpenHalf(__m256i center, __m256i north, __m256i south, __m256i west, __m256i east, __m256i weights, bool isHigh)
+	{
+		__m256i c = Widen(center, isHigh);
+		__m256i sum = _mm256_add_epi16(_mm256_add_epi16(Widen(north, isHigh), Widen(south, isHigh)), _mm256_add_epi16(Widen(west, isHigh), Widen(east, isHigh)));
+		__m256i laplacian = _mm256_sub_epi16(sum, _mm256_slli_epi16(c, 2));
+
+		// The laplacian is within 4 * 255, so it has the bits to spare for k's fixed point, and one more for
+		// rounding the product to the nearest level.
+		__m256i doubled = _mm256_mulhi_epi16(_mm256_slli_epi16(laplacian, 16 - 12 + 1), weights);
+		return _mm256_add_epi16(c, _mm256_srai_epi16(_mm256_add_epi16(doubled, _mm256_set1_epi16(1)), 1));
+	}
+
+	// Eight pixels at once, from their neighbors. Alpha passes through untouched.
+	inline __m256i SharpenEight(__m256i center, __m256i north, __m256i south, __m256i west, __m256i east, int16_t const* table)
+	{
+		__m256i minimum = _mm256_min_epu8(_mm256_min_epu8(center, north), _mm256_min_epu8(_mm256_min_epu8(south, west), east));
+		__m256i maximum = _mm256_max_epu8(_mm256_max_epu8(center, north), _mm256_max_epu8(_mm256_max_epu8(south, west), east));
+
+		// Sharpen less where the neighborhood is already close to clipping.
+		__m256i headroom = _mm256_min_epu8(minimum, _mm256_subs_epu8(_mm256_set1_epi8(-1), maximum));
+
+		__m256i low = SharpenHalf(center, north, south, west, east, GetWeights(headroom, maximum, table, false), false);
+		__m256i high = SharpenHalf(center, north, south, west, east, GetWeights(headroom, maximum, table, true), true);
+
+		__m256i alpha = _mm256_set1_epi32(static_cast<int>(0xFF000000));
+		return _mm256_or_si256(_mm256_and_si256(center, alpha), _mm256_andnot_si256(alpha, _mm256_packus_epi16(low, high)));
+	}
+
+	// For the edges of the row, where the neighbors are clamped: up to eight pixels from x.
+	void SharpenClamped(uint32_t const* above, uint32_t const* center, uint32_t const* below, int width, int x, int16_t const* table, uint32_t* out)
+	{
+		alignas(32) uint32_t lanes[5][8];
+		for (int i = 0; i < 8; ++i)
+		{
+			int lane = std::min(x + i, width - 1);
+			lanes[0][i] = center[lane];
+			lanes[1][i] = above[lane];
+			lanes[2][i] = below[lane];
+			lanes[3][i] = center[std::max(lane - 1, 0)];
+			lanes[4][i] = center[std::min(lane + 1, width - 1)];
+		}
+
+		alignas(32) uint32_t sharpened[8];
+		_mm256_store_si256(reinterpret_cast<__m256i*>(sharpened),
+			SharpenEight(Load(lanes[0]), Load(lanes[1]), Load(lanes[2]), Load(lanes[3]), Load(lanes[4]), table));
+		std::copy(sharpened, sharpened + std::min(8, width - x), out + x);
+	}
+}
+
+CpuSharpenWeights::CpuSharpenWeights()
+	: m_sharpness(-1.0f)
+{
+}
+
+void CpuSharpenWeights::SetSharpness(float sharpness)
+{
+	if (sharpness == m_sharpness)
+	{
+		return;
+	}
+	m_sharpness = sharpness;
+
+	// One more entry, for the top half of the last one's gather.
+	m_table.assign((c_maxHeadroom + 1) * 256 + 1, 0);
+	float scaledPeak = PeakWeight(sharpness) * c_weightScale;
+	for (int headroom = 0; headroom <= c_maxHeadroom; ++headroom)
+	{
+		float numerator = std::sqrt(static_cast<float>(headroom)) * scaledPeak;
+		for (int maximum = 0; maximum < 256; ++maximum)
+		{
+			float maximumRoot = std::max(std::sqrt(static_cast<float>(maximum)), 0.5f);
+			float weight = numerator / (maximumRoot + numerator * (4.0f / c_weightScale));
+			m_table[headroom * 256 + maximum] = static_cast<int16_t>(std::lround(weight));
+		}
+	}
+}
+
+void scaling::CpuSharpenRow(uint32_t const* above, uint32_t const* center, uint32_t const* below, int width, CpuSharpenWeights const& weights, uint32_t* out)
+{
+	if (width <= 0)
+	{
+		return;
+	}
+	int16_t const* table = weights.GetTable();
+
+	// The first pixel has no neighbor to its left, and the last none to its right.
+	SharpenClamped(above, center, below, width, 0, table, out);
+	int x = 8;
+	for (; x + 8 < width; x += 8)
+	{
+		__m256i sharpened = SharpenEight(Load(center + x), Load(above + x), Load(below + x), Load(center + x - 1), Load(center + x + 1), table);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + x), sharpened);
+	}
+	for (; x < width; x += 8)
+	{
+		SharpenClamped(above, center, below, width, x, table, out);
+	}
+}
+
+void scaling::CpuSharpen(ImageBgra8 const& src, ImageBgra8& dst, float sharpness)
+{
+	int width = src.GetWidth();
+	int height = src.GetHeight();
+	dst.Resize(width, height);
+
+	if (sharpness <= 0.0f)
+	{
+		std::copy(src.GetData(), src.GetData() + src.GetPixelCount(), dst.GetData());
+		return;
+	}
+
+	CpuSharpenWeights weights;
+	weights.SetSharpness(sharpness);
+	for (int y = 0; y < height; ++y)
+	{
+		uint32_t const* above = src.GetRow(std::max(y - 1, 0));
+		uint32_t const* below = src.GetRow(std::min(y + 1, height - 1));
+		CpuSharpenRow(above, src.GetRow(y), below, width, weights, dst.GetRow(y));
+	}
+}
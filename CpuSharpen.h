@@ -0,0 +1,34 @@
+#pragma once
+
+#include "CpuImage.h"
+
+#include <vector>
+
+namespace scaling
+{
+	// The weight sharpening gives a pixel's neighbors, for every headroom and maximum its neighborhood can
+	// have at one sharpness, so that sharpening takes no square roots or divisions per pixel. Only rebuilt
+	// when the sharpness changes.
+	class CpuSharpenWeights
+	{
+	public:
+		CpuSharpenWeights();
+
+		void SetSharpness(float sharpness);
+
+		// In 4096ths, indexed by the maximum plus 256 times the headroom.
+		int16_t const* GetTable() const { return m_table.data(); }
+
+	private:
+		float m_sharpness;
+		std::vector<int16_t> m_table;
+	};
+
+	// Contrast-adaptive sharpening, the same filter that pass 2 applies on the GPU, to within a level of each
+	// channel. sharpness is in [0, 1], where 0 turns sharpening off.
+	void CpuSharpen(ImageBgra8 const& src, ImageBgra8& dst, float sharpness);
+
+	// Sharpens one row given its neighbors above and below. Used to fuse sharpening into the last write of
+	// another kernel, so the image doesn't have to be read back in a separate pass.
+	void CpuSharpenRow(uint32_t const* above, uint32_t const* center, uint32_t const* below, int width, CpuSharpenWeights const& weights, uint32_t* out);
+}
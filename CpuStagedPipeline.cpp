@@ -0,0 +1,227 @@
+#include "CpuStagedPipeline.h"
+
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+using namespace scaling;
+
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	double SecondsSince(Clock::time_point start)
+	{
+		return std::chrono::duration<double>(Clock::now() - start).count();
+	}
+
+	template<typename T>
+	T Pop(SpscRing<T>& ring, double& waitingSeconds)
+	{
+		T value;
+		if (!ring.TryPop(value))
+		{
+			Clock::time_point start = Clock::now();
+			do
+			{
+				ring.WaitWhileEmpty();
+			} while (!ring.TryPop(value));
+			waitingSeconds += SecondsSince(start);
+		}
+		return value;
+	}
+
+	// Rings have room for every frame, so there's always room.
+	template<typename T>
+	void Push(SpscRing<T>& ring, T const& value)
+	{
+		bool isPushed = ring.TryPush(value);
+		assert(isPushed);
+		(void)isPushed;
+	}
+}
+
+CpuStagedPipeline::CpuStagedPipeline(CpuDevice& device, int queueDepth, int maxRenderWidth, int maxRenderHeight, int outputWidth, int outputHeight)
+	: m_device(device)
+	, m_motionVectorSource(MotionVectorSource::Rendered)
+	, m_previousLumaIndex(0)
+	, m_isStopping(false)
+	, m_runSeconds(0.0)
+{
+	assert(queueDepth > 0);
+	for (int i = 0; i < queueDepth; ++i)
+	{
+		std::unique_ptr<CpuStagedFrame> frame(new CpuStagedFrame());
+		frame->color = device.CreateImage(ImageFormat::Bgra8, maxRenderWidth, maxRenderHeight);
+		frame->depth = device.CreateImage(ImageFormat::Depth32, maxRenderWidth, maxRenderHeight);
+		frame->motionVectors = device.CreateImage(ImageFormat::MotionVectors, maxRenderWidth, maxRenderHeight);
+		frame->output = device.CreateImage(ImageFormat::Bgra8, outputWidth, outputHeight);
+		m_frames.push_back(std::move(frame));
+	}
+
+	for (std::unique_ptr<IImage>& luma : m_luma)
+	{
+		luma = device.CreateImage(ImageFormat::Luma, maxRenderWidth, maxRenderHeight);
+	}
+}
+
+int CpuStagedPipeline::Run(int frameCount, RenderSize renderSize, IUpscaler& upscaler, PrepareFrame const& prepare, FinishFrame const& finish)
+{
+	bool isTemporal = upscaler.IsTemporal();
+	bool isRenderingMotion = isTemporal && m_motionVectorSource == MotionVectorSource::Rendered;
+	bool isEstimatingMotion = isTemporal && m_motionVectorSource == MotionVectorSource::Estimated;
+
+	// The stages between the first and the last.
+	std::vector<std::function<void(CpuStagedFrame&)>> middleStages;
+	m_stageStats.clear();
+	m_stageStats.push_back(CpuStageStats{ "pass 1", 0, 0.0, 0.0 });
+	if (isEstimatingMotion)
+	{
+		middleStages.push_back([&](CpuStagedFrame& frame) { EstimateMotion(frame, renderSize); });
+		m_stageStats.push_back(CpuStageStats{ "motion estimation", 0, 0.0, 0.0 });
+	}
+	middleStages.push_back([&](CpuStagedFrame& frame)
+	{
+		UpscaleInputs inputs = {};
+		inputs.color = frame.color.get();
+		inputs.depth = frame.depth.get();
+		inputs.motionVectors = frame.motionVectors.get();
+		inputs.renderSize = renderSize;
+		inputs.jitter = frame.jitter;
+		inputs.reset = frame.isReset;
+		upscaler.Upscale(inputs, *frame.output);
+	});
+	m_stageStats.push_back(CpuStageStats{ "upscaling", 0, 0.0, 0.0 });
+	m_stageStats.push_back(CpuStageStats{ "finishing", 0, 0.0, 0.0 });
+
+	// rings[i] goes into stage i, and the free list into the first. Each has room for every frame, and
+	// for the null one that ends the run.
+	std::vector<std::unique_ptr<FrameRing>> rings;
+	for (size_t i = 0; i < m_stageStats.size(); ++i)
+	{
+		rings.emplace_back(new FrameRing(m_frames.size() + 1));
+	}
+	for (std::unique_ptr<CpuStagedFrame>& frame : m_frames)
+	{
+		Push(*rings[0], frame.get());
+	}
+	m_isStopping = false;
+
+	Clock::time_point start = Clock::now();
+
+	std::vector<std::thread> threads;
+	threads.emplace_back([&]
+	{
+		CpuStageStats& stats = m_stageStats[0];
+		SceneConstants previousConstants = {};
+		for (int frameNumber = 0; frameNumber < frameCount && !m_isStopping; ++frameNumber)
+		{
+			CpuStagedFrame* frame = Pop(*rings[0], stats.waitingSeconds);
+			Clock::time_point busyStart = Clock::now();
+
+			frame->frameNumber = frameNumber;
+			frame->jitter = JitterOffset{};
+			prepare(frameNumber, frame->constants, frame->jitter);
+			frame->isReset = frameNumber == 0;
+
+			// Measuring motion against this frame itself gives no motion.
+			SceneConstants const& previous = frame->isReset ? frame->constants : previousConstants;
+			m_device.RenderScene(frame->constants, previous, renderSize, *frame->color, *frame->depth, isRenderingMotion ? frame->motionVectors.get() : nullptr);
+			frame->rasterizerStats = m_device.GetRasterizerStats();
+			previousConstants = frame->constants;
+
+			stats.busySeconds += SecondsSince(busyStart);
+			++stats.frameCount;
+			Push(*rings[1], frame);
+		}
+		Push(*rings[1], static_cast<CpuStagedFrame*>(nullptr));
+	});
+	for (size_t i = 0; i < middleStages.size(); ++i)
+	{
+		threads.emplace_back([&, i]
+		{
+			RunStage(*rings[i + 1], *rings[i + 2], middleStages[i], m_stageStats[i + 1]);
+		});
+	}
+
+	// The last stage, here. Frames after a stop are only handed back.
+	CpuStageStats& stats = m_stageStats.back();
+	int finishedCount = 0;
+	for (;;)
+	{
+		CpuStagedFrame* frame = Pop(*rings.back(), stats.waitingSeconds);
+		if (!frame)
+		{
+			break;
+		}
+		if (!m_isStopping)
+		{
+			Clock::time_point busyStart = Clock::now();
+			if (finish(*frame))
+			{
+				++finishedCount;
+			}
+			else
+			{
+				m_isStopping = true;
+			}
+			stats.busySeconds += SecondsSince(busyStart);
+			++stats.frameCount;
+		}
+		Push(*rings[0], frame);
+	}
+
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+	m_runSeconds = SecondsSince(start);
+	return finishedCount;
+}
+
+std::string CpuStagedPipeline::GetStageSummary() const
+{
+	char text[128];
+	snprintf(text, sizeof(text), "Stages at queue depth %d:", GetQueueDepth());
+	std::string summary = text;
+	for (size_t i = 0; i < m_stageStats.size(); ++i)
+	{
+		double busy = m_runSeconds > 0.0 ? m_stageStats[i].busySeconds / m_runSeconds : 0.0;
+		snprintf(text, sizeof(text), "%s %s %.1f%% busy", i == 0 ? "" : ",", m_stageStats[i].name, busy * 100.0);
+		summary += text;
+	}
+	return summary;
+}
+
+void CpuStagedPipeline::RunStage(FrameRing& input, FrameRing& output, std::function<void(CpuStagedFrame&)> const& work, CpuStageStats& stats)
+{
+	for (;;)
+	{
+		CpuStagedFrame* frame = Pop(input, stats.waitingSeconds);
+		if (frame)
+		{
+			Clock::time_point busyStart = Clock::now();
+			work(*frame);
+			stats.busySeconds += SecondsSince(busyStart);
+			++stats.frameCount;
+		}
+		Push(output, frame);
+		if (!frame)
+		{
+			return;
+		}
+	}
+}
+
+// Like ScalingPipeline, without history there's nothing to estimate against, and the upscaler is reset.
+void CpuStagedPipeline::EstimateMotion(CpuStagedFrame& frame, RenderSize renderSize)
+{
+	int lumaIndex = 1 - m_previousLumaIndex;
+	m_device.ConvertToLuma(*frame.color, renderSize, *m_luma[lumaIndex]);
+	if (!frame.isReset)
+	{
+		m_device.EstimateMotion(*m_luma[lumaIndex], *m_luma[m_previousLumaIndex], renderSize, *frame.motionVectors);
+	}
+	m_previousLumaIndex = lumaIndex;
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "CpuBackend.h"
+#include "ScalingPipeline.h"
+#include "SpscRing.h"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace scaling
+{
+	// Everything about one frame, which goes from stage to stage.
+	struct CpuStagedFrame
+	{
+		int frameNumber;
+		SceneConstants constants;
+		JitterOffset jitter;
+		bool isReset;	// Nothing came before this frame, so there's no history
+		RasterizerStats rasterizerStats;
+
+		std::unique_ptr<IImage> color;
+		std::unique_ptr<IImage> depth;
+		std::unique_ptr<IImage> motionVectors;
+		std::unique_ptr<IImage> output;
+	};
+
+	struct CpuStageStats
+	{
+		char const* name;
+		int frameCount;
+		double busySeconds;		// Working on frames
+		double waitingSeconds;	// Waiting for a frame from the stage before, or for a free one
+	};
+
+	// ScalingPipeline's passes on the CPU backend, with each stage on a thread of its own so that the stages
+	// overlap across frames: pass 1, then luma conversion and motion estimation when motion is estimated,
+	// then upscaling, and last what the caller does with the finished frame, on the thread that calls Run.
+	// Pass 1 still spreads over the rasterizer's workers.
+	//
+	// Frames go from each stage to the next through SpscRings, and back from the last stage to the first
+	// through one more, which is the free list, so nothing is allocated per frame. The queue depth is how
+	// many frames there are, which bounds how far pass 1 gets ahead of the last stage: with 1 the stages
+	// take turns like ScalingPipeline, and more trades latency for throughput until the slowest stage never
+	// waits. A waiting stage sleeps on its input ring's index, and the push that fills it wakes it.
+	//
+	// The stages' threads, the caller's among them, are on top of the job system's own, which they call
+	// into, so a run with n workers in all gives the job system n - GetThreadCount() + 1.
+	class CpuStagedPipeline
+	{
+	public:
+		CpuStagedPipeline(CpuDevice& device, int queueDepth, int maxRenderWidth, int maxRenderHeight, int outputWidth, int outputHeight);
+
+		// Rendered unless this is called. Only used with temporal upscalers.
+		void SetMotionVectorSource(MotionVectorSource source) { m_motionVectorSource = source; }
+
+		// Fills in a frame's constants and jitter. Called by the first stage, in order.
+		typedef std::function<void(int frameNumber, SceneConstants& constants, JitterOffset& jitter)> PrepareFrame;
+
+		// Takes a finished frame, whose images are only valid during the call. Called by the last stage, in
+		// order. Returns false to stop the run.
+		typedef std::function<bool(CpuStagedFrame const& frame)> FinishFrame;
+
+		// Runs frames 0 to frameCount - 1 through the stages, and returns how many were finished. Only the
+		// upscaling stage uses the upscaler, and no two stages use the same part of the device.
+		int Run(int frameCount, RenderSize renderSize, IUpscaler& upscaler, PrepareFrame const& prepare, FinishFrame const& finish);
+
+		int GetQueueDepth() const { return static_cast<int>(m_frames.size()); }
+
+		// The threads a Run keeps, counting the caller's: one per stage.
+		static int GetThreadCount(bool isEstimatingMotion) { return isEstimatingMotion ? 4 : 3; }
+
+		// For the last Run, with the stages in order.
+		std::vector<CpuStageStats> const& GetStageStats() const { return m_stageStats; }
+		double GetRunSeconds() const { return m_runSeconds; }
+
+		// One line with how much of the last Run each stage was busy. The busiest one limits throughput.
+		std::string GetStageSummary() const;
+
+	private:
+		typedef SpscRing<CpuStagedFrame*> FrameRing;
+
+		// A stage between the first and the last. A null frame ends the run, and is passed on.
+		void RunStage(FrameRing& input, FrameRing& output, std::function<void(CpuStagedFrame&)> const& work, CpuStageStats& stats);
+
+		void EstimateMotion(CpuStagedFrame& frame, RenderSize renderSize);
+
+		CpuDevice& m_device;
+		MotionVectorSource m_motionVectorSource;
+
+		std::vector<std::unique_ptr<CpuStagedFrame>> m_frames;
+
+		// Owned by the motion estimation stage, which keeps the luma of the last frame to estimate against.
+		std::unique_ptr<IImage> m_luma[2];
+		int m_previousLumaIndex;
+
+		// Set by the last stage, to stop the first.
+		std::atomic<bool> m_isStopping;
+
+		std::vector<CpuStageStats> m_stageStats;
+		double m_runSeconds;
+	};
+}
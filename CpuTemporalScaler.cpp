@@ -0,0 +1,202 @@
+#include "CpuTemporalScaler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <emmintrin.h>
+
+using namespace scaling;
+
+namespace
+{
+	// Weight of the current frame once there's history. The rest is history, which so holds about the last
+	// twenty frames' worth of jitter positions.
+	const float c_currentWeight = 0.1f;
+
+	// Rows scaled by each job.
+	const int c_rowsPerJob = 16;
+
+	// A pixel's b, g, r and a as floats, in that order.
+	typedef __m128 Color;
+
+	inline Color Unpack(uint32_t pixel)
+	{
+		__m128i const zero = _mm_setzero_si128();
+		__m128i channels = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(static_cast<int>(pixel)), zero), zero);
+		return _mm_cvtepi32_ps(channels);
+	}
+
+	// Rounds to the nearest level. Opaque, like everything pass 1 draws.
+	inline uint32_t Pack(Color color)
+	{
+		__m128i channels = _mm_cvtps_epi32(color);
+		channels = _mm_packs_epi32(channels, channels);
+		channels = _mm_packus_epi16(channels, channels);
+		return static_cast<uint32_t>(_mm_cvtsi128_si32(channels)) | 0xFF000000;
+	}
+
+	inline Color Load(uint32_t pixel)
+	{
+		return Unpack(pixel);
+	}
+
+	// A pixel of the history, which is already in floats.
+	template<typename THistoryPixel>
+	inline Color Load(THistoryPixel const& pixel)
+	{
+		return _mm_loadu_ps(pixel.channels);
+	}
+
+	inline Color Lerp(Color a, Color b, float weight)
+	{
+		return _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), _mm_set1_ps(weight)));
+	}
+
+	// Bilinear, at (x, y) in pixels with pixel centers at whole numbers, from the width x height top left of
+	// the image. Edges are clamped.
+	template<typename TPixel>
+	Color Sample(CpuImage<TPixel> const& image, int width, int height, float x, float y)
+	{
+		x = std::min(std::max(x, 0.0f), static_cast<float>(width - 1));
+		y = std::min(std::max(y, 0.0f), static_cast<float>(height - 1));
+		int x0 = static_cast<int>(x);
+		int y0 = static_cast<int>(y);
+		int x1 = std::min(x0 + 1, width - 1);
+		int y1 = std::min(y0 + 1, height - 1);
+		float fx = x - x0;
+		float fy = y - y0;
+
+		Color top = Lerp(Load(image.At(x0, y0)), Load(image.At(x1, y0)), fx);
+		Color bottom = Lerp(Load(image.At(x0, y1)), Load(image.At(x1, y1)), fx);
+		return Lerp(top, bottom, fy);
+	}
+
+	inline int ClampIndex(int index, int size)
+	{
+		return std::min(std::max(index, 0), size - 1);
+	}
+
+	// What each render pixel gives the output pixels nearest to it, from the 3x3 pixels around it with edges
+	// clamped. The history is clipped to the box of colors within a standard deviation of their mean, and
+	// inside their range, which lets less of another surface's history through at edges than the range alone.
+	// The motion is that of the nearest of the pixels, so that the edges of what moved move with it.
+	void FindNeighborhoodRows(ImageBgra8 const& color, ImageD32 const& depth, ImageMotionVectors const& motionVectors, RenderSize renderSize,
+		int firstRow, int endRow, ImageBgra8& low, ImageBgra8& high, ImageMotionVectors& nearestMotion)
+	{
+		int width = renderSize.width;
+		int height = renderSize.height;
+		for (int y = firstRow; y < endRow; ++y)
+		{
+			for (int x = 0; x < width; ++x)
+			{
+				Color sum = _mm_setzero_ps();
+				Color sumOfSquares = _mm_setzero_ps();
+				Color lowest = _mm_set1_ps(255.0f);
+				Color highest = _mm_setzero_ps();
+				float nearestDepth = depth.At(x, y);
+				MotionVector motion = motionVectors.At(x, y);
+				for (int dy = -1; dy <= 1; ++dy)
+				{
+					int sampleY = ClampIndex(y + dy, height);
+					for (int dx = -1; dx <= 1; ++dx)
+					{
+						int sampleX = ClampIndex(x + dx, width);
+						Color sample = Unpack(color.At(sampleX, sampleY));
+						sum = _mm_add_ps(sum, sample);
+						sumOfSquares = _mm_add_ps(sumOfSquares, _mm_mul_ps(sample, sample));
+						lowest = _mm_min_ps(lowest, sample);
+						highest = _mm_max_ps(highest, sample);
+						if (depth.At(sampleX, sampleY) < nearestDepth)
+						{
+							nearestDepth = depth.At(sampleX, sampleY);
+							motion = motionVectors.At(sampleX, sampleY);
+						}
+					}
+				}
+
+				Color mean = _mm_mul_ps(sum, _mm_set1_ps(1.0f / 9.0f));
+				Color variance = _mm_sub_ps(_mm_mul_ps(sumOfSquares, _mm_set1_ps(1.0f / 9.0f)), _mm_mul_ps(mean, mean));
+				Color deviation = _mm_sqrt_ps(_mm_max_ps(variance, _mm_setzero_ps()));
+				low.At(x, y) = Pack(_mm_max_ps(lowest, _mm_sub_ps(mean, deviation)));
+				high.At(x, y) = Pack(_mm_min_ps(highest, _mm_add_ps(mean, deviation)));
+				nearestMotion.At(x, y) = motion;
+			}
+		}
+	}
+}
+
+CpuTemporalScaler::CpuTemporalScaler()
+	: m_historyIndex(0)
+{
+}
+
+void CpuTemporalScaler::Upscale(ImageBgra8 const& color, ImageD32 const& depth, ImageMotionVectors const& motionVectors, RenderSize renderSize, JitterOffset jitter, bool reset, ImageBgra8& output, JobSystem* jobs)
+{
+	int outputWidth = output.GetWidth();
+	int outputHeight = output.GetHeight();
+	for (CpuImage<HistoryPixel>& history : m_history)
+	{
+		if (history.GetWidth() != outputWidth || history.GetHeight() != outputHeight)
+		{
+			history.Resize(outputWidth, outputHeight);
+			reset = true;
+		}
+	}
+
+	// Found once per render pixel rather than once per output pixel.
+	m_neighborhoodLow.Resize(renderSize.width, renderSize.height);
+	m_neighborhoodHigh.Resize(renderSize.width, renderSize.height);
+	m_nearestMotion.Resize(renderSize.width, renderSize.height);
+	if (!reset)
+	{
+		ForEachTile(jobs, renderSize.width, renderSize.height, renderSize.width, c_rowsPerJob, [&](Tile const& rows, int)
+		{
+			FindNeighborhoodRows(color, depth, motionVectors, renderSize, rows.y, rows.y + rows.height, m_neighborhoodLow, m_neighborhoodHigh, m_nearestMotion);
+		});
+	}
+
+	CpuImage<HistoryPixel> const& previous = m_history[m_historyIndex];
+	CpuImage<HistoryPixel>& next = m_history[1 - m_historyIndex];
+
+	float scaleX = static_cast<float>(renderSize.width) / outputWidth;
+	float scaleY = static_cast<float>(renderSize.height) / outputHeight;
+
+	ForEachTile(jobs, outputWidth, outputHeight, outputWidth, c_rowsPerJob, [&](Tile const& rows, int)
+	{
+		for (int y = rows.y; y < rows.y + rows.height; ++y)
+		{
+			// Where the output pixel is among the render pixels, each of which sampled at its center plus the jitter.
+			float renderY = (y + 0.5f) * scaleY - 0.5f - jitter.y;
+			int nearestY = ClampIndex(static_cast<int>(std::floor(renderY + 0.5f)), renderSize.height);
+
+			uint32_t* outputRow = output.GetRow(y);
+			HistoryPixel* nextRow = next.GetRow(y);
+			for (int x = 0; x < outputWidth; ++x)
+			{
+				float renderX = (x + 0.5f) * scaleX - 0.5f - jitter.x;
+				int nearestX = ClampIndex(static_cast<int>(std::floor(renderX + 0.5f)), renderSize.width);
+				Color current = Sample(color, renderSize.width, renderSize.height, renderX, renderY);
+
+				// Motion vectors are in quarter render pixels, and point to where the content was last frame.
+				MotionVector motion = reset ? MotionVector{ 0, 0 } : m_nearestMotion.At(nearestX, nearestY);
+				float historyX = x + motion.x * 0.25f / scaleX;
+				float historyY = y + motion.y * 0.25f / scaleY;
+				bool isHistoryOnScreen = historyX > -0.5f && historyX < outputWidth - 0.5f && historyY > -0.5f && historyY < outputHeight - 0.5f;
+
+				Color blended = current;
+				if (!reset && isHistoryOnScreen)
+				{
+					Color low = Unpack(m_neighborhoodLow.At(nearestX, nearestY));
+					Color high = Unpack(m_neighborhoodHigh.At(nearestX, nearestY));
+					Color history = Sample(previous, outputWidth, outputHeight, historyX, historyY);
+					history = _mm_min_ps(_mm_max_ps(history, low), high);
+					blended = Lerp(history, current, c_currentWeight);
+				}
+
+				outputRow[x] = Pack(blended);
+				_mm_storeu_ps(nextRow[x].channels, blended);
+			}
+		}
+	});
+
+	m_historyIndex = 1 - m_historyIndex;
+}
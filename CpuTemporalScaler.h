@@ -0,0 +1,45 @@
+#pragma once
+
+#include "CpuImage.h"
+#include "JitterSequence.h"
+#include "JobSystem.h"
+#include "QualityPreset.h"
+
+namespace scaling
+{
+	// Reference temporal upscaling, to run the temporal paths on the CPU: motion vectors, jitter and history.
+	// Each output pixel blends the current frame, sampled where its jittered render pixels landed, into the
+	// history reprojected along the motion vectors. The history is first clipped to the colors around the
+	// pixel in the current frame, so that what moved away or came into view doesn't leave ghosts behind.
+	//
+	// The history is a ping-ponged pair of output-sized images: each frame reads one and writes the other
+	// along with the output, so nothing is copied. It's kept in floats and only the output is rounded to
+	// 8 bits, since with a tenth of each frame blended in, history rounded every frame would stop short of
+	// a color it's within 5 levels of.
+	class CpuTemporalScaler
+	{
+	public:
+		CpuTemporalScaler();
+
+		// Scales the renderSize sub-rect of color up to the size of output, reprojecting the history with the
+		// motion of the nearest surface around each pixel by depth. With reset, or when the output size
+		// changed, starts the history over from this frame alone. Bands of rows are scaled in parallel
+		// when there's a job system, with the same result.
+		void Upscale(ImageBgra8 const& color, ImageD32 const& depth, ImageMotionVectors const& motionVectors, RenderSize renderSize, JitterOffset jitter, bool reset, ImageBgra8& output, JobSystem* jobs = nullptr);
+
+	private:
+		// b, g, r and a, from 0 to 255.
+		struct HistoryPixel
+		{
+			float channels[4];
+		};
+
+		CpuImage<HistoryPixel> m_history[2];
+		int m_historyIndex;	// The one holding the last frame
+
+		// Per render pixel: the box the history is clipped to, and the motion to reproject it with.
+		ImageBgra8 m_neighborhoodLow;
+		ImageBgra8 m_neighborhoodHigh;
+		ImageMotionVectors m_nearestMotion;
+	};
+}
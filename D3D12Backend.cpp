@@ -0,0 +1,1425 @@
+#include "pch.h"
+
+#include "D3D12Backend.h"
+
+#include "DirectXHelper.h"
+
+#include "Pass1VS.h"
+#include "Pass1PS.h"
+#include "Pass2_RgbToYuvCS.h"
+
+using namespace scaling;
+
+using namespace DirectX;
+using namespace Microsoft::WRL;
+
+// Same as the clear color of the swap chain.
+static const float c_clearColor[] = { 0.3f, 0.58f, 0.93f, 1.0f };
+static const float c_noMotion[] = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+// The states a resource can be in several of at once.
+static const uint32_t c_readStates = D3D12_RESOURCE_STATE_GENERIC_READ | D3D12_RESOURCE_STATE_DEPTH_READ | D3D12_RESOURCE_STATE_RESOLVE_SOURCE;
+
+static D3D12_RESOURCE_BARRIER_FLAGS ToBarrierFlags(BarrierPart part)
+{
+	switch (part)
+	{
+	case BarrierPart::Begin: return D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY;
+	case BarrierPart::End: return D3D12_RESOURCE_BARRIER_FLAG_END_ONLY;
+	default: return D3D12_RESOURCE_BARRIER_FLAG_NONE;
+	}
+}
+
+// HLSL reads the matrices column-major.
+static XMFLOAT4X4 ToShaderMatrix(Float4x4 const& matrix)
+{
+	XMFLOAT4X4 result;
+	for (int row = 0; row < 4; ++row)
+	{
+		for (int column = 0; column < 4; ++column)
+		{
+			result.m[row][column] = matrix.m[column][row];
+		}
+	}
+	return result;
+}
+
+static NVSDK_NGX_PerfQuality_Value ToDlssPerfQuality(QualityPreset preset)
+{
+	switch (preset)
+	{
+	case QualityPreset::Performance: return NVSDK_NGX_PerfQuality_Value_MaxPerf;
+	case QualityPreset::Balanced: return NVSDK_NGX_PerfQuality_Value_Balanced;
+	case QualityPreset::Quality: return NVSDK_NGX_PerfQuality_Value_MaxQuality;
+	default: return NVSDK_NGX_PerfQuality_Value_UltraQuality;
+	}
+}
+
+static xess_quality_settings_t ToXessQuality(QualityPreset preset)
+{
+	switch (preset)
+	{
+	case QualityPreset::Performance: return XESS_QUALITY_SETTING_PERFORMANCE;
+	case QualityPreset::Balanced: return XESS_QUALITY_SETTING_BALANCED;
+	case QualityPreset::Quality: return XESS_QUALITY_SETTING_QUALITY;
+	default: return XESS_QUALITY_SETTING_ULTRA_QUALITY;
+	}
+}
+
+D3D12Fence::D3D12Fence(ID3D12Device* device)
+	: m_event(nullptr)
+{
+	DX::ThrowIfFailed(device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_fence)));
+	CreateCompletionEvent();
+}
+
+D3D12Fence::D3D12Fence(ComPtr<ID3D12Fence> const& fence)
+	: m_fence(fence)
+	, m_event(nullptr)
+{
+	CreateCompletionEvent();
+}
+
+D3D12Fence::~D3D12Fence()
+{
+	CloseHandle(m_event);
+}
+
+uint64_t D3D12Fence::GetCompletedValue() const
+{
+	return m_fence->GetCompletedValue();
+}
+
+void D3D12Fence::WaitOnCpu(uint64_t value)
+{
+	DX::ThrowIfFailed(m_fence->SetEventOnCompletion(value, m_event));
+	WaitForSingleObjectEx(m_event, INFINITE, FALSE);
+}
+
+void D3D12Fence::CreateCompletionEvent()
+{
+	m_event = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+	if (m_event == nullptr)
+	{
+		DX::ThrowIfFailed(HRESULT_FROM_WIN32(GetLastError()));
+	}
+}
+
+void D3D12Queue::Signal(IGpuFence& fence, uint64_t value)
+{
+	DX::ThrowIfFailed(m_queue->Signal(static_cast<D3D12Fence&>(fence).GetFence(), value));
+}
+
+void D3D12Queue::Wait(IGpuFence& fence, uint64_t value)
+{
+	DX::ThrowIfFailed(m_queue->Wait(static_cast<D3D12Fence&>(fence).GetFence(), value));
+}
+
+D3D12Image::D3D12Image(ImageFormat format, int width, int height, ComPtr<ID3D12Resource> const& resource, D3D12_RESOURCE_STATES restingState)
+	: m_format(format)
+	, m_width(width)
+	, m_height(height)
+	, m_resource(resource)
+	, m_restingState(restingState)
+	, m_targetView{}
+	, m_srvDescriptorIndex(0)
+	, m_uavTableDescriptorIndex(0)
+	, m_uavTableSource(nullptr)
+{
+}
+
+D3D12Device::D3D12Device(std::shared_ptr<DX::DeviceResources> const& deviceResources)
+	: m_deviceResources(deviceResources)
+	, m_cbvDescriptorSize(0)
+	, m_nextDescriptorIndex(DX::c_frameCount)
+	, m_rtvDescriptorSize(0)
+	, m_dsvDescriptorSize(0)
+	, m_rtvCount(0)
+	, m_dsvCount(0)
+	, m_mappedConstantBuffer(nullptr)
+	, m_meshVertexBufferView{}
+	, m_meshIndexBufferView{}
+	, m_isMeshUploadPending(false)
+	, m_meshUploadFrameIndex(0)
+	, m_instanceCount(0)
+	, m_isInstanceUploadPending(false)
+	, m_isMotionEstimationSupported(false)
+	, m_motionEstimatorWidth(0)
+	, m_motionEstimatorHeight(0)
+	, m_resourceStates(c_readStates)
+{
+	auto d3dDevice = m_deviceResources->GetD3DDevice();
+
+	// Create command lists
+	DX::ThrowIfFailed(d3dDevice->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, m_deviceResources->GetDirectCommandAllocator(), nullptr, IID_PPV_ARGS(&m_commandList)));
+	NAME_D3D12_OBJECT(m_commandList);
+
+	if (m_deviceResources->GetVideoQueue())
+	{
+		DX::ThrowIfFailed(d3dDevice->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_VIDEO_ENCODE, m_deviceResources->GetVideoEncodeCommandAllocator(), nullptr, IID_PPV_ARGS(&m_videoEncodeCommandList)));
+		NAME_D3D12_OBJECT(m_videoEncodeCommandList);
+		DX::ThrowIfFailed(m_videoEncodeCommandList->Close());
+	}
+
+	if (m_videoEncodeCommandList && SUCCEEDED(d3dDevice->QueryInterface(IID_PPV_ARGS(&m_videoDevice))))
+	{
+		D3D12_FEATURE_DATA_VIDEO_MOTION_ESTIMATOR motionEstimatorSupport = { 0u, DXGI_FORMAT_NV12 };
+		if (SUCCEEDED(m_videoDevice->CheckFeatureSupport(D3D12_FEATURE_VIDEO_MOTION_ESTIMATOR, &motionEstimatorSupport, sizeof(motionEstimatorSupport))))
+		{
+			m_isMotionEstimationSupported = true;
+		}
+	}
+
+	if (m_isMotionEstimationSupported)
+	{
+		m_directQueue = std::make_unique<D3D12Queue>(m_deviceResources->GetCommandQueue());
+		m_videoQueue = std::make_unique<D3D12Queue>(m_deviceResources->GetVideoQueue());
+		m_directFence = std::make_unique<D3D12Fence>(d3dDevice);
+		m_videoFence = std::make_unique<D3D12Fence>(d3dDevice);
+		m_videoSchedule = std::make_unique<VideoQueueSchedule>(*m_directQueue, *m_directFence, *m_videoQueue, *m_videoFence, DX::c_frameCount);
+	}
+
+	CreateRootSignatures();
+	CreatePipelineStates();
+	CreateDescriptorHeaps();
+	CreateConstantBuffers();
+	SetSceneMesh(GetMeshView(CreateCubeMesh()));
+	SetSceneInstances(CreateInstancedScene(1));
+}
+
+D3D12Device::~D3D12Device()
+{
+	if (m_videoSchedule)
+	{
+		m_videoSchedule->WaitForVideoWork();
+	}
+
+	m_constantBuffer->Unmap(0, nullptr);
+	m_mappedConstantBuffer = nullptr;
+}
+
+void D3D12Device::CreateRootSignatures()
+{
+	auto d3dDevice = m_deviceResources->GetD3DDevice();
+
+	// Graphics root sig
+	{
+		CD3DX12_DESCRIPTOR_RANGE ranges[2];
+		CD3DX12_ROOT_PARAMETER parameters[4];
+
+		{
+			UINT numDescriptors = 1; // the current frame's constant buffer
+			UINT baseShaderRegister = 0;
+			ranges[0].Init(D3D12_DESCRIPTOR_RANGE_TYPE_CBV, numDescriptors, baseShaderRegister);
+			parameters[0].InitAsDescriptorTable(1, &ranges[0], D3D12_SHADER_VISIBILITY_ALL);
+		}
+		{
+			UINT num32BitValues = sizeof(DrawConstants) / sizeof(UINT);
+			UINT shaderRegister = 3;
+			UINT registerSpace = 0u;
+			parameters[1].InitAsConstants(num32BitValues, shaderRegister, registerSpace, D3D12_SHADER_VISIBILITY_ALL);
+		}
+		{
+			UINT numDescriptors = 1; // the texture read by pass 2
+			UINT baseShaderRegister = 0;
+			ranges[1].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, numDescriptors, baseShaderRegister);
+			parameters[2].InitAsDescriptorTable(1, &ranges[1], D3D12_SHADER_VISIBILITY_PIXEL);
+		}
+		{
+			UINT shaderRegister = 1; // the instances drawn by pass 1
+			parameters[3].InitAsShaderResourceView(shaderRegister, 0, D3D12_SHADER_VISIBILITY_VERTEX);
+		}
+
+		D3D12_ROOT_SIGNATURE_FLAGS rootSignatureFlags =
+			D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT | // Only the input assembler stage needs access to the constant buffer.
+			D3D12_ROOT_SIGNATURE_FLAG_DENY_DOMAIN_SHADER_ROOT_ACCESS |
+			D3D12_ROOT_SIGNATURE_FLAG_DENY_GEOMETRY_SHADER_ROOT_ACCESS |
+			D3D12_ROOT_SIGNATURE_FLAG_DENY_HULL_SHADER_ROOT_ACCESS;
+
+		D3D12_STATIC_SAMPLER_DESC samplers[2] = {};
+		{
+			samplers[0].Filter = D3D12_FILTER_MIN_MAG_MIP_POINT;
+			samplers[0].AddressU = D3D12_TEXTURE_ADDRESS_MODE_BORDER;
+			samplers[0].AddressV = D3D12_TEXTURE_ADDRESS_MODE_BORDER;
+			samplers[0].AddressW = D3D12_TEXTURE_ADDRESS_MODE_BORDER;
+			samplers[0].MipLODBias = 0;
+			samplers[0].MaxAnisotropy = 0;
+			samplers[0].ComparisonFunc = D3D12_COMPARISON_FUNC_NEVER;
+			samplers[0].BorderColor = D3D12_STATIC_BORDER_COLOR_TRANSPARENT_BLACK;
+			samplers[0].MinLOD = 0.0f;
+			samplers[0].MaxLOD = D3D12_FLOAT32_MAX;
+			samplers[0].ShaderRegister = 0;
+			samplers[0].RegisterSpace = 0;
+			samplers[0].ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;
+		}
+		{
+			samplers[1].Filter = D3D12_FILTER_MIN_MAG_MIP_LINEAR;
+			samplers[1].AddressU = D3D12_TEXTURE_ADDRESS_MODE_BORDER;
+			samplers[1].AddressV = D3D12_TEXTURE_ADDRESS_MODE_BORDER;
+			samplers[1].AddressW = D3D12_TEXTURE_ADDRESS_MODE_BORDER;
+			samplers[1].MipLODBias = 0;
+			samplers[1].MaxAnisotropy = 0;
+			samplers[1].ComparisonFunc = D3D12_COMPARISON_FUNC_NEVER;
+			samplers[1].BorderColor = D3D12_STATIC_BORDER_COLOR_TRANSPARENT_BLACK;
+			samplers[1].MinLOD = 0.0f;
+			samplers[1].MaxLOD = D3D12_FLOAT32_MAX;
+			samplers[1].ShaderRegister = 1;
+			samplers[1].RegisterSpace = 0;
+			samplers[1].ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;
+		}
+
+		CD3DX12_ROOT_SIGNATURE_DESC descRootSignature;
+		descRootSignature.Init(_countof(parameters), parameters, _countof(samplers), samplers, rootSignatureFlags);
+
+		ComPtr<ID3DBlob> pSignature;
+		ComPtr<ID3DBlob> pError;
+
+		HRESULT serializeRootSignatureHR = D3D12SerializeRootSignature(&descRootSignature, D3D_ROOT_SIGNATURE_VERSION_1, pSignature.GetAddressOf(), pError.GetAddressOf());
+		if (FAILED(serializeRootSignatureHR))
+		{
+			OutputDebugStringA(reinterpret_cast<char*>(pError->GetBufferPointer()));
+			_com_issue_error(serializeRootSignatureHR);
+		}
+		DX::ThrowIfFailed(d3dDevice->CreateRootSignature(0, pSignature->GetBufferPointer(), pSignature->GetBufferSize(), IID_PPV_ARGS(&m_commonGraphicsRootSignature)));
+		NAME_D3D12_OBJECT(m_commonGraphicsRootSignature);
+	}
+
+	// Compute root sig
+	{
+		CD3DX12_DESCRIPTOR_RANGE ranges[1];
+		CD3DX12_ROOT_PARAMETER parameters[2];
+
+		UINT descriptorCount = 3;
+		ranges[0].Init(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, descriptorCount, 0);
+
+		parameters[0].InitAsDescriptorTable(_countof(ranges), ranges);
+		parameters[1].InitAsConstants(2, 0);
+
+		D3D12_ROOT_SIGNATURE_FLAGS rootSignatureFlags = D3D12_ROOT_SIGNATURE_FLAG_DENY_VERTEX_SHADER_ROOT_ACCESS;
+
+		CD3DX12_ROOT_SIGNATURE_DESC descRootSignature;
+		descRootSignature.Init(_countof(parameters), parameters, 0, nullptr, rootSignatureFlags);
+
+		ComPtr<ID3DBlob> pSignature;
+		ComPtr<ID3DBlob> pError;
+
+		HRESULT serializeRootSignatureHR = D3D12SerializeRootSignature(&descRootSignature, D3D_ROOT_SIGNATURE_VERSION_1, pSignature.GetAddressOf(), pError.GetAddressOf());
+		if (FAILED(serializeRootSignatureHR))
+		{
+			OutputDebugStringA(reinterpret_cast<char*>(pError->GetBufferPointer()));
+			_com_issue_error(serializeRootSignatureHR);
+		}
+		DX::ThrowIfFailed(d3dDevice->CreateRootSignature(0, pSignature->GetBufferPointer(), pSignature->GetBufferSize(), IID_PPV_ARGS(&m_commonComputeRootSignature)));
+		NAME_D3D12_OBJECT(m_commonComputeRootSignature);
+	}
+}
+
+void D3D12Device::CreatePipelineStates()
+{
+	auto d3dDevice = m_deviceResources->GetD3DDevice();
+
+	{
+		static const D3D12_INPUT_ELEMENT_DESC inputLayout[] =
+		{
+			{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, offsetof(SceneVertex, position), D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+			{ "COLOR", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, offsetof(SceneVertex, color), D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+		};
+
+		// The same shaders either way; without the motion vector target, the pixel shader's second output is
+		// discarded.
+		D3D12_GRAPHICS_PIPELINE_STATE_DESC state = {};
+		state.InputLayout = { inputLayout, _countof(inputLayout) };
+		state.pRootSignature = m_commonGraphicsRootSignature.Get();
+		state.VS = CD3DX12_SHADER_BYTECODE((void*)(g_Pass1VS), _countof(g_Pass1VS));
+		state.PS = CD3DX12_SHADER_BYTECODE((void*)(g_Pass1PS), _countof(g_Pass1PS));
+		state.RasterizerState = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
+		state.BlendState = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
+		state.DepthStencilState = CD3DX12_DEPTH_STENCIL_DESC(D3D12_DEFAULT);
+		state.SampleMask = UINT_MAX;
+		state.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+		state.NumRenderTargets = 1;
+		state.RTVFormats[0] = DXGI_FORMAT_B8G8R8A8_UNORM;
+		state.DSVFormat = DXGI_FORMAT_D32_FLOAT;
+		state.SampleDesc.Count = 1;
+
+		DX::ThrowIfFailed(d3dDevice->CreateGraphicsPipelineState(&state, IID_PPV_ARGS(&m_pass1PipelineState)));
+
+		state.NumRenderTargets = 2;
+		state.RTVFormats[1] = DXGI_FORMAT_R16G16_SINT;
+		DX::ThrowIfFailed(d3dDevice->CreateGraphicsPipelineState(&state, IID_PPV_ARGS(&m_pass1MotionPipelineState)));
+	}
+	{
+		D3D12_COMPUTE_PIPELINE_STATE_DESC pipelineStateDesc{};
+		pipelineStateDesc.pRootSignature = m_commonComputeRootSignature.Get();
+		pipelineStateDesc.CS = CD3DX12_SHADER_BYTECODE((void*)(g_Pass2_RgbToYuvCS), _countof(g_Pass2_RgbToYuvCS));
+		DX::ThrowIfFailed(d3dDevice->CreateComputePipelineState(&pipelineStateDesc, IID_PPV_ARGS(&m_pass2_YuvConversion_PipelineState)));
+	}
+}
+
+void D3D12Device::CreateDescriptorHeaps()
+{
+	auto d3dDevice = m_deviceResources->GetD3DDevice();
+
+	{
+		D3D12_DESCRIPTOR_HEAP_DESC heapDesc = {};
+		heapDesc.NumDescriptors = c_descriptorCapacity;
+		heapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+		// This flag indicates that this descriptor heap can be bound to the pipeline and that descriptors contained in it can be referenced by a root table.
+		heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+		DX::ThrowIfFailed(d3dDevice->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(&m_cbvSrvHeap)));
+		NAME_D3D12_OBJECT(m_cbvSrvHeap);
+
+		m_cbvDescriptorSize = d3dDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+	}
+	{
+		D3D12_DESCRIPTOR_HEAP_DESC heapDesc = {};
+		heapDesc.NumDescriptors = c_targetViewCapacity;
+		heapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
+		DX::ThrowIfFailed(d3dDevice->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(&m_rtvHeap)));
+		NAME_D3D12_OBJECT(m_rtvHeap);
+
+		m_rtvDescriptorSize = d3dDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
+	}
+	{
+		D3D12_DESCRIPTOR_HEAP_DESC heapDesc = {};
+		heapDesc.NumDescriptors = c_targetViewCapacity;
+		heapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_DSV;
+		DX::ThrowIfFailed(d3dDevice->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(&m_dsvHeap)));
+		NAME_D3D12_OBJECT(m_dsvHeap);
+
+		m_dsvDescriptorSize = d3dDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_DSV);
+	}
+}
+
+// One constant buffer per frame in flight, each with a view at the start of the descriptor heap.
+void D3D12Device::CreateConstantBuffers()
+{
+	auto d3dDevice = m_deviceResources->GetD3DDevice();
+
+	CD3DX12_HEAP_PROPERTIES uploadHeapProperties(D3D12_HEAP_TYPE_UPLOAD);
+	CD3DX12_RESOURCE_DESC constantBufferDesc = CD3DX12_RESOURCE_DESC::Buffer(DX::c_frameCount * c_alignedConstantBufferSize);
+	DX::ThrowIfFailed(d3dDevice->CreateCommittedResource(
+		&uploadHeapProperties,
+		D3D12_HEAP_FLAG_NONE,
+		&constantBufferDesc,
+		D3D12_RESOURCE_STATE_GENERIC_READ,
+		nullptr,
+		IID_PPV_ARGS(&m_constantBuffer)));
+	NAME_D3D12_OBJECT(m_constantBuffer);
+
+	D3D12_GPU_VIRTUAL_ADDRESS cbvGpuAddress = m_constantBuffer->GetGPUVirtualAddress();
+	for (UINT n = 0; n < DX::c_frameCount; n++)
+	{
+		D3D12_CONSTANT_BUFFER_VIEW_DESC desc;
+		desc.BufferLocation = cbvGpuAddress;
+		desc.SizeInBytes = c_alignedConstantBufferSize;
+		d3dDevice->CreateConstantBufferView(&desc, GetCpuDescriptor(n));
+
+		cbvGpuAddress += desc.SizeInBytes;
+	}
+
+	// Map the constant buffers.
+	CD3DX12_RANGE readRange(0, 0);		// We do not intend to read from this resource on the CPU.
+	DX::ThrowIfFailed(m_constantBuffer->Map(0, &readRange, reinterpret_cast<void**>(&m_mappedConstantBuffer)));
+	ZeroMemory(m_mappedConstantBuffer, DX::c_frameCount * c_alignedConstantBufferSize);
+	// We don't unmap this until the app closes. Keeping things mapped for the lifetime of the resource is okay.
+}
+
+void D3D12Device::FinishUploads()
+{
+	// Close the command list and execute it to begin the copies into the GPU's default heap.
+	FlushBarriers();
+	DX::ThrowIfFailed(m_commandList->Close());
+	ID3D12CommandList* ppCommandLists[] = { m_commandList.Get() };
+	m_deviceResources->GetCommandQueue()->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
+
+	// Wait for the command list to finish executing; the owner's buffers need to be uploaded to the GPU before its upload resources are released.
+	m_deviceResources->WaitForGpuOnDirectQueue();
+}
+
+// Created the first time motion is estimated, since that's when the size of the images is known.
+void D3D12Device::CreateMotionEstimator(int width, int height)
+{
+	m_videoSchedule->WaitForVideoWork();
+	m_videoMotionEstimator.Reset();
+	m_videoMotionVectorHeap.Reset();
+
+	UINT videoWidth = static_cast<UINT>(width);
+	UINT videoHeight = static_cast<UINT>(height);
+
+	D3D12_VIDEO_MOTION_ESTIMATOR_DESC motionEstimatorDesc = {
+		0, //NodeIndex
+		DXGI_FORMAT_NV12,
+		D3D12_VIDEO_MOTION_ESTIMATOR_SEARCH_BLOCK_SIZE_16X16,
+		D3D12_VIDEO_MOTION_ESTIMATOR_VECTOR_PRECISION_QUARTER_PEL,
+		{videoWidth, videoHeight, videoWidth, videoHeight} // D3D12_VIDEO_SIZE_RANGE
+	};
+
+	DX::ThrowIfFailed(m_videoDevice->CreateVideoMotionEstimator(
+		&motionEstimatorDesc,
+		nullptr,
+		IID_PPV_ARGS(&m_videoMotionEstimator)));
+
+	D3D12_VIDEO_MOTION_VECTOR_HEAP_DESC motionVectorHeapDesc = {
+		0, // NodeIndex
+		DXGI_FORMAT_NV12,
+		D3D12_VIDEO_MOTION_ESTIMATOR_SEARCH_BLOCK_SIZE_16X16,
+		D3D12_VIDEO_MOTION_ESTIMATOR_VECTOR_PRECISION_QUARTER_PEL,
+		{videoWidth, videoHeight, videoWidth, videoHeight} // D3D12_VIDEO_SIZE_RANGE
+	};
+
+	DX::ThrowIfFailed(m_videoDevice->CreateVideoMotionVectorHeap(
+		&motionVectorHeapDesc,
+		nullptr,
+		IID_PPV_ARGS(&m_videoMotionVectorHeap)));
+
+	m_motionEstimatorWidth = width;
+	m_motionEstimatorHeight = height;
+}
+
+// The vertices and indices share one upload buffer, which is filled with a copy from wherever the mesh is,
+// such as a mapped mesh file. That copy is the only pass over the mesh on the CPU.
+void D3D12Device::SetSceneMesh(SceneMeshView const& mesh)
+{
+	m_deviceResources->WaitForGpuOnDirectQueue();
+
+	auto d3dDevice = m_deviceResources->GetD3DDevice();
+
+	CD3DX12_HEAP_PROPERTIES uploadHeapProperties(D3D12_HEAP_TYPE_UPLOAD);
+	CD3DX12_HEAP_PROPERTIES defaultHeapProperties(D3D12_HEAP_TYPE_DEFAULT);
+
+	const UINT64 vertexBufferSize = mesh.vertexCount * sizeof(SceneVertex);
+	const UINT64 indexBufferSize = mesh.indexCount * sizeof(uint16_t);
+	const UINT64 indexUploadOffset = (vertexBufferSize + 255) & ~255ull;
+
+	m_resourceStates.Forget(m_meshVertexBuffer.Get());
+	m_resourceStates.Forget(m_meshIndexBuffer.Get());
+
+	CD3DX12_RESOURCE_DESC vertexBufferDesc = CD3DX12_RESOURCE_DESC::Buffer(vertexBufferSize);
+	DX::ThrowIfFailed(d3dDevice->CreateCommittedResource(
+		&defaultHeapProperties,
+		D3D12_HEAP_FLAG_NONE,
+		&vertexBufferDesc,
+		D3D12_RESOURCE_STATE_COPY_DEST,
+		nullptr,
+		IID_PPV_ARGS(&m_meshVertexBuffer)));
+	NAME_D3D12_OBJECT(m_meshVertexBuffer);
+
+	CD3DX12_RESOURCE_DESC indexBufferDesc = CD3DX12_RESOURCE_DESC::Buffer(indexBufferSize);
+	DX::ThrowIfFailed(d3dDevice->CreateCommittedResource(
+		&defaultHeapProperties,
+		D3D12_HEAP_FLAG_NONE,
+		&indexBufferDesc,
+		D3D12_RESOURCE_STATE_COPY_DEST,
+		nullptr,
+		IID_PPV_ARGS(&m_meshIndexBuffer)));
+	NAME_D3D12_OBJECT(m_meshIndexBuffer);
+
+	m_resourceStates.SetState(m_meshVertexBuffer.Get(), D3D12_RESOURCE_STATE_COPY_DEST);
+	m_resourceStates.SetState(m_meshIndexBuffer.Get(), D3D12_RESOURCE_STATE_COPY_DEST);
+
+	CD3DX12_RESOURCE_DESC uploadBufferDesc = CD3DX12_RESOURCE_DESC::Buffer(indexUploadOffset + indexBufferSize);
+	DX::ThrowIfFailed(d3dDevice->CreateCommittedResource(
+		&uploadHeapProperties,
+		D3D12_HEAP_FLAG_NONE,
+		&uploadBufferDesc,
+		D3D12_RESOURCE_STATE_GENERIC_READ,
+		nullptr,
+		IID_PPV_ARGS(&m_meshUpload)));
+
+	UINT8* mappedUpload = nullptr;
+	CD3DX12_RANGE readRange(0, 0);
+	DX::ThrowIfFailed(m_meshUpload->Map(0, &readRange, reinterpret_cast<void**>(&mappedUpload)));
+	memcpy(mappedUpload, mesh.vertices, static_cast<size_t>(vertexBufferSize));
+	memcpy(mappedUpload + indexUploadOffset, mesh.indices, static_cast<size_t>(indexBufferSize));
+	m_meshUpload->Unmap(0, nullptr);
+
+	m_meshVertexBufferView.BufferLocation = m_meshVertexBuffer->GetGPUVirtualAddress();
+	m_meshVertexBufferView.StrideInBytes = sizeof(SceneVertex);
+	m_meshVertexBufferView.SizeInBytes = static_cast<UINT>(vertexBufferSize);
+
+	m_meshIndexBufferView.BufferLocation = m_meshIndexBuffer->GetGPUVirtualAddress();
+	m_meshIndexBufferView.SizeInBytes = static_cast<UINT>(indexBufferSize);
+	m_meshIndexBufferView.Format = DXGI_FORMAT_R16_UINT;
+
+	m_meshChunks.assign(mesh.chunks, mesh.chunks + mesh.chunkCount);
+	m_isMeshUploadPending = true;
+}
+
+void D3D12Device::SetSceneInstances(std::vector<SceneInstance> const& instances)
+{
+	m_deviceResources->WaitForGpuOnDirectQueue();
+
+	auto d3dDevice = m_deviceResources->GetD3DDevice();
+
+	CD3DX12_HEAP_PROPERTIES uploadHeapProperties(D3D12_HEAP_TYPE_UPLOAD);
+	CD3DX12_HEAP_PROPERTIES defaultHeapProperties(D3D12_HEAP_TYPE_DEFAULT);
+
+	const UINT instanceBufferSize = static_cast<UINT>(instances.size() * sizeof(SceneInstance));
+	CD3DX12_RESOURCE_DESC instanceBufferDesc = CD3DX12_RESOURCE_DESC::Buffer(instanceBufferSize);
+
+	m_resourceStates.Forget(m_instanceBuffer.Get());
+
+	DX::ThrowIfFailed(d3dDevice->CreateCommittedResource(
+		&defaultHeapProperties,
+		D3D12_HEAP_FLAG_NONE,
+		&instanceBufferDesc,
+		D3D12_RESOURCE_STATE_COPY_DEST,
+		nullptr,
+		IID_PPV_ARGS(&m_instanceBuffer)));
+	NAME_D3D12_OBJECT(m_instanceBuffer);
+	m_resourceStates.SetState(m_instanceBuffer.Get(), D3D12_RESOURCE_STATE_COPY_DEST);
+
+	DX::ThrowIfFailed(d3dDevice->CreateCommittedResource(
+		&uploadHeapProperties,
+		D3D12_HEAP_FLAG_NONE,
+		&instanceBufferDesc,
+		D3D12_RESOURCE_STATE_GENERIC_READ,
+		nullptr,
+		IID_PPV_ARGS(&m_instanceBufferUpload)));
+
+	UINT8* mappedUpload = nullptr;
+	CD3DX12_RANGE readRange(0, 0);
+	DX::ThrowIfFailed(m_instanceBufferUpload->Map(0, &readRange, reinterpret_cast<void**>(&mappedUpload)));
+	memcpy(mappedUpload, instances.data(), instanceBufferSize);
+	m_instanceBufferUpload->Unmap(0, nullptr);
+
+	m_instanceCount = static_cast<UINT>(instances.size());
+	m_isInstanceUploadPending = true;
+}
+
+UINT D3D12Device::AllocateDescriptors(UINT count)
+{
+	if (m_nextDescriptorIndex + count > c_descriptorCapacity)
+	{
+		_com_issue_error(E_OUTOFMEMORY);
+	}
+
+	UINT index = m_nextDescriptorIndex;
+	m_nextDescriptorIndex += count;
+	return index;
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE D3D12Device::GetCpuDescriptor(UINT index) const
+{
+	return CD3DX12_CPU_DESCRIPTOR_HANDLE(m_cbvSrvHeap->GetCPUDescriptorHandleForHeapStart(), index, m_cbvDescriptorSize);
+}
+
+D3D12_GPU_DESCRIPTOR_HANDLE D3D12Device::GetGpuDescriptor(UINT index) const
+{
+	return CD3DX12_GPU_DESCRIPTOR_HANDLE(m_cbvSrvHeap->GetGPUDescriptorHandleForHeapStart(), index, m_cbvDescriptorSize);
+}
+
+static CD3DX12_RESOURCE_DESC GetImageResourceDesc(ImageFormat format, int width, int height)
+{
+	DXGI_FORMAT dxgiFormat = DXGI_FORMAT_UNKNOWN;
+	D3D12_RESOURCE_FLAGS flags = D3D12_RESOURCE_FLAG_NONE;
+
+	switch (format)
+	{
+	case ImageFormat::Bgra8:
+		// Rendered to by pass 1, read as a UAV by the YUV conversion, and written as a UAV by upscalers.
+		dxgiFormat = DXGI_FORMAT_B8G8R8A8_UNORM;
+		flags = D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
+		break;
+
+	case ImageFormat::Depth32:
+		dxgiFormat = DXGI_FORMAT_D32_FLOAT;
+		flags = D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL;
+		break;
+
+	case ImageFormat::Luma:
+		dxgiFormat = DXGI_FORMAT_NV12;
+		flags = D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
+		break;
+
+	case ImageFormat::MotionVectors:
+		// Rendered to by pass 1, or written by the video motion estimator.
+		dxgiFormat = DXGI_FORMAT_R16G16_SINT;
+		flags = D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET;
+		break;
+
+	default:
+		_com_issue_error(E_INVALIDARG);
+	}
+
+	return CD3DX12_RESOURCE_DESC::Tex2D(dxgiFormat, width, height, 1, 1, 1, 0, flags);
+}
+
+ResourceFootprint D3D12Device::GetImageFootprint(ImageFormat format, int width, int height) const
+{
+	CD3DX12_RESOURCE_DESC resourceDesc = GetImageResourceDesc(format, width, height);
+	D3D12_RESOURCE_ALLOCATION_INFO info = m_deviceResources->GetD3DDevice()->GetResourceAllocationInfo(0, 1, &resourceDesc);
+	return ResourceFootprint{ info.SizeInBytes, info.Alignment };
+}
+
+uint32_t D3D12Device::GetRestingState(ImageFormat format) const
+{
+	switch (format)
+	{
+	case ImageFormat::Bgra8: return D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
+	case ImageFormat::Depth32: return D3D12_RESOURCE_STATE_DEPTH_WRITE;
+	default: return D3D12_RESOURCE_STATE_COMMON;
+	}
+}
+
+uint32_t D3D12Device::GetImageState(ImageAccess access) const
+{
+	switch (access)
+	{
+	case ImageAccess::RenderTarget: return D3D12_RESOURCE_STATE_RENDER_TARGET;
+	case ImageAccess::DepthWrite: return D3D12_RESOURCE_STATE_DEPTH_WRITE;
+	case ImageAccess::PixelShaderRead: return D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
+	case ImageAccess::NonPixelShaderRead: return D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
+	case ImageAccess::UnorderedAccess: return D3D12_RESOURCE_STATE_UNORDERED_ACCESS;
+	case ImageAccess::VideoEncodeRead: return D3D12_RESOURCE_STATE_VIDEO_ENCODE_READ;
+	case ImageAccess::VideoEncodeWrite: return D3D12_RESOURCE_STATE_VIDEO_ENCODE_WRITE;
+	default: assert(false); return D3D12_RESOURCE_STATE_COMMON;
+	}
+}
+
+uint32_t D3D12Device::GetReadStates() const
+{
+	return c_readStates;
+}
+
+std::unique_ptr<IImage> D3D12Device::CreateImage(ImageFormat format, int width, int height)
+{
+	auto d3dDevice = m_deviceResources->GetD3DDevice();
+
+	CD3DX12_RESOURCE_DESC resourceDesc = GetImageResourceDesc(format, width, height);
+	DXGI_FORMAT dxgiFormat = resourceDesc.Format;
+	D3D12_RESOURCE_STATES restingState = static_cast<D3D12_RESOURCE_STATES>(GetRestingState(format));
+	D3D12_CLEAR_VALUE clearValue = {};
+	D3D12_CLEAR_VALUE const* optimizedClearValue = nullptr;
+	wchar_t const* name = L"";
+
+	switch (format)
+	{
+	case ImageFormat::Bgra8:
+		clearValue = CD3DX12_CLEAR_VALUE(dxgiFormat, c_clearColor);
+		optimizedClearValue = &clearValue;
+		name = L"Bgra8 image";
+		break;
+
+	case ImageFormat::Depth32:
+		clearValue = CD3DX12_CLEAR_VALUE(dxgiFormat, 1.0f, 0);
+		optimizedClearValue = &clearValue;
+		name = L"Depth32 image";
+		break;
+
+	case ImageFormat::Luma:
+		assert(width % 2 == 0); // NV12 needs to have multiple-of-two size.
+		assert(height % 2 == 0);
+		name = L"Luma image";
+		break;
+
+	case ImageFormat::MotionVectors:
+		clearValue = CD3DX12_CLEAR_VALUE(dxgiFormat, c_noMotion);
+		optimizedClearValue = &clearValue;
+		name = L"MotionVectors image";
+		break;
+
+	default:
+		_com_issue_error(E_INVALIDARG);
+	}
+
+	ComPtr<ID3D12Resource> resource;
+	auto defaultHeapType = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
+	DX::ThrowIfFailed(d3dDevice->CreateCommittedResource(
+		&defaultHeapType,
+		D3D12_HEAP_FLAG_NONE,
+		&resourceDesc,
+		restingState,
+		optimizedClearValue,
+		IID_PPV_ARGS(&resource)));
+	DX::SetName(resource.Get(), name);
+
+	std::unique_ptr<D3D12Image> image(new D3D12Image(format, width, height, resource, restingState));
+	m_resourceStates.SetState(resource.Get(), restingState);
+
+	if (format == ImageFormat::Bgra8 || format == ImageFormat::MotionVectors)
+	{
+		if (m_rtvCount == c_targetViewCapacity)
+		{
+			_com_issue_error(E_OUTOFMEMORY);
+		}
+		image->m_targetView = CD3DX12_CPU_DESCRIPTOR_HANDLE(m_rtvHeap->GetCPUDescriptorHandleForHeapStart(), m_rtvCount++, m_rtvDescriptorSize);
+		d3dDevice->CreateRenderTargetView(resource.Get(), nullptr, image->m_targetView);
+	}
+
+	if (format == ImageFormat::Bgra8)
+	{
+		image->m_srvDescriptorIndex = AllocateDescriptors(1);
+
+		D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+		srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+		srvDesc.Format = dxgiFormat;
+		srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+		srvDesc.Texture2D.MipLevels = 1;
+		d3dDevice->CreateShaderResourceView(resource.Get(), &srvDesc, GetCpuDescriptor(image->m_srvDescriptorIndex));
+	}
+	else if (format == ImageFormat::Depth32)
+	{
+		if (m_dsvCount == c_targetViewCapacity)
+		{
+			_com_issue_error(E_OUTOFMEMORY);
+		}
+		image->m_targetView = CD3DX12_CPU_DESCRIPTOR_HANDLE(m_dsvHeap->GetCPUDescriptorHandleForHeapStart(), m_dsvCount++, m_dsvDescriptorSize);
+
+		D3D12_DEPTH_STENCIL_VIEW_DESC dsvDesc = {};
+		dsvDesc.Format = dxgiFormat;
+		dsvDesc.ViewDimension = D3D12_DSV_DIMENSION_TEXTURE2D;
+		dsvDesc.Flags = D3D12_DSV_FLAG_NONE;
+		d3dDevice->CreateDepthStencilView(resource.Get(), &dsvDesc, image->m_targetView);
+	}
+	else if (format == ImageFormat::Luma)
+	{
+		// The first view of the table is for the color image being converted, and is filled in by ConvertToLuma.
+		image->m_uavTableDescriptorIndex = AllocateDescriptors(3);
+		{
+			D3D12_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
+			uavDesc.Format = DXGI_FORMAT_R8_UNORM; // Selects the luminance plane
+			uavDesc.ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2D;
+			d3dDevice->CreateUnorderedAccessView(resource.Get(), nullptr, &uavDesc, GetCpuDescriptor(image->m_uavTableDescriptorIndex + 1));
+		}
+		{
+			D3D12_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
+			uavDesc.Format = DXGI_FORMAT_R8G8_UNORM; // Selects the chrominance plane
+			uavDesc.ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2D;
+			uavDesc.Texture2D.PlaneSlice = 1;
+			d3dDevice->CreateUnorderedAccessView(resource.Get(), nullptr, &uavDesc, GetCpuDescriptor(image->m_uavTableDescriptorIndex + 2));
+		}
+	}
+
+	return std::move(image);
+}
+
+void D3D12Device::TrackResource(ID3D12Resource* resource, D3D12_RESOURCE_STATES state)
+{
+	m_resourceStates.SetState(resource, state);
+}
+
+void D3D12Device::RequireState(ID3D12Resource* resource, D3D12_RESOURCE_STATES state)
+{
+	m_resourceStates.Require(resource, state);
+}
+
+void D3D12Device::BeginStateTransition(ID3D12Resource* resource, D3D12_RESOURCE_STATES state)
+{
+	m_resourceStates.BeginTransition(resource, state);
+}
+
+void D3D12Device::FlushBarriers()
+{
+	std::vector<StateTransition> const& transitions = m_resourceStates.Flush();
+	if (transitions.empty())
+	{
+		return;
+	}
+
+	m_barriers.clear();
+	for (StateTransition const& transition : transitions)
+	{
+		m_barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(
+			static_cast<ID3D12Resource*>(const_cast<void*>(transition.resource)),
+			static_cast<D3D12_RESOURCE_STATES>(transition.before),
+			static_cast<D3D12_RESOURCE_STATES>(transition.after),
+			D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES,
+			ToBarrierFlags(transition.part)));
+	}
+	m_commandList->ResourceBarrier(static_cast<UINT>(m_barriers.size()), m_barriers.data());
+}
+
+void D3D12Device::BeginFrame()
+{
+	// Frames only come back around once the GPU has finished with them.
+	if (m_meshUpload && !m_isMeshUploadPending && m_deviceResources->GetCurrentFrameIndex() == m_meshUploadFrameIndex)
+	{
+		m_meshUpload.Reset();
+	}
+
+	DX::ThrowIfFailed(m_deviceResources->GetDirectCommandAllocator()->Reset());
+
+	// The command list can be reset anytime after ExecuteCommandList() is called.
+	DX::ThrowIfFailed(m_commandList->Reset(m_deviceResources->GetDirectCommandAllocator(), nullptr));
+}
+
+void D3D12Device::EndFrame()
+{
+	FlushBarriers();
+	DX::ThrowIfFailed(m_commandList->Close());
+
+	// Execute the command list.
+	ID3D12CommandList* ppCommandLists[] = { m_commandList.Get() };
+	m_deviceResources->GetCommandQueue()->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
+}
+
+// Each pass sets all of the state it uses, since motion estimation reopens the command list, and DLSS and
+// XeSS leave its bindings undefined.
+void D3D12Device::RenderScene(
+	SceneConstants const& constants,
+	SceneConstants const& previousConstants,
+	RenderSize renderSize,
+	IImage& color,
+	IImage& depth,
+	IImage* motionVectors)
+{
+	D3D12Image& colorImage = static_cast<D3D12Image&>(color);
+	D3D12Image& depthImage = static_cast<D3D12Image&>(depth);
+	D3D12Image* motionVectorImage = static_cast<D3D12Image*>(motionVectors);
+	UINT frameIndex = m_deviceResources->GetCurrentFrameIndex();
+
+	// Update the constant buffer resource.
+	{
+		ModelViewProjectionConstantBuffer constantBufferData;
+		constantBufferData.modelViewProjection = ToShaderMatrix(GetModelViewProjection(constants));
+		constantBufferData.currentMotion = ToShaderMatrix(GetUnjitteredModelViewProjection(constants));
+		constantBufferData.previousMotion = ToShaderMatrix(GetUnjitteredModelViewProjection(previousConstants));
+
+		// Half the viewport, since normalized device coordinates go from -1 to 1, times four quarter pixels.
+		// Normalized device coordinates have y up, and images y down.
+		constantBufferData.motionVectorScale = XMFLOAT2(2.0f * renderSize.width, -2.0f * renderSize.height);
+		constantBufferData.sceneAngle = constants.sceneAngle;
+		constantBufferData.previousSceneAngle = previousConstants.sceneAngle;
+
+		UINT8* destination = m_mappedConstantBuffer + (frameIndex * c_alignedConstantBufferSize);
+		memcpy(destination, &constantBufferData, sizeof(constantBufferData));
+	}
+
+	ID3D12DescriptorHeap* ppHeaps[] = { m_cbvSrvHeap.Get() };
+	m_commandList->SetDescriptorHeaps(_countof(ppHeaps), ppHeaps);
+	m_commandList->SetGraphicsRootSignature(m_commonGraphicsRootSignature.Get());
+	m_commandList->SetGraphicsRootDescriptorTable(0, GetGpuDescriptor(frameIndex));
+	m_commandList->SetPipelineState(motionVectorImage ? m_pass1MotionPipelineState.Get() : m_pass1PipelineState.Get());
+
+	if (m_isInstanceUploadPending)
+	{
+		m_commandList->CopyBufferRegion(m_instanceBuffer.Get(), 0, m_instanceBufferUpload.Get(), 0, m_instanceCount * sizeof(SceneInstance));
+		RequireState(m_instanceBuffer.Get(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+		m_isInstanceUploadPending = false;
+	}
+	m_commandList->SetGraphicsRootShaderResourceView(3, m_instanceBuffer->GetGPUVirtualAddress());
+
+	if (m_isMeshUploadPending)
+	{
+		m_commandList->CopyBufferRegion(m_meshVertexBuffer.Get(), 0, m_meshUpload.Get(), 0, m_meshVertexBufferView.SizeInBytes);
+		m_commandList->CopyBufferRegion(m_meshIndexBuffer.Get(), 0, m_meshUpload.Get(), (m_meshVertexBufferView.SizeInBytes + 255) & ~255u, m_meshIndexBufferView.SizeInBytes);
+		RequireState(m_meshVertexBuffer.Get(), D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER);
+		RequireState(m_meshIndexBuffer.Get(), D3D12_RESOURCE_STATE_INDEX_BUFFER);
+		m_isMeshUploadPending = false;
+		m_meshUploadFrameIndex = frameIndex;
+	}
+
+	// Set the viewport and scissor rectangle. Only the top-left part of the target is rendered to when dynamic resolution has scaled it down.
+	D3D12_VIEWPORT viewport = { 0.0f, 0.0f, static_cast<float>(renderSize.width), static_cast<float>(renderSize.height), 0.0f, 1.0f };
+	D3D12_RECT scissorRect = { 0, 0, static_cast<LONG>(renderSize.width), static_cast<LONG>(renderSize.height) };
+	m_commandList->RSSetViewports(1, &viewport);
+	m_commandList->RSSetScissorRects(1, &scissorRect);
+
+	RequireState(colorImage.GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET);
+	if (motionVectorImage)
+	{
+		RequireState(motionVectorImage->GetResource(), D3D12_RESOURCE_STATE_RENDER_TARGET);
+	}
+	FlushBarriers();
+
+	{
+		D3D12_CPU_DESCRIPTOR_HANDLE renderTargetViews[2] = { colorImage.GetTargetView() };
+		D3D12_CPU_DESCRIPTOR_HANDLE depthStencilView = depthImage.GetTargetView();
+
+		m_commandList->ClearRenderTargetView(renderTargetViews[0], c_clearColor, 0, nullptr);
+		m_commandList->ClearDepthStencilView(depthStencilView, D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, nullptr);
+
+		UINT renderTargetCount = 1;
+		if (motionVectorImage)
+		{
+			renderTargetViews[renderTargetCount++] = motionVectorImage->GetTargetView();
+			m_commandList->ClearRenderTargetView(motionVectorImage->GetTargetView(), c_noMotion, 0, nullptr);
+		}
+		m_commandList->OMSetRenderTargets(renderTargetCount, renderTargetViews, false, &depthStencilView);
+	}
+
+	m_commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	m_commandList->IASetVertexBuffers(0, 1, &m_meshVertexBufferView);
+	m_commandList->IASetIndexBuffer(&m_meshIndexBufferView);
+	for (MeshChunk const& chunk : m_meshChunks)
+	{
+		m_commandList->DrawIndexedInstanced(chunk.indexCount, m_instanceCount, chunk.firstIndex, static_cast<INT>(chunk.firstVertex), 0);
+	}
+
+	RequireRestingState(colorImage);
+	if (motionVectorImage)
+	{
+		RequireRestingState(*motionVectorImage);
+	}
+}
+
+// Convert Rgb to Yuv because motion estimation requires yuv
+void D3D12Device::ConvertToLuma(IImage& color, RenderSize renderSize, IImage& luma)
+{
+	D3D12Image& colorImage = static_cast<D3D12Image&>(color);
+	D3D12Image& lumaImage = static_cast<D3D12Image&>(luma);
+
+	// Point the start of the table at the color image. Earlier frames may still be reading the table, so
+	// they have to finish first if it changes; in practice it's only ever set once.
+	if (lumaImage.m_uavTableSource != &colorImage)
+	{
+		if (lumaImage.m_uavTableSource)
+		{
+			m_deviceResources->WaitForGpuOnDirectQueue();
+		}
+
+		D3D12_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
+		uavDesc.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
+		uavDesc.ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2D;
+		m_deviceResources->GetD3DDevice()->CreateUnorderedAccessView(colorImage.GetResource(), nullptr, &uavDesc, GetCpuDescriptor(lumaImage.GetUavTableDescriptorIndex()));
+		lumaImage.m_uavTableSource = &colorImage;
+	}
+
+	RequireState(colorImage.GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	RequireState(lumaImage.GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	FlushBarriers();
+
+	ID3D12DescriptorHeap* ppHeaps[] = { m_cbvSrvHeap.Get() };
+	m_commandList->SetDescriptorHeaps(_countof(ppHeaps), ppHeaps);
+	m_commandList->SetComputeRootSignature(m_commonComputeRootSignature.Get());
+	m_commandList->SetPipelineState(m_pass2_YuvConversion_PipelineState.Get());
+	m_commandList->SetComputeRootDescriptorTable(0, GetGpuDescriptor(lumaImage.GetUavTableDescriptorIndex()));
+
+	UINT renderWidth = static_cast<UINT>(renderSize.width);
+	UINT renderHeight = static_cast<UINT>(renderSize.height);
+	UINT rootConstants[2] = { renderWidth, renderHeight };
+	m_commandList->SetComputeRoot32BitConstants(1, 2, rootConstants, 0);
+
+	UINT dispatchX = renderWidth / 64 + 1;
+	UINT dispatchY = renderHeight;
+	m_commandList->Dispatch(dispatchX, dispatchY, 1);
+
+	RequireRestingState(lumaImage);
+	RequireRestingState(colorImage);
+}
+
+void D3D12Device::EstimateMotion(IImage& current, IImage& previous, RenderSize, IImage& motionVectors)
+{
+	D3D12Image& currentImage = static_cast<D3D12Image&>(current);
+	D3D12Image& previousImage = static_cast<D3D12Image&>(previous);
+	D3D12Image& motionVectorImage = static_cast<D3D12Image&>(motionVectors);
+
+	if (!m_isMotionEstimationSupported)
+	{
+		return;
+	}
+
+	// The video motion estimator works on whole images, so the part outside the render size is estimated too and ignored.
+	if (currentImage.GetWidth() != m_motionEstimatorWidth || currentImage.GetHeight() != m_motionEstimatorHeight)
+	{
+		CreateMotionEstimator(currentImage.GetWidth(), currentImage.GetHeight());
+	}
+
+	// The video queue takes the images in their resting states.
+	FlushBarriers();
+	DX::ThrowIfFailed(m_commandList->Close());
+
+	{
+		ID3D12CommandList* ppCommandLists[] = { m_commandList.Get() };
+		m_deviceResources->GetCommandQueue()->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
+	}
+
+	// The video queue waits for the YUV conversion on the GPU.
+	m_videoSchedule->AfterDirectWork();
+
+	UINT frameIndex = m_deviceResources->GetCurrentFrameIndex();
+	m_videoSchedule->BeginVideoWork(static_cast<int>(frameIndex));
+	DX::ThrowIfFailed(m_deviceResources->GetVideoEncodeCommandAllocator()->Reset());
+	DX::ThrowIfFailed(m_videoEncodeCommandList->Reset(m_deviceResources->GetVideoEncodeCommandAllocator()));
+
+	{
+		CD3DX12_RESOURCE_BARRIER barriers[] =
+		{
+			CD3DX12_RESOURCE_BARRIER::Transition(previousImage.GetResource(), previousImage.GetRestingState(), D3D12_RESOURCE_STATE_VIDEO_ENCODE_READ),
+			CD3DX12_RESOURCE_BARRIER::Transition(currentImage.GetResource(), currentImage.GetRestingState(), D3D12_RESOURCE_STATE_VIDEO_ENCODE_READ),
+			CD3DX12_RESOURCE_BARRIER::Transition(motionVectorImage.GetResource(), motionVectorImage.GetRestingState(), D3D12_RESOURCE_STATE_VIDEO_ENCODE_WRITE)
+		};
+		m_videoEncodeCommandList->ResourceBarrier(_countof(barriers), barriers);
+	}
+
+	// Run motion estimation
+	{
+		const D3D12_VIDEO_MOTION_ESTIMATOR_INPUT inputArgs = {
+			currentImage.GetResource(),
+			0,
+			previousImage.GetResource(),
+			0,
+			nullptr // pHintMotionVectorHeap
+		};
+
+		const D3D12_VIDEO_MOTION_ESTIMATOR_OUTPUT outputArgs = { m_videoMotionVectorHeap.Get() };
+
+		m_videoEncodeCommandList->EstimateMotion(m_videoMotionEstimator.Get(), &outputArgs, &inputArgs);
+	}
+	// Resolve motion vectors
+	{
+		D3D12_RESOLVE_VIDEO_MOTION_VECTOR_HEAP_INPUT inputArgs =
+		{
+			m_videoMotionVectorHeap.Get(),
+			static_cast<UINT>(currentImage.GetWidth()),
+			static_cast<UINT>(currentImage.GetHeight())
+		};
+
+		D3D12_RESOURCE_COORDINATE ouputCoordinate{};
+
+		D3D12_RESOLVE_VIDEO_MOTION_VECTOR_HEAP_OUTPUT outputArgs =
+		{
+			motionVectorImage.GetResource(),
+			ouputCoordinate
+		};
+
+		m_videoEncodeCommandList->ResolveMotionVectorHeap(&outputArgs, &inputArgs);
+	}
+
+	{
+		CD3DX12_RESOURCE_BARRIER barriers[] =
+		{
+			CD3DX12_RESOURCE_BARRIER::Transition(previousImage.GetResource(), D3D12_RESOURCE_STATE_VIDEO_ENCODE_READ, previousImage.GetRestingState()),
+			CD3DX12_RESOURCE_BARRIER::Transition(currentImage.GetResource(), D3D12_RESOURCE_STATE_VIDEO_ENCODE_READ, currentImage.GetRestingState()),
+			CD3DX12_RESOURCE_BARRIER::Transition(motionVectorImage.GetResource(), D3D12_RESOURCE_STATE_VIDEO_ENCODE_WRITE, motionVectorImage.GetRestingState())
+		};
+		m_videoEncodeCommandList->ResourceBarrier(_countof(barriers), barriers);
+	}
+
+	DX::ThrowIfFailed(m_videoEncodeCommandList->Close());
+
+	{
+		ID3D12CommandList* ppCommandLists[] = { m_videoEncodeCommandList.Get() };
+		m_deviceResources->GetVideoQueue()->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
+	}
+	// The upscale that reads the motion vectors is recorded in the next frame, after WaitForMotionEstimation.
+	m_videoSchedule->AfterVideoWork(static_cast<int>(frameIndex));
+
+	// Reopen the graphics command list. The allocator still holds the commands executed above, which may be
+	// running, so it isn't reset until the frame comes back around.
+	DX::ThrowIfFailed(m_commandList->Reset(m_deviceResources->GetDirectCommandAllocator(), nullptr));
+}
+
+void D3D12Device::WaitForMotionEstimation()
+{
+	if (m_isMotionEstimationSupported)
+	{
+		int lastFrameIndex = (GetFrameIndex() + DX::c_frameCount - 1) % DX::c_frameCount;
+		m_videoSchedule->AwaitVideoWork(lastFrameIndex);
+	}
+}
+
+DlssUpscaler::DlssUpscaler(D3D12Device& device, int outputWidth, int outputHeight)
+	: m_device(device)
+	, m_outputWidth(outputWidth)
+	, m_outputHeight(outputHeight)
+	, m_qualityPreset(QualityPreset::UltraQuality)
+	, m_areMotionVectorsJittered(false)
+	, m_isSupported(false)
+	, m_dlssFeatureHandle(nullptr)
+{
+	NVSDK_NGX_Result ngxResult{};
+
+	ngxResult = NVSDK_NGX_D3D12_Init(12341234, L"./", m_device.GetDeviceResources()->GetD3DDevice());
+	DX::ThrowIfNGXFailed(ngxResult);
+
+	ngxResult = NVSDK_NGX_D3D12_GetCapabilityParameters(&m_ngxParameters);
+	DX::ThrowIfNGXFailed(ngxResult);
+
+	int DLSSAvailable = 0;
+	ngxResult = m_ngxParameters->Get(NVSDK_NGX_Parameter_SuperSampling_Available, &DLSSAvailable);
+	DX::ThrowIfNGXFailed(ngxResult);
+	m_isSupported = DLSSAvailable > 0;
+}
+
+DlssUpscaler::~DlssUpscaler()
+{
+	if (m_dlssFeatureHandle)
+	{
+		NVSDK_NGX_D3D12_ReleaseFeature(m_dlssFeatureHandle);
+	}
+}
+
+void DlssUpscaler::SetMotionVectorsJittered(bool areJittered)
+{
+	if (areJittered != m_areMotionVectorsJittered)
+	{
+		ReleaseFeature();
+		m_areMotionVectorsJittered = areJittered;
+	}
+}
+
+void DlssUpscaler::SetQualityPreset(QualityPreset preset)
+{
+	ReleaseFeature();
+	m_qualityPreset = preset;
+}
+
+// The next Upscale creates it again.
+void DlssUpscaler::ReleaseFeature()
+{
+	if (m_dlssFeatureHandle)
+	{
+		DX::ThrowIfNGXFailed(NVSDK_NGX_D3D12_ReleaseFeature(m_dlssFeatureHandle));
+		m_dlssFeatureHandle = nullptr;
+	}
+}
+
+RenderSize DlssUpscaler::GetOptimalInputSize(int outputWidth, int outputHeight)
+{
+	RenderSize renderSize = GetPresetRenderSize(m_qualityPreset, outputWidth, outputHeight);
+
+	unsigned int optimalWidth = 0, optimalHeight = 0;
+	unsigned int maxWidth = 0, maxHeight = 0;
+	unsigned int minWidth = 0, minHeight = 0;
+	float sharpness = 0.0f;
+	NVSDK_NGX_Result ngxResult = NGX_DLSS_GET_OPTIMAL_SETTINGS(
+		m_ngxParameters,
+		outputWidth,
+		outputHeight,
+		ToDlssPerfQuality(m_qualityPreset),
+		&optimalWidth,
+		&optimalHeight,
+		&maxWidth,
+		&maxHeight,
+		&minWidth,
+		&minHeight,
+		&sharpness);
+
+	// Not every mode is available on every driver; those report a size of 0.
+	if (NVSDK_NGX_SUCCEED(ngxResult) && optimalWidth > 0 && optimalHeight > 0)
+	{
+		renderSize.width = static_cast<int>(optimalWidth);
+		renderSize.height = static_cast<int>(optimalHeight);
+	}
+
+	return renderSize;
+}
+
+// Records creation of the DLSS feature into the device's command list.
+void DlssUpscaler::CreateFeature(RenderSize maxInputSize)
+{
+	int DlssCreateFeatureFlags = m_areMotionVectorsJittered ? NVSDK_NGX_DLSS_Feature_Flags_MVJittered : NVSDK_NGX_DLSS_Feature_Flags_None;
+
+	NVSDK_NGX_DLSS_Create_Params dlssCreateParams{};
+	dlssCreateParams.Feature.InTargetWidth = m_outputWidth;
+	dlssCreateParams.Feature.InTargetHeight = m_outputHeight;
+	dlssCreateParams.Feature.InWidth = maxInputSize.width;
+	dlssCreateParams.Feature.InHeight = maxInputSize.height;
+	dlssCreateParams.Feature.InPerfQualityValue = ToDlssPerfQuality(m_qualityPreset);
+	dlssCreateParams.InFeatureCreateFlags = DlssCreateFeatureFlags;
+
+	UINT creationNodeMask = 1;
+	UINT visibilityNodeMask = 1;
+	NVSDK_NGX_Result ngxResult = NGX_D3D12_CREATE_DLSS_EXT(
+		m_device.GetCommandList(),
+		creationNodeMask,
+		visibilityNodeMask,
+		&m_dlssFeatureHandle,
+		m_ngxParameters,
+		&dlssCreateParams);
+
+	DX::ThrowIfNGXFailed(ngxResult);
+}
+
+void DlssUpscaler::Upscale(UpscaleInputs const& inputs, IImage& output)
+{
+	D3D12Image& colorImage = static_cast<D3D12Image&>(*inputs.color);
+	D3D12Image& depthImage = static_cast<D3D12Image&>(*inputs.depth);
+	D3D12Image& motionVectorImage = static_cast<D3D12Image&>(*inputs.motionVectors);
+	D3D12Image& outputImage = static_cast<D3D12Image&>(output);
+	ID3D12GraphicsCommandList* commandList = m_device.GetCommandList();
+
+	if (!m_dlssFeatureHandle)
+	{
+		CreateFeature(ClampRenderSize(GetOptimalInputSize(m_outputWidth, m_outputHeight), colorImage.GetWidth(), colorImage.GetHeight()));
+	}
+
+	m_device.RequireState(outputImage.GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	m_device.FlushBarriers();
+
+	NVSDK_NGX_D3D12_DLSS_Eval_Params dlssEvalParams{};
+	dlssEvalParams.Feature.pInColor = colorImage.GetResource();
+	dlssEvalParams.Feature.pInOutput = outputImage.GetResource(); // Looks like you can't upscale directly to a swapchain target.
+	dlssEvalParams.pInDepth = depthImage.GetResource();
+	dlssEvalParams.pInMotionVectors = motionVectorImage.GetResource();
+	dlssEvalParams.pInExposureTexture = nullptr;
+	dlssEvalParams.pInBiasCurrentColorMask = nullptr;
+	dlssEvalParams.InJitterOffsetX = inputs.jitter.x;
+	dlssEvalParams.InJitterOffsetY = inputs.jitter.y;
+	dlssEvalParams.Feature.InSharpness = 0.0f; // Sharpening is done when writing to the swap chain, the same as for the other scaling types
+	dlssEvalParams.InReset = inputs.reset ? 1 : 0;
+
+	// DLSS takes motion vectors in render pixels, pointing to where the content was last frame. Ours point
+	// the same way, in quarter pixels.
+	dlssEvalParams.InMVScaleX = 0.25f;
+	dlssEvalParams.InMVScaleY = 0.25f;
+	dlssEvalParams.InRenderSubrectDimensions.Width = inputs.renderSize.width;
+	dlssEvalParams.InRenderSubrectDimensions.Height = inputs.renderSize.height;
+
+	NVSDK_NGX_Result Status = NGX_D3D12_EVALUATE_DLSS_EXT(
+		commandList,
+		m_dlssFeatureHandle,
+		m_ngxParameters,
+		&dlssEvalParams);
+
+	DX::ThrowIfNGXFailed(Status);
+
+	m_device.RequireRestingState(outputImage);
+}
+
+XessUpscaler::XessUpscaler(D3D12Device& device, int outputWidth, int outputHeight)
+	: m_device(device)
+	, m_outputWidth(outputWidth)
+	, m_outputHeight(outputHeight)
+	, m_qualityPreset(QualityPreset::UltraQuality)
+	, m_areMotionVectorsJittered(false)
+{
+	xess_result_t xessResult;
+
+	xessResult = xessD3D12CreateContext(m_device.GetDeviceResources()->GetD3DDevice(), &m_xessContext);
+	DX::ThrowIfXeSSFailed(xessResult);
+
+	if (XESS_RESULT_WARNING_OLD_DRIVER == xessIsOptimalDriver(m_xessContext))
+	{
+		OutputDebugStringW(L"Please install the latest graphics driver from your vendor for optimal Intel(R) XeSS performance and visual quality");
+	}
+
+	xess_2d_t desiredOutputResolution;
+	desiredOutputResolution.x = m_outputWidth;
+	desiredOutputResolution.y = m_outputHeight;
+
+	xess_properties_t props;
+	xessResult = xessGetProperties(m_xessContext, &desiredOutputResolution, &props);
+	DX::ThrowIfXeSSFailed(xessResult);
+
+	xess_version_t xefx_version;
+	xessResult = xessGetIntelXeFXVersion(m_xessContext, &xefx_version);
+	DX::ThrowIfXeSSFailed(xessResult);
+
+	Initialize();
+}
+
+XessUpscaler::~XessUpscaler()
+{
+	if (m_xessContext)
+	{
+		xessDestroyContext(m_xessContext);
+	}
+}
+
+// (Re)initializes XeSS for the current quality preset. XeSS must not be in use on the GPU.
+void XessUpscaler::Initialize()
+{
+	xess_2d_t desiredOutputResolution;
+	desiredOutputResolution.x = m_outputWidth;
+	desiredOutputResolution.y = m_outputHeight;
+
+	xess_d3d12_init_params_t params = {
+
+		desiredOutputResolution, /* Output width and height. */
+
+		ToXessQuality(m_qualityPreset), /* Quality setting */
+
+		// Motion vectors are at the render size. Estimated ones include the jitter; rendered ones don't.
+		m_areMotionVectorsJittered ? XESS_INIT_FLAG_JITTERED_MV : XESS_INIT_FLAG_NONE,
+
+		/* Specfies the node mask for internally created resources on
+		 * multi-adapter systems. */
+		0,
+		/* Specfies the node visibility mask for internally created resources
+		 * on multi-adapter systems. */
+		0,
+		/* Optional externally allocated buffers storage for X<sup>e</sup>SS. If NULL the
+		 * storage is allocated internally. If allocated, the heap type must be
+		 * D3D12_HEAP_TYPE_DEFAULT. This heap is not accessed by the CPU. */
+		nullptr,
+		/* Offset in the externally allocated heap for temporary buffers storage. */
+		0,
+		/* Optional externally allocated textures storage for X<sup>e</sup>SS. If NULL the
+		 * storage is allocated internally. If allocated, the heap type must be
+		 * D3D12_HEAP_TYPE_DEFAULT. This heap is not accessed by the CPU. */
+		nullptr,
+		/* Offset in the externally allocated heap for temporary textures storage. */
+		0,
+		/* No pipeline library */
+		NULL
+	};
+
+	xess_result_t xessResult = xessD3D12Init(m_xessContext, &params);
+	DX::ThrowIfXeSSFailed(xessResult);
+
+	// XeSS takes motion vectors in render pixels, pointing to where the content was last frame. Ours point
+	// the same way, in quarter pixels.
+	xessResult = xessSetVelocityScale(m_xessContext, 0.25f, 0.25f);
+	DX::ThrowIfXeSSFailed(xessResult);
+}
+
+void XessUpscaler::SetMotionVectorsJittered(bool areJittered)
+{
+	if (areJittered != m_areMotionVectorsJittered)
+	{
+		m_areMotionVectorsJittered = areJittered;
+		Initialize();
+	}
+}
+
+void XessUpscaler::SetQualityPreset(QualityPreset preset)
+{
+	m_qualityPreset = preset;
+	Initialize();
+}
+
+RenderSize XessUpscaler::GetOptimalInputSize(int outputWidth, int outputHeight)
+{
+	xess_2d_t desiredOutputResolution;
+	desiredOutputResolution.x = outputWidth;
+	desiredOutputResolution.y = outputHeight;
+
+	xess_2d_t recommendedInputResolution{};
+	xess_result_t xessResult = xessGetInputResolution(
+		m_xessContext, &desiredOutputResolution, ToXessQuality(m_qualityPreset), &recommendedInputResolution);
+	DX::ThrowIfXeSSFailed(xessResult);
+
+	return RenderSize{ static_cast<int>(recommendedInputResolution.x), static_cast<int>(recommendedInputResolution.y) };
+}
+
+void XessUpscaler::Upscale(UpscaleInputs const& inputs, IImage& output)
+{
+	D3D12Image& colorImage = static_cast<D3D12Image&>(*inputs.color);
+	D3D12Image& depthImage = static_cast<D3D12Image&>(*inputs.depth);
+	D3D12Image& motionVectorImage = static_cast<D3D12Image&>(*inputs.motionVectors);
+	D3D12Image& outputImage = static_cast<D3D12Image&>(output);
+	ID3D12GraphicsCommandList* commandList = m_device.GetCommandList();
+
+	// For XeSS:
+	//     - It wants source RGB in NON_PIXEL_SHADER_RESOURCE state, which color's resting state includes
+	//     - It cares about depth stencil state
+	//     - It wants motion vectors to be in NON_PIXEL_SHADER_RESOURCE state
+	//     - It wants the target to be in UNORDERED_ACCESS state
+	m_device.RequireState(depthImage.GetResource(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+	m_device.RequireState(motionVectorImage.GetResource(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+	m_device.RequireState(outputImage.GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	m_device.FlushBarriers();
+
+	xess_d3d12_execute_params_t exec_params{};
+	exec_params.inputWidth = inputs.renderSize.width;
+	exec_params.inputHeight = inputs.renderSize.height;
+	exec_params.jitterOffsetX = inputs.jitter.x;
+	exec_params.jitterOffsetY = inputs.jitter.y;
+	exec_params.exposureScale = 1.0f;
+	exec_params.resetHistory = inputs.reset ? 1 : 0;
+	exec_params.pColorTexture = colorImage.GetResource();
+	exec_params.pVelocityTexture = motionVectorImage.GetResource();
+	exec_params.pOutputTexture = outputImage.GetResource();
+	exec_params.pDepthTexture = depthImage.GetResource();
+	exec_params.pExposureScaleTexture = 0;
+	xess_result_t status = xessD3D12Execute(m_xessContext, commandList, &exec_params);
+	DX::ThrowIfXeSSFailed(status);
+
+	m_device.RequireRestingState(outputImage);
+	m_device.RequireRestingState(motionVectorImage);
+	m_device.RequireRestingState(depthImage);
+}
@@ -0,0 +1,306 @@
+#pragma once
+
+#include "Backend.h"
+#include "DeviceResources.h"
+#include "GpuQueue.h"
+#include "ResourceStateTracker.h"
+#include "ShaderStructures.h"
+
+namespace scaling
+{
+	// A texture created by D3D12Device. Between passes, every image rests in the state given by
+	// GetRestingState(); a pass that needs it in another state asks the device for it there and back, and
+	// the device only records the transitions that are left once the round trips are taken out.
+	class D3D12Image : public IImage
+	{
+	public:
+		D3D12Image(ImageFormat format, int width, int height, Microsoft::WRL::ComPtr<ID3D12Resource> const& resource, D3D12_RESOURCE_STATES restingState);
+
+		ImageFormat GetFormat() const override	{ return m_format; }
+		int GetWidth() const override			{ return m_width; }
+		int GetHeight() const override			{ return m_height; }
+
+		ID3D12Resource*			GetResource() const			{ return m_resource.Get(); }
+		D3D12_RESOURCE_STATES	GetRestingState() const		{ return m_restingState; }
+
+		// Render target view for Bgra8 and MotionVectors, depth stencil view for Depth32.
+		D3D12_CPU_DESCRIPTOR_HANDLE	GetTargetView() const	{ return m_targetView; }
+
+		// Locations in the device's shader-visible heap. Bgra8 has an SRV. Luma has a table of three UAVs,
+		// which is what the YUV conversion shader binds: the color it converts, then its luminance and
+		// chrominance planes.
+		UINT GetSrvDescriptorIndex() const			{ return m_srvDescriptorIndex; }
+		UINT GetUavTableDescriptorIndex() const		{ return m_uavTableDescriptorIndex; }
+
+	private:
+		friend class D3D12Device;
+
+		ImageFormat								m_format;
+		int										m_width;
+		int										m_height;
+		Microsoft::WRL::ComPtr<ID3D12Resource>	m_resource;
+		D3D12_RESOURCE_STATES					m_restingState;
+		D3D12_CPU_DESCRIPTOR_HANDLE				m_targetView;
+		UINT									m_srvDescriptorIndex;
+		UINT									m_uavTableDescriptorIndex;
+
+		// For Luma, the color image whose UAV is currently at the start of the table.
+		D3D12Image const*						m_uavTableSource;
+	};
+
+	// Also what FrameScheduler awaits, so a fence the D3D12 code already signals, such as DeviceResources'
+	// frame fence, can be shared rather than created.
+	class D3D12Fence : public IGpuFence
+	{
+	public:
+		explicit D3D12Fence(ID3D12Device* device);
+		explicit D3D12Fence(Microsoft::WRL::ComPtr<ID3D12Fence> const& fence);
+		~D3D12Fence();
+
+		uint64_t GetCompletedValue() const override;
+		void WaitOnCpu(uint64_t value) override;
+
+		ID3D12Fence* GetFence() const { return m_fence.Get(); }
+
+	private:
+		void CreateCompletionEvent();
+
+		Microsoft::WRL::ComPtr<ID3D12Fence>	m_fence;
+		HANDLE								m_event;
+	};
+
+	class D3D12Queue : public IGpuQueue
+	{
+	public:
+		explicit D3D12Queue(ID3D12CommandQueue* queue) : m_queue(queue) {}
+
+		void Signal(IGpuFence& fence, uint64_t value) override;
+		void Wait(IGpuFence& fence, uint64_t value) override;
+
+	private:
+		ID3D12CommandQueue* m_queue;
+	};
+
+	// Runs the passes before upscaling with Direct3D 12: pass 1 on the direct queue, the YUV conversion as a
+	// compute shader, and motion estimation on the video encode queue. Pass 1 renders motion vectors as a
+	// second render target, so motion estimation is only needed when asked for.
+	//
+	// Everything is recorded into one direct command list, which is executed at EndFrame. Motion estimation
+	// is the exception: the video queue can't wait on work that hasn't been submitted yet, so EstimateMotion
+	// executes what's been recorded so far and reopens the list after submitting the video work. The queues
+	// wait on each other's fences in between, and the CPU goes on to record without waiting for either. The
+	// direct queue's wait for the motion vectors comes in the next frame, after its pass 1 has been executed.
+	class D3D12Device : public IDevice
+	{
+	public:
+		D3D12Device(std::shared_ptr<DX::DeviceResources> const& deviceResources);
+		~D3D12Device();
+
+		std::unique_ptr<IImage> CreateImage(ImageFormat format, int width, int height) override;
+		ResourceFootprint GetImageFootprint(ImageFormat format, int width, int height) const override;
+
+		uint32_t GetRestingState(ImageFormat format) const override;
+		uint32_t GetImageState(ImageAccess access) const override;
+		uint32_t GetReadStates() const override;
+
+		// These wait for the GPU, since it may still be drawing the current mesh and instances. The mesh is
+		// copied straight from its memory into an upload buffer, so it's only needed during the call.
+		void SetSceneMesh(SceneMeshView const& mesh) override;
+		void SetSceneInstances(std::vector<SceneInstance> const& instances) override;
+
+		void BeginFrame() override;
+		void EndFrame() override;
+
+		int GetFrameCount() const override { return DX::c_frameCount; }
+		int GetFrameIndex() const override { return static_cast<int>(m_deviceResources->GetCurrentFrameIndex()); }
+
+		void RenderScene(
+			SceneConstants const& constants,
+			SceneConstants const& previousConstants,
+			RenderSize renderSize,
+			IImage& color,
+			IImage& depth,
+			IImage* motionVectors) override;
+		void ConvertToLuma(IImage& color, RenderSize renderSize, IImage& luma) override;
+		void EstimateMotion(IImage& current, IImage& previous, RenderSize renderSize, IImage& motionVectors) override;
+
+		// The wait holds back the whole command list being recorded, which after EstimateMotion starts after
+		// pass 1.
+		bool HasVideoQueue() const override { return m_isMotionEstimationSupported; }
+		void WaitForMotionEstimation() override;
+
+		// Runs the uploads recorded since construction and waits for them. The command list starts out open, so
+		// that the device's owner can record its own uploads alongside the device's.
+		void FinishUploads();
+
+		bool IsMotionEstimationSupported() const { return m_isMotionEstimationSupported; }
+
+		// The device tracks the state of its images and buffers on the command list. What's recorded into it
+		// asks for the states it needs, calls FlushBarriers before the work that needs them, and asks for the
+		// resting states back afterwards. The barriers are recorded together at the flush, leaving out the
+		// ones that would undo each other, so everything is in its resting state after a flush except what's
+		// been asked for since. Other resources, such as the swap chain's, can be tracked too.
+		void TrackResource(ID3D12Resource* resource, D3D12_RESOURCE_STATES state);
+		void RequireState(ID3D12Resource* resource, D3D12_RESOURCE_STATES state);
+		void RequireRestingState(D3D12Image const& image) { RequireState(image.GetResource(), image.GetRestingState()); }
+		void FlushBarriers();
+
+		// The first half of a split barrier, for a resource that won't be used until a later RequireState
+		// with the same state.
+		void BeginStateTransition(ID3D12Resource* resource, D3D12_RESOURCE_STATES state);
+
+		ResourceStateStats const& GetBarrierStats() const { return m_resourceStates.GetStats(); }
+
+		// For what's still recorded outside of the device, such as presenting and the upscalers. Valid between
+		// BeginFrame and EndFrame.
+		ID3D12GraphicsCommandList*	GetCommandList() const				{ return m_commandList.Get(); }
+
+		ID3D12DescriptorHeap*		GetDescriptorHeap() const			{ return m_cbvSrvHeap.Get(); }
+		D3D12_GPU_DESCRIPTOR_HANDLE	GetGpuDescriptor(UINT index) const;
+		ID3D12RootSignature*		GetGraphicsRootSignature() const	{ return m_commonGraphicsRootSignature.Get(); }
+
+		std::shared_ptr<DX::DeviceResources> const& GetDeviceResources() const { return m_deviceResources; }
+
+	private:
+		void CreateRootSignatures();
+		void CreatePipelineStates();
+		void CreateDescriptorHeaps();
+		void CreateConstantBuffers();
+		void CreateMotionEstimator(int width, int height);
+		UINT AllocateDescriptors(UINT count);
+		D3D12_CPU_DESCRIPTOR_HANDLE GetCpuDescriptor(UINT index) const;
+
+	private:
+		// Constant buffers must be 256-byte aligned.
+		static const UINT c_alignedConstantBufferSize = (sizeof(ModelViewProjectionConstantBuffer) + 255) & ~255;
+
+		// The first c_frameCount descriptors are the per-frame constant buffer views. Images take the rest.
+		static const UINT c_descriptorCapacity = DX::c_frameCount + 64;
+		// ScalingPipeline keeps color, motion vectors and output for one more frame than are in flight.
+		static const UINT c_targetViewCapacity = 16;
+
+		std::shared_ptr<DX::DeviceResources>				m_deviceResources;
+
+		Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList>	m_commandList;
+		Microsoft::WRL::ComPtr<ID3D12RootSignature>			m_commonGraphicsRootSignature;
+		Microsoft::WRL::ComPtr<ID3D12RootSignature>			m_commonComputeRootSignature;
+
+		Microsoft::WRL::ComPtr<ID3D12DescriptorHeap>		m_cbvSrvHeap;
+		UINT												m_cbvDescriptorSize;
+		UINT												m_nextDescriptorIndex;
+
+		// Not shader-visible, so these only need to hold the views of the images that are rendered to.
+		Microsoft::WRL::ComPtr<ID3D12DescriptorHeap>		m_rtvHeap;
+		Microsoft::WRL::ComPtr<ID3D12DescriptorHeap>		m_dsvHeap;
+		UINT												m_rtvDescriptorSize;
+		UINT												m_dsvDescriptorSize;
+		UINT												m_rtvCount;
+		UINT												m_dsvCount;
+
+		Microsoft::WRL::ComPtr<ID3D12Resource>				m_constantBuffer;
+		UINT8*												m_mappedConstantBuffer;
+
+		Microsoft::WRL::ComPtr<ID3D12PipelineState>			m_pass1PipelineState;
+		Microsoft::WRL::ComPtr<ID3D12PipelineState>			m_pass1MotionPipelineState; // Also renders motion vectors
+
+		// The scene's mesh, filled from a single upload buffer at the next RenderScene after it's set, like the
+		// instances. The upload buffer is released once the frame that copied from it has finished, since a
+		// large mesh would otherwise be held in memory twice.
+		Microsoft::WRL::ComPtr<ID3D12Resource>				m_meshVertexBuffer;
+		Microsoft::WRL::ComPtr<ID3D12Resource>				m_meshIndexBuffer;
+		Microsoft::WRL::ComPtr<ID3D12Resource>				m_meshUpload;
+		D3D12_VERTEX_BUFFER_VIEW							m_meshVertexBufferView;
+		D3D12_INDEX_BUFFER_VIEW								m_meshIndexBufferView;
+		std::vector<MeshChunk>								m_meshChunks;
+		bool												m_isMeshUploadPending;
+		UINT												m_meshUploadFrameIndex; // The frame that copied from m_meshUpload
+
+		// Read by pass 1's vertex shader as a structured buffer. Filled from the upload buffer at the next
+		// RenderScene after the instances are set, so that the copy is recorded along with a frame.
+		Microsoft::WRL::ComPtr<ID3D12Resource>				m_instanceBuffer;
+		Microsoft::WRL::ComPtr<ID3D12Resource>				m_instanceBufferUpload;
+		UINT												m_instanceCount;
+		bool												m_isInstanceUploadPending;
+
+		Microsoft::WRL::ComPtr<ID3D12PipelineState>			m_pass2_YuvConversion_PipelineState;
+
+		bool												 m_isMotionEstimationSupported;
+		Microsoft::WRL::ComPtr<ID3D12VideoDevice1>			 m_videoDevice;
+		Microsoft::WRL::ComPtr<ID3D12VideoEncodeCommandList> m_videoEncodeCommandList;
+		Microsoft::WRL::ComPtr<ID3D12VideoMotionEstimator>   m_videoMotionEstimator;
+		Microsoft::WRL::ComPtr<ID3D12VideoMotionVectorHeap>  m_videoMotionVectorHeap;
+		int													 m_motionEstimatorWidth;
+		int													 m_motionEstimatorHeight;
+
+		// Only when motion estimation is supported.
+		std::unique_ptr<D3D12Queue>							 m_directQueue;
+		std::unique_ptr<D3D12Queue>							 m_videoQueue;
+		std::unique_ptr<D3D12Fence>							 m_directFence;
+		std::unique_ptr<D3D12Fence>							 m_videoFence;
+		std::unique_ptr<VideoQueueSchedule>					 m_videoSchedule;
+
+		ResourceStateTracker								 m_resourceStates;
+		std::vector<D3D12_RESOURCE_BARRIER>					 m_barriers; // Kept between flushes to save allocating
+	};
+
+	// DLSS, through NGX.
+	class DlssUpscaler : public IUpscaler
+	{
+	public:
+		DlssUpscaler(D3D12Device& device, int outputWidth, int outputHeight);
+		~DlssUpscaler();
+
+		bool IsSupported() const { return m_isSupported; }
+
+		// Whether the motion vectors include the jitter, as estimated ones do, while rendered ones don't.
+		// DLSS is told when the feature is created, so this recreates it, as SetQualityPreset does.
+		void SetMotionVectorsJittered(bool areJittered);
+
+		bool IsTemporal() const override { return true; }
+		void SetQualityPreset(QualityPreset preset) override;
+		RenderSize GetOptimalInputSize(int outputWidth, int outputHeight) override;
+		void Upscale(UpscaleInputs const& inputs, IImage& output) override;
+
+	private:
+		void ReleaseFeature();
+		void CreateFeature(RenderSize maxInputSize);
+
+		D3D12Device&			m_device;
+		int						m_outputWidth;
+		int						m_outputHeight;
+		QualityPreset			m_qualityPreset;
+		bool					m_areMotionVectorsJittered;
+		bool					m_isSupported;
+		NVSDK_NGX_Parameter*	m_ngxParameters{};
+
+		// Created on the first Upscale after the quality preset changes, since creating it is recorded into
+		// the command list.
+		NVSDK_NGX_Handle*		m_dlssFeatureHandle;
+	};
+
+	// Intel XeSS.
+	class XessUpscaler : public IUpscaler
+	{
+	public:
+		XessUpscaler(D3D12Device& device, int outputWidth, int outputHeight);
+		~XessUpscaler();
+
+		// As for DlssUpscaler. Reinitializes XeSS, so XeSS must not be in use on the GPU.
+		void SetMotionVectorsJittered(bool areJittered);
+
+		bool IsTemporal() const override { return true; }
+		void SetQualityPreset(QualityPreset preset) override;
+		RenderSize GetOptimalInputSize(int outputWidth, int outputHeight) override;
+		void Upscale(UpscaleInputs const& inputs, IImage& output) override;
+
+	private:
+		void Initialize();
+
+		D3D12Device&			m_device;
+		int						m_outputWidth;
+		int						m_outputHeight;
+		QualityPreset			m_qualityPreset;
+		bool					m_areMotionVectorsJittered;
+		xess_context_handle_t	m_xessContext = nullptr;
+	};
+}
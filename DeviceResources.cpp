@@ -60,16 +60,19 @@ namespace ScreenRotation
 };
 
 // Constructor for DeviceResources.
-DX::DeviceResources::DeviceResources(DXGI_FORMAT backBufferFormat, DXGI_FORMAT depthBufferFormat) :
+DX::DeviceResources::DeviceResources(DXGI_FORMAT backBufferFormat) :
 	m_currentFrame(0),
 	m_pass1Viewport(),
 	m_pass2Viewport(),
 	m_rtvDescriptorSize(0),
 	m_fenceEvent(0),
 	m_backBufferFormat(backBufferFormat),
-	m_depthBufferFormat(depthBufferFormat),
 	m_fenceValues{},
 	m_deviceRemoved(false),
+	m_syncInterval(1),
+	m_frameStatistics{},
+	m_refreshSeconds(1.0 / 60.0),
+	m_presentedFenceValue(0),
 	m_videoFenceValue(0)
 {
 	CreateDeviceIndependentResources();
@@ -143,9 +146,10 @@ void DX::DeviceResources::CreateDeviceResources()
 		NAME_D3D12_OBJECT(m_videoQueue);
 	}
 
-	// Create descriptor heaps for render target views and depth stencil views.
+	// Create a descriptor heap for render target views. The targets that are rendered to before presenting
+	// belong to scaling::D3D12Device.
 	D3D12_DESCRIPTOR_HEAP_DESC rtvHeapDesc = {};
-	rtvHeapDesc.NumDescriptors = c_frameCount + 1; // One for the intermediate, and then one for each swap chain target
+	rtvHeapDesc.NumDescriptors = c_frameCount; // One for each swap chain target
 	rtvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
 	rtvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
 	DX::ThrowIfFailed(m_d3dDevice->CreateDescriptorHeap(&rtvHeapDesc, IID_PPV_ARGS(&m_rtvHeap)));
@@ -153,13 +157,6 @@ void DX::DeviceResources::CreateDeviceResources()
 
 	m_rtvDescriptorSize = m_d3dDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);	
 
-	D3D12_DESCRIPTOR_HEAP_DESC dsvHeapDesc = {};
-	dsvHeapDesc.NumDescriptors = 1;
-	dsvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_DSV;
-	dsvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
-	ThrowIfFailed(m_d3dDevice->CreateDescriptorHeap(&dsvHeapDesc, IID_PPV_ARGS(&m_dsvHeap)));
-	NAME_D3D12_OBJECT(m_dsvHeap);
-
 	for (UINT n = 0; n < c_frameCount; n++)
 	{
 		DX::ThrowIfFailed(
@@ -169,9 +166,12 @@ void DX::DeviceResources::CreateDeviceResources()
 
 	if (m_videoQueue)
 	{
-		DX::ThrowIfFailed(
-			m_d3dDevice->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_VIDEO_ENCODE, IID_PPV_ARGS(&m_videoEncodeCommandAllocator))
-		);
+		for (UINT n = 0; n < c_frameCount; n++)
+		{
+			DX::ThrowIfFailed(
+				m_d3dDevice->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_VIDEO_ENCODE, IID_PPV_ARGS(&m_videoEncodeCommandAllocators[n]))
+			);
+		}
 	}
 
 	// Create synchronization objects.
@@ -268,57 +268,6 @@ void DX::DeviceResources::CreateTargetSizeDependentResources()
 		}
 	}
 
-	D3D12_HEAP_PROPERTIES defaultHeapProperties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
-
-	// Create intermediate render target and view for it.
-	{
-		D3D12_RESOURCE_DESC resourceDesc = CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_B8G8R8A8_UNORM, g_scaling_sourceWidth, g_scaling_sourceHeight, 1, 1);
-		resourceDesc.Flags |= D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
-
-		float cornflowerBlue[] = { 0.3f, 0.58f, 0.93f, 1.0f };
-		CD3DX12_CLEAR_VALUE clearValue(DXGI_FORMAT_B8G8R8A8_UNORM, cornflowerBlue);
-
-		ThrowIfFailed(m_d3dDevice->CreateCommittedResource(
-			&defaultHeapProperties,
-			D3D12_HEAP_FLAG_NONE,
-			&resourceDesc,
-			D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
-			&clearValue,
-			IID_PPV_ARGS(&m_intermediateRenderTarget)
-		));
-		NAME_D3D12_OBJECT(m_intermediateRenderTarget);
-
-		CD3DX12_CPU_DESCRIPTOR_HANDLE rtvDescriptor(m_rtvHeap->GetCPUDescriptorHandleForHeapStart(), c_frameCount, m_rtvDescriptorSize);
-		m_d3dDevice->CreateRenderTargetView(m_intermediateRenderTarget.Get(), nullptr, rtvDescriptor);
-	}
-
-	// Create a depth stencil and view.
-	{
-
-		D3D12_RESOURCE_DESC depthResourceDesc = CD3DX12_RESOURCE_DESC::Tex2D(m_depthBufferFormat, backBufferWidth, backBufferHeight, 1, 1);
-		depthResourceDesc.Flags |= D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL;
-
-		CD3DX12_CLEAR_VALUE depthOptimizedClearValue(m_depthBufferFormat, 1.0f, 0);
-
-		ThrowIfFailed(m_d3dDevice->CreateCommittedResource(
-			&defaultHeapProperties,
-			D3D12_HEAP_FLAG_NONE,
-			&depthResourceDesc,
-			D3D12_RESOURCE_STATE_DEPTH_WRITE,
-			&depthOptimizedClearValue,
-			IID_PPV_ARGS(&m_depthStencil)
-			));
-
-		NAME_D3D12_OBJECT(m_depthStencil);
-
-		D3D12_DEPTH_STENCIL_VIEW_DESC dsvDesc = {};
-		dsvDesc.Format = m_depthBufferFormat;
-		dsvDesc.ViewDimension = D3D12_DSV_DIMENSION_TEXTURE2D;
-		dsvDesc.Flags = D3D12_DSV_FLAG_NONE;
-
-		m_d3dDevice->CreateDepthStencilView(m_depthStencil.Get(), &dsvDesc, m_dsvHeap->GetCPUDescriptorHandleForHeapStart());
-	}
-
 	m_pass1Viewport = { 0.0f, 0.0f, static_cast<float>(g_scaling_sourceWidth), static_cast<float>(g_scaling_sourceHeight), 0.0f, 1.0f };
 	m_pass2Viewport = { 0.0f, 0.0f, static_cast<float>(g_scaling_destWidth), static_cast<float>(g_scaling_destHeight), 0.0f, 1.0f };
 }
@@ -379,10 +328,10 @@ void DX::DeviceResources::ValidateDevice()
 // Present the contents of the swap chain to the screen.
 void DX::DeviceResources::Present()
 {
-	// The first argument instructs DXGI to block until VSync, putting the application
+	// A sync interval of 1 instructs DXGI to block until VSync, putting the application
 	// to sleep until the next VSync. This ensures we don't waste any cycles rendering
 	// frames that will never be displayed to the screen.
-	HRESULT hr = m_swapChain->Present(1, 0);
+	HRESULT hr = m_swapChain->Present(m_syncInterval, 0);
 
 	// If the device was removed either by a disconnection or a driver upgrade, we 
 	// must recreate all device resources.
@@ -398,6 +347,37 @@ void DX::DeviceResources::Present()
 	}
 }
 
+bool DX::DeviceResources::GetVblankTiming(double& secondsSinceVblank, double& refreshSeconds, UINT& presentCount)
+{
+	DXGI_FRAME_STATISTICS statistics = {};
+	if (FAILED(m_swapChain->GetFrameStatistics(&statistics)) || statistics.SyncQPCTime.QuadPart == 0)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER frequency;
+	LARGE_INTEGER now;
+	QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&now);
+
+	// The refresh interval is measured between two sets of statistics, and is 60 Hz until it can be.
+	UINT refreshCount = statistics.SyncRefreshCount - m_frameStatistics.SyncRefreshCount;
+	LONGLONG refreshTicks = statistics.SyncQPCTime.QuadPart - m_frameStatistics.SyncQPCTime.QuadPart;
+	if (refreshCount > 0)
+	{
+		if (m_frameStatistics.SyncQPCTime.QuadPart != 0 && refreshTicks > 0)
+		{
+			m_refreshSeconds = static_cast<double>(refreshTicks) / refreshCount / frequency.QuadPart;
+		}
+		m_frameStatistics = statistics;
+	}
+
+	secondsSinceVblank = static_cast<double>(now.QuadPart - statistics.SyncQPCTime.QuadPart) / frequency.QuadPart;
+	refreshSeconds = m_refreshSeconds;
+	presentCount = statistics.PresentCount;
+	return true;
+}
+
 void DX::DeviceResources::WaitForGpuImpl(ID3D12CommandQueue* pQueue)
 {
 	// Schedule a Signal command in the queue.
@@ -423,23 +403,17 @@ void DX::DeviceResources::WaitForGpuOnVideoQueue()
 	WaitForGpuImpl(m_videoQueue.Get());
 }
 
-// Prepare to render the next frame.
+// Prepare to render the next frame. The caller waits for it to be ready to start.
 void DX::DeviceResources::MoveToNextFrame()
 {
 	// Schedule a Signal command in the queue.
 	const UINT64 currentFenceValue = m_fenceValues[m_currentFrame];
 	DX::ThrowIfFailed(m_commandQueue->Signal(m_fence.Get(), currentFenceValue));
+	m_presentedFenceValue = currentFenceValue;
 
 	// Advance the frame index.
 	m_currentFrame = m_swapChain->GetCurrentBackBufferIndex();
 
-	// Check to see if the next frame is ready to start.
-	if (m_fence->GetCompletedValue() < m_fenceValues[m_currentFrame])
-	{
-		DX::ThrowIfFailed(m_fence->SetEventOnCompletion(m_fenceValues[m_currentFrame], m_fenceEvent));
-		WaitForSingleObjectEx(m_fenceEvent, INFINITE, FALSE);
-	}
-
 	// Set the fence value for the next frame.
 	m_fenceValues[m_currentFrame] = currentFenceValue + 1;
 }
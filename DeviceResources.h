@@ -24,7 +24,7 @@ namespace DX
 	class DeviceResources
 	{
 	public:
-		DeviceResources(DXGI_FORMAT backBufferFormat = DXGI_FORMAT_B8G8R8A8_UNORM, DXGI_FORMAT depthBufferFormat = DXGI_FORMAT_D32_FLOAT);
+		DeviceResources(DXGI_FORMAT backBufferFormat = DXGI_FORMAT_B8G8R8A8_UNORM);
 		void SetWindow(HWND window);
 		void SetLogicalSize(SizeF logicalSize);
 		void ValidateDevice();
@@ -34,24 +34,34 @@ namespace DX
 
 		bool						IsDeviceRemoved() const				{ return m_deviceRemoved; }
 
+		// What Present signals, which reaches the value once the GPU is done with the last frame presented.
+		// Present doesn't wait for the next frame's resources: a frame only starts once the frame c_frameCount
+		// before it is done, which the caller waits for.
+		ID3D12Fence*				GetFence() const					{ return m_fence.Get(); }
+		UINT64						GetPresentedFenceValue() const		{ return m_presentedFenceValue; }
+
+		// 0 presents without waiting for vsync, 1 on the next vblank.
+		void						SetSyncInterval(UINT syncInterval)	{ m_syncInterval = syncInterval; }
+
+		// When the display last refreshed, in seconds before now, how often it does, and how many presents had
+		// been made by then. False until the swap chain has the statistics.
+		bool GetVblankTiming(double& secondsSinceVblank, double& refreshSeconds, UINT& presentCount);
+
 		HWND						GetWindow() const					{ return m_window; }
 
 		// D3D Accessors.
 		ID3D12Device*				GetD3DDevice() const				{ return m_d3dDevice.Get(); }
 		IDXGISwapChain3*			GetSwapChain() const				{ return m_swapChain.Get(); }
 
-		ID3D12Resource*				GetIntermediateRenderTarget() const { return m_intermediateRenderTarget.Get(); }
 		ID3D12Resource*				GetSwapChainRenderTarget() const	{ return m_swapChainRenderTargets[m_currentFrame].Get(); }
 
-		ID3D12Resource*				GetDepthStencil() const				{ return m_depthStencil.Get(); }
 		ID3D12CommandQueue*			GetCommandQueue() const				{ return m_commandQueue.Get(); }
 		ID3D12CommandQueue*			GetVideoQueue() const				{ return m_videoQueue.Get(); }
 
 		ID3D12CommandAllocator*		GetDirectCommandAllocator() const		{ return m_commandAllocators[m_currentFrame].Get(); }
-		ID3D12CommandAllocator*		GetVideoEncodeCommandAllocator() const	{ return m_videoEncodeCommandAllocator.Get(); }
+		ID3D12CommandAllocator*		GetVideoEncodeCommandAllocator() const	{ return m_videoEncodeCommandAllocators[m_currentFrame].Get(); }
 		
 		DXGI_FORMAT					GetBackBufferFormat() const			{ return m_backBufferFormat; }
-		DXGI_FORMAT					GetDepthBufferFormat() const		{ return m_depthBufferFormat; }
 
 		D3D12_VIEWPORT				GetPass1Viewport() const			{ return m_pass1Viewport; }
 		D3D12_VIEWPORT				GetPass2Viewport() const			{ return m_pass2Viewport; }
@@ -59,19 +69,10 @@ namespace DX
 		DirectX::XMFLOAT4X4			GetOrientationTransform3D() const	{ return m_orientationTransform3D; }
 		UINT						GetCurrentFrameIndex() const		{ return m_currentFrame; }
 
-		CD3DX12_CPU_DESCRIPTOR_HANDLE GetIntermediateRenderTargetCpuDescriptor() const
-		{
-			return CD3DX12_CPU_DESCRIPTOR_HANDLE(m_rtvHeap->GetCPUDescriptorHandleForHeapStart(), c_frameCount, m_rtvDescriptorSize);
-		}
-
 		CD3DX12_CPU_DESCRIPTOR_HANDLE GetSwapChainRenderTargetCpuDescriptor() const
 		{
 			return CD3DX12_CPU_DESCRIPTOR_HANDLE(m_rtvHeap->GetCPUDescriptorHandleForHeapStart(), m_currentFrame, m_rtvDescriptorSize);
 		}
-		CD3DX12_CPU_DESCRIPTOR_HANDLE GetDepthStencilView() const
-		{
-			return CD3DX12_CPU_DESCRIPTOR_HANDLE(m_dsvHeap->GetCPUDescriptorHandleForHeapStart());
-		}
 
 	private:
 		void CreateDeviceIndependentResources();
@@ -93,18 +94,14 @@ namespace DX
 		Microsoft::WRL::ComPtr<ID3D12Device>			m_d3dDevice;
 		Microsoft::WRL::ComPtr<IDXGIFactory4>			m_dxgiFactory;
 
-		Microsoft::WRL::ComPtr<ID3D12Resource>			m_intermediateRenderTarget;
 		Microsoft::WRL::ComPtr<ID3D12Resource>			m_swapChainRenderTargets[c_frameCount];
 
-		Microsoft::WRL::ComPtr<ID3D12Resource>			m_depthStencil;
 		Microsoft::WRL::ComPtr<ID3D12DescriptorHeap>	m_rtvHeap;
-		Microsoft::WRL::ComPtr<ID3D12DescriptorHeap>	m_dsvHeap;
 
 		Microsoft::WRL::ComPtr<ID3D12CommandAllocator>	m_commandAllocators[c_frameCount];
-		Microsoft::WRL::ComPtr<ID3D12CommandAllocator>  m_videoEncodeCommandAllocator;
+		Microsoft::WRL::ComPtr<ID3D12CommandAllocator>  m_videoEncodeCommandAllocators[c_frameCount];
 
 		DXGI_FORMAT										m_backBufferFormat;
-		DXGI_FORMAT										m_depthBufferFormat;
 
 		D3D12_VIEWPORT									m_pass1Viewport;
 		D3D12_VIEWPORT									m_pass2Viewport;
@@ -113,11 +110,17 @@ namespace DX
 
 		bool											m_deviceRemoved;
 		UINT											m_currentFrame;
+		UINT											m_syncInterval;
+
+		// The last frame statistics, for measuring the refresh interval.
+		DXGI_FRAME_STATISTICS							m_frameStatistics;
+		double											m_refreshSeconds;
 
 		// CPU/GPU Synchronization.
 		Microsoft::WRL::ComPtr<ID3D12Fence>				m_fence;
 		UINT64											m_fenceValues[c_frameCount];
 		HANDLE											m_fenceEvent;
+		UINT64											m_presentedFenceValue;
 
 		UINT64											m_videoFenceValue;
 
@@ -0,0 +1,250 @@
+#include "DynamicResolution.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+using namespace scaling;
+
+namespace
+{
+	// Weight of the newest frame in the smoothed cost.
+	const double c_smoothing = 0.2;
+
+	// Frames under this fraction of the budget are allowed to grow the sub-rect. Between this and the budget
+	// the size is held, so that it doesn't oscillate around the budget.
+	const double c_growThreshold = 0.85;
+
+	// A single frame over this multiple of the budget is treated as a spike, and acted on right away
+	// rather than waiting for it to show up in the smoothed cost.
+	const double c_spikeThreshold = 1.25;
+
+	// Growth is gradual, while shrinking happens in one step.
+	const float c_maxGrowthPerFrame = 0.02f;
+
+	// A trace stretch needs this many frames to count as steady, and the size has to be held for the last
+	// c_settledFrames of them for the controller to count as settled.
+	const int c_steadyStretchFrames = 60;
+	const int c_settledFrames = 30;
+	const double c_stretchChange = 0.25;
+}
+
+DynamicResolutionController::DynamicResolutionController(int maxWidth, int maxHeight, double budgetSeconds, float minScale)
+	: m_maxWidth(maxWidth)
+	, m_maxHeight(maxHeight)
+	, m_budgetSeconds(budgetSeconds)
+	, m_minScale(std::min(std::max(minScale, 0.0f), 1.0f))
+	, m_scale(1.0f)
+	, m_renderWidth(maxWidth)
+	, m_renderHeight(maxHeight)
+	, m_smoothedSeconds(0)
+{
+	Reset();
+}
+
+void DynamicResolutionController::Reset()
+{
+	m_smoothedSeconds = 0;
+	SetScale(1.0f);
+}
+
+void DynamicResolutionController::SetMaxSize(int maxWidth, int maxHeight)
+{
+	m_maxWidth = maxWidth;
+	m_maxHeight = maxHeight;
+	Reset();
+}
+
+void DynamicResolutionController::OnFrameCompleted(double frameSeconds, int renderWidth, int renderHeight)
+{
+	if (frameSeconds <= 0 || m_budgetSeconds <= 0 || renderWidth <= 0 || renderHeight <= 0)
+	{
+		return;
+	}
+	frameSeconds *= static_cast<double>(m_renderWidth) * m_renderHeight / (static_cast<double>(renderWidth) * renderHeight);
+
+	if (m_smoothedSeconds == 0 || frameSeconds > m_budgetSeconds * c_spikeThreshold)
+	{
+		m_smoothedSeconds = frameSeconds;
+	}
+	else
+	{
+		m_smoothedSeconds += (frameSeconds - m_smoothedSeconds) * c_smoothing;
+	}
+
+	// Cost is taken to be proportional to the number of pixels, which goes with the square of the scale.
+	double headroom = m_budgetSeconds / m_smoothedSeconds;
+	float idealScale = static_cast<float>(m_scale * std::sqrt(headroom));
+
+	float newScale = m_scale;
+	if (headroom < 1.0)
+	{
+		newScale = idealScale;
+	}
+	else if (m_smoothedSeconds < m_budgetSeconds * c_growThreshold)
+	{
+		newScale = std::min(idealScale, m_scale + c_maxGrowthPerFrame);
+	}
+
+	newScale = std::min(std::max(newScale, m_minScale), 1.0f);
+	if (newScale != m_scale)
+	{
+		// Predict what the smoothed cost will be at the new size, so that frames rendered at the old size
+		// don't keep pushing it in the same direction.
+		double ratio = static_cast<double>(newScale) / m_scale;
+		m_smoothedSeconds *= ratio * ratio;
+		SetScale(newScale);
+	}
+}
+
+void DynamicResolutionController::SetScale(float scale)
+{
+	m_scale = scale;
+
+	// Sizes are kept even, since the motion estimation input is NV12 and subsamples chroma 2x2.
+	m_renderWidth = std::max(2, static_cast<int>(m_maxWidth * scale) & ~1);
+	m_renderHeight = std::max(2, static_cast<int>(m_maxHeight * scale) & ~1);
+	m_renderWidth = std::min(m_renderWidth, m_maxWidth);
+	m_renderHeight = std::min(m_renderHeight, m_maxHeight);
+}
+
+DynamicResolutionSimulation scaling::SimulateDynamicResolution(std::vector<double> const& fullSizeSeconds, int maxWidth, int maxHeight, double budgetSeconds, int latencyFrames, float minScale)
+{
+	assert(latencyFrames >= 1);
+	DynamicResolutionController controller(maxWidth, maxHeight, budgetSeconds, minScale);
+	int minWidth = std::max(2, static_cast<int>(maxWidth * minScale) & ~1);
+	int minHeight = std::max(2, static_cast<int>(maxHeight * minScale) & ~1);
+
+	DynamicResolutionSimulation simulation = {};
+	simulation.frameCount = static_cast<int>(fullSizeSeconds.size());
+	simulation.minRenderWidth = maxWidth;
+	simulation.minRenderHeight = maxHeight;
+	simulation.isWithinBounds = true;
+
+	// What each frame cost, and the size it was rendered at.
+	struct RenderedFrame
+	{
+		double seconds;
+		int width;
+		int height;
+	};
+	std::vector<RenderedFrame> rendered(simulation.frameCount);
+
+	int stretchStart = 0;
+	int sizeHeldSince = 0;
+	int lastShrink = -1;
+	double heldSeconds = 0.0;
+	for (int frame = 0; frame < simulation.frameCount; ++frame)
+	{
+		// The cost of the frame latencyFrames back is in, and may change the size of this one.
+		int measured = frame - latencyFrames;
+		if (measured >= 0)
+		{
+			int previousWidth = controller.GetRenderWidth();
+			int previousHeight = controller.GetRenderHeight();
+			controller.OnFrameCompleted(rendered[measured].seconds, rendered[measured].width, rendered[measured].height);
+			if (controller.GetRenderWidth() != previousWidth || controller.GetRenderHeight() != previousHeight)
+			{
+				sizeHeldSince = frame;
+				heldSeconds = 0.0;
+			}
+			if (controller.GetRenderWidth() < previousWidth)
+			{
+				++simulation.shrinkCount;
+				if (measured < lastShrink)
+				{
+					++simulation.staleShrinkCount;
+				}
+				lastShrink = frame;
+			}
+		}
+
+		int width = controller.GetRenderWidth();
+		int height = controller.GetRenderHeight();
+		simulation.isWithinBounds = simulation.isWithinBounds &&
+			width % 2 == 0 && height % 2 == 0 &&
+			width >= minWidth && width <= maxWidth && height >= minHeight && height <= maxHeight;
+		simulation.minRenderWidth = std::min(simulation.minRenderWidth, width);
+		simulation.minRenderHeight = std::min(simulation.minRenderHeight, height);
+
+		double seconds = fullSizeSeconds[frame] * width * height / (static_cast<double>(maxWidth) * maxHeight);
+		if (seconds > budgetSeconds)
+		{
+			++simulation.overBudgetCount;
+		}
+		rendered[frame] = RenderedFrame{ seconds, width, height };
+		heldSeconds += seconds;
+
+		bool isStretchEnd = frame + 1 == simulation.frameCount ||
+			std::abs(fullSizeSeconds[frame + 1] - fullSizeSeconds[frame]) > fullSizeSeconds[frame] * c_stretchChange;
+		if (isStretchEnd)
+		{
+			int frameCount = frame + 1 - stretchStart;
+			int heldFrameCount = frame + 1 - std::max(sizeHeldSince, stretchStart);
+			if (frameCount >= c_steadyStretchFrames)
+			{
+				++simulation.steadyStretchCount;
+				if (heldFrameCount >= c_settledFrames &&
+					(heldSeconds / heldFrameCount <= budgetSeconds || controller.GetScale() <= minScale))
+				{
+					++simulation.settledStretchCount;
+				}
+			}
+			stretchStart = frame + 1;
+			heldSeconds = 0.0;
+		}
+	}
+	return simulation;
+}
+
+bool scaling::LoadFrameCostTrace(std::string const& path, std::vector<double>& seconds, std::string& error)
+{
+	std::ifstream file(path);
+	if (!file)
+	{
+		error = "Couldn't open " + path;
+		return false;
+	}
+
+	seconds.clear();
+	std::string line;
+	for (int lineNumber = 1; std::getline(file, line); ++lineNumber)
+	{
+		size_t first = line.find_first_not_of(" \t\r");
+		if (first == std::string::npos || line[first] == '#')
+		{
+			continue;
+		}
+
+		std::istringstream fields(line);
+		double milliseconds = 0.0;
+		std::string rest;
+		if (!(fields >> milliseconds) || (fields >> rest) || milliseconds <= 0.0)
+		{
+			error = path + " line " + std::to_string(lineNumber) + " isn't a frame cost in milliseconds";
+			return false;
+		}
+		seconds.push_back(milliseconds / 1000.0);
+	}
+	return true;
+}
+
+bool scaling::IsDynamicResolutionSettled(DynamicResolutionSimulation const& simulation)
+{
+	return simulation.isWithinBounds && simulation.settledStretchCount == simulation.steadyStretchCount && simulation.staleShrinkCount == 0;
+}
+
+std::string scaling::FormatDynamicResolutionSimulation(DynamicResolutionSimulation const& simulation, int maxWidth, int maxHeight)
+{
+	char text[320];
+	snprintf(text, sizeof(text),
+		"Dynamic resolution: %d frames, %d over budget, %d shrinks of which %d by costs from before the last one, settled in %d of %d steady stretches, sizes from %dx%d to %dx%d%s",
+		simulation.frameCount, simulation.overBudgetCount, simulation.shrinkCount, simulation.staleShrinkCount,
+		simulation.settledStretchCount, simulation.steadyStretchCount,
+		simulation.minRenderWidth, simulation.minRenderHeight, maxWidth, maxHeight,
+		simulation.isWithinBounds ? "" : ", some of them odd or out of bounds");
+	return text;
+}
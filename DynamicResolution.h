@@ -0,0 +1,85 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace scaling
+{
+	// Picks the size of the pass 1 render sub-rect from how long recent frames took, so that rendering stays
+	// within a frame-time budget. The sub-rect always keeps the aspect ratio of the full allocation, and
+	// never goes outside of it, so changing it doesn't reallocate anything.
+	//
+	// Doesn't measure anything itself: call OnFrameCompleted with the cost of each frame and the size it was
+	// rendered at. That keeps it deterministic for a given sequence of costs. Costs usually arrive a few
+	// frames late, from frames rendered before the size last changed, so each is scaled to the current size
+	// by the number of pixels first; otherwise a frame from before a shrink would count against the smaller
+	// size and shrink it again.
+	class DynamicResolutionController
+	{
+	public:
+		DynamicResolutionController(int maxWidth, int maxHeight, double budgetSeconds, float minScale = 0.5f);
+
+		void OnFrameCompleted(double frameSeconds, int renderWidth, int renderHeight);
+
+		// Goes back to the full size and forgets the measurement history.
+		void Reset();
+
+		// Changes the full size, for instance when switching quality presets. Also resets.
+		void SetMaxSize(int maxWidth, int maxHeight);
+
+		int		GetRenderWidth() const		{ return m_renderWidth; }
+		int		GetRenderHeight() const		{ return m_renderHeight; }
+		int		GetMaxWidth() const			{ return m_maxWidth; }
+		int		GetMaxHeight() const		{ return m_maxHeight; }
+
+		// Fraction of the full size along each axis, in [minScale, 1].
+		float	GetScale() const			{ return m_scale; }
+
+		double	GetBudgetSeconds() const	{ return m_budgetSeconds; }
+		void	SetBudgetSeconds(double budgetSeconds) { m_budgetSeconds = budgetSeconds; }
+
+	private:
+		void SetScale(float scale);
+
+		int m_maxWidth;
+		int m_maxHeight;
+		double m_budgetSeconds;
+		float m_minScale;
+
+		float m_scale;
+		int m_renderWidth;
+		int m_renderHeight;
+
+		// Smoothed frame cost, in seconds at the current scale. 0 means nothing has been measured yet.
+		double m_smoothedSeconds;
+	};
+
+	struct DynamicResolutionSimulation
+	{
+		int frameCount;
+		int overBudgetCount;		// Frames that took longer than the budget
+		int shrinkCount;
+		int staleShrinkCount;		// Shrinks by a cost from a frame rendered before the last shrink
+		int minRenderWidth;
+		int minRenderHeight;
+		bool isWithinBounds;		// Every size was even, and between the minimum and the full size
+		int steadyStretchCount;		// Stretches of the trace long enough to settle in
+		int settledStretchCount;	// Of those, the ones that ended with the size held and within the budget
+	};
+
+	// Runs a trace of frame costs at the full size through a controller. Each frame costs its share of the
+	// full size's pixels, the way the controller expects, and its cost reaches the controller latencyFrames
+	// frames later, before that frame is sized, the way GPU timestamps do with that many frames in flight. A
+	// stretch ends where the cost changes by more than a quarter from one frame to the next; the controller
+	// is settled at the end of one if it hasn't changed the size for a while, and the frames since then were
+	// within the budget on average, or the scale is at its minimum.
+	DynamicResolutionSimulation SimulateDynamicResolution(std::vector<double> const& fullSizeSeconds, int maxWidth, int maxHeight, double budgetSeconds, int latencyFrames, float minScale = 0.5f);
+
+	// Reads one frame cost in milliseconds per line. Blank lines and lines that start with # are skipped.
+	bool LoadFrameCostTrace(std::string const& path, std::vector<double>& seconds, std::string& error);
+
+	// Whether the controller settled in every steady stretch, kept every size even and within bounds, and
+	// never shrank twice for the same cost.
+	bool IsDynamicResolutionSettled(DynamicResolutionSimulation const& simulation);
+	std::string FormatDynamicResolutionSimulation(DynamicResolutionSimulation const& simulation, int maxWidth, int maxHeight);
+}
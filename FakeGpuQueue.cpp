@@ -0,0 +1,90 @@
+#include "FakeGpuQueue.h"
+
+using namespace scaling;
+
+FakeGpuFence::FakeGpuFence()
+	: m_value(0)
+{
+}
+
+uint64_t FakeGpuFence::GetCompletedValue() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_value;
+}
+
+void FakeGpuFence::WaitOnCpu(uint64_t value)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_completed.wait(lock, [&] { return m_value >= value; });
+}
+
+void FakeGpuFence::Complete(uint64_t value)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (value <= m_value)
+		{
+			return;
+		}
+		m_value = value;
+	}
+	m_completed.notify_all();
+}
+
+FakeGpuQueue::FakeGpuQueue()
+	: m_exiting(false)
+{
+	m_thread = std::thread(&FakeGpuQueue::QueueMain, this);
+}
+
+FakeGpuQueue::~FakeGpuQueue()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_exiting = true;
+	}
+	m_workAvailable.notify_one();
+	m_thread.join();
+}
+
+void FakeGpuQueue::Execute(std::function<void()> work)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_work.push_back(std::move(work));
+	}
+	m_workAvailable.notify_one();
+}
+
+void FakeGpuQueue::Signal(IGpuFence& fence, uint64_t value)
+{
+	FakeGpuFence& fakeFence = static_cast<FakeGpuFence&>(fence);
+	Execute([&fakeFence, value] { fakeFence.Complete(value); });
+}
+
+void FakeGpuQueue::Wait(IGpuFence& fence, uint64_t value)
+{
+	FakeGpuFence& fakeFence = static_cast<FakeGpuFence&>(fence);
+	Execute([&fakeFence, value] { fakeFence.WaitOnCpu(value); });
+}
+
+void FakeGpuQueue::QueueMain()
+{
+	for (;;)
+	{
+		std::function<void()> work;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_workAvailable.wait(lock, [this] { return m_exiting || !m_work.empty(); });
+			if (m_work.empty())
+			{
+				return;
+			}
+			work = std::move(m_work.front());
+			m_work.pop_front();
+		}
+
+		work();
+	}
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "GpuQueue.h"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace scaling
+{
+	class FakeGpuFence : public IGpuFence
+	{
+	public:
+		FakeGpuFence();
+
+		uint64_t GetCompletedValue() const override;
+		void WaitOnCpu(uint64_t value) override;
+
+		// What a queue does when it reaches a signal. Values lower than the current one are ignored.
+		void Complete(uint64_t value);
+
+	private:
+		mutable std::mutex		m_mutex;
+		std::condition_variable	m_completed;
+		uint64_t				m_value;
+	};
+
+	// Stands in for a GPU queue where there isn't one, so that the order work runs in across queues can be
+	// checked on any platform. Everything submitted runs in order on a thread of the queue's own, and a Wait
+	// blocks that thread rather than the caller. Signal and Wait only take FakeGpuFences.
+	class FakeGpuQueue : public IGpuQueue
+	{
+	public:
+		FakeGpuQueue();
+		~FakeGpuQueue(); // Finishes everything submitted first
+
+		void Execute(std::function<void()> work);
+
+		void Signal(IGpuFence& fence, uint64_t value) override;
+		void Wait(IGpuFence& fence, uint64_t value) override;
+
+	private:
+		void QueueMain();
+
+		std::mutex								m_mutex;
+		std::condition_variable					m_workAvailable;
+		std::deque<std::function<void()>>		m_work;
+		bool									m_exiting;
+		std::thread								m_thread;
+	};
+}
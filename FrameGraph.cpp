@@ -0,0 +1,293 @@
+#include "FrameGraph.h"
+
+#include <algorithm>
+#include <cassert>
+
+using namespace scaling;
+
+namespace
+{
+	uint64_t AlignUp(uint64_t value, uint64_t alignment)
+	{
+		return alignment > 1 ? (value + alignment - 1) / alignment * alignment : value;
+	}
+
+	bool Overlaps(int firstA, int lastA, int firstB, int lastB)
+	{
+		return firstA <= lastB && firstB <= lastA;
+	}
+
+	// Kahn's algorithm, taking the earliest added of the passes that are ready, so that passes added in an
+	// order that works keep it.
+	bool OrderPasses(FrameGraph const& graph, std::vector<int>& order)
+	{
+		std::vector<FrameGraph::Pass> const& passes = graph.GetPasses();
+		int passCount = static_cast<int>(passes.size());
+
+		std::vector<std::vector<int>> writers(graph.GetResources().size());
+		for (int pass = 0; pass < passCount; ++pass)
+		{
+			for (FrameGraph::Access const& access : passes[pass].accesses)
+			{
+				std::vector<int>& resourceWriters = writers[access.resource];
+				if (access.isWrite && (resourceWriters.empty() || resourceWriters.back() != pass))
+				{
+					resourceWriters.push_back(pass);
+				}
+			}
+		}
+
+		std::vector<std::vector<int>> dependents(passCount);
+		std::vector<int> dependencyCount(passCount, 0);
+		auto addDependency = [&](int before, int after)
+		{
+			std::vector<int>& beforeDependents = dependents[before];
+			if (before != after && std::find(beforeDependents.begin(), beforeDependents.end(), after) == beforeDependents.end())
+			{
+				beforeDependents.push_back(after);
+				++dependencyCount[after];
+			}
+		};
+
+		for (std::vector<int> const& resourceWriters : writers)
+		{
+			for (size_t i = 1; i < resourceWriters.size(); ++i)
+			{
+				addDependency(resourceWriters[i - 1], resourceWriters[i]);
+			}
+		}
+		for (int pass = 0; pass < passCount; ++pass)
+		{
+			for (FrameGraph::Access const& access : passes[pass].accesses)
+			{
+				if (!access.isWrite)
+				{
+					for (int writer : writers[access.resource])
+					{
+						addDependency(writer, pass);
+					}
+				}
+			}
+		}
+
+		order.clear();
+		std::vector<bool> isDone(passCount, false);
+		while (static_cast<int>(order.size()) < passCount)
+		{
+			int next = -1;
+			for (int pass = 0; pass < passCount && next < 0; ++pass)
+			{
+				if (!isDone[pass] && dependencyCount[pass] == 0)
+				{
+					next = pass;
+				}
+			}
+			if (next < 0)
+			{
+				return false;
+			}
+
+			isDone[next] = true;
+			order.push_back(next);
+			for (int dependent : dependents[next])
+			{
+				--dependencyCount[dependent];
+			}
+		}
+		return true;
+	}
+
+	// Largest first, each at the lowest offset that doesn't overlap the memory of anything already placed
+	// whose lifetime overlaps its own.
+	void PlaceTransients(FrameGraph const& graph, FrameGraphPlan& plan)
+	{
+		std::vector<FrameGraph::Resource> const& resources = graph.GetResources();
+
+		std::vector<int> transients;
+		for (int resource = 0; resource < static_cast<int>(resources.size()); ++resource)
+		{
+			if (resources[resource].isTransient && plan.resources[resource].firstPass >= 0)
+			{
+				transients.push_back(resource);
+			}
+		}
+		std::stable_sort(transients.begin(), transients.end(), [&](int a, int b)
+		{
+			return resources[a].footprint.size > resources[b].footprint.size;
+		});
+
+		std::vector<int> placed;
+		std::vector<std::pair<uint64_t, uint64_t>> taken; // Memory of the placed resources alive at the same time
+		for (int resource : transients)
+		{
+			PlannedResource& planned = plan.resources[resource];
+			ResourceFootprint const& footprint = resources[resource].footprint;
+
+			taken.clear();
+			for (int other : placed)
+			{
+				PlannedResource const& otherPlanned = plan.resources[other];
+				if (Overlaps(planned.firstPass, planned.lastPass, otherPlanned.firstPass, otherPlanned.lastPass))
+				{
+					taken.emplace_back(otherPlanned.heapOffset, otherPlanned.heapOffset + resources[other].footprint.size);
+				}
+			}
+			std::sort(taken.begin(), taken.end());
+
+			uint64_t offset = 0;
+			for (std::pair<uint64_t, uint64_t> const& range : taken)
+			{
+				if (AlignUp(offset, footprint.alignment) + footprint.size <= range.first)
+				{
+					break;
+				}
+				offset = std::max(offset, range.second);
+			}
+			planned.heapOffset = AlignUp(offset, footprint.alignment);
+
+			placed.push_back(resource);
+			plan.heapBytes = std::max(plan.heapBytes, planned.heapOffset + footprint.size);
+		}
+
+		// A transient whose memory something else used earlier in the frame needs an aliasing barrier first.
+		for (int resource : transients)
+		{
+			PlannedResource const& planned = plan.resources[resource];
+			uint64_t end = planned.heapOffset + resources[resource].footprint.size;
+			for (int other : transients)
+			{
+				PlannedResource const& otherPlanned = plan.resources[other];
+				uint64_t otherEnd = otherPlanned.heapOffset + resources[other].footprint.size;
+				if (otherPlanned.lastPass < planned.firstPass && planned.heapOffset < otherEnd && otherPlanned.heapOffset < end)
+				{
+					plan.passes[planned.firstPass].aliasedResources.push_back(resource);
+					break;
+				}
+			}
+		}
+	}
+}
+
+FrameGraph::FrameGraph(uint32_t readStates)
+	: m_readStates(readStates)
+{
+}
+
+int FrameGraph::AddTransient(std::string const& name, ResourceFootprint footprint, uint32_t initialState)
+{
+	m_resources.push_back(Resource{ name, footprint, initialState, true });
+	return static_cast<int>(m_resources.size()) - 1;
+}
+
+int FrameGraph::AddPersistent(std::string const& name, ResourceFootprint footprint, uint32_t initialState)
+{
+	m_resources.push_back(Resource{ name, footprint, initialState, false });
+	return static_cast<int>(m_resources.size()) - 1;
+}
+
+FrameGraph::HistoryPair FrameGraph::AddHistoryPair(std::string const& name, ResourceFootprint footprint, uint32_t initialState)
+{
+	HistoryPair pair;
+	pair.current = AddPersistent(name, footprint, initialState);
+	pair.previous = AddPersistent(name + ", last frame's", footprint, initialState);
+	m_resources[pair.previous].isLastFrame = true;
+	return pair;
+}
+
+int FrameGraph::AddPass(std::string const& name)
+{
+	m_passes.push_back(Pass{ name, {} });
+	return static_cast<int>(m_passes.size()) - 1;
+}
+
+void FrameGraph::Read(int pass, int resource, uint32_t state)
+{
+	assert(resource >= 0 && resource < static_cast<int>(m_resources.size()));
+	m_passes[pass].accesses.push_back(Access{ resource, state, false });
+}
+
+void FrameGraph::Write(int pass, int resource, uint32_t state)
+{
+	assert(resource >= 0 && resource < static_cast<int>(m_resources.size()));
+	m_passes[pass].accesses.push_back(Access{ resource, state, true });
+}
+
+bool scaling::PlanFrameGraph(FrameGraph const& graph, FrameGraphPlan& plan, std::string& error)
+{
+	std::vector<FrameGraph::Resource> const& resources = graph.GetResources();
+	std::vector<FrameGraph::Pass> const& passes = graph.GetPasses();
+
+	plan = FrameGraphPlan();
+
+	for (FrameGraph::Pass const& pass : passes)
+	{
+		for (FrameGraph::Access const& access : pass.accesses)
+		{
+			if (access.isWrite && resources[access.resource].isLastFrame)
+			{
+				error = pass.name + " writes " + resources[access.resource].name + ", which is history";
+				return false;
+			}
+		}
+	}
+
+	std::vector<int> order;
+	if (!OrderPasses(graph, order))
+	{
+		error = "The passes depend on each other in a cycle";
+		return false;
+	}
+
+	plan.resources.assign(resources.size(), PlannedResource{ -1, -1, 0 });
+	for (int position = 0; position < static_cast<int>(order.size()); ++position)
+	{
+		plan.passes.push_back(PlannedPass{ order[position], {}, {} });
+		for (FrameGraph::Access const& access : passes[order[position]].accesses)
+		{
+			PlannedResource& planned = plan.resources[access.resource];
+			if (planned.firstPass < 0)
+			{
+				planned.firstPass = position;
+			}
+			planned.lastPass = position;
+		}
+	}
+
+	for (size_t resource = 0; resource < resources.size(); ++resource)
+	{
+		if (!resources[resource].isTransient)
+		{
+			plan.persistentBytes += resources[resource].footprint.size;
+		}
+		else if (plan.resources[resource].firstPass >= 0)
+		{
+			plan.transientBytes += resources[resource].footprint.size;
+		}
+	}
+	PlaceTransients(graph, plan);
+
+	// The barriers are what a tracker would record, given each pass's states and a flush before each pass.
+	ResourceStateTracker tracker(graph.GetReadStates());
+	for (size_t resource = 0; resource < resources.size(); ++resource)
+	{
+		tracker.SetState(&plan.resources[resource], resources[resource].initialState);
+	}
+	for (PlannedPass& plannedPass : plan.passes)
+	{
+		for (FrameGraph::Access const& access : passes[plannedPass.pass].accesses)
+		{
+			tracker.Require(&plan.resources[access.resource], access.state);
+		}
+		plannedPass.barriers = tracker.Flush();
+	}
+	for (size_t resource = 0; resource < resources.size(); ++resource)
+	{
+		if (!resources[resource].isTransient)
+		{
+			tracker.Require(&plan.resources[resource], resources[resource].initialState);
+		}
+	}
+	plan.finalBarriers = tracker.Flush();
+
+	return true;
+}
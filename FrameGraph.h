@@ -0,0 +1,117 @@
+#pragma once
+
+#include "ResourceStateTracker.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace scaling
+{
+	// How much memory a resource takes in a heap, and what its offset has to be a multiple of.
+	struct ResourceFootprint
+	{
+		uint64_t size;
+		uint64_t alignment;
+	};
+
+	// One frame's passes, and the resources they read and write, declared up front so that the whole frame
+	// can be planned before any of it is recorded. Resources are either transient, meaning they only hold
+	// anything between the first and last passes that use them, or persistent, like history that the next
+	// frame reads. States are bit masks, as for ResourceStateTracker.
+	class FrameGraph
+	{
+	public:
+		explicit FrameGraph(uint32_t readStates);
+
+		// The state is what the resource is in before the frame's first pass uses it. Returns the resource's
+		// index.
+		int AddTransient(std::string const& name, ResourceFootprint footprint, uint32_t initialState);
+		int AddPersistent(std::string const& name, ResourceFootprint footprint, uint32_t initialState);
+
+		// Two persistent resources that trade places every frame, for history: the frame writes current and
+		// reads the last frame's from previous, which was last frame's current, so nothing is copied. Planning
+		// fails if a pass writes previous.
+		struct HistoryPair
+		{
+			int current;
+			int previous;
+		};
+		HistoryPair AddHistoryPair(std::string const& name, ResourceFootprint footprint, uint32_t initialState);
+
+		// Returns the pass's index. Passes can be added in any order: a pass runs after every other pass that
+		// writes what it reads, and passes that write the same resource run in the order they were added. So
+		// reads see what the frame writes, and history from the last frame needs a resource of its own.
+		int AddPass(std::string const& name);
+		void Read(int pass, int resource, uint32_t state);
+		void Write(int pass, int resource, uint32_t state);
+
+		struct Access
+		{
+			int resource;
+			uint32_t state;
+			bool isWrite;
+		};
+
+		struct Resource
+		{
+			std::string name;
+			ResourceFootprint footprint;
+			uint32_t initialState;
+			bool isTransient;
+			bool isLastFrame = false;	// The previous half of a history pair
+		};
+
+		struct Pass
+		{
+			std::string name;
+			std::vector<Access> accesses;
+		};
+
+		std::vector<Resource> const& GetResources() const { return m_resources; }
+		std::vector<Pass> const& GetPasses() const { return m_passes; }
+		uint32_t GetReadStates() const { return m_readStates; }
+
+	private:
+		uint32_t m_readStates;
+		std::vector<Resource> m_resources;
+		std::vector<Pass> m_passes;
+	};
+
+	struct PlannedPass
+	{
+		int pass;
+		std::vector<int> aliasedResources;			// Transients that start using memory another one used earlier in the frame
+		std::vector<StateTransition> barriers;		// Resources are addresses in FrameGraphPlan::resources
+	};
+
+	struct PlannedResource
+	{
+		int firstPass;		// Positions in the plan's order, or -1 for resources no pass uses
+		int lastPass;
+		uint64_t heapOffset; // For transients, where in the shared heap the resource goes
+	};
+
+	struct FrameGraphPlan
+	{
+		std::vector<PlannedPass> passes;			// In the order they run
+		std::vector<PlannedResource> resources;		// Indexed like the graph's
+
+		uint64_t persistentBytes;
+		uint64_t transientBytes;	// Every transient in memory of its own
+		uint64_t heapBytes;			// The transients sharing one heap wherever their lifetimes don't overlap
+
+		// What puts the persistent resources back in the states they started the frame in.
+		std::vector<StateTransition> finalBarriers;
+
+		uint64_t GetPeakBytes() const { return persistentBytes + transientBytes; }
+		uint64_t GetAliasedPeakBytes() const { return persistentBytes + heapBytes; }
+
+		int GetResourceIndex(void const* resource) const { return static_cast<int>(static_cast<PlannedResource const*>(resource) - resources.data()); }
+	};
+
+	// Orders the passes, works out the barriers before each of them, and places the transients in a heap.
+	// Fails, saying why, when the passes depend on each other in a cycle, or one writes the last frame's
+	// history.
+	bool PlanFrameGraph(FrameGraph const& graph, FrameGraphPlan& plan, std::string& error);
+}
@@ -0,0 +1,332 @@
+#include "FramePacer.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+using namespace scaling;
+
+namespace
+{
+	// How much earlier than the slowest recent frame needs a frame starts, under the latency-minimizing policy.
+	const double c_marginSeconds = 0.001;
+
+	// Started frames that are never reported as displayed are forgotten after this many.
+	const size_t c_maxStartedFrames = 64;
+
+	// The index of the first vblank at or after the time. Times a hair past a vblank count as on it.
+	long long GetVblankAtOrAfter(double seconds, double vblankSeconds, double refreshSeconds)
+	{
+		return static_cast<long long>(std::ceil((seconds - vblankSeconds) / refreshSeconds - 1e-6));
+	}
+}
+
+SteadyPacingClock::SteadyPacingClock()
+	: m_start(std::chrono::steady_clock::now())
+{
+}
+
+double SteadyPacingClock::GetSeconds() const
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();
+}
+
+void SteadyPacingClock::SleepUntil(double seconds)
+{
+	std::this_thread::sleep_until(m_start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(seconds)));
+}
+
+void SimulatedPacingClock::SleepUntil(double seconds)
+{
+	m_seconds = std::max(m_seconds, seconds);
+}
+
+char const* scaling::GetPacingPolicyName(PacingPolicy policy)
+{
+	switch (policy)
+	{
+	case PacingPolicy::MaxThroughput: return "throughput";
+	case PacingPolicy::VsyncLocked: return "vsync";
+	default: return "low-latency";
+	}
+}
+
+bool scaling::ParsePacingPolicy(std::string const& name, PacingPolicy& policy)
+{
+	for (PacingPolicy candidate : { PacingPolicy::MaxThroughput, PacingPolicy::VsyncLocked, PacingPolicy::LowLatency })
+	{
+		if (name == GetPacingPolicyName(candidate))
+		{
+			policy = candidate;
+			return true;
+		}
+	}
+	return false;
+}
+
+FramePacer::FramePacer(IPacingClock& clock, PacingPolicy policy, double refreshSeconds)
+	: m_clock(clock)
+	, m_policy(policy)
+	, m_refreshSeconds(refreshSeconds)
+	, m_vblankSeconds(0.0)
+	, m_targetVblank(-1)
+	, m_recentSeconds()
+	, m_recentCount(0)
+	, m_nextRecent(0)
+	, m_correction(0)
+{
+	assert(refreshSeconds > 0.0);
+}
+
+void FramePacer::OnVblank(double seconds, double refreshSeconds)
+{
+	assert(refreshSeconds > 0.0);
+	double targetSeconds = GetTargetVblankSeconds();
+	m_vblankSeconds = seconds;
+	m_refreshSeconds = refreshSeconds;
+	m_targetVblank = std::llround((targetSeconds - seconds) / refreshSeconds);
+}
+
+void FramePacer::OnFrameMeasured(double cpuSeconds, double gpuSeconds)
+{
+	m_recentSeconds[m_nextRecent] = cpuSeconds + gpuSeconds;
+	m_nextRecent = (m_nextRecent + 1) % c_historyLength;
+	m_recentCount = std::min(m_recentCount + 1, c_historyLength);
+}
+
+void FramePacer::OnFramesDisplayed(int count, double lastSeconds)
+{
+	StartedFrame last = {};
+	for (int i = 0; i < count; ++i)
+	{
+		if (m_startedFrames.empty())
+		{
+			return;
+		}
+		last = m_startedFrames.front();
+		m_startedFrames.pop_front();
+	}
+
+	// Frames that started after the last correction are late because of what came before them.
+	long long lateVblanks = std::llround((lastSeconds - last.targetSeconds) / m_refreshSeconds);
+	if (lateVblanks > 0 && last.correction == m_correction)
+	{
+		m_targetVblank += lateVblanks;
+		++m_correction;
+	}
+}
+
+void FramePacer::WaitForFrameStart()
+{
+	if (m_policy != PacingPolicy::LowLatency)
+	{
+		return;
+	}
+
+	// The first vblank the frame can make, and never one an earlier frame was aimed at.
+	double frameSeconds = PredictFrameSeconds() + c_marginSeconds;
+	long long vblank = GetVblankAtOrAfter(m_clock.GetSeconds() + frameSeconds, m_vblankSeconds, m_refreshSeconds);
+	m_targetVblank = std::max(vblank, m_targetVblank + 1);
+
+	m_startedFrames.push_back(StartedFrame{ GetTargetVblankSeconds(), m_correction });
+	if (m_startedFrames.size() > c_maxStartedFrames)
+	{
+		m_startedFrames.pop_front();
+	}
+	m_clock.SleepUntil(GetTargetVblankSeconds() - frameSeconds);
+}
+
+double FramePacer::PredictFrameSeconds() const
+{
+	double slowest = 0.0;
+	for (int i = 0; i < m_recentCount; ++i)
+	{
+		slowest = std::max(slowest, m_recentSeconds[i]);
+	}
+	return slowest;
+}
+
+bool scaling::LoadFrameTimeTrace(std::string const& path, std::vector<FrameTimes>& trace, std::string& error)
+{
+	std::ifstream file(path);
+	if (!file)
+	{
+		error = "Couldn't open " + path;
+		return false;
+	}
+
+	trace.clear();
+	std::string line;
+	for (int lineNumber = 1; std::getline(file, line); ++lineNumber)
+	{
+		size_t first = line.find_first_not_of(" \t\r");
+		if (first == std::string::npos || line[first] == '#')
+		{
+			continue;
+		}
+
+		std::istringstream fields(line);
+		double cpuMilliseconds = 0.0;
+		double gpuMilliseconds = 0.0;
+		std::string rest;
+		if (!(fields >> cpuMilliseconds >> gpuMilliseconds) || (fields >> rest) || cpuMilliseconds < 0.0 || gpuMilliseconds < 0.0)
+		{
+			error = path + " line " + std::to_string(lineNumber) + " isn't a CPU and a GPU time in milliseconds";
+			return false;
+		}
+		trace.push_back(FrameTimes{ cpuMilliseconds / 1000.0, gpuMilliseconds / 1000.0 });
+	}
+	return true;
+}
+
+bool scaling::SaveFrameTimeTrace(std::string const& path, std::vector<FrameTimes> const& trace, std::string& error)
+{
+	std::ofstream file(path);
+	file << "# CPU and GPU milliseconds per frame\n";
+	for (FrameTimes const& times : trace)
+	{
+		char text[64];
+		snprintf(text, sizeof(text), "%.4f %.4f\n", times.cpuSeconds * 1000.0, times.gpuSeconds * 1000.0);
+		file << text;
+	}
+	if (!file)
+	{
+		error = "Couldn't write " + path;
+		return false;
+	}
+	return true;
+}
+
+PacingSimulation scaling::SimulatePacing(std::vector<FrameTimes> const& trace, PacingPolicy policy, double refreshSeconds, int framesInFlight)
+{
+	assert(refreshSeconds > 0.0 && framesInFlight > 0);
+
+	PacingSimulation simulation = {};
+	int frameCount = static_cast<int>(trace.size());
+	simulation.frameCount = frameCount;
+	if (frameCount == 0)
+	{
+		return simulation;
+	}
+
+	SimulatedPacingClock clock;
+	FramePacer pacer(clock, policy, refreshSeconds);
+	bool isVsync = pacer.GetSyncInterval() != 0;
+
+	std::vector<double> gpuEnds(frameCount);
+	std::vector<double> displays(frameCount);
+	int reportedCount = 0;
+	int displayedCount = 0;
+	double latencySum = 0.0;
+	for (int frame = 0; frame < frameCount; ++frame)
+	{
+		if (frame >= framesInFlight)
+		{
+			clock.SleepUntil(isVsync ? displays[frame - framesInFlight] : gpuEnds[frame - framesInFlight]);
+		}
+		for (; reportedCount < frame && gpuEnds[reportedCount] <= clock.GetSeconds(); ++reportedCount)
+		{
+			pacer.OnFrameMeasured(trace[reportedCount].cpuSeconds, trace[reportedCount].gpuSeconds);
+		}
+		for (; displayedCount < frame && displays[displayedCount] <= clock.GetSeconds(); ++displayedCount)
+		{
+			pacer.OnFramesDisplayed(1, displays[displayedCount]);
+		}
+
+		pacer.WaitForFrameStart();
+		double start = clock.GetSeconds();
+		double targetSeconds = pacer.GetTargetVblankSeconds();
+		clock.Advance(trace[frame].cpuSeconds);
+
+		double gpuStart = frame > 0 ? std::max(clock.GetSeconds(), gpuEnds[frame - 1]) : clock.GetSeconds();
+		gpuEnds[frame] = gpuStart + trace[frame].gpuSeconds;
+		displays[frame] = gpuEnds[frame];
+		if (isVsync)
+		{
+			displays[frame] = GetVblankAtOrAfter(gpuEnds[frame], 0.0, refreshSeconds) * refreshSeconds;
+			if (frame > 0)
+			{
+				displays[frame] = std::max(displays[frame], displays[frame - 1] + refreshSeconds);
+				simulation.repeatedRefreshCount += static_cast<int>(std::lround((displays[frame] - displays[frame - 1]) / refreshSeconds)) - 1;
+			}
+		}
+
+		if (policy == PacingPolicy::LowLatency && displays[frame] > targetSeconds + refreshSeconds * 0.5)
+		{
+			++simulation.missedVblankCount;
+		}
+
+		double latency = displays[frame] - start;
+		latencySum += latency;
+		simulation.worstLatencySeconds = std::max(simulation.worstLatencySeconds, latency);
+	}
+
+	double displaySeconds = displays.back() - displays.front();
+	simulation.framesPerSecond = displaySeconds > 0.0 ? (frameCount - 1) / displaySeconds : 0.0;
+	simulation.meanLatencySeconds = latencySum / frameCount;
+	return simulation;
+}
+
+std::string scaling::FormatPacingSimulation(PacingPolicy policy, PacingSimulation const& simulation)
+{
+	char text[192];
+	snprintf(text, sizeof(text), "Pacing %s: %.1f frames per second, %.2f ms mean latency, %.2f ms worst, %d refreshes repeated",
+		GetPacingPolicyName(policy), simulation.framesPerSecond, simulation.meanLatencySeconds * 1000.0,
+		simulation.worstLatencySeconds * 1000.0, simulation.repeatedRefreshCount);
+	std::string formatted = text;
+	if (policy == PacingPolicy::LowLatency)
+	{
+		formatted += ", " + std::to_string(simulation.missedVblankCount) + " vblanks missed";
+	}
+	return formatted;
+}
+
+bool scaling::LoadPacingExpectation(std::string const& path, PacingSimulation& expected, std::string& error)
+{
+	std::ifstream file(path);
+	if (!file)
+	{
+		error = "Couldn't open " + path;
+		return false;
+	}
+
+	std::string line;
+	for (int lineNumber = 1; std::getline(file, line); ++lineNumber)
+	{
+		size_t first = line.find_first_not_of(" \t\r");
+		if (first == std::string::npos || line[first] == '#')
+		{
+			continue;
+		}
+
+		std::istringstream fields(line);
+		double meanMilliseconds = 0.0;
+		double worstMilliseconds = 0.0;
+		std::string rest;
+		expected = PacingSimulation{};
+		if (!(fields >> meanMilliseconds >> worstMilliseconds >> expected.missedVblankCount >> expected.repeatedRefreshCount) || (fields >> rest))
+		{
+			error = path + " line " + std::to_string(lineNumber) + " isn't two latencies in milliseconds and two counts";
+			return false;
+		}
+		expected.meanLatencySeconds = meanMilliseconds / 1000.0;
+		expected.worstLatencySeconds = worstMilliseconds / 1000.0;
+		return true;
+	}
+	error = path + " has no expected values";
+	return false;
+}
+
+bool scaling::MatchesPacingExpectation(PacingSimulation const& simulation, PacingSimulation const& expected)
+{
+	// Half a hundredth of a millisecond for the rounding, and a little more.
+	const double toleranceSeconds = 0.000006;
+	return std::abs(simulation.meanLatencySeconds - expected.meanLatencySeconds) <= toleranceSeconds &&
+		std::abs(simulation.worstLatencySeconds - expected.worstLatencySeconds) <= toleranceSeconds &&
+		simulation.missedVblankCount == expected.missedVblankCount &&
+		simulation.repeatedRefreshCount == expected.repeatedRefreshCount;
+}
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <chrono>
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace scaling
+{
+	// Where a FramePacer gets the time from, in seconds from any fixed point, so that pacing can run against
+	// a simulated clock as well as the real one.
+	class IPacingClock
+	{
+	public:
+		virtual ~IPacingClock() {}
+
+		virtual double GetSeconds() const = 0;
+		virtual void SleepUntil(double seconds) = 0;
+	};
+
+	// The real time, from when the clock was created.
+	class SteadyPacingClock : public IPacingClock
+	{
+	public:
+		SteadyPacingClock();
+
+		double GetSeconds() const override;
+		void SleepUntil(double seconds) override;
+
+	private:
+		std::chrono::steady_clock::time_point m_start;
+	};
+
+	// Time that only moves when it's told to, for running recorded frame times through a pacer.
+	class SimulatedPacingClock : public IPacingClock
+	{
+	public:
+		SimulatedPacingClock() : m_seconds(0.0) {}
+
+		double GetSeconds() const override { return m_seconds; }
+		void SleepUntil(double seconds) override;
+
+		void Advance(double seconds) { m_seconds += seconds; }
+
+	private:
+		double m_seconds;
+	};
+
+	enum class PacingPolicy
+	{
+		MaxThroughput,	// Frames start as soon as there's room for them, and are presented without waiting for vsync
+		VsyncLocked,	// Presented on vsync, which holds frames back once the swap chain is full
+		LowLatency		// Presented on vsync, with each frame's CPU work started just in time to make a vblank
+	};
+
+	// "throughput", "vsync" and "low-latency".
+	char const* GetPacingPolicyName(PacingPolicy policy);
+	bool ParsePacingPolicy(std::string const& name, PacingPolicy& policy);
+
+	// Decides when each frame's CPU work starts, and how it's presented. The latency-minimizing policy
+	// aims every frame at the first vblank it can make, going by the slowest of the recent frames plus a
+	// margin, and holds its start back until just in time for it, so that what the frame samples, such as
+	// input, is as recent as it can be when it reaches the display.
+	//
+	// A frame that misses its vblank pushes the ones already started back too, and they'd stay a refresh
+	// late from then on. So once a frame is seen to be late, the next one to start is aimed that much later.
+	//
+	// Vblanks are at multiples of the refresh interval from the clock's zero until one is seen.
+	class FramePacer
+	{
+	public:
+		static const int c_historyLength = 16;
+
+		FramePacer(IPacingClock& clock, PacingPolicy policy, double refreshSeconds);
+
+		PacingPolicy GetPolicy() const { return m_policy; }
+		void SetPolicy(PacingPolicy policy) { m_policy = policy; }
+
+		// For Present: 0 for max throughput, otherwise 1.
+		int GetSyncInterval() const { return m_policy == PacingPolicy::MaxThroughput ? 0 : 1; }
+
+		// When the display last refreshed, by the pacer's clock, and how often it does.
+		void OnVblank(double seconds, double refreshSeconds);
+
+		// How long a recent frame took: on the CPU, from its start until it was submitted, and on the GPU.
+		// Frames can be reported late, such as once their GPU timestamps have been read back.
+		void OnFrameMeasured(double cpuSeconds, double gpuSeconds);
+
+		// The next count frames to start have reached the display, the last of them at the time given.
+		void OnFramesDisplayed(int count, double lastSeconds);
+
+		// Returns when the next frame's CPU work should start.
+		void WaitForFrameStart();
+
+		// The vblank the last frame that waited was aimed at.
+		double GetTargetVblankSeconds() const { return m_vblankSeconds + m_targetVblank * m_refreshSeconds; }
+
+	private:
+		double PredictFrameSeconds() const;
+
+		// A frame that started and hasn't been reported as displayed.
+		struct StartedFrame
+		{
+			double targetSeconds;
+			int correction;	// How many times the target had been corrected when the frame started
+		};
+
+		IPacingClock& m_clock;
+		PacingPolicy m_policy;
+		double m_refreshSeconds;
+		double m_vblankSeconds;		// A vblank that the others are counted from
+		long long m_targetVblank;	// Counted from m_vblankSeconds
+
+		double m_recentSeconds[c_historyLength]; // CPU and GPU time of the most recent frames, as a ring
+		int m_recentCount;
+		int m_nextRecent;
+
+		std::deque<StartedFrame> m_startedFrames;
+		int m_correction;
+	};
+
+	// What one frame took, as recorded in a trace.
+	struct FrameTimes
+	{
+		double cpuSeconds;
+		double gpuSeconds;
+	};
+
+	// Reads a trace of frame times: one frame per line, its CPU and GPU times in milliseconds, separated by
+	// white space. Lines that start with # are comments. On failure, error says why.
+	bool LoadFrameTimeTrace(std::string const& path, std::vector<FrameTimes>& trace, std::string& error);
+	bool SaveFrameTimeTrace(std::string const& path, std::vector<FrameTimes> const& trace, std::string& error);
+
+	struct PacingSimulation
+	{
+		int frameCount;
+		double framesPerSecond;		// Between the first frame reaching the display and the last
+		double meanLatencySeconds;	// From the start of a frame's CPU work until it reaches the display
+		double worstLatencySeconds;
+		int repeatedRefreshCount;	// Vblanks that showed the same frame again, since a new one wasn't ready
+		int missedVblankCount;		// With the latency-minimizing policy, frames shown after the vblank they were aimed at
+	};
+
+	// Runs a trace through a pacer on a simulated clock. The CPU works on one frame at a time, the GPU starts
+	// a frame once the CPU has submitted it and the GPU has finished the one before, and with vsync, each frame
+	// is shown at the first vblank after the GPU finishes it that the frame before isn't shown at. The CPU can't
+	// start a frame until the one framesInFlight before it is off the GPU, or on the display with vsync. Each
+	// frame's times are only reported to the pacer once its GPU work is done, and its display once it's shown.
+	PacingSimulation SimulatePacing(std::vector<FrameTimes> const& trace, PacingPolicy policy, double refreshSeconds, int framesInFlight);
+
+	std::string FormatPacingSimulation(PacingPolicy policy, PacingSimulation const& simulation);
+
+	// Reads what a simulation is expected to give, to catch changes to a policy: one line with the mean and
+	// worst latency in milliseconds, the vblanks missed, and the refreshes repeated. Lines that start with #
+	// are comments. On failure, error says why.
+	bool LoadPacingExpectation(std::string const& path, PacingSimulation& expected, std::string& error);
+
+	// Whether the latencies are the same to the hundredth of a millisecond they're written to, and the counts
+	// exactly.
+	bool MatchesPacingExpectation(PacingSimulation const& simulation, PacingSimulation const& expected);
+}
@@ -0,0 +1,155 @@
+#include "FrameScheduler.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <utility>
+
+using namespace scaling;
+
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	double SecondsSince(Clock::time_point start)
+	{
+		return std::chrono::duration<double>(Clock::now() - start).count();
+	}
+}
+
+FrameTask::FrameTask(FrameTask&& other) noexcept
+	: m_handle(std::exchange(other.m_handle, nullptr))
+{
+}
+
+FrameTask& FrameTask::operator=(FrameTask&& other) noexcept
+{
+	if (this != &other)
+	{
+		if (m_handle)
+		{
+			m_handle.destroy();
+		}
+		m_handle = std::exchange(other.m_handle, nullptr);
+	}
+	return *this;
+}
+
+FrameTask::~FrameTask()
+{
+	if (m_handle)
+	{
+		m_handle.destroy();
+	}
+}
+
+FrameScheduler::FenceWait::FenceWait(FrameScheduler& scheduler, IGpuFence& fence, uint64_t value)
+	: m_scheduler(scheduler)
+	, m_fence(fence)
+	, m_value(value)
+{
+}
+
+bool FrameScheduler::FenceWait::await_ready()
+{
+	++m_scheduler.m_stats.waitCount;
+	if (m_fence.GetCompletedValue() >= m_value)
+	{
+		return true;
+	}
+
+	if (m_scheduler.m_isBlocking)
+	{
+		m_scheduler.Block(m_fence, m_value);
+		return true;
+	}
+	return false;
+}
+
+void FrameScheduler::FenceWait::await_suspend(std::coroutine_handle<>)
+{
+	Frame& frame = m_scheduler.m_frames[m_scheduler.m_runningFrame];
+	frame.fence = &m_fence;
+	frame.fenceValue = m_value;
+}
+
+FrameScheduler::FrameScheduler(bool isBlocking)
+	: m_isBlocking(isBlocking)
+	, m_isStopping(false)
+	, m_runningFrame(0)
+	, m_stats()
+{
+}
+
+int FrameScheduler::Run(int frameCount, int framesInFlight, std::function<FrameTask(int frame)> const& startFrame)
+{
+	assert(framesInFlight > 0);
+	m_stats = FrameSchedulerStats();
+	m_isStopping = false;
+	Clock::time_point start = Clock::now();
+
+	int startedCount = 0;
+	for (;;)
+	{
+		while (!m_isStopping && startedCount < frameCount && static_cast<int>(m_frames.size()) < framesInFlight)
+		{
+			m_frames.push_back(Frame{ startFrame(startedCount), nullptr, 0 });
+			++startedCount;
+			Resume(m_frames.size() - 1);
+			if (m_frames.back().task.IsDone())
+			{
+				m_frames.pop_back();
+			}
+		}
+		if (m_frames.empty())
+		{
+			break;
+		}
+
+		bool isAnyResumed = false;
+		for (size_t frame = 0; frame < m_frames.size(); ++frame)
+		{
+			if (m_frames[frame].fence->GetCompletedValue() >= m_frames[frame].fenceValue)
+			{
+				Resume(frame);
+				isAnyResumed = true;
+			}
+		}
+		m_frames.erase(std::remove_if(m_frames.begin(), m_frames.end(), [](Frame const& frame) { return frame.task.IsDone(); }), m_frames.end());
+
+		// Every frame is waiting, so the thread has to as well.
+		if (!isAnyResumed)
+		{
+			Block(*m_frames.front().fence, m_frames.front().fenceValue);
+		}
+	}
+
+	m_stats.seconds = SecondsSince(start);
+	return startedCount;
+}
+
+std::string FrameScheduler::GetSummary() const
+{
+	double blocked = m_stats.seconds > 0.0 ? m_stats.blockedSeconds / m_stats.seconds : 0.0;
+
+	char text[160];
+	snprintf(text, sizeof(text), "%s frames: blocked for %.3f s, %.1f%% of the run, %llu times in %llu waits on fences",
+		m_isBlocking ? "Blocking" : "Coroutine", m_stats.blockedSeconds, blocked * 100.0,
+		static_cast<unsigned long long>(m_stats.blockCount), static_cast<unsigned long long>(m_stats.waitCount));
+	return text;
+}
+
+void FrameScheduler::Resume(size_t frame)
+{
+	m_runningFrame = frame;
+	m_frames[frame].task.Resume();
+}
+
+void FrameScheduler::Block(IGpuFence& fence, uint64_t value)
+{
+	Clock::time_point start = Clock::now();
+	fence.WaitOnCpu(value);
+	m_stats.blockedSeconds += SecondsSince(start);
+	++m_stats.blockCount;
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "GpuQueue.h"
+
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace scaling
+{
+	// A frame written as a coroutine, which co_awaits FrameScheduler::WaitFor wherever it would otherwise block
+	// on a fence. It starts suspended, and only a FrameScheduler runs it.
+	class FrameTask
+	{
+	public:
+		struct promise_type
+		{
+			FrameTask get_return_object() { return FrameTask(std::coroutine_handle<promise_type>::from_promise(*this)); }
+			std::suspend_always initial_suspend() noexcept { return {}; }
+			std::suspend_always final_suspend() noexcept { return {}; }
+			void return_void() {}
+			void unhandled_exception() { std::terminate(); }
+		};
+
+		FrameTask(FrameTask&& other) noexcept;
+		FrameTask& operator=(FrameTask&& other) noexcept;
+		~FrameTask();
+
+		bool IsDone() const { return m_handle.done(); }
+		void Resume() { m_handle.resume(); }
+
+	private:
+		explicit FrameTask(std::coroutine_handle<promise_type> handle) : m_handle(handle) {}
+
+		std::coroutine_handle<promise_type> m_handle;
+	};
+
+	struct FrameSchedulerStats
+	{
+		double seconds;			// The whole run
+		double blockedSeconds;	// The thread waiting on a fence with nothing else it could get on with
+		uint64_t waitCount;		// Fences the frames waited for
+		uint64_t blockCount;	// Times the thread blocked
+	};
+
+	// Runs frames as coroutines on the calling thread, so that one thread can keep several frames in flight.
+	// A frame that waits on a fence is set aside, and the thread gets on with whatever else it can: starting
+	// the next frame, or finishing one whose fence has been reached since. The thread only blocks when every
+	// frame is waiting, and then on the oldest frame's fence.
+	//
+	// The fences have to be signalled by other threads, such as a queue's. Frames waiting on fences of the
+	// same in-order queue resume in the order they were started.
+	//
+	// A blocking scheduler waits on each fence as it's asked to, and runs one frame at a time, the way a loop
+	// of plain calls does, so that what that costs can be measured with the same frames.
+	class FrameScheduler
+	{
+	public:
+		explicit FrameScheduler(bool isBlocking = false);
+
+		class FenceWait
+		{
+		public:
+			FenceWait(FrameScheduler& scheduler, IGpuFence& fence, uint64_t value);
+
+			bool await_ready();
+			void await_suspend(std::coroutine_handle<>);
+			void await_resume() {}
+
+		private:
+			FrameScheduler&	m_scheduler;
+			IGpuFence&		m_fence;
+			uint64_t		m_value;
+		};
+
+		// For frames to co_await.
+		FenceWait WaitFor(IGpuFence& fence, uint64_t value) { return FenceWait(*this, fence, value); }
+
+		// Runs frames 0 to frameCount - 1, each as the coroutine that startFrame returns for it, with at most
+		// framesInFlight of them started and not yet finished at a time. Returns how many were started.
+		int Run(int frameCount, int framesInFlight, std::function<FrameTask(int frame)> const& startFrame);
+
+		// From a frame: no more are started, and the ones already started finish.
+		void Stop() { m_isStopping = true; }
+
+		bool IsBlocking() const { return m_isBlocking; }
+
+		// For the last run.
+		FrameSchedulerStats const& GetStats() const { return m_stats; }
+		std::string GetSummary() const;
+
+	private:
+		struct Frame
+		{
+			FrameTask task;
+			IGpuFence* fence;	// What the frame is waiting on
+			uint64_t fenceValue;
+		};
+
+		void Resume(size_t frame);
+		void Block(IGpuFence& fence, uint64_t value);
+
+		bool m_isBlocking;
+		bool m_isStopping;
+		std::vector<Frame> m_frames;	// Started and not finished, oldest first
+		size_t m_runningFrame;
+		FrameSchedulerStats m_stats;
+	};
+}
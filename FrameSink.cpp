@@ -0,0 +1,87 @@
+#include "FrameSink.h"
+
+#include <cinttypes>
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+using namespace scaling;
+
+ChecksumFrameSink::ChecksumFrameSink()
+	: m_checksum(14695981039346656037ull)
+{
+}
+
+bool ChecksumFrameSink::OnFrame(int, ImageBgra8 const& image)
+{
+	uint32_t const* pixels = image.GetData();
+	for (size_t i = 0; i < image.GetPixelCount(); ++i)
+	{
+		m_checksum = (m_checksum ^ pixels[i]) * 1099511628211ull;
+	}
+	return true;
+}
+
+void ChecksumFrameSink::OnMotionVectors(int, ImageMotionVectors const& motionVectors)
+{
+	MotionVector const* vectors = motionVectors.GetData();
+	for (size_t i = 0; i < motionVectors.GetPixelCount(); ++i)
+	{
+		uint32_t packed = static_cast<uint16_t>(vectors[i].x) | static_cast<uint32_t>(static_cast<uint16_t>(vectors[i].y)) << 16;
+		m_checksum = (m_checksum ^ packed) * 1099511628211ull;
+	}
+}
+
+std::string ChecksumFrameSink::GetSummary() const
+{
+	char text[64];
+	snprintf(text, sizeof(text), "Checksum: %016" PRIx64, m_checksum);
+	return text;
+}
+
+FileFrameSink::FileFrameSink(std::string const& prefix)
+	: m_prefix(prefix)
+	, m_writtenCount(0)
+{
+}
+
+bool FileFrameSink::OnFrame(int frameIndex, ImageBgra8 const& image)
+{
+	char suffix[32];
+	snprintf(suffix, sizeof(suffix), "_%05d.ppm", frameIndex);
+	std::string path = m_prefix + suffix;
+
+	std::ofstream file(path, std::ios::binary);
+	file << "P6\n" << image.GetWidth() << " " << image.GetHeight() << "\n255\n";
+
+	// PPM is RGB, without alpha.
+	std::vector<uint8_t> row(image.GetWidth() * 3);
+	for (int y = 0; y < image.GetHeight(); ++y)
+	{
+		uint32_t const* pixels = image.GetRow(y);
+		for (int x = 0; x < image.GetWidth(); ++x)
+		{
+			row[x * 3 + 0] = static_cast<uint8_t>(pixels[x] >> 16);
+			row[x * 3 + 1] = static_cast<uint8_t>(pixels[x] >> 8);
+			row[x * 3 + 2] = static_cast<uint8_t>(pixels[x]);
+		}
+		file.write(reinterpret_cast<char const*>(row.data()), row.size());
+	}
+
+	if (!file)
+	{
+		m_failedPath = path;
+		return false;
+	}
+	++m_writtenCount;
+	return true;
+}
+
+std::string FileFrameSink::GetSummary() const
+{
+	if (!m_failedPath.empty())
+	{
+		return "Couldn't write " + m_failedPath;
+	}
+	return "Wrote " + std::to_string(m_writtenCount) + " frames to " + m_prefix + "_*.ppm";
+}
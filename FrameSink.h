@@ -0,0 +1,66 @@
+#pragma once
+
+#include "CpuImage.h"
+
+#include <cstdint>
+#include <string>
+
+namespace scaling
+{
+	// Receives every upscaled frame of a headless run, in place of presenting it.
+	class IFrameSink
+	{
+	public:
+		virtual ~IFrameSink() {}
+
+		// The image is only valid during the call. Returns false to stop the run, for instance when a write fails.
+		virtual bool OnFrame(int frameIndex, ImageBgra8 const& image) = 0;
+
+		// With a temporal upscaler, the motion vectors a frame was upscaled with, before its OnFrame. Only
+		// valid during the call.
+		virtual void OnMotionVectors(int, ImageMotionVectors const&) {}
+
+		// One line for the end of the run. Empty when there's nothing to say.
+		virtual std::string GetSummary() const = 0;
+	};
+
+	// For measuring throughput alone.
+	class DiscardFrameSink : public IFrameSink
+	{
+	public:
+		bool OnFrame(int, ImageBgra8 const&) override { return true; }
+		std::string GetSummary() const override { return std::string(); }
+	};
+
+	// FNV-1a over the pixels of every frame, and its motion vectors if it has any, in order. Runs are
+	// deterministic, so two runs with the same options, backend and build match exactly.
+	class ChecksumFrameSink : public IFrameSink
+	{
+	public:
+		ChecksumFrameSink();
+
+		bool OnFrame(int frameIndex, ImageBgra8 const& image) override;
+		void OnMotionVectors(int frameIndex, ImageMotionVectors const& motionVectors) override;
+		std::string GetSummary() const override;
+
+		uint64_t GetChecksum() const { return m_checksum; }
+
+	private:
+		uint64_t m_checksum;
+	};
+
+	// Writes each frame to <prefix>_<frame index>.ppm, as binary PPM.
+	class FileFrameSink : public IFrameSink
+	{
+	public:
+		explicit FileFrameSink(std::string const& prefix);
+
+		bool OnFrame(int frameIndex, ImageBgra8 const& image) override;
+		std::string GetSummary() const override;
+
+	private:
+		std::string m_prefix;
+		int m_writtenCount;
+		std::string m_failedPath;
+	};
+}
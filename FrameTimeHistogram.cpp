@@ -0,0 +1,108 @@
+#include "FrameTimeHistogram.h"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+
+using namespace scaling;
+
+namespace
+{
+	const uint64_t c_maxMicroseconds = (uint64_t(1) << FrameTimeHistogram::c_maxMicrosecondBits) - 1;
+
+	// How far a bucket's times are shifted, and the bucket past its last time, in microseconds.
+	int GetBucketShift(int bucket)
+	{
+		return std::max(0, bucket / FrameTimeHistogram::c_subBucketCount - 1);
+	}
+
+	uint64_t GetBucketEndMicroseconds(int bucket)
+	{
+		int shift = GetBucketShift(bucket);
+		uint64_t subBucket = bucket - shift * FrameTimeHistogram::c_subBucketCount;
+		return (subBucket + 1) << shift;
+	}
+}
+
+FrameTimeHistogram::FrameTimeHistogram()
+{
+	Clear();
+}
+
+void FrameTimeHistogram::Add(double seconds)
+{
+	seconds = std::max(seconds, 0.0);
+	uint64_t microseconds = std::min(static_cast<uint64_t>(seconds * 1e6), c_maxMicroseconds);
+
+	++m_counts[GetBucket(microseconds)];
+	++m_count;
+	m_sumSeconds += seconds;
+	m_maxSeconds = std::max(m_maxSeconds, seconds);
+}
+
+void FrameTimeHistogram::Clear()
+{
+	m_counts.fill(0);
+	m_count = 0;
+	m_sumSeconds = 0.0;
+	m_maxSeconds = 0.0;
+}
+
+void FrameTimeHistogram::Merge(FrameTimeHistogram const& other)
+{
+	for (int bucket = 0; bucket < c_bucketCount; ++bucket)
+	{
+		m_counts[bucket] += other.m_counts[bucket];
+	}
+	m_count += other.m_count;
+	m_sumSeconds += other.m_sumSeconds;
+	m_maxSeconds = std::max(m_maxSeconds, other.m_maxSeconds);
+}
+
+double FrameTimeHistogram::GetPercentileSeconds(double fraction) const
+{
+	assert(fraction >= 0.0 && fraction <= 1.0);
+	if (m_count == 0)
+	{
+		return 0.0;
+	}
+
+	// The rank of the frame, counting from 1.
+	uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(fraction * m_count)));
+	uint64_t counted = 0;
+	for (int bucket = 0; bucket < c_bucketCount; ++bucket)
+	{
+		counted += m_counts[bucket];
+		if (counted >= rank)
+		{
+			return std::min(GetBucketEndMicroseconds(bucket) * 1e-6, m_maxSeconds);
+		}
+	}
+	return m_maxSeconds;
+}
+
+// The times below twice the sub-bucket count each have a bucket. Above that, each power of two is split
+// into c_subBucketCount buckets by the bits that follow the top one.
+int FrameTimeHistogram::GetBucket(uint64_t microseconds)
+{
+	int shift = std::max(0, static_cast<int>(std::bit_width(microseconds)) - c_subBucketBits - 1);
+	int bucket = shift * c_subBucketCount + static_cast<int>(microseconds >> shift);
+	assert(bucket < c_bucketCount);
+	return bucket;
+}
+
+std::string scaling::FormatFrameTimes(FrameTimeHistogram const& histogram)
+{
+	if (histogram.GetCount() == 0)
+	{
+		return "no frames";
+	}
+
+	char text[96];
+	snprintf(text, sizeof(text), "p50 %.2f ms, p95 %.2f ms, p99 %.2f ms, max %.2f ms",
+		histogram.GetPercentileSeconds(0.50) * 1000.0, histogram.GetPercentileSeconds(0.95) * 1000.0,
+		histogram.GetPercentileSeconds(0.99) * 1000.0, histogram.GetMaxSeconds() * 1000.0);
+	return text;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+namespace scaling
+{
+	// Counts frame times in a fixed set of buckets, so that adding one takes constant time and never allocates,
+	// and percentiles can be read at any point. Times are kept in microseconds: exactly below 64 µs, and above
+	// that in 32 buckets per power of two, so to within about 3%. Anything over a minute counts as a minute.
+	class FrameTimeHistogram
+	{
+	public:
+		static const int c_subBucketBits = 5;
+		static const int c_subBucketCount = 1 << c_subBucketBits;
+		static const int c_maxMicrosecondBits = 26;
+		static const int c_bucketCount = (c_maxMicrosecondBits - c_subBucketBits + 1) * c_subBucketCount;
+
+		FrameTimeHistogram();
+
+		void Add(double seconds);
+		void Clear();
+
+		// Counts the other histogram's frames too, as if they'd been added here.
+		void Merge(FrameTimeHistogram const& other);
+
+		uint64_t GetCount() const { return m_count; }
+		double GetMeanSeconds() const { return m_count > 0 ? m_sumSeconds / m_count : 0.0; }
+		double GetMaxSeconds() const { return m_maxSeconds; }
+
+		// The time that the given fraction of the frames took at most, such as 0.99 for the 99th percentile:
+		// the top of the bucket the frame at that rank is in, and never more than the slowest frame. 0 if
+		// there are no frames.
+		double GetPercentileSeconds(double fraction) const;
+
+	private:
+		static int GetBucket(uint64_t microseconds);
+
+		std::array<uint32_t, c_bucketCount> m_counts;
+		uint64_t m_count;
+		double m_sumSeconds;
+		double m_maxSeconds;
+	};
+
+	// "p50 16.67 ms, p95 ..., p99 ..., max ...", or "no frames".
+	std::string FormatFrameTimes(FrameTimeHistogram const& histogram);
+}
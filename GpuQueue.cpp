@@ -0,0 +1,62 @@
+#include "GpuQueue.h"
+
+#include <cassert>
+
+using namespace scaling;
+
+VideoQueueSchedule::VideoQueueSchedule(IGpuQueue& directQueue, IGpuFence& directFence, IGpuQueue& videoQueue, IGpuFence& videoFence, int frameCount)
+	: m_directQueue(directQueue)
+	, m_directFence(directFence)
+	, m_videoQueue(videoQueue)
+	, m_videoFence(videoFence)
+	, m_directFenceValue(0)
+	, m_videoFenceValue(0)
+	, m_awaitedVideoFenceValue(0)
+	, m_frameVideoFenceValues(frameCount, 0)
+{
+}
+
+void VideoQueueSchedule::AfterDirectWork()
+{
+	++m_directFenceValue;
+	m_directQueue.Signal(m_directFence, m_directFenceValue);
+	m_videoQueue.Wait(m_directFence, m_directFenceValue);
+}
+
+void VideoQueueSchedule::BeginVideoWork(int frameIndex)
+{
+	assert(frameIndex >= 0 && frameIndex < static_cast<int>(m_frameVideoFenceValues.size()));
+
+	uint64_t value = m_frameVideoFenceValues[frameIndex];
+	if (m_videoFence.GetCompletedValue() < value)
+	{
+		m_videoFence.WaitOnCpu(value);
+	}
+}
+
+void VideoQueueSchedule::AfterVideoWork(int frameIndex)
+{
+	++m_videoFenceValue;
+	m_videoQueue.Signal(m_videoFence, m_videoFenceValue);
+	m_frameVideoFenceValues[frameIndex] = m_videoFenceValue;
+}
+
+void VideoQueueSchedule::AwaitVideoWork(int frameIndex)
+{
+	assert(frameIndex >= 0 && frameIndex < static_cast<int>(m_frameVideoFenceValues.size()));
+
+	uint64_t value = m_frameVideoFenceValues[frameIndex];
+	if (value > m_awaitedVideoFenceValue)
+	{
+		m_directQueue.Wait(m_videoFence, value);
+		m_awaitedVideoFenceValue = value;
+	}
+}
+
+void VideoQueueSchedule::WaitForVideoWork()
+{
+	if (m_videoFence.GetCompletedValue() < m_videoFenceValue)
+	{
+		m_videoFence.WaitOnCpu(m_videoFenceValue);
+	}
+}
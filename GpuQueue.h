@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace scaling
+{
+	// A fence that queues signal, whose value only goes up, like ID3D12Fence.
+	class IGpuFence
+	{
+	public:
+		virtual ~IGpuFence() {}
+
+		virtual uint64_t GetCompletedValue() const = 0;
+
+		// Blocks the calling thread until the fence reaches the value.
+		virtual void WaitOnCpu(uint64_t value) = 0;
+	};
+
+	// The part of a queue that orders it against other queues. Work itself goes through the queue's own API,
+	// and Signal and Wait apply in order with it: Signal once the work submitted before it has finished,
+	// and Wait holds back the work submitted after it.
+	class IGpuQueue
+	{
+	public:
+		virtual ~IGpuQueue() {}
+
+		virtual void Signal(IGpuFence& fence, uint64_t value) = 0;
+		virtual void Wait(IGpuFence& fence, uint64_t value) = 0;
+	};
+
+	// Puts motion estimation on the video queue between the direct queue's work that it reads and the work
+	// that reads its motion vectors, with the queues waiting on each other's fences so that the CPU waits on
+	// neither. Each frame records its video work with an allocator of its own, and the schedule keeps track
+	// of when each one can be reset.
+	//
+	// Per frame:
+	//     submit the direct work up to the YUV conversion
+	//     AfterDirectWork()
+	//     BeginVideoWork(frameIndex), then reset the frame's video allocator, record and submit
+	//     AfterVideoWork(frameIndex)
+	//     AwaitVideoWork(the last frame's index)
+	//     submit the rest of the direct work, which upscales the last frame
+	//
+	// Upscaling reads the motion vectors, so it runs a frame behind, as ScalingPipeline records it on devices
+	// with a video queue: the direct queue only waits for a frame's motion estimation in the next frame,
+	// after that frame's pass 1, which the motion estimation runs alongside.
+	class VideoQueueSchedule
+	{
+	public:
+		// The fences are the schedule's own, and start at 0.
+		VideoQueueSchedule(IGpuQueue& directQueue, IGpuFence& directFence, IGpuQueue& videoQueue, IGpuFence& videoFence, int frameCount);
+
+		// The video queue waits for the direct work submitted so far.
+		void AfterDirectWork();
+
+		// Returns once the video work last recorded for the frame index has finished, which it almost always
+		// has, since the frame has come back around.
+		void BeginVideoWork(int frameIndex);
+
+		// The video queue signals once the frame's video work is done.
+		void AfterVideoWork(int frameIndex);
+
+		// The direct queue waits for the video work last submitted for the frame index before anything
+		// submitted after this, unless it already has.
+		void AwaitVideoWork(int frameIndex);
+
+		// Waits on the CPU for all of the video work submitted so far, such as before releasing what it uses.
+		void WaitForVideoWork();
+
+	private:
+		IGpuQueue&				m_directQueue;
+		IGpuFence&				m_directFence;
+		IGpuQueue&				m_videoQueue;
+		IGpuFence&				m_videoFence;
+		uint64_t				m_directFenceValue;
+		uint64_t				m_videoFenceValue;
+		uint64_t				m_awaitedVideoFenceValue; // What the direct queue last waited for
+		std::vector<uint64_t>	m_frameVideoFenceValues; // What the video fence reaches when each frame's video work is done
+	};
+}
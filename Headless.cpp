@@ -0,0 +1,888 @@
+#include "Headless.h"
+#include "CpuBackend.h"
+#include "CpuFeatures.h"
+#include "CpuStagedPipeline.h"
+#include "DynamicResolution.h"
+#include "FakeGpuQueue.h"
+#include "FramePacer.h"
+#include "FrameScheduler.h"
+#include "MeshFile.h"
+#include "QueuedCpuDevice.h"
+#include "ReferenceRenderer.h"
+#include "ScalingFrameGraph.h"
+#include "ScalingPipeline.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <limits>
+
+using namespace scaling;
+
+namespace
+{
+	// 45 degrees per second, like the windowed application, at 60 frames per second.
+	const float c_radiansPerFrame = 3.14159265f / 4.0f / 60.0f;
+
+	const int c_maxFramesInFlight = 8;
+	const int c_maxPipelineDepth = 16;
+
+	// Pacing traces run with as many frames in flight as the windowed application has, and frame cost traces
+	// reach dynamic resolution as late as its GPU timestamps do, which is as many frames.
+	const int c_pacingFramesInFlight = 3;
+	const int c_resolutionLatencyFrames = 3;
+
+	bool ParsePositive(std::string const& text, int& value)
+	{
+		char* end = nullptr;
+		long parsed = strtol(text.c_str(), &end, 10);
+		if (end == text.c_str() || *end != '\0' || parsed <= 0 || parsed > 1000000)
+		{
+			return false;
+		}
+		value = static_cast<int>(parsed);
+		return true;
+	}
+
+	bool ParseSize(std::string const& text, int& width, int& height)
+	{
+		size_t separator = text.find('x');
+		return separator != std::string::npos &&
+			ParsePositive(text.substr(0, separator), width) &&
+			ParsePositive(text.substr(separator + 1), height);
+	}
+
+	typedef std::chrono::steady_clock Clock;
+
+	double SecondsSince(Clock::time_point start)
+	{
+		return std::chrono::duration<double>(Clock::now() - start).count();
+	}
+
+	// Each linear kernel is timed over this many upscales.
+	const int c_kernelComparisonRuns = 20;
+
+	// Times a specialized linear kernel against the generic loop, both on the calling thread and without
+	// sharpening, on an image of noise so that every weight and both edges are exercised. Fails unless their
+	// output is the same.
+	bool CompareLinearKernels(char const* kernelName, RenderSize renderSize, int outputWidth, int outputHeight, std::string& summary, std::string& error)
+	{
+		ImageBgra8 src(renderSize.width, renderSize.height);
+		uint32_t noise = 1;
+		for (int y = 0; y < renderSize.height; ++y)
+		{
+			for (int x = 0; x < renderSize.width; ++x)
+			{
+				noise = noise * 1664525 + 1013904223;
+				src.At(x, y) = noise;
+			}
+		}
+
+		ImageBgra8 specialized(outputWidth, outputHeight);
+		Clock::time_point start = Clock::now();
+		for (int run = 0; run < c_kernelComparisonRuns; ++run)
+		{
+			CpuUpscale(src, specialized, CpuFilter::Linear);
+		}
+		double specializedSeconds = SecondsSince(start) / c_kernelComparisonRuns;
+
+		ImageBgra8 generic(outputWidth, outputHeight);
+		start = Clock::now();
+		for (int run = 0; run < c_kernelComparisonRuns; ++run)
+		{
+			CpuUpscaleLinearGeneric(src, generic);
+		}
+		double genericSeconds = SecondsSince(start) / c_kernelComparisonRuns;
+
+		char text[192];
+		for (int y = 0; y < outputHeight; ++y)
+		{
+			if (memcmp(specialized.GetRow(y), generic.GetRow(y), outputWidth * sizeof(uint32_t)) != 0)
+			{
+				snprintf(text, sizeof(text), "The %s linear kernel's output differs from the generic loop's in row %d", kernelName, y);
+				error = text;
+				return false;
+			}
+		}
+
+		snprintf(text, sizeof(text), "Kernels: the %s linear kernel took %.3f ms on one thread, the generic loop %.3f ms, %.2f times as long, with the same output",
+			kernelName, specializedSeconds * 1000.0, genericSeconds * 1000.0, specializedSeconds > 0.0 ? genericSeconds / specializedSeconds : 0.0);
+		summary = text;
+		return true;
+	}
+
+	struct QueuedFrame
+	{
+		IImage* output;
+		IImage* motionVectors;	// With a temporal upscaler
+		RasterizerStats rasterizerStats;
+		double queueSeconds;
+	};
+
+	// What the frames of a run on a queue share.
+	struct FrameQueueContext
+	{
+		FrameScheduler& scheduler;
+		FakeGpuQueue& queue;
+		FakeGpuFence& fence;				// Reaches n + 1 once frame n is done on the queue
+		CpuDevice& device;
+		ScalingPipeline& pipeline;
+		IUpscaler& upscaler;
+		RenderSize renderSize;
+		std::vector<QueuedFrame>& frames;	// One for each frame in flight
+		std::function<void(int, SceneConstants&, JitterOffset&)> prepareFrame;
+		std::function<bool(int, SceneConstants const&, ImageBgra8 const&, ImageMotionVectors const*, RasterizerStats const&)> finishFrame;
+		int finishedCount;
+		bool isStopped;
+		std::vector<FrameTimes> frameTimes;	// Of the frames that finished, with the time on this thread as the CPU time
+	};
+
+	// Prepares the frame here, records it on the queue, and finishes it here once the queue is done with it.
+	// The queue's thread is the only one that touches the device and the pipeline.
+	FrameTask RunQueuedFrame(FrameQueueContext& context, int frame)
+	{
+		Clock::time_point prepareStart = Clock::now();
+		SceneConstants constants;
+		JitterOffset jitter;
+		context.prepareFrame(frame, constants, jitter);
+		double cpuSeconds = SecondsSince(prepareStart);
+
+		QueuedFrame& queued = context.frames[frame % context.frames.size()];
+		context.queue.Execute([&context, &queued, constants, jitter]
+		{
+			Clock::time_point queueStart = Clock::now();
+			context.device.BeginFrame();
+			context.pipeline.RenderFrame(constants, context.renderSize, jitter, &context.upscaler);
+			context.device.EndFrame();
+			queued.output = &context.pipeline.GetOutput();
+			queued.motionVectors = context.upscaler.IsTemporal() ? &context.pipeline.GetMotionVectors() : nullptr;
+			queued.rasterizerStats = context.device.GetRasterizerStats();
+			queued.queueSeconds = SecondsSince(queueStart);
+		});
+		context.queue.Signal(context.fence, frame + 1);
+		co_await context.scheduler.WaitFor(context.fence, frame + 1);
+
+		// Frames started before an earlier one stopped the run go no further.
+		if (context.isStopped)
+		{
+			co_return;
+		}
+		Clock::time_point finishStart = Clock::now();
+		ImageMotionVectors const* motionVectors = queued.motionVectors ? &GetCpuImage<MotionVector>(*queued.motionVectors) : nullptr;
+		if (!context.finishFrame(frame, constants, GetCpuImage<uint32_t>(*queued.output), motionVectors, queued.rasterizerStats))
+		{
+			context.isStopped = true;
+			context.scheduler.Stop();
+			co_return;
+		}
+		++context.finishedCount;
+		context.frameTimes.push_back(FrameTimes{ cpuSeconds + SecondsSince(finishStart), queued.queueSeconds });
+	}
+}
+
+bool scaling::IsHeadlessCommandLine(std::vector<std::string> const& arguments)
+{
+	for (std::string const& argument : arguments)
+	{
+		if (argument == "--headless")
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+bool scaling::ParseHeadlessOptions(std::vector<std::string> const& arguments, HeadlessOptions& options, std::string& error)
+{
+	for (size_t i = 0; i < arguments.size(); ++i)
+	{
+		std::string const& name = arguments[i];
+		if (name == "--headless")
+		{
+			continue;
+		}
+
+		if (i + 1 == arguments.size())
+		{
+			error = "Missing a value for " + name;
+			return false;
+		}
+		std::string const& value = arguments[++i];
+
+		bool isValid = true;
+		if (name == "--frames")
+		{
+			isValid = ParsePositive(value, options.frameCount);
+		}
+		else if (name == "--instances")
+		{
+			isValid = ParsePositive(value, options.instanceCount) && options.instanceCount <= c_maxSceneInstanceCount;
+		}
+		else if (name == "--mesh")
+		{
+			options.meshPath = value;
+		}
+		else if (name == "--render")
+		{
+			isValid = ParseSize(value, options.renderWidth, options.renderHeight);
+		}
+		else if (name == "--output-size")
+		{
+			isValid = ParseSize(value, options.outputWidth, options.outputHeight);
+		}
+		else if (name == "--filter")
+		{
+			isValid = value == "point" || value == "linear";
+			options.filter = value == "point" ? CpuFilter::Point : CpuFilter::Linear;
+		}
+		else if (name == "--upscaler")
+		{
+			isValid = value == "spatial" || value == "temporal";
+			options.isTemporal = value == "temporal";
+		}
+		else if (name == "--motion-vectors")
+		{
+			isValid = value == "rendered" || value == "estimated";
+			options.motionVectorSource = value == "estimated" ? MotionVectorSource::Estimated : MotionVectorSource::Rendered;
+		}
+		else if (name == "--sharpness")
+		{
+			char* end = nullptr;
+			options.sharpness = strtof(value.c_str(), &end);
+			isValid = end != value.c_str() && *end == '\0' && options.sharpness >= 0.0f && options.sharpness <= 1.0f;
+		}
+		else if (name == "--workers")
+		{
+			isValid = ParsePositive(value, options.workerCount);
+		}
+		else if (name == "--deterministic")
+		{
+			isValid = value == "on" || value == "off";
+			options.isDeterministic = value == "on";
+		}
+		else if (name == "--hiz")
+		{
+			isValid = value == "on" || value == "off";
+			options.isHierarchicalDepthEnabled = value == "on";
+		}
+		else if (name == "--frames-in-flight")
+		{
+			isValid = ParsePositive(value, options.framesInFlight) && options.framesInFlight <= c_maxFramesInFlight;
+		}
+		else if (name == "--frame-driver")
+		{
+			isValid = value == "inline" || value == "blocking" || value == "coroutine" || value == "video-queue";
+			options.frameDriver = value == "blocking" ? FrameDriver::Blocking : value == "coroutine" ? FrameDriver::Coroutine :
+				value == "video-queue" ? FrameDriver::VideoQueue : FrameDriver::Inline;
+		}
+		else if (name == "--frame-graph")
+		{
+			isValid = value == "on" || value == "off";
+			options.isFrameGraphReported = value == "on";
+		}
+		else if (name == "--pipeline-depth")
+		{
+			isValid = ParsePositive(value, options.pipelineDepth) && options.pipelineDepth <= c_maxPipelineDepth;
+		}
+		else if (name == "--sink")
+		{
+			isValid = value == "discard" || value == "checksum" || value == "file";
+			options.sinkType = value == "discard" ? FrameSinkType::Discard : value == "file" ? FrameSinkType::File : FrameSinkType::Checksum;
+		}
+		else if (name == "--output")
+		{
+			options.outputPrefix = value;
+		}
+		else if (name == "--reference")
+		{
+			isValid = ParsePositive(value, options.referenceSamplesPerSide) && options.referenceSamplesPerSide <= ReferenceRenderer::c_maxSamplesPerSide;
+		}
+		else if (name == "--reference-output")
+		{
+			options.referenceOutputPrefix = value;
+		}
+		else if (name == "--frame-times")
+		{
+			options.frameTimesPath = value;
+		}
+		else if (name == "--pacing-trace")
+		{
+			options.pacingTracePath = value;
+		}
+		else if (name == "--pacing-expected")
+		{
+			options.pacingExpectedPath = value;
+		}
+		else if (name == "--refresh-rate")
+		{
+			isValid = ParsePositive(value, options.refreshRate) && options.refreshRate <= 1000;
+		}
+		else if (name == "--resolution-trace")
+		{
+			options.resolutionTracePath = value;
+		}
+		else if (name == "--resolution-budget")
+		{
+			isValid = ParsePositive(value, options.resolutionBudgetMilliseconds) && options.resolutionBudgetMilliseconds <= 1000;
+		}
+		else
+		{
+			error = "Unknown argument " + name;
+			return false;
+		}
+
+		if (!isValid)
+		{
+			error = "Invalid value for " + name + ": " + value;
+			return false;
+		}
+	}
+
+	if (options.renderWidth > options.outputWidth || options.renderHeight > options.outputHeight)
+	{
+		error = "The render size can't be larger than the output size";
+		return false;
+	}
+	if (options.isTemporal && options.sharpness > 0.0f)
+	{
+		error = "--sharpness needs --upscaler spatial";
+		return false;
+	}
+	if (!options.isTemporal && options.motionVectorSource == MotionVectorSource::Estimated)
+	{
+		error = "--motion-vectors needs --upscaler temporal";
+		return false;
+	}
+	if (!options.referenceOutputPrefix.empty() && options.referenceSamplesPerSide == 0)
+	{
+		error = "--reference-output needs --reference";
+		return false;
+	}
+	if (options.pipelineDepth > 0)
+	{
+		int stageThreadCount = CpuStagedPipeline::GetThreadCount(options.motionVectorSource == MotionVectorSource::Estimated);
+		if (options.workerCount < stageThreadCount)
+		{
+			error = "--pipeline-depth runs " + std::to_string(stageThreadCount) + " stages here, so it needs at least as many --workers";
+			return false;
+		}
+	}
+	if (!options.pacingExpectedPath.empty() && options.pacingTracePath.empty())
+	{
+		error = "--pacing-expected needs --pacing-trace";
+		return false;
+	}
+	if (!options.frameTimesPath.empty() && (options.frameDriver == FrameDriver::Inline || options.frameDriver == FrameDriver::VideoQueue || options.pipelineDepth > 0))
+	{
+		error = "--frame-times needs --frame-driver blocking or coroutine";
+		return false;
+	}
+	return true;
+}
+
+char const* scaling::GetHeadlessUsage()
+{
+	return
+		"--headless                   Render without a window or swap chain\n"
+		"--frames N                   Frames to render (600)\n"
+		"--instances N                Cubes in the scene, from 1 to 100000 (10000)\n"
+		"--mesh PATH                  Mesh file to draw in place of the cube\n"
+		"--render WxH                 Render size (788x592)\n"
+		"--output-size WxH            Upscaled size (1024x768)\n"
+		"--upscaler spatial|temporal  Upscale each frame on its own, or accumulate jittered frames along\n"
+		"                             their motion vectors (spatial)\n"
+		"--motion-vectors rendered|estimated\n"
+		"                             Where a temporal upscaler's motion vectors come from (rendered)\n"
+		"--filter point|linear        Spatial upscaling filter (linear)\n"
+		"--sharpness S                Sharpening from 0 to 1, where 0 is off (0)\n"
+		"--workers N                  Threads shared by every CPU pass and pipeline stage (1)\n"
+		"--deterministic on|off       Give jobs to the same threads every run instead of stealing (off)\n"
+		"--hiz on|off                 Rasterizer depth hierarchy (on)\n"
+		"--frames-in-flight N         Copies of the per-frame images, up to 8 (1)\n"
+		"--frame-driver inline|blocking|coroutine|video-queue\n"
+		"                             Run the passes on this thread, or on a queue's thread with this one\n"
+		"                             waiting for each frame, or with frames as coroutines, or on a direct\n"
+		"                             and a video queue, checking the order they ran in and, with more than\n"
+		"                             one frame in flight, that motion estimation overlapped them (inline)\n"
+		"--frame-graph on|off         Check the resource state tracker, and report the frame graph's memory\n"
+		"                             with and without aliasing (off)\n"
+		"--pipeline-depth N           Run the passes as stages on threads of their own, out of --workers,\n"
+		"                             with N frames between them, up to 16, and report how busy each\n"
+		"                             stage is (off)\n"
+		"--sink discard|checksum|file Where frames go (checksum)\n"
+		"--output PREFIX              File name prefix for --sink file (frame)\n"
+		"--reference N                Measure PSNR against an NxN supersampled reference, N up to 8\n"
+		"--reference-output PREFIX    Also write the references to files\n"
+		"--frame-times PATH           Write each frame's CPU and queue times, with a frame driver that\n"
+		"                             uses a queue\n"
+		"--pacing-trace PATH          After the run, report how each pacing policy does on a trace of\n"
+		"                             frame times, such as one from --frame-times\n"
+		"--pacing-expected PATH       Fail unless the low-latency policy's latencies, missed vblanks and\n"
+		"                             repeated refreshes on --pacing-trace are the ones in the file\n"
+		"--refresh-rate HZ            Display refresh rate for --pacing-trace (60)\n"
+		"--resolution-trace PATH      After the run, check that dynamic resolution settles on a trace of\n"
+		"                             GPU frame costs in milliseconds at the render size\n"
+		"--resolution-budget MS       Frame time budget for --resolution-trace (15)\n";
+}
+
+std::unique_ptr<IFrameSink> scaling::CreateFrameSink(HeadlessOptions const& options)
+{
+	switch (options.sinkType)
+	{
+	case FrameSinkType::Discard: return std::unique_ptr<IFrameSink>(new DiscardFrameSink());
+	case FrameSinkType::File: return std::unique_ptr<IFrameSink>(new FileFrameSink(options.outputPrefix));
+	default: return std::unique_ptr<IFrameSink>(new ChecksumFrameSink());
+	}
+}
+
+HeadlessResult scaling::RunHeadless(HeadlessOptions const& options, IFrameSink& sink)
+{
+	HeadlessResult result = {};
+	if (!IsAvx2Supported())
+	{
+		result.error = "The CPU backend needs a processor with AVX2 and FMA";
+		return result;
+	}
+
+	// A staged pipeline's threads count against the workers too.
+	int jobWorkerCount = options.workerCount;
+	if (options.pipelineDepth > 0)
+	{
+		jobWorkerCount -= CpuStagedPipeline::GetThreadCount(options.motionVectorSource == MotionVectorSource::Estimated) - 1;
+	}
+	JobSystem jobs(jobWorkerCount, options.isDeterministic);
+	CpuDevice device(&jobs, options.framesInFlight);
+	device.SetHierarchicalDepthEnabled(options.isHierarchicalDepthEnabled);
+	device.SetSceneInstances(CreateInstancedScene(options.instanceCount));
+	if (options.isFrameGraphReported)
+	{
+		// The plan's barriers are the tracker's, so it's checked first.
+		if (!CheckResourceStateTracker(result.error))
+		{
+			return result;
+		}
+		result.frameGraphReport = "Barriers: the resource state tracker gave the expected barriers for every made-up sequence\n" +
+			FormatScalingFrameGraphReport(device, options.renderWidth, options.renderHeight, options.outputWidth, options.outputHeight);
+	}
+
+	MeshFile meshFile;
+	if (!options.meshPath.empty())
+	{
+		auto openStart = std::chrono::steady_clock::now();
+		if (!meshFile.Open(options.meshPath, result.error))
+		{
+			return result;
+		}
+		result.meshOpenSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - openStart).count();
+		result.meshTriangleCount = meshFile.GetView().indexCount / 3;
+		device.SetSceneMesh(meshFile.GetView());
+	}
+
+	// Rendered at the output size, with the same scene.
+	std::unique_ptr<ReferenceRenderer> referenceRenderer;
+	std::unique_ptr<FileFrameSink> referenceSink;
+	ImageBgra8 reference(options.outputWidth, options.outputHeight);
+	double referenceSeconds = 0.0;
+	if (options.referenceSamplesPerSide > 0)
+	{
+		referenceRenderer.reset(new ReferenceRenderer(options.outputWidth, options.outputHeight, options.referenceSamplesPerSide, &jobs));
+		referenceRenderer->SetSceneInstances(CreateInstancedScene(options.instanceCount));
+		if (!options.meshPath.empty())
+		{
+			referenceRenderer->SetSceneMesh(meshFile.GetView());
+		}
+		if (!options.referenceOutputPrefix.empty())
+		{
+			referenceSink.reset(new FileFrameSink(options.referenceOutputPrefix));
+		}
+		result.worstPsnr = std::numeric_limits<double>::infinity();
+	}
+
+	CpuUpscaler spatialUpscaler(options.filter, options.sharpness, &jobs);
+	CpuTemporalUpscaler temporalUpscaler(&jobs);
+	IUpscaler& upscaler = options.isTemporal ? static_cast<IUpscaler&>(temporalUpscaler) : spatialUpscaler;
+	JitterSequence jitterSequence(JitterPattern::Halton23, JitterSequence::RecommendedPhaseCount(options.renderWidth, options.outputWidth));
+
+	RenderSize renderSize{ options.renderWidth, options.renderHeight };
+
+	SceneConstants sceneConstants;
+	sceneConstants.view = GetSceneView();
+	sceneConstants.projection = GetSceneProjection(static_cast<float>(options.renderWidth) / static_cast<float>(options.renderHeight));
+	sceneConstants.unjitteredProjection = sceneConstants.projection;
+	auto prepareFrame = [&](int frame, SceneConstants& constants, JitterOffset& jitter)
+	{
+		constants = sceneConstants;
+		constants.sceneAngle = frame * c_radiansPerFrame;
+		constants.model = MatrixRotationY(constants.sceneAngle);
+		jitter = JitterOffset{};
+		if (options.isTemporal)
+		{
+			jitter = jitterSequence.GetOffset(frame);
+			constants.projection = JitterProjection(sceneConstants.unjitteredProjection, jitter, renderSize);
+		}
+	};
+
+	auto start = std::chrono::steady_clock::now();
+	auto lastFinish = start;
+
+	// Everything after upscaling. Returns false to stop the run.
+	auto finishFrame = [&](int frame, SceneConstants const& constants, ImageBgra8 const& output, ImageMotionVectors const* motionVectors, RasterizerStats const& rasterizerStats)
+	{
+		auto finish = std::chrono::steady_clock::now();
+		result.rasterizerStats += rasterizerStats;
+		result.frameTimes.Add(std::chrono::duration<double>(finish - (frame == 0 ? start : lastFinish)).count());
+		lastFinish = finish;
+		if (frame == 0)
+		{
+			result.firstFrameSeconds = std::chrono::duration<double>(finish - start).count();
+		}
+
+		if (motionVectors)
+		{
+			sink.OnMotionVectors(frame, *motionVectors);
+		}
+		if (!sink.OnFrame(frame, output))
+		{
+			return false;
+		}
+
+		if (referenceRenderer)
+		{
+			auto referenceStart = std::chrono::steady_clock::now();
+			referenceRenderer->Render(constants, reference);
+			double psnr = ComputePsnr(output, reference, &jobs);
+			result.meanPsnr += psnr;
+			result.worstPsnr = std::min(result.worstPsnr, psnr);
+			if (referenceSink && !referenceSink->OnFrame(frame, reference))
+			{
+				return false;
+			}
+			auto referenceDuration = std::chrono::steady_clock::now() - referenceStart;
+			referenceSeconds += std::chrono::duration<double>(referenceDuration).count();
+			lastFinish += referenceDuration;
+		}
+		return true;
+	};
+
+	if (options.pipelineDepth > 0)
+	{
+		CpuStagedPipeline pipeline(device, options.pipelineDepth, options.renderWidth, options.renderHeight, options.outputWidth, options.outputHeight);
+		start = std::chrono::steady_clock::now();
+		pipeline.SetMotionVectorSource(options.motionVectorSource);
+		result.frameCount = pipeline.Run(options.frameCount, renderSize, upscaler, prepareFrame,
+			[&](CpuStagedFrame const& frame)
+			{
+				ImageMotionVectors const* motionVectors = options.isTemporal ? &GetCpuImage<MotionVector>(*frame.motionVectors) : nullptr;
+				return finishFrame(frame.frameNumber, frame.constants, GetCpuImage<uint32_t>(*frame.output), motionVectors, frame.rasterizerStats);
+			});
+		result.stageSummary = pipeline.GetStageSummary();
+	}
+	else if (options.frameDriver == FrameDriver::VideoQueue)
+	{
+		QueuedCpuDevice queuedDevice(device);
+		QueuedUpscaler queuedUpscaler(queuedDevice, upscaler);
+		ScalingPipeline pipeline(queuedDevice, options.renderWidth, options.renderHeight, options.outputWidth, options.outputHeight);
+		pipeline.SetMotionVectorSource(options.motionVectorSource);
+
+		struct RecordedFrame
+		{
+			SceneConstants constants;
+			int frameIndex;			// The device's, for its rasterizer stats
+			uint64_t upscaledBy;	// How many frames the device had recorded once this one was upscaled
+			IImage* output;
+			IImage* motionVectors;	// With a temporal upscaler
+		};
+		std::vector<RecordedFrame> frames(options.framesInFlight);
+
+		// Estimated motion has each frame upscaled in the next one, so a frame's output is only known after
+		// the next has been recorded.
+		uint64_t deviceFrameCount = 0;
+		auto recordDeviceFrame = [&](std::function<void()> const& record)
+		{
+			queuedDevice.BeginFrame();
+			record();
+			queuedDevice.EndFrame();
+			++deviceFrameCount;
+
+			int upscaled = pipeline.GetOutputFrameNumber();
+			if (upscaled >= result.frameCount && frames[upscaled % options.framesInFlight].upscaledBy == 0)
+			{
+				RecordedFrame& recorded = frames[upscaled % options.framesInFlight];
+				recorded.upscaledBy = deviceFrameCount;
+				recorded.output = &pipeline.GetOutput();
+				recorded.motionVectors = options.isTemporal ? &pipeline.GetMotionVectors() : nullptr;
+			}
+		};
+
+		// Hands the oldest frame to the sink once the queues are done with it, as a pass that reads its images,
+		// so that the check covers recording over them too. With one frame in flight, or at the end of the run,
+		// the frame may still be waiting for the next to upscale it.
+		bool isStopped = false;
+		auto finishOldest = [&]
+		{
+			int frame = result.frameCount;
+			RecordedFrame const& recorded = frames[frame % options.framesInFlight];
+			if (recorded.upscaledBy == 0)
+			{
+				recordDeviceFrame([&] { pipeline.FinishUpscaling(); });
+			}
+			queuedDevice.GetFrameFence().WaitOnCpu(recorded.upscaledBy);
+
+			std::vector<IImage const*> reads = { recorded.output };
+			if (recorded.motionVectors)
+			{
+				reads.push_back(recorded.motionVectors);
+			}
+			queuedDevice.RunOnCpu("finishing", frame, std::move(reads), [&]
+			{
+				ImageMotionVectors const* motionVectors = recorded.motionVectors ? &GetCpuImage<MotionVector>(*recorded.motionVectors) : nullptr;
+				isStopped = !finishFrame(frame, recorded.constants, GetCpuImage<uint32_t>(*recorded.output), motionVectors, queuedDevice.GetRasterizerStats(recorded.frameIndex));
+			});
+			if (!isStopped)
+			{
+				++result.frameCount;
+			}
+		};
+
+		start = std::chrono::steady_clock::now();
+		for (int frame = 0; frame < options.frameCount && !isStopped; ++frame)
+		{
+			if (frame - result.frameCount == options.framesInFlight)
+			{
+				finishOldest();
+				if (isStopped)
+				{
+					break;
+				}
+			}
+
+			RecordedFrame& recorded = frames[frame % options.framesInFlight];
+			JitterOffset jitter;
+			prepareFrame(frame, recorded.constants, jitter);
+			recorded.frameIndex = queuedDevice.GetFrameIndex();
+			recorded.upscaledBy = 0;
+			recordDeviceFrame([&] { pipeline.RenderFrame(recorded.constants, renderSize, jitter, &queuedUpscaler); });
+		}
+		while (!isStopped && result.frameCount < options.frameCount)
+		{
+			finishOldest();
+		}
+
+		queuedDevice.WaitForIdle();
+		if (!queuedDevice.CheckOrder(result.error))
+		{
+			return result;
+		}
+
+		// Each frame's motion estimation has the next frame's pass 1 to run alongside, given a frame to spare.
+		bool isEstimatingMotion = options.isTemporal && options.motionVectorSource == MotionVectorSource::Estimated;
+		if (isEstimatingMotion && options.framesInFlight > 1 && result.frameCount > 2 && queuedDevice.GetOverlapCount() == 0)
+		{
+			result.error = "Motion estimation never ran alongside the direct queue's passes";
+			return result;
+		}
+		result.schedulerSummary = queuedDevice.GetSummary() + ", and every pass ran after those it depends on";
+	}
+	else if (options.frameDriver != FrameDriver::Inline)
+	{
+		ScalingPipeline pipeline(device, options.renderWidth, options.renderHeight, options.outputWidth, options.outputHeight);
+		pipeline.SetMotionVectorSource(options.motionVectorSource);
+		FakeGpuFence fence;
+		FakeGpuQueue queue; // Gone before the fence, which its thread may still be signalling
+		std::vector<QueuedFrame> frames(options.framesInFlight);
+		FrameScheduler scheduler(options.frameDriver == FrameDriver::Blocking);
+		FrameQueueContext context = { scheduler, queue, fence, device, pipeline, upscaler, renderSize, frames, prepareFrame, finishFrame, 0, false, {} };
+
+		start = std::chrono::steady_clock::now();
+		scheduler.Run(options.frameCount, options.framesInFlight, [&](int frame) { return RunQueuedFrame(context, frame); });
+		result.frameCount = context.finishedCount;
+		result.schedulerSummary = scheduler.GetSummary();
+
+		if (!options.frameTimesPath.empty() && !SaveFrameTimeTrace(options.frameTimesPath, context.frameTimes, result.error))
+		{
+			return result;
+		}
+	}
+	else
+	{
+		ScalingPipeline pipeline(device, options.renderWidth, options.renderHeight, options.outputWidth, options.outputHeight);
+		pipeline.SetMotionVectorSource(options.motionVectorSource);
+		start = std::chrono::steady_clock::now();
+		for (int frame = 0; frame < options.frameCount; ++frame)
+		{
+			SceneConstants constants;
+			JitterOffset jitter;
+			prepareFrame(frame, constants, jitter);
+
+			device.BeginFrame();
+			pipeline.RenderFrame(constants, renderSize, jitter, &upscaler);
+			device.EndFrame();
+
+			ImageMotionVectors const* motionVectors = options.isTemporal ? &GetCpuImage<MotionVector>(pipeline.GetMotionVectors()) : nullptr;
+			if (!finishFrame(frame, constants, GetCpuImage<uint32_t>(pipeline.GetOutput()), motionVectors, device.GetRasterizerStats()))
+			{
+				break;
+			}
+			++result.frameCount;
+		}
+	}
+
+	result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() - referenceSeconds;
+	if (result.frameCount > 0)
+	{
+		result.overdraw = result.rasterizerStats.GetOverdraw(renderSize) / result.frameCount;
+		result.meanPsnr /= result.frameCount;
+		result.upscaleSeconds = (options.isTemporal ? temporalUpscaler.GetUpscaleSeconds() : spatialUpscaler.GetUpscaleSeconds()) / result.frameCount;
+		result.sharpenSeconds = spatialUpscaler.GetSharpenSeconds() / result.frameCount;
+	}
+	if (referenceSink)
+	{
+		result.referenceSummary = referenceSink->GetSummary();
+	}
+
+	char const* kernelName = CpuGetLinearKernelName(options.renderWidth, options.outputWidth);
+	if (!options.isTemporal && options.filter == CpuFilter::Linear && kernelName &&
+		!CompareLinearKernels(kernelName, renderSize, options.outputWidth, options.outputHeight, result.kernelSummary, result.error))
+	{
+		return result;
+	}
+
+	if (!options.pacingTracePath.empty())
+	{
+		std::vector<FrameTimes> trace;
+		if (!LoadFrameTimeTrace(options.pacingTracePath, trace, result.error))
+		{
+			return result;
+		}
+		PacingSimulation lowLatency = {};
+		for (PacingPolicy policy : { PacingPolicy::MaxThroughput, PacingPolicy::VsyncLocked, PacingPolicy::LowLatency })
+		{
+			PacingSimulation simulation = SimulatePacing(trace, policy, 1.0 / options.refreshRate, c_pacingFramesInFlight);
+			result.pacingReport += (result.pacingReport.empty() ? "" : "\n") + FormatPacingSimulation(policy, simulation);
+			if (policy == PacingPolicy::LowLatency)
+			{
+				lowLatency = simulation;
+			}
+		}
+
+		if (!options.pacingExpectedPath.empty())
+		{
+			PacingSimulation expected;
+			if (!LoadPacingExpectation(options.pacingExpectedPath, expected, result.error))
+			{
+				return result;
+			}
+			if (!MatchesPacingExpectation(lowLatency, expected))
+			{
+				char text[512];
+				snprintf(text, sizeof(text), "\nLow-latency pacing changed: %s expects %.2f ms mean latency, %.2f ms worst, %d vblanks missed, %d refreshes repeated",
+					options.pacingExpectedPath.c_str(), expected.meanLatencySeconds * 1000.0, expected.worstLatencySeconds * 1000.0,
+					expected.missedVblankCount, expected.repeatedRefreshCount);
+				result.error = result.pacingReport + text;
+				return result;
+			}
+		}
+	}
+
+	if (!options.resolutionTracePath.empty())
+	{
+		std::vector<double> trace;
+		if (!LoadFrameCostTrace(options.resolutionTracePath, trace, result.error))
+		{
+			return result;
+		}
+		DynamicResolutionSimulation simulation = SimulateDynamicResolution(trace, options.renderWidth, options.renderHeight,
+			options.resolutionBudgetMilliseconds / 1000.0, c_resolutionLatencyFrames);
+		result.resolutionReport = FormatDynamicResolutionSimulation(simulation, options.renderWidth, options.renderHeight);
+		if (!IsDynamicResolutionSettled(simulation))
+		{
+			result.error = result.resolutionReport + "\nDynamic resolution didn't settle on " + options.resolutionTracePath;
+			return result;
+		}
+	}
+	return result;
+}
+
+std::string scaling::FormatHeadlessResult(HeadlessResult const& result, IFrameSink const& sink)
+{
+	if (!result.error.empty())
+	{
+		return result.error;
+	}
+
+	double framesPerSecond = result.seconds > 0.0 ? result.frameCount / result.seconds : 0.0;
+	double millisecondsPerFrame = result.frameCount > 0 ? result.seconds * 1000.0 / result.frameCount : 0.0;
+
+	RasterizerStats const& stats = result.rasterizerStats;
+	double binRejectionRate = stats.triangleBinsTested ? static_cast<double>(stats.triangleBinsRejected) / stats.triangleBinsTested : 0.0;
+
+	char text[256];
+	snprintf(text, sizeof(text),
+		"%d frames in %.3f s: %.1f frames per second, %.3f ms per frame\n"
+		"Overdraw: %.3f fragments shaded per pixel, %.1f%% of tiles and %.1f%% of triangle bins rejected",
+		result.frameCount, result.seconds, framesPerSecond, millisecondsPerFrame,
+		result.overdraw, stats.GetTileRejectionRate() * 100.0, binRejectionRate * 100.0);
+	std::string formatted = text;
+
+	formatted += "\nFrame times: " + FormatFrameTimes(result.frameTimes);
+
+	if (result.sharpenSeconds > 0.0)
+	{
+		snprintf(text, sizeof(text), "Upscale: %.3f ms per frame, of which sharpening took %.3f ms of CPU time",
+			result.upscaleSeconds * 1000.0, result.sharpenSeconds * 1000.0);
+	}
+	else
+	{
+		snprintf(text, sizeof(text), "Upscale: %.3f ms per frame", result.upscaleSeconds * 1000.0);
+	}
+	formatted += std::string("\n") + text;
+	if (!result.kernelSummary.empty())
+	{
+		formatted += "\n" + result.kernelSummary;
+	}
+
+	if (result.meshTriangleCount > 0)
+	{
+		snprintf(text, sizeof(text), "Mesh: %zu triangles, mapped in %.3f ms, first frame in %.3f ms",
+			result.meshTriangleCount, result.meshOpenSeconds * 1000.0, result.firstFrameSeconds * 1000.0);
+		formatted += std::string("\n") + text;
+	}
+
+	if (result.worstPsnr > 0.0)
+	{
+		snprintf(text, sizeof(text), "Quality: %.2f dB mean PSNR, %.2f dB in the worst frame, against the supersampled reference",
+			result.meanPsnr, result.worstPsnr);
+		formatted += std::string("\n") + text;
+		if (!result.referenceSummary.empty())
+		{
+			formatted += "\n" + result.referenceSummary;
+		}
+	}
+
+	if (!result.stageSummary.empty())
+	{
+		formatted += "\n" + result.stageSummary;
+	}
+	if (!result.schedulerSummary.empty())
+	{
+		formatted += "\n" + result.schedulerSummary;
+	}
+	if (!result.pacingReport.empty())
+	{
+		formatted += "\n" + result.pacingReport;
+	}
+	if (!result.resolutionReport.empty())
+	{
+		formatted += "\n" + result.resolutionReport;
+	}
+	if (!result.frameGraphReport.empty())
+	{
+		formatted += "\n" + result.frameGraphReport;
+	}
+
+	std::string summary = sink.GetSummary();
+	return summary.empty() ? formatted : formatted + "\n" + summary;
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+#include "CpuScaler.h"
+#include "FrameSink.h"
+#include "FrameTimeHistogram.h"
+#include "ScalingPipeline.h"
+#include "SoftwareRasterizer.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace scaling
+{
+	enum class FrameSinkType
+	{
+		Discard,
+		Checksum,
+		File
+	};
+
+	// How a headless run gets its frames done.
+	enum class FrameDriver
+	{
+		Inline,		// Each pass runs on the calling thread as it's recorded
+		Blocking,	// The passes run on a queue's thread, and the calling thread waits for each frame's fence in turn
+		Coroutine,	// The passes run on a queue's thread, and each frame is a coroutine that a FrameScheduler runs
+		VideoQueue	// The passes run on a direct and a video queue's threads as QueuedCpuDevice runs them, checked for order
+	};
+
+	// Sizes default to the windowed application's source and destination sizes. The scene defaults to the
+	// instanced stress scene, which is the standard benchmark workload.
+	struct HeadlessOptions
+	{
+		int frameCount = 600;
+		int instanceCount = 10000;
+		std::string meshPath;	// A mesh file to draw for every instance in place of the cube
+		int renderWidth = 788;
+		int renderHeight = 592;
+		int outputWidth = 1024;
+		int outputHeight = 768;
+		bool isTemporal = false;	// CpuTemporalUpscaler, which takes jitter and motion vectors, in place of CpuUpscaler
+		MotionVectorSource motionVectorSource = MotionVectorSource::Rendered;
+		CpuFilter filter = CpuFilter::Linear;
+		float sharpness = 0.0f;
+		int workerCount = 1;			// Threads that every CPU pass shares, counting the caller and a staged pipeline's stages
+		bool isDeterministic = false;	// Whether jobs go to the same workers every run instead of being stolen
+		bool isHierarchicalDepthEnabled = true;
+		int framesInFlight = 1;	// How many copies of the per-frame images the pipeline cycles through
+		FrameDriver frameDriver = FrameDriver::Inline;
+		bool isFrameGraphReported = false;	// Whether to check the state tracker, plan the frame as a frame graph and report its memory
+
+		// With more than 0, the passes run as a CpuStagedPipeline this many frames deep in place of a
+		// ScalingPipeline, and framesInFlight and frameDriver don't apply.
+		int pipelineDepth = 0;
+		FrameSinkType sinkType = FrameSinkType::Checksum;
+		std::string outputPrefix = "frame"; // For FrameSinkType::File
+
+		// With more than 0, every frame is compared against a reference supersampled this many times per side.
+		// The references are written to files too when there's a prefix for them.
+		int referenceSamplesPerSide = 0;
+		std::string referenceOutputPrefix;
+
+		// With a frame driver that uses a queue, each frame's time on this thread and on the queue is written
+		// to a frame time trace (see FramePacer.h).
+		std::string frameTimesPath;
+
+		// After the run, a frame time trace is run through every pacing policy on a display of this rate.
+		std::string pacingTracePath;
+		int refreshRate = 60;
+
+		// With a pacing trace, the run fails unless the latency-minimizing policy does exactly as well on it
+		// as this file says (see LoadPacingExpectation).
+		std::string pacingExpectedPath;
+
+		// After the run, a trace of GPU frame costs at the render size is run through the dynamic resolution
+		// controller with this budget, and the run fails if the controller doesn't settle.
+		std::string resolutionTracePath;
+		int resolutionBudgetMilliseconds = 15;
+	};
+
+	struct HeadlessResult
+	{
+		int frameCount;	// Fewer than asked for when the sink stopped the run
+		double seconds;	// Rendering, upscaling and the sink, without setup
+		double overdraw;	// Fragments shaded per pixel of the render size, averaged over the frames
+		RasterizerStats rasterizerStats;	// Summed over the frames
+		FrameTimeHistogram frameTimes;		// Between one frame reaching the sink and the next, without the reference
+
+		// Per frame, and with sharpening, how much of it that took.
+		double upscaleSeconds;
+		double sharpenSeconds;
+
+		// With spatial linear upscaling at a ratio that has a specialized kernel, how long the kernel takes
+		// against the generic loop. The run fails if they don't give the same output.
+		std::string kernelSummary;
+
+		// With a mesh file, how long it took to map, and how long the first frame took, which includes
+		// reading in every page of it that's drawn.
+		size_t meshTriangleCount;
+		double meshOpenSeconds;
+		double firstFrameSeconds;
+
+		// With a reference, the PSNR of the upscaled frames against it, in dB. Rendering the references
+		// isn't counted in seconds.
+		double meanPsnr;
+		double worstPsnr;
+		std::string referenceSummary;	// Where the references were written
+
+		std::string stageSummary;		// With a staged pipeline, how busy each stage was
+		std::string schedulerSummary;	// With frames on a queue, how long the calling thread was blocked
+		std::string pacingReport;		// With a pacing trace, how each policy did
+		std::string resolutionReport;	// With a frame cost trace, how the dynamic resolution controller did
+		std::string frameGraphReport;
+
+		std::string error;	// Why nothing was rendered, such as a mesh file that couldn't be opened
+	};
+
+	// Whether the command line asks for a headless run, with --headless.
+	bool IsHeadlessCommandLine(std::vector<std::string> const& arguments);
+
+	// Fills in options from the command line, leaving the defaults for what isn't given. On failure, error
+	// says which argument was wrong.
+	bool ParseHeadlessOptions(std::vector<std::string> const& arguments, HeadlessOptions& options, std::string& error);
+
+	// The arguments ParseHeadlessOptions takes, one per line.
+	char const* GetHeadlessUsage();
+
+	std::unique_ptr<IFrameSink> CreateFrameSink(HeadlessOptions const& options);
+
+	// Renders and upscales frameCount frames on the CPU backend as fast as it can, handing each one to the
+	// sink instead of presenting it. The scene turns by the same amount every frame, at the windowed
+	// application's speed for 60 frames per second, so that runs are repeatable.
+	HeadlessResult RunHeadless(HeadlessOptions const& options, IFrameSink& sink);
+
+	// One line with the frame rate, one with how much shading the depth hierarchy saved, one with how long
+	// upscaling took and one comparing its kernels if it has a specialized one, one each with the mesh file's
+	// timings and the quality against the reference if there were any, how busy the stages were and the
+	// frame graph report if asked for, and then the sink's summary.
+	std::string FormatHeadlessResult(HeadlessResult const& result, IFrameSink const& sink);
+}
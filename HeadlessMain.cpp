@@ -0,0 +1,37 @@
+// Entry point for headless runs on platforms without the windowed application, such as Linux. On Windows,
+// the application itself takes --headless, and this file is excluded from the build.
+//
+// Builds from the portable files alone:
+//
+//     g++ -std=c++20 -O2 -mavx2 -mfma -pthread -o scaling-headless HeadlessMain.cpp Headless.cpp FrameSink.cpp
+//         CpuBackend.cpp ScalingPipeline.cpp SoftwareRasterizer.cpp JobSystem.cpp SceneGeometry.cpp
+//         CpuColorConversion.cpp CpuMotionEstimator.cpp CpuScaler.cpp CpuSharpen.cpp QualityPreset.cpp
+//         MeshFile.cpp MappedFile.cpp VertexTransform.cpp ReferenceRenderer.cpp FrameGraph.cpp
+//         ResourceStateTracker.cpp ScalingFrameGraph.cpp CpuStagedPipeline.cpp FakeGpuQueue.cpp FrameScheduler.cpp
+//         FramePacer.cpp FrameTimeHistogram.cpp DynamicResolution.cpp CpuTemporalScaler.cpp
+//         JitterSequence.cpp QueuedCpuDevice.cpp GpuQueue.cpp CpuFeatures.cpp
+
+#include "Headless.h"
+
+#include <cstdio>
+
+using namespace scaling;
+
+int main(int argc, char** argv)
+{
+	std::vector<std::string> arguments(argv + 1, argv + argc);
+
+	HeadlessOptions options;
+	std::string error;
+	if (!ParseHeadlessOptions(arguments, options, error))
+	{
+		fprintf(stderr, "%s\n\n%s", error.c_str(), GetHeadlessUsage());
+		return 1;
+	}
+
+	std::unique_ptr<IFrameSink> sink = CreateFrameSink(options);
+	HeadlessResult result = RunHeadless(options, *sink);
+	printf("%s\n", FormatHeadlessResult(result, *sink).c_str());
+
+	return result.error.empty() && result.frameCount == options.frameCount ? 0 : 1;
+}
@@ -0,0 +1,76 @@
+#include "JitterSequence.h"
+
+#include <cmath>
+
+using namespace scaling;
+
+double scaling::Halton(uint32_t index, uint32_t base)
+{
+	double result = 0;
+	double fraction = 1.0 / base;
+	while (index > 0)
+	{
+		result += (index % base) * fraction;
+		index /= base;
+		fraction /= base;
+	}
+	return result;
+}
+
+JitterSequence::JitterSequence(JitterPattern pattern, int phaseCount)
+	: m_pattern(pattern)
+	, m_phaseCount(1)
+{
+	SetPhaseCount(phaseCount);
+}
+
+void JitterSequence::SetPhaseCount(int phaseCount)
+{
+	m_phaseCount = phaseCount < 1 ? 1 : phaseCount;
+}
+
+int JitterSequence::RecommendedPhaseCount(int renderWidth, int displayWidth)
+{
+	if (renderWidth <= 0 || displayWidth <= renderWidth)
+	{
+		return 8;
+	}
+	double ratio = static_cast<double>(displayWidth) / renderWidth;
+	return static_cast<int>(std::ceil(8.0 * ratio * ratio));
+}
+
+JitterOffset JitterSequence::GetOffset(uint32_t frameNumber) const
+{
+	uint32_t phase = frameNumber % static_cast<uint32_t>(m_phaseCount);
+
+	double x = 0.5;
+	double y = 0.5;
+	switch (m_pattern)
+	{
+	case JitterPattern::Halton23:
+		// Index 0 of both sequences is 0, a corner of the pixel, so start at 1.
+		x = Halton(phase + 1, 2);
+		y = Halton(phase + 1, 3);
+		break;
+
+	case JitterPattern::R2:
+	{
+		// The additive recurrence on the plastic number. See "The Unreasonable Effectiveness of Quasirandom Sequences".
+		const double g = 1.32471795724474602596;
+		double n = static_cast<double>(phase);
+		x = 0.5 + n / g;
+		y = 0.5 + n / (g * g);
+		x -= std::floor(x);
+		y -= std::floor(y);
+		break;
+	}
+
+	default:
+		break;
+	}
+
+	JitterOffset offset;
+	offset.x = static_cast<float>(x - 0.5);
+	offset.y = static_cast<float>(y - 0.5);
+	return offset;
+}
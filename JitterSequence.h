@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+
+namespace scaling
+{
+	enum class JitterPattern
+	{
+		None,
+		Halton23,
+		R2,
+		NumJitterPatterns
+	};
+
+	// Where in the pixel a frame samples, in pixels relative to the pixel center. x points right and y
+	// points down; both are in [-0.5, 0.5). This is the convention DLSS and XeSS take their jitter in.
+	struct JitterOffset
+	{
+		float x;
+		float y;
+	};
+
+	// Sub-pixel sample positions for temporal upscaling. The offset for a frame depends only on the
+	// pattern, the phase count and the frame number, so a captured sequence of frames can be replayed
+	// with exactly the same jitter.
+	class JitterSequence
+	{
+	public:
+		JitterSequence(JitterPattern pattern, int phaseCount);
+
+		JitterOffset GetOffset(uint32_t frameNumber) const;
+
+		JitterPattern	GetPattern() const			{ return m_pattern; }
+		void			SetPattern(JitterPattern pattern) { m_pattern = pattern; }
+		int				GetPhaseCount() const		{ return m_phaseCount; }
+		void			SetPhaseCount(int phaseCount);
+
+		// Enough phases to cover each output pixel about eight times, which is what DLSS's guidelines ask for.
+		static int RecommendedPhaseCount(int renderWidth, int displayWidth);
+
+	private:
+		JitterPattern m_pattern;
+		int m_phaseCount;
+	};
+
+	// Element index of the radical inverse sequence in the given base, in [0, 1).
+	double Halton(uint32_t index, uint32_t base);
+}
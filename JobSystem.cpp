@@ -0,0 +1,458 @@
+#include "JobSystem.h"
+#include "WorkStealingDeque.h"
+
+#include <algorithm>
+#include <cassert>
+#include <deque>
+
+using namespace scaling;
+
+namespace
+{
+	// Far more than a thread has at once, since ranges split in halves.
+	const size_t c_dequeCapacity = 1024;
+
+	// How many times an idle thread looks for work, yielding in between, before it sleeps.
+	const int c_searchesBeforeSleeping = 64;
+}
+
+// One set of deques and a mailbox, for a thread of the system's own or a thread that's called in.
+struct scaling::JobWorker
+{
+	explicit JobWorker(int index)
+		: index(index)
+		, deque(c_dequeCapacity)
+		, mailboxSize(0)
+		, isClaimed(false)
+	{
+	}
+
+	int index;
+	WorkStealingDeque<JobSystem::Job> deque;
+
+	// Jobs that only this worker may run. Filled by any thread.
+	std::mutex mailboxMutex;
+	std::deque<JobSystem::Job*> mailbox;
+	std::atomic<int> mailboxSize;
+
+	std::atomic<bool> isClaimed; // For the calling threads' workers, whether a thread is using it
+};
+
+namespace
+{
+	// The system and worker that the current thread runs jobs as, if any.
+	thread_local JobSystem* t_system = nullptr;
+	thread_local JobWorker* t_worker = nullptr;
+}
+
+struct JobSystem::Job
+{
+	Batch* batch;
+	int begin;	// ParallelFor: items begin, begin + stride and so on, below end. Graphs: the job's index.
+	int end;
+	int stride;
+};
+
+// One call to ParallelFor or Run. Lives on the caller's stack, and nothing refers to it once every job has
+// finished.
+struct JobSystem::Batch
+{
+	std::function<void(int, int)> const* task;
+	JobGraph const* graph;
+
+	std::vector<Job> jobs;
+	std::atomic<int> jobCount; // Used from the front of jobs, as ranges split
+	std::atomic<int> remainingCount; // Items, or graph jobs, that haven't finished
+	std::unique_ptr<std::atomic<int>[]> dependencyCounts; // Graphs: how many jobs each job still waits for
+
+	// Deterministic mode: the caller's worker, then the threads'. Work goes to them by index, modulo their number.
+	std::vector<JobWorker*> participants;
+};
+
+int JobGraph::Add(Job job)
+{
+	m_nodes.push_back(Node{ std::move(job), {}, 0 });
+	return static_cast<int>(m_nodes.size()) - 1;
+}
+
+void JobGraph::AddDependency(int before, int after)
+{
+	assert(before >= 0 && before < after && after < static_cast<int>(m_nodes.size()));
+	m_nodes[before].dependents.push_back(after);
+	++m_nodes[after].dependencyCount;
+}
+
+void scaling::ForEachTile(JobSystem* jobs, int width, int height, int tileWidth, int tileHeight, std::function<void(Tile const&, int)> const& task)
+{
+	if (jobs)
+	{
+		jobs->ParallelForTiles(width, height, tileWidth, tileHeight, task);
+		return;
+	}
+
+	for (int y = 0; y < height; y += tileHeight)
+	{
+		for (int x = 0; x < width; x += tileWidth)
+		{
+			Tile tile = { (y / tileHeight) * ((width + tileWidth - 1) / tileWidth) + x / tileWidth, x, y, std::min(tileWidth, width - x), std::min(tileHeight, height - y) };
+			task(tile, 0);
+		}
+	}
+}
+
+JobSystem::JobSystem(int workerCount, bool isDeterministic)
+	: m_isDeterministic(isDeterministic)
+	, m_epoch(0)
+	, m_sleepingCount(0)
+	, m_isExiting(false)
+{
+	int threadCount = std::max(workerCount - 1, 0);
+	for (int index = 0; index < c_maxCallingThreads + threadCount; ++index)
+	{
+		m_workers.emplace_back(new JobWorker(index));
+	}
+	for (int thread = 0; thread < threadCount; ++thread)
+	{
+		m_threads.emplace_back(&JobSystem::WorkerMain, this, std::ref(*m_workers[c_maxCallingThreads + thread]));
+	}
+}
+
+JobSystem::~JobSystem()
+{
+	m_isExiting = true;
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+	}
+	m_jobAvailable.notify_all();
+
+	for (std::thread& thread : m_threads)
+	{
+		thread.join();
+	}
+}
+
+void JobSystem::ParallelFor(int count, std::function<void(int, int)> const& task)
+{
+	if (count <= 0)
+	{
+		return;
+	}
+
+	Batch batch;
+	batch.task = &task;
+	batch.graph = nullptr;
+	batch.jobs.resize(count);
+	batch.jobCount = 0;
+	batch.remainingCount = count;
+	RunBatch(batch);
+}
+
+void JobSystem::ParallelForTiles(int width, int height, int tileWidth, int tileHeight, std::function<void(Tile const&, int)> const& task)
+{
+	assert(tileWidth > 0 && tileHeight > 0);
+	int tilesX = (width + tileWidth - 1) / tileWidth;
+	int tilesY = (height + tileHeight - 1) / tileHeight;
+	ParallelFor(tilesX * tilesY, [&](int index, int worker)
+	{
+		Tile tile;
+		tile.index = index;
+		tile.x = (index % tilesX) * tileWidth;
+		tile.y = (index / tilesX) * tileHeight;
+		tile.width = std::min(tileWidth, width - tile.x);
+		tile.height = std::min(tileHeight, height - tile.y);
+		task(tile, worker);
+	});
+}
+
+void JobSystem::Run(JobGraph const& graph)
+{
+	int jobCount = graph.GetJobCount();
+	if (jobCount == 0)
+	{
+		return;
+	}
+
+	Batch batch;
+	batch.task = nullptr;
+	batch.graph = &graph;
+	batch.jobs.resize(jobCount);
+	batch.jobCount = jobCount;
+	batch.remainingCount = jobCount;
+	batch.dependencyCounts.reset(new std::atomic<int>[jobCount]);
+	for (int index = 0; index < jobCount; ++index)
+	{
+		batch.jobs[index] = Job{ &batch, index, index + 1, 1 };
+		batch.dependencyCounts[index] = graph.m_nodes[index].dependencyCount;
+	}
+	RunBatch(batch);
+}
+
+void JobSystem::RunBatch(Batch& batch)
+{
+	// A thread that already runs jobs as one of this system's workers, because it's one of the threads or
+	// it's calling in from a job, stays that worker.
+	JobSystem* previousSystem = t_system;
+	JobWorker* previousWorker = t_worker;
+	bool isCallingIn = previousSystem != this;
+	JobWorker& worker = isCallingIn ? *ClaimCallingWorker() : *previousWorker;
+	t_system = this;
+	t_worker = &worker;
+
+	if (m_isDeterministic)
+	{
+		batch.participants.push_back(&worker);
+		for (size_t index = c_maxCallingThreads; index < m_workers.size(); ++index)
+		{
+			if (m_workers[index].get() != &worker)
+			{
+				batch.participants.push_back(m_workers[index].get());
+			}
+		}
+	}
+
+	if (batch.graph)
+	{
+		Job* first = nullptr;
+		for (Job& job : batch.jobs)
+		{
+			if (batch.dependencyCounts[job.begin] != 0)
+			{
+				continue;
+			}
+			if (m_isDeterministic)
+			{
+				Pin(*batch.participants[job.begin % batch.participants.size()], &job);
+			}
+			else if (!first)
+			{
+				first = &job;
+			}
+			else
+			{
+				Push(worker, &job);
+			}
+		}
+		Execute(worker, first);
+	}
+	else
+	{
+		int count = static_cast<int>(batch.jobs.size());
+		if (m_isDeterministic)
+		{
+			int participantCount = std::min(static_cast<int>(batch.participants.size()), count);
+			for (int participant = 0; participant < participantCount; ++participant)
+			{
+				batch.jobs[participant] = Job{ &batch, participant, count, participantCount };
+			}
+			for (int participant = 1; participant < participantCount; ++participant)
+			{
+				Pin(*batch.participants[participant], &batch.jobs[participant]);
+			}
+		}
+		else
+		{
+			batch.jobs[0] = Job{ &batch, 0, count, 1 };
+			batch.jobCount = 1;
+		}
+		Execute(worker, &batch.jobs[0]);
+	}
+
+	// Helps with whatever there is, which may be another caller's, until this batch is done.
+	while (batch.remainingCount.load(std::memory_order_acquire) > 0)
+	{
+		Job* job = FindJob(worker);
+		if (job)
+		{
+			Execute(worker, job);
+		}
+		else
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	t_system = previousSystem;
+	t_worker = previousWorker;
+	if (isCallingIn)
+	{
+		worker.isClaimed.store(false, std::memory_order_release);
+	}
+}
+
+JobWorker* JobSystem::ClaimCallingWorker()
+{
+	for (;;)
+	{
+		for (int index = 0; index < c_maxCallingThreads; ++index)
+		{
+			bool isClaimed = false;
+			if (m_workers[index]->isClaimed.compare_exchange_strong(isClaimed, true, std::memory_order_acquire))
+			{
+				return m_workers[index].get();
+			}
+		}
+		std::this_thread::yield();
+	}
+}
+
+// Runs the job, and then any job in the same graph that it made ready, until there's none.
+void JobSystem::Execute(JobWorker& worker, Job* job)
+{
+	while (job)
+	{
+		Batch& batch = *job->batch;
+		Job* next = nullptr;
+
+		if (batch.graph)
+		{
+			JobGraph::Node const& node = batch.graph->m_nodes[job->begin];
+			node.job(worker.index);
+			for (int dependent : node.dependents)
+			{
+				if (batch.dependencyCounts[dependent].fetch_sub(1, std::memory_order_acq_rel) != 1)
+				{
+					continue;
+				}
+				Job* ready = &batch.jobs[dependent];
+				if (m_isDeterministic)
+				{
+					Pin(*batch.participants[dependent % batch.participants.size()], ready);
+				}
+				else if (!next)
+				{
+					next = ready;
+				}
+				else
+				{
+					Push(worker, ready);
+				}
+			}
+			batch.remainingCount.fetch_sub(1, std::memory_order_release);
+		}
+		else
+		{
+			int begin = job->begin;
+			int end = job->end;
+			if (job->stride == 1)
+			{
+				while (end - begin > 1 && !worker.deque.IsFull())
+				{
+					int middle = begin + (end - begin) / 2;
+					Job* rest = &batch.jobs[batch.jobCount.fetch_add(1, std::memory_order_relaxed)];
+					*rest = Job{ &batch, middle, end, 1 };
+					Push(worker, rest);
+					end = middle;
+				}
+			}
+
+			int doneCount = 0;
+			for (int index = begin; index < end; index += job->stride)
+			{
+				(*batch.task)(index, worker.index);
+				++doneCount;
+			}
+			batch.remainingCount.fetch_sub(doneCount, std::memory_order_release);
+		}
+
+		job = next;
+	}
+}
+
+JobSystem::Job* JobSystem::FindJob(JobWorker& worker)
+{
+	if (worker.mailboxSize.load(std::memory_order_acquire) > 0)
+	{
+		std::lock_guard<std::mutex> lock(worker.mailboxMutex);
+		if (!worker.mailbox.empty())
+		{
+			Job* job = worker.mailbox.front();
+			worker.mailbox.pop_front();
+			--worker.mailboxSize;
+			return job;
+		}
+	}
+
+	if (Job* job = worker.deque.Pop())
+	{
+		return job;
+	}
+
+	if (m_isDeterministic)
+	{
+		return nullptr;
+	}
+	size_t workerCount = m_workers.size();
+	for (size_t offset = 1; offset < workerCount; ++offset)
+	{
+		if (Job* job = m_workers[(worker.index + offset) % workerCount]->deque.Steal())
+		{
+			return job;
+		}
+	}
+	return nullptr;
+}
+
+// Onto the worker's own deque, or its mailbox if the deque is full.
+void JobSystem::Push(JobWorker& worker, Job* job)
+{
+	if (!worker.deque.Push(job))
+	{
+		Pin(worker, job);
+		return;
+	}
+	Wake();
+}
+
+void JobSystem::Pin(JobWorker& worker, Job* job)
+{
+	{
+		std::lock_guard<std::mutex> lock(worker.mailboxMutex);
+		worker.mailbox.push_back(job);
+		++worker.mailboxSize;
+	}
+	Wake();
+}
+
+void JobSystem::Wake()
+{
+	m_epoch.fetch_add(1);
+	if (m_sleepingCount.load() > 0)
+	{
+		// Taking the lock means a thread that's about to sleep either sees the new epoch or is already waiting.
+		{
+			std::lock_guard<std::mutex> lock(m_sleepMutex);
+		}
+		m_jobAvailable.notify_all();
+	}
+}
+
+void JobSystem::WorkerMain(JobWorker& worker)
+{
+	t_system = this;
+	t_worker = &worker;
+
+	int searchCount = 0;
+	while (!m_isExiting.load(std::memory_order_acquire))
+	{
+		uint64_t epoch = m_epoch.load();
+		Job* job = FindJob(worker);
+		if (job)
+		{
+			Execute(worker, job);
+			searchCount = 0;
+			continue;
+		}
+
+		if (++searchCount < c_searchesBeforeSleeping)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(m_sleepMutex);
+		++m_sleepingCount;
+		m_jobAvailable.wait(lock, [&] { return m_isExiting.load() || m_epoch.load() != epoch; });
+		--m_sleepingCount;
+		searchCount = 0;
+	}
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace scaling
+{
+	// A rectangle of a ParallelForTiles area.
+	struct Tile
+	{
+		int index;	// Row by row
+		int x;
+		int y;
+		int width;	// Smaller than asked for at the right and bottom edges
+		int height;
+	};
+
+	// Jobs, and the order they have to run in, for JobSystem::Run.
+	class JobGraph
+	{
+	public:
+		// Takes the worker index, as for JobSystem::ParallelFor.
+		typedef std::function<void(int worker)> Job;
+
+		// Returns the job's index.
+		int Add(Job job);
+
+		// Has after wait for before to finish. Jobs can only wait for jobs added before them, so there are no
+		// cycles.
+		void AddDependency(int before, int after);
+
+		int GetJobCount() const { return static_cast<int>(m_nodes.size()); }
+
+	private:
+		friend class JobSystem;
+
+		struct Node
+		{
+			Job job;
+			std::vector<int> dependents;
+			int dependencyCount;
+		};
+
+		std::vector<Node> m_nodes;
+	};
+
+	struct JobWorker;
+
+	// The threads every CPU kernel runs its parallel work on, so that kernels running at the same time, on
+	// different stages of a CpuStagedPipeline for instance, share one set of threads instead of each
+	// bringing its own. As with the pool it replaces, workerCount counts the thread that calls in: there are
+	// workerCount - 1 threads of its own, and a thread that calls in runs jobs too until its own are done,
+	// including other callers' jobs, so waiting never leaves a core idle. Up to c_maxCallingThreads threads
+	// can call in at once; any more wait for a turn.
+	//
+	// Every thread has a WorkStealingDeque. A range of work splits in halves, keeping the first half and
+	// leaving the second on the deque, so a thread works through its own share in order while idle
+	// threads steal the biggest pieces that are left. In a graph, a thread that finishes a job goes on to a
+	// job that it made ready, and leaves any others to be stolen.
+	//
+	// Deterministic mode does away with stealing: with n workers, the caller and the first n - 1 threads,
+	// work item i always runs on worker i % n, and a graph job j on worker j % n, in order. Runs are slower
+	// when the work is uneven, but which thread did what is the same every time, for benchmarks that have
+	// to be reproducible.
+	class JobSystem
+	{
+	public:
+		static const int c_maxCallingThreads = 8;
+
+		explicit JobSystem(int workerCount, bool isDeterministic = false);
+		~JobSystem();
+
+		int GetWorkerCount() const { return static_cast<int>(m_threads.size()) + 1; }
+		bool IsDeterministic() const { return m_isDeterministic; }
+
+		// Tasks are given a worker index below this, which no other task running at the same time has, for
+		// scratch memory of their own.
+		int GetWorkerIndexCount() const { return static_cast<int>(m_workers.size()); }
+
+		// Calls task(index, worker) for every index in [0, count), and returns once they've all finished.
+		void ParallelFor(int count, std::function<void(int, int)> const& task);
+
+		// Calls task(tile, worker) for the tileWidth x tileHeight tiles that cover a width x height area.
+		void ParallelForTiles(int width, int height, int tileWidth, int tileHeight, std::function<void(Tile const&, int)> const& task);
+
+		// Runs every job of the graph, each once the jobs it depends on have finished, and returns once
+		// they've all finished.
+		void Run(JobGraph const& graph);
+
+	private:
+		friend struct JobWorker;
+
+		struct Batch;
+		struct Job;
+
+		void RunBatch(Batch& batch);
+		JobWorker* ClaimCallingWorker();
+		void Execute(JobWorker& worker, Job* job);
+		Job* FindJob(JobWorker& worker);
+		void Push(JobWorker& worker, Job* job);
+		void Pin(JobWorker& worker, Job* job);
+		void Wake();
+		void WorkerMain(JobWorker& worker);
+
+		bool m_isDeterministic;
+
+		// The calling threads' workers first, then the threads'.
+		std::vector<std::unique_ptr<JobWorker>> m_workers;
+		std::vector<std::thread> m_threads;
+
+		// Idle threads sleep until the epoch moves, which it does whenever there's a new job.
+		std::mutex m_sleepMutex;
+		std::condition_variable m_jobAvailable;
+		std::atomic<uint64_t> m_epoch;
+		std::atomic<int> m_sleepingCount;
+		std::atomic<bool> m_isExiting;
+	};
+
+	// JobSystem::ParallelForTiles, or the same tiles in order on the calling thread, as worker 0, without a
+	// job system.
+	void ForEachTile(JobSystem* jobs, int width, int height, int tileWidth, int tileHeight, std::function<void(Tile const&, int)> const& task);
+}
@@ -0,0 +1,141 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace scaling;
+
+#ifdef _WIN32
+
+MappedFile::MappedFile()
+	: m_data(nullptr)
+	, m_size(0)
+	, m_file(INVALID_HANDLE_VALUE)
+	, m_mapping(nullptr)
+{
+}
+
+bool MappedFile::Open(std::string const& path, std::string& error)
+{
+	Close();
+
+	int wideLength = MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, nullptr, 0);
+	std::wstring widePath(wideLength > 0 ? wideLength : 1, L'\0');
+	MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, &widePath[0], wideLength);
+
+	m_file = CreateFileW(widePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	LARGE_INTEGER size = {};
+	if (m_file == INVALID_HANDLE_VALUE || !GetFileSizeEx(m_file, &size))
+	{
+		error = "Couldn't open " + path;
+		Close();
+		return false;
+	}
+	if (size.QuadPart == 0)
+	{
+		error = path + " is empty";
+		Close();
+		return false;
+	}
+
+	m_mapping = CreateFileMappingW(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	m_data = m_mapping ? static_cast<uint8_t const*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+	if (!m_data)
+	{
+		error = "Couldn't map " + path;
+		Close();
+		return false;
+	}
+	m_size = static_cast<size_t>(size.QuadPart);
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (m_data)
+	{
+		UnmapViewOfFile(m_data);
+	}
+	if (m_mapping)
+	{
+		CloseHandle(m_mapping);
+	}
+	if (m_file != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(m_file);
+	}
+	m_data = nullptr;
+	m_size = 0;
+	m_mapping = nullptr;
+	m_file = INVALID_HANDLE_VALUE;
+}
+
+#else
+
+MappedFile::MappedFile()
+	: m_data(nullptr)
+	, m_size(0)
+	, m_file(-1)
+{
+}
+
+bool MappedFile::Open(std::string const& path, std::string& error)
+{
+	Close();
+
+	m_file = open(path.c_str(), O_RDONLY);
+	struct stat status = {};
+	if (m_file < 0 || fstat(m_file, &status) != 0)
+	{
+		error = "Couldn't open " + path;
+		Close();
+		return false;
+	}
+	if (status.st_size == 0)
+	{
+		error = path + " is empty";
+		Close();
+		return false;
+	}
+
+	void* data = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, m_file, 0);
+	if (data == MAP_FAILED)
+	{
+		error = "Couldn't map " + path;
+		Close();
+		return false;
+	}
+	m_data = static_cast<uint8_t const*>(data);
+	m_size = static_cast<size_t>(status.st_size);
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (m_data)
+	{
+		munmap(const_cast<uint8_t*>(m_data), m_size);
+	}
+	if (m_file >= 0)
+	{
+		close(m_file);
+	}
+	m_data = nullptr;
+	m_size = 0;
+	m_file = -1;
+}
+
+#endif
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace scaling
+{
+	// A whole file mapped read-only into memory. Pages are read in by the OS as they're first touched, so
+	// opening costs the same whatever the size of the file.
+	class MappedFile
+	{
+	public:
+		MappedFile();
+		~MappedFile();
+
+		MappedFile(MappedFile const&) = delete;
+		MappedFile& operator=(MappedFile const&) = delete;
+
+		// Unmaps whatever was open. The path is UTF-8. On failure, error says why, and the file is left closed.
+		bool Open(std::string const& path, std::string& error);
+		void Close();
+
+		uint8_t const* GetData() const	{ return m_data; }
+		size_t GetSize() const			{ return m_size; }
+
+	private:
+		uint8_t const* m_data;
+		size_t m_size;
+
+#ifdef _WIN32
+		void* m_file;
+		void* m_mapping;
+#else
+		int m_file;
+#endif
+	};
+}
@@ -0,0 +1,61 @@
+// Converts OBJ files to the mesh files that --mesh loads, and writes large test meshes. Excluded from the
+// Windows build, like HeadlessMain.cpp; builds from the portable files alone:
+//
+//     g++ -std=c++17 -O2 -o mesh-convert MeshConvertMain.cpp MeshFile.cpp MappedFile.cpp SceneGeometry.cpp
+//         QualityPreset.cpp
+
+#include "MeshFile.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace scaling;
+
+namespace
+{
+	const char c_usage[] =
+		"mesh-convert INPUT.obj OUTPUT.mesh   Converts an OBJ file\n"
+		"mesh-convert --sphere N OUTPUT.mesh  Writes the stress mesh with about N triangles\n";
+}
+
+int main(int argc, char** argv)
+{
+	if (argc != 3 && !(argc == 4 && std::string(argv[1]) == "--sphere"))
+	{
+		fprintf(stderr, "%s", c_usage);
+		return 1;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+
+	SceneMesh mesh;
+	std::string error;
+	if (argc == 4)
+	{
+		long triangleCount = strtol(argv[2], nullptr, 10);
+		if (triangleCount <= 0 || triangleCount > 100000000)
+		{
+			fprintf(stderr, "The triangle count must be from 1 to 100000000\n");
+			return 1;
+		}
+		mesh = CreateStressMesh(static_cast<int>(triangleCount));
+	}
+	else if (!LoadObjMesh(argv[1], mesh, error))
+	{
+		fprintf(stderr, "%s\n", error.c_str());
+		return 1;
+	}
+
+	char const* outputPath = argv[argc - 1];
+	if (!WriteMeshFile(outputPath, GetMeshView(mesh), error))
+	{
+		fprintf(stderr, "%s\n", error.c_str());
+		return 1;
+	}
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	printf("Wrote %zu triangles, %zu vertices and %zu chunks to %s in %.3f s\n",
+		mesh.indices.size() / 3, mesh.vertices.size(), mesh.chunks.size(), outputPath, seconds);
+	return 0;
+}
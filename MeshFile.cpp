@@ -0,0 +1,298 @@
+#include "MeshFile.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+using namespace scaling;
+
+namespace
+{
+	const char c_meshFileMagic[4] = { 'S', 'M', 'S', 'H' };
+	const uint32_t c_meshFileVersion = 1;
+	const uint64_t c_meshFileAlignment = 16;
+
+	struct MeshFileHeader
+	{
+		char magic[4];
+		uint32_t version;
+		uint32_t vertexSize;	// sizeof(SceneVertex), as a check that the layout matches
+		uint32_t chunkCount;
+		uint64_t vertexCount;
+		uint64_t indexCount;
+		uint64_t chunkOffset;
+		uint64_t vertexOffset;
+		uint64_t indexOffset;
+	};
+	static_assert(sizeof(MeshFileHeader) == 56, "The mesh file header can't have padding");
+	static_assert(sizeof(SceneVertex) == 24 && sizeof(MeshChunk) == 16, "Mesh files hold these as they are in memory");
+
+	uint64_t AlignOffset(uint64_t offset)
+	{
+		return (offset + c_meshFileAlignment - 1) & ~(c_meshFileAlignment - 1);
+	}
+
+	// Whether count elements of the given size fit in the file at offset.
+	bool IsInFile(uint64_t offset, uint64_t count, uint64_t elementSize, uint64_t fileSize)
+	{
+		return offset % c_meshFileAlignment == 0 && offset <= fileSize && count <= (fileSize - offset) / elementSize;
+	}
+
+	// OBJ indices start at 1, and count back from the last vertex when negative. Returns false for an index
+	// that isn't a vertex.
+	bool ParseObjIndex(char const*& text, size_t vertexCount, uint32_t& index)
+	{
+		char* end = nullptr;
+		long parsed = strtol(text, &end, 10);
+		if (end == text)
+		{
+			return false;
+		}
+		text = end;
+
+		// Skip the texture coordinate and normal of v/vt/vn, v//vn and v/vt.
+		while (*text == '/' || (*text >= '0' && *text <= '9') || *text == '-')
+		{
+			++text;
+		}
+
+		long long resolved = parsed < 0 ? static_cast<long long>(vertexCount) + parsed : parsed - 1;
+		if (parsed == 0 || resolved < 0 || resolved >= static_cast<long long>(vertexCount))
+		{
+			return false;
+		}
+		index = static_cast<uint32_t>(resolved);
+		return true;
+	}
+}
+
+bool MeshFile::Open(std::string const& path, std::string& error)
+{
+	m_view = SceneMeshView{};
+	if (!m_file.Open(path, error))
+	{
+		return false;
+	}
+
+	MeshFileHeader header;
+	uint64_t fileSize = m_file.GetSize();
+	if (fileSize < sizeof(header))
+	{
+		error = path + " is too small to be a mesh file";
+		m_file.Close();
+		return false;
+	}
+	memcpy(&header, m_file.GetData(), sizeof(header));
+
+	if (memcmp(header.magic, c_meshFileMagic, sizeof(c_meshFileMagic)) != 0 || header.version != c_meshFileVersion || header.vertexSize != sizeof(SceneVertex))
+	{
+		error = path + " isn't a version " + std::to_string(c_meshFileVersion) + " mesh file";
+		m_file.Close();
+		return false;
+	}
+	if (!IsInFile(header.chunkOffset, header.chunkCount, sizeof(MeshChunk), fileSize) ||
+		!IsInFile(header.vertexOffset, header.vertexCount, sizeof(SceneVertex), fileSize) ||
+		!IsInFile(header.indexOffset, header.indexCount, sizeof(uint16_t), fileSize))
+	{
+		error = path + " is truncated";
+		m_file.Close();
+		return false;
+	}
+
+	if (header.chunkCount == 0 || header.indexCount == 0)
+	{
+		error = path + " has no triangles";
+		m_file.Close();
+		return false;
+	}
+
+	uint8_t const* data = m_file.GetData();
+	MeshChunk const* chunks = reinterpret_cast<MeshChunk const*>(data + header.chunkOffset);
+	uint16_t const* indices = reinterpret_cast<uint16_t const*>(data + header.indexOffset);
+	for (uint32_t i = 0; i < header.chunkCount; ++i)
+	{
+		MeshChunk const& chunk = chunks[i];
+		if (chunk.vertexCount > 65536 || chunk.indexCount % 3 != 0 ||
+			static_cast<uint64_t>(chunk.firstVertex) + chunk.vertexCount > header.vertexCount ||
+			static_cast<uint64_t>(chunk.firstIndex) + chunk.indexCount > header.indexCount)
+		{
+			error = path + " has a chunk outside of its vertices or indices";
+			m_file.Close();
+			return false;
+		}
+
+		// The renderers index the chunk's vertices with these as they are.
+		uint16_t const* chunkIndices = indices + chunk.firstIndex;
+		uint32_t largestIndex = 0;
+		for (uint32_t j = 0; j < chunk.indexCount; ++j)
+		{
+			largestIndex = std::max<uint32_t>(largestIndex, chunkIndices[j]);
+		}
+		if (chunk.indexCount > 0 && largestIndex >= chunk.vertexCount)
+		{
+			error = path + " has an index past the vertices of its chunk";
+			m_file.Close();
+			return false;
+		}
+	}
+
+	m_view.vertices = reinterpret_cast<SceneVertex const*>(data + header.vertexOffset);
+	m_view.vertexCount = static_cast<size_t>(header.vertexCount);
+	m_view.indices = indices;
+	m_view.indexCount = static_cast<size_t>(header.indexCount);
+	m_view.chunks = chunks;
+	m_view.chunkCount = header.chunkCount;
+	return true;
+}
+
+bool scaling::WriteMeshFile(std::string const& path, SceneMeshView const& mesh, std::string& error)
+{
+	MeshFileHeader header = {};
+	memcpy(header.magic, c_meshFileMagic, sizeof(c_meshFileMagic));
+	header.version = c_meshFileVersion;
+	header.vertexSize = sizeof(SceneVertex);
+	header.chunkCount = static_cast<uint32_t>(mesh.chunkCount);
+	header.vertexCount = mesh.vertexCount;
+	header.indexCount = mesh.indexCount;
+	header.chunkOffset = AlignOffset(sizeof(header));
+	header.vertexOffset = AlignOffset(header.chunkOffset + mesh.chunkCount * sizeof(MeshChunk));
+	header.indexOffset = AlignOffset(header.vertexOffset + mesh.vertexCount * sizeof(SceneVertex));
+
+	std::ofstream file(path, std::ios::binary);
+	const char padding[c_meshFileAlignment] = {};
+	auto writeAt = [&](uint64_t offset, void const* data, size_t size)
+	{
+		file.write(padding, static_cast<std::streamsize>(offset - static_cast<uint64_t>(file.tellp())));
+		file.write(static_cast<char const*>(data), static_cast<std::streamsize>(size));
+	};
+
+	file.write(reinterpret_cast<char const*>(&header), sizeof(header));
+	writeAt(header.chunkOffset, mesh.chunks, mesh.chunkCount * sizeof(MeshChunk));
+	writeAt(header.vertexOffset, mesh.vertices, mesh.vertexCount * sizeof(SceneVertex));
+	writeAt(header.indexOffset, mesh.indices, mesh.indexCount * sizeof(uint16_t));
+
+	if (!file)
+	{
+		error = "Couldn't write " + path;
+		return false;
+	}
+	return true;
+}
+
+bool scaling::LoadObjMesh(std::string const& path, SceneMesh& mesh, std::string& error)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+	{
+		error = "Couldn't open " + path;
+		return false;
+	}
+	std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+	text.push_back('\n');
+
+	std::vector<SceneVertex> vertices;
+	std::vector<bool> isColored;
+	std::vector<uint32_t> indices;
+	std::vector<uint32_t> face;
+
+	int lineNumber = 0;
+	for (size_t lineStart = 0; lineStart < text.size(); )
+	{
+		// Each line is null-terminated in place, for strtof and strtol.
+		size_t lineEnd = text.find('\n', lineStart);
+		text[lineEnd] = '\0';
+		char const* line = &text[lineStart];
+		lineStart = lineEnd + 1;
+		++lineNumber;
+
+		if (line[0] == 'v' && line[1] == ' ')
+		{
+			float values[6];
+			int valueCount = 0;
+			char const* cursor = line + 2;
+			for (; valueCount < 6; ++valueCount)
+			{
+				char* end = nullptr;
+				values[valueCount] = strtof(cursor, &end);
+				if (end == cursor)
+				{
+					break;
+				}
+				cursor = end;
+			}
+			if (valueCount < 3)
+			{
+				error = path + ":" + std::to_string(lineNumber) + ": a vertex needs a position";
+				return false;
+			}
+			bool hasColor = valueCount == 6;
+			vertices.push_back(SceneVertex{ { values[0], values[1], values[2] }, { hasColor ? values[3] : 0.0f, hasColor ? values[4] : 0.0f, hasColor ? values[5] : 0.0f } });
+			isColored.push_back(hasColor);
+		}
+		else if (line[0] == 'f' && line[1] == ' ')
+		{
+			face.clear();
+			char const* cursor = line + 2;
+			for (;;)
+			{
+				while (*cursor == ' ' || *cursor == '\t' || *cursor == '\r')
+				{
+					++cursor;
+				}
+				if (*cursor == '\0')
+				{
+					break;
+				}
+				uint32_t index;
+				if (!ParseObjIndex(cursor, vertices.size(), index))
+				{
+					error = path + ":" + std::to_string(lineNumber) + ": a face refers to a vertex that isn't there";
+					return false;
+				}
+				face.push_back(index);
+			}
+
+			// OBJ faces are counterclockwise, and the cube's are clockwise.
+			for (size_t i = 2; i < face.size(); ++i)
+			{
+				indices.push_back(face[0]);
+				indices.push_back(face[i]);
+				indices.push_back(face[i - 1]);
+			}
+		}
+	}
+
+	if (indices.empty())
+	{
+		error = path + " has no faces";
+		return false;
+	}
+
+	// Center the mesh on the origin, and scale its longest side to the cube's.
+	Float3 minimum = vertices[0].position;
+	Float3 maximum = vertices[0].position;
+	for (SceneVertex const& vertex : vertices)
+	{
+		minimum = Float3{ std::min(minimum.x, vertex.position.x), std::min(minimum.y, vertex.position.y), std::min(minimum.z, vertex.position.z) };
+		maximum = Float3{ std::max(maximum.x, vertex.position.x), std::max(maximum.y, vertex.position.y), std::max(maximum.z, vertex.position.z) };
+	}
+	Float3 center = { (minimum.x + maximum.x) * 0.5f, (minimum.y + maximum.y) * 0.5f, (minimum.z + maximum.z) * 0.5f };
+	float size = std::max(maximum.x - minimum.x, std::max(maximum.y - minimum.y, maximum.z - minimum.z));
+	float scale = size > 0.0f ? 1.0f / size : 1.0f;
+
+	for (size_t i = 0; i < vertices.size(); ++i)
+	{
+		Float3& position = vertices[i].position;
+		position = Float3{ (position.x - center.x) * scale, (position.y - center.y) * scale, (position.z - center.z) * scale };
+		if (!isColored[i])
+		{
+			vertices[i].color = Float3{ position.x + 0.5f, position.y + 0.5f, position.z + 0.5f };
+		}
+	}
+
+	mesh = CreateChunkedMesh(vertices, indices);
+	return true;
+}
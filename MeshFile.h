@@ -0,0 +1,43 @@
+#pragma once
+
+#include "MappedFile.h"
+#include "SceneGeometry.h"
+
+#include <string>
+
+namespace scaling
+{
+	// A mesh in the layout the renderers draw from, so that it can be used straight from a mapped file:
+	//
+	//     A header, with the counts and the offset of each array
+	//     The chunk table, as MeshChunk
+	//     The vertices, as SceneVertex
+	//     The indices, 16 bits each and relative to their chunk's first vertex
+	//
+	// All little-endian, with each array 16-byte aligned. Write them with WriteMeshFile, or convert OBJ
+	// files with the converter in MeshConvertMain.cpp.
+	class MeshFile
+	{
+	public:
+		// Checks the header, the chunk table, and that every index is within its chunk's vertices, which reads
+		// in the indices, at 2 bytes each against 24 for a vertex. The vertices aren't touched, so that their
+		// pages are only read in as they're first drawn. On failure, error says what was wrong.
+		bool Open(std::string const& path, std::string& error);
+
+		// Points into the mapped file, so it's only valid while this is open.
+		SceneMeshView const& GetView() const { return m_view; }
+
+		size_t GetFileSize() const { return m_file.GetSize(); }
+
+	private:
+		MappedFile m_file;
+		SceneMeshView m_view = {};
+	};
+
+	bool WriteMeshFile(std::string const& path, SceneMeshView const& mesh, std::string& error);
+
+	// Reads the triangles of an OBJ file: positions with optional vertex colors, and faces, which are
+	// triangulated as fans. Everything else is skipped. The mesh is centered and scaled to fit in the cube,
+	// and vertices without a color are colored by position, like the cube.
+	bool LoadObjMesh(std::string const& path, SceneMesh& mesh, std::string& error);
+}
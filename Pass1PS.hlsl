@@ -1,12 +1,30 @@
+#include "Bindings.hlsli"
+
 // Per-pixel color data passed through the pixel shader.
 struct PixelShaderInput
 {
 	float4 pos : SV_POSITION;
 	float3 color : COLOR0;
+	float4 currentPos : TEXCOORD0;
+	float4 previousPos : TEXCOORD1;
+};
+
+// The second target is only bound when motion vectors are rendered.
+struct PixelShaderOutput
+{
+	float4 color : SV_TARGET0;
+	int2 motionVector : SV_TARGET1;
 };
 
-// A pass-through function for the (interpolated) color data.
-float4 main(PixelShaderInput input) : SV_TARGET
+// A pass-through function for the (interpolated) color data. The motion vector points to where the pixel's
+// surface was last frame, in quarter pixels, like the output of the video motion estimator.
+PixelShaderOutput main(PixelShaderInput input)
 {
-	return float4(input.color, 1.0f);
+	PixelShaderOutput output;
+	output.color = float4(input.color, 1.0f);
+
+	float2 difference = input.previousPos.xy / input.previousPos.w - input.currentPos.xy / input.currentPos.w;
+	output.motionVector = int2(clamp(floor(difference * motionVectorScale + 0.5f), -32768.0f, 32767.0f));
+
+	return output;
 }
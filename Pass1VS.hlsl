@@ -1,10 +1,22 @@
 #include "Bindings.hlsli"
 
+// Matches SceneInstance in SceneGeometry.h.
+struct SceneInstance
+{
+	float3 position;
+	float scale;
+	float3 axis;
+	float spinRate;
+	float phase;
+};
+StructuredBuffer<SceneInstance> g_instances : register(t1);
+
 // Per-vertex data used as input to the vertex shader.
 struct VertexShaderInput
 {
 	float3 pos : POSITION;
 	float3 color : COLOR0;
+	uint instanceId : SV_InstanceID;
 };
 
 // Per-pixel color data passed through the pixel shader.
@@ -12,19 +24,34 @@ struct PixelShaderInput
 {
 	float4 pos : SV_POSITION;
 	float3 color : COLOR0;
+	float4 currentPos : TEXCOORD0; // Where the vertex is, and was last frame, without jitter
+	float4 previousPos : TEXCOORD1;
 };
 
+// Same as GetInstanceModel: turns the vertex about the instance's axis, then scales and moves it.
+float4 TransformByInstance(float3 pos, SceneInstance instance, float angle)
+{
+	float s;
+	float c;
+	sincos(instance.spinRate * angle + instance.phase, s, c);
+
+	float3 axis = instance.axis;
+	float3 rotated = pos * c + cross(axis, pos) * s + axis * dot(axis, pos) * (1.0f - c);
+	return float4(rotated * instance.scale + instance.position, 1.0f);
+}
+
 // Simple shader to do vertex processing on the GPU.
 PixelShaderInput main(VertexShaderInput input)
 {
 	PixelShaderInput output;
-	float4 pos = float4(input.pos, 1.0f);
+	SceneInstance instance = g_instances[input.instanceId];
+	float4 pos = TransformByInstance(input.pos, instance, sceneAngle);
 
 	// Transform the vertex position into projected space.
-	pos = mul(pos, model);
-	pos = mul(pos, view);
-	pos = mul(pos, projection);
-	output.pos = pos;
+	output.pos = mul(pos, modelViewProjection);
+
+	output.currentPos = mul(pos, currentMotion);
+	output.previousPos = mul(TransformByInstance(input.pos, instance, previousSceneAngle), previousMotion);
 
 	// Pass the color through without modification.
 	output.color = input.color;
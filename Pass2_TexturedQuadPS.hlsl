@@ -6,9 +6,9 @@ struct PSInput
 	float2 uv : TEXCOORD;
 };
 
-float4 main(PSInput input) : SV_TARGET
+float4 SampleInput(float2 quadUv)
 {
-	float2 uv = input.uv;
+	float2 uv = min(quadUv * drawConstants.inputUvScale, drawConstants.inputUvMax);
 	if (drawConstants.samplerIndex == 0)
 	{
 		return g_inputTexture.Sample(g_sampler_point, uv);
@@ -17,4 +17,38 @@ float4 main(PSInput input) : SV_TARGET
 	{
 		return g_inputTexture.Sample(g_sampler_linear, uv);
 	}
-}
\ No newline at end of file
+}
+
+// Contrast-adaptive sharpening over the cross-shaped neighborhood of the output pixel. The neighbors are
+// fetched one output pixel apart, so this sharpens the scaled image as it's being written.
+float4 Sharpen(float2 uv)
+{
+	float2 texel = drawConstants.outputTexelSize;
+	float4 center = SampleInput(uv);
+	float3 c = center.rgb;
+	float3 n = SampleInput(uv + float2(0, -texel.y)).rgb;
+	float3 s = SampleInput(uv + float2(0, texel.y)).rgb;
+	float3 w = SampleInput(uv + float2(-texel.x, 0)).rgb;
+	float3 e = SampleInput(uv + float2(texel.x, 0)).rgb;
+
+	float3 minimum = min(c, min(min(n, s), min(w, e)));
+	float3 maximum = max(c, max(max(n, s), max(w, e)));
+
+	// Sharpen less where the neighborhood is already close to clipping.
+	float3 amplitude = sqrt(saturate(min(minimum, 1.0f - maximum) / max(maximum, 1.0f / 1024.0f)));
+	float peak = -1.0f / lerp(8.0f, 5.0f, saturate(drawConstants.sharpness));
+	float3 weight = amplitude * peak;
+
+	float3 result = (c + (n + s + w + e) * weight) / (1.0f + 4.0f * weight);
+	return float4(saturate(result), center.a);
+}
+
+float4 main(PSInput input) : SV_TARGET
+{
+	float2 uv = input.uv;
+	if (drawConstants.sharpness > 0.0f)
+	{
+		return Sharpen(uv);
+	}
+	return SampleInput(uv);
+}
@@ -0,0 +1,50 @@
+#include "QualityPreset.h"
+
+#include <cmath>
+
+using namespace scaling;
+
+float scaling::GetUpscaleRatio(QualityPreset preset)
+{
+	switch (preset)
+	{
+	case QualityPreset::Performance: return 2.0f;
+	case QualityPreset::Balanced: return 1.7f;
+	case QualityPreset::Quality: return 1.5f;
+	case QualityPreset::UltraQuality: return 1.3f;
+	default: return 1.0f;
+	}
+}
+
+char const* scaling::GetQualityPresetName(QualityPreset preset)
+{
+	switch (preset)
+	{
+	case QualityPreset::Performance: return "Performance";
+	case QualityPreset::Balanced: return "Balanced";
+	case QualityPreset::Quality: return "Quality";
+	case QualityPreset::UltraQuality: return "Ultra quality";
+	default: return "<error>";
+	}
+}
+
+RenderSize scaling::GetPresetRenderSize(QualityPreset preset, int displayWidth, int displayHeight)
+{
+	float ratio = GetUpscaleRatio(preset);
+
+	RenderSize size;
+	size.width = static_cast<int>(std::lround(displayWidth / ratio));
+	size.height = static_cast<int>(std::lround(displayHeight / ratio));
+	return ClampRenderSize(size, displayWidth, displayHeight);
+}
+
+RenderSize scaling::ClampRenderSize(RenderSize size, int maxWidth, int maxHeight)
+{
+	if (size.width > maxWidth) size.width = maxWidth;
+	if (size.height > maxHeight) size.height = maxHeight;
+	size.width &= ~1;
+	size.height &= ~1;
+	if (size.width < 2) size.width = 2;
+	if (size.height < 2) size.height = 2;
+	return size;
+}
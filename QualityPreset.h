@@ -0,0 +1,33 @@
+#pragma once
+
+namespace scaling
+{
+	// How much of the output resolution to render at before upscaling. Named after, and using the same
+	// ratios as, the DLSS and XeSS quality modes.
+	enum class QualityPreset
+	{
+		Performance,
+		Balanced,
+		Quality,
+		UltraQuality,
+		NumQualityPresets
+	};
+
+	struct RenderSize
+	{
+		int width;
+		int height;
+	};
+
+	// Output size divided by render size, along each axis.
+	float GetUpscaleRatio(QualityPreset preset);
+
+	char const* GetQualityPresetName(QualityPreset preset);
+
+	// The render size for upscalers that have no opinion of their own. Sizes are kept even, which the NV12
+	// motion estimation input needs.
+	RenderSize GetPresetRenderSize(QualityPreset preset, int displayWidth, int displayHeight);
+
+	// Keeps a size within the given bounds, and even.
+	RenderSize ClampRenderSize(RenderSize size, int maxWidth, int maxHeight);
+}
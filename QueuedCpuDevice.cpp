@@ -0,0 +1,270 @@
+#include "QueuedCpuDevice.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <unordered_map>
+
+using namespace scaling;
+
+namespace
+{
+	char const* GetQueueName(PassQueue queue)
+	{
+		switch (queue)
+		{
+		case PassQueue::Direct:	return "the direct queue";
+		case PassQueue::Video:	return "the video queue";
+		default:				return "the CPU";
+		}
+	}
+
+	std::string DescribePass(QueuedPass const& pass)
+	{
+		char text[128];
+		snprintf(text, sizeof(text), "%s of frame %d on %s", pass.name, pass.frameNumber, GetQueueName(pass.queue));
+		return text;
+	}
+}
+
+QueuedCpuDevice::QueuedCpuDevice(CpuDevice& device)
+	: m_device(device)
+	, m_schedule(m_directQueue, m_directFence, m_videoQueue, m_videoFence, device.GetFrameCount())
+	, m_frameStats(device.GetFrameCount())
+	, m_clock(0)
+	, m_recordedFrameCount(0)
+{
+}
+
+QueuedCpuDevice::~QueuedCpuDevice()
+{
+	WaitForIdle();
+}
+
+void QueuedCpuDevice::Upscale(IUpscaler& upscaler, UpscaleInputs const& inputs, IImage& output)
+{
+	std::vector<IImage const*> reads = { inputs.color, inputs.depth };
+	if (upscaler.IsTemporal())
+	{
+		reads.push_back(inputs.motionVectors);
+	}
+	Run(PassQueue::Direct, "upscaling", m_recordedFrameCount, std::move(reads), { &output }, [&upscaler, inputs, &output]
+	{
+		upscaler.Upscale(inputs, output);
+	});
+}
+
+void QueuedCpuDevice::RunOnCpu(char const* name, int frameNumber, std::vector<IImage const*> reads, std::function<void()> work)
+{
+	Run(PassQueue::Cpu, name, frameNumber, std::move(reads), {}, std::move(work));
+}
+
+// The last frame's motion estimation may have nothing on the direct queue waiting for it.
+void QueuedCpuDevice::WaitForIdle()
+{
+	m_frameFence.WaitOnCpu(m_recordedFrameCount);
+	m_schedule.WaitForVideoWork();
+}
+
+bool QueuedCpuDevice::CheckOrder(std::string& error) const
+{
+	// Per image, the last pass recorded to write it, and those recorded to read it since.
+	struct ImageUse
+	{
+		QueuedPass const* lastWrite = nullptr;
+		std::vector<QueuedPass const*> reads;
+	};
+	std::unordered_map<IImage const*, ImageUse> uses;
+
+	auto isAfter = [&error](QueuedPass const& pass, QueuedPass const* earlier)
+	{
+		if (earlier && earlier->endTime >= pass.beginTime)
+		{
+			error = DescribePass(pass) + " began before " + DescribePass(*earlier) + " was done with an image they share";
+			return false;
+		}
+		return true;
+	};
+
+	for (QueuedPass const& pass : m_passes)
+	{
+		assert(pass.endTime > 0);
+		for (IImage const* image : pass.reads)
+		{
+			if (!isAfter(pass, uses[image].lastWrite))
+			{
+				return false;
+			}
+		}
+		for (IImage const* image : pass.writes)
+		{
+			ImageUse const& use = uses[image];
+			if (!isAfter(pass, use.lastWrite))
+			{
+				return false;
+			}
+			for (QueuedPass const* read : use.reads)
+			{
+				if (!isAfter(pass, read))
+				{
+					return false;
+				}
+			}
+		}
+
+		// Once all of them are checked, so that a pass isn't checked against itself.
+		for (IImage const* image : pass.reads)
+		{
+			uses[image].reads.push_back(&pass);
+		}
+		for (IImage const* image : pass.writes)
+		{
+			ImageUse& use = uses[image];
+			use.lastWrite = &pass;
+			use.reads.clear();
+		}
+	}
+	return true;
+}
+
+int QueuedCpuDevice::GetOverlapCount() const
+{
+	std::vector<QueuedPass const*> directPasses;
+	std::vector<QueuedPass const*> videoPasses;
+	for (QueuedPass const& pass : m_passes)
+	{
+		if (pass.queue == PassQueue::Direct)
+		{
+			directPasses.push_back(&pass);
+		}
+		else if (pass.queue == PassQueue::Video)
+		{
+			videoPasses.push_back(&pass);
+		}
+	}
+
+	// The direct queue's passes run one after another, so the first that might overlap a video pass is the
+	// first to end after it began.
+	int overlapCount = 0;
+	for (QueuedPass const* videoPass : videoPasses)
+	{
+		auto direct = std::partition_point(directPasses.begin(), directPasses.end(),
+			[videoPass](QueuedPass const* pass) { return pass->endTime < videoPass->beginTime; });
+		if (direct != directPasses.end() && (*direct)->beginTime < videoPass->endTime)
+		{
+			++overlapCount;
+		}
+	}
+	return overlapCount;
+}
+
+std::string QueuedCpuDevice::GetSummary() const
+{
+	size_t directPassCount = std::count_if(m_passes.begin(), m_passes.end(), [](QueuedPass const& pass) { return pass.queue == PassQueue::Direct; });
+	size_t videoPassCount = std::count_if(m_passes.begin(), m_passes.end(), [](QueuedPass const& pass) { return pass.queue == PassQueue::Video; });
+
+	char text[160];
+	snprintf(text, sizeof(text), "Queues: %zu passes on the direct queue, %zu on the video queue, which overlapped the direct queue's passes %d times",
+		directPassCount, videoPassCount, GetOverlapCount());
+	return text;
+}
+
+void QueuedCpuDevice::SetSceneMesh(SceneMeshView const& mesh)
+{
+	WaitForIdle();
+	m_device.SetSceneMesh(mesh);
+}
+
+void QueuedCpuDevice::SetSceneInstances(std::vector<SceneInstance> const& instances)
+{
+	WaitForIdle();
+	m_device.SetSceneInstances(instances);
+}
+
+// The frame's images were last used frameCount frames ago.
+void QueuedCpuDevice::BeginFrame()
+{
+	int frameCount = m_device.GetFrameCount();
+	if (m_recordedFrameCount >= frameCount)
+	{
+		m_frameFence.WaitOnCpu(m_recordedFrameCount - frameCount + 1);
+	}
+	m_device.BeginFrame();
+}
+
+void QueuedCpuDevice::EndFrame()
+{
+	m_device.EndFrame();
+	m_directQueue.Signal(m_frameFence, ++m_recordedFrameCount);
+}
+
+void QueuedCpuDevice::RenderScene(
+	SceneConstants const& constants,
+	SceneConstants const& previousConstants,
+	RenderSize renderSize,
+	IImage& color,
+	IImage& depth,
+	IImage* motionVectors)
+{
+	std::vector<IImage const*> writes = { &color, &depth };
+	if (motionVectors)
+	{
+		writes.push_back(motionVectors);
+	}
+	RasterizerStats& stats = m_frameStats[m_device.GetFrameIndex()];
+	Run(PassQueue::Direct, "pass 1", m_recordedFrameCount, {}, std::move(writes),
+		[this, constants, previousConstants, renderSize, &color, &depth, motionVectors, &stats]
+	{
+		m_device.RenderScene(constants, previousConstants, renderSize, color, depth, motionVectors);
+		stats = m_device.GetRasterizerStats();
+	});
+}
+
+void QueuedCpuDevice::ConvertToLuma(IImage& color, RenderSize renderSize, IImage& luma)
+{
+	Run(PassQueue::Direct, "luma conversion", m_recordedFrameCount, { &color }, { &luma }, [this, &color, renderSize, &luma]
+	{
+		m_device.ConvertToLuma(color, renderSize, luma);
+	});
+}
+
+// Submitted as D3D12Device submits it.
+void QueuedCpuDevice::EstimateMotion(IImage& current, IImage& previous, RenderSize renderSize, IImage& motionVectors)
+{
+	int frameIndex = m_device.GetFrameIndex();
+	m_schedule.AfterDirectWork();
+	m_schedule.BeginVideoWork(frameIndex);
+	Run(PassQueue::Video, "motion estimation", m_recordedFrameCount, { &current, &previous }, { &motionVectors },
+		[this, &current, &previous, renderSize, &motionVectors]
+	{
+		m_device.EstimateMotion(current, previous, renderSize, motionVectors);
+	});
+	m_schedule.AfterVideoWork(frameIndex);
+}
+
+void QueuedCpuDevice::WaitForMotionEstimation()
+{
+	int frameCount = m_device.GetFrameCount();
+	m_schedule.AwaitVideoWork((m_device.GetFrameIndex() + frameCount - 1) % frameCount);
+}
+
+void QueuedCpuDevice::Run(PassQueue queue, char const* name, int frameNumber, std::vector<IImage const*> reads, std::vector<IImage const*> writes, std::function<void()> work)
+{
+	m_passes.push_back(QueuedPass{ name, frameNumber, queue, std::move(reads), std::move(writes), 0, 0 });
+	QueuedPass& pass = m_passes.back();
+	auto run = [this, &pass, work = std::move(work)]
+	{
+		pass.beginTime = ++m_clock;
+		work();
+		pass.endTime = ++m_clock;
+	};
+
+	if (queue == PassQueue::Cpu)
+	{
+		run();
+	}
+	else
+	{
+		(queue == PassQueue::Direct ? m_directQueue : m_videoQueue).Execute(std::move(run));
+	}
+}
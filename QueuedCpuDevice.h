@@ -0,0 +1,139 @@
+#pragma once
+
+#include "CpuBackend.h"
+#include "FakeGpuQueue.h"
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace scaling
+{
+	enum class PassQueue
+	{
+		Direct,
+		Video,
+		Cpu		// On the calling thread, such as handing a finished frame to the sink
+	};
+
+	// A pass that a QueuedCpuDevice ran, and the images it read and wrote. The times are on a clock that
+	// ticks once at every pass's beginning and end, across all the queues.
+	struct QueuedPass
+	{
+		char const* name;
+		int frameNumber;
+		PassQueue queue;
+		std::vector<IImage const*> reads;
+		std::vector<IImage const*> writes;
+		uint64_t beginTime;
+		uint64_t endTime;
+	};
+
+	// Runs a CpuDevice's passes on fake queues the way D3D12Device submits them to the GPU: recorded on the
+	// calling thread and run on the direct queue's, except motion estimation, which runs on the video
+	// queue's, ordered against the direct queue by a VideoQueueSchedule. The CPU only waits in BeginFrame,
+	// for the frame whose images are about to be used again, so the queues' fences are all that keep the
+	// passes from racing. Like D3D12Device, the direct queue only waits for a frame's motion estimation when
+	// WaitForMotionEstimation is called in the next one. Every pass is logged with what it reads and writes, so that CheckOrder can tell
+	// whether each one ran after the passes it depends on.
+	class QueuedCpuDevice : public IDevice
+	{
+	public:
+		explicit QueuedCpuDevice(CpuDevice& device);
+		~QueuedCpuDevice(); // Waits for the queues
+
+		// Runs the upscaler on the direct queue as the frame's next pass, with QueuedUpscaler.
+		void Upscale(IUpscaler& upscaler, UpscaleInputs const& inputs, IImage& output);
+
+		// Runs work on the calling thread, logged as a pass of the given frame that reads the images.
+		void RunOnCpu(char const* name, int frameNumber, std::vector<IImage const*> reads, std::function<void()> work);
+
+		// Reaches n once the direct queue is done with the first n frames, and so with the motion estimation
+		// that the first n - 1 frames waited for.
+		IGpuFence& GetFrameFence() { return m_frameFence; }
+
+		// For the last frame at the frame index to be done.
+		RasterizerStats const& GetRasterizerStats(int frameIndex) const { return m_frameStats[frameIndex]; }
+
+		void WaitForIdle();
+
+		// Whether every pass began after the passes recorded before it that write what it reads, or read or
+		// write what it writes, had ended. Only once the queues are idle. On failure, error names the two.
+		bool CheckOrder(std::string& error) const;
+
+		// How many of the video queue's passes ran alongside one of the direct queue's. Only once the queues
+		// are idle.
+		int GetOverlapCount() const;
+
+		// "Queues: N passes on the direct queue, M on the video queue, which overlapped the direct queue's
+		// passes K times".
+		std::string GetSummary() const;
+
+		std::unique_ptr<IImage> CreateImage(ImageFormat format, int width, int height) override { return m_device.CreateImage(format, width, height); }
+		ResourceFootprint GetImageFootprint(ImageFormat format, int width, int height) const override { return m_device.GetImageFootprint(format, width, height); }
+		uint32_t GetRestingState(ImageFormat format) const override { return m_device.GetRestingState(format); }
+		uint32_t GetImageState(ImageAccess access) const override { return m_device.GetImageState(access); }
+		uint32_t GetReadStates() const override { return m_device.GetReadStates(); }
+
+		void SetSceneMesh(SceneMeshView const& mesh) override;
+		void SetSceneInstances(std::vector<SceneInstance> const& instances) override;
+
+		void BeginFrame() override;
+		void EndFrame() override;
+
+		int GetFrameCount() const override { return m_device.GetFrameCount(); }
+		int GetFrameIndex() const override { return m_device.GetFrameIndex(); }
+
+		void RenderScene(
+			SceneConstants const& constants,
+			SceneConstants const& previousConstants,
+			RenderSize renderSize,
+			IImage& color,
+			IImage& depth,
+			IImage* motionVectors) override;
+		void ConvertToLuma(IImage& color, RenderSize renderSize, IImage& luma) override;
+		void EstimateMotion(IImage& current, IImage& previous, RenderSize renderSize, IImage& motionVectors) override;
+
+		bool HasVideoQueue() const override { return true; }
+		void WaitForMotionEstimation() override;
+
+	private:
+		void Run(PassQueue queue, char const* name, int frameNumber, std::vector<IImage const*> reads, std::vector<IImage const*> writes, std::function<void()> work);
+
+		CpuDevice& m_device;
+
+		// Before the queues, whose threads signal them until they're gone.
+		FakeGpuFence m_directFence;
+		FakeGpuFence m_videoFence;
+		FakeGpuFence m_frameFence;
+		FakeGpuQueue m_directQueue;
+		FakeGpuQueue m_videoQueue;
+		VideoQueueSchedule m_schedule;
+
+		std::vector<RasterizerStats> m_frameStats;	// Per frame index
+
+		// In the order they were recorded. A deque, so that a queue can fill in the times of a pass while
+		// more are added.
+		std::deque<QueuedPass> m_passes;
+		std::atomic<uint64_t> m_clock;
+		int m_recordedFrameCount;
+	};
+
+	// Runs another upscaler's Upscale on a QueuedCpuDevice's direct queue.
+	class QueuedUpscaler : public IUpscaler
+	{
+	public:
+		QueuedUpscaler(QueuedCpuDevice& device, IUpscaler& upscaler) : m_device(device), m_upscaler(upscaler) {}
+
+		bool IsTemporal() const override { return m_upscaler.IsTemporal(); }
+		void SetQualityPreset(QualityPreset preset) override { m_upscaler.SetQualityPreset(preset); }
+		RenderSize GetOptimalInputSize(int outputWidth, int outputHeight) override { return m_upscaler.GetOptimalInputSize(outputWidth, outputHeight); }
+		void Upscale(UpscaleInputs const& inputs, IImage& output) override { m_device.Upscale(m_upscaler, inputs, output); }
+
+	private:
+		QueuedCpuDevice& m_device;
+		IUpscaler& m_upscaler;
+	};
+}
@@ -0,0 +1,127 @@
+#include "ReferenceRenderer.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+using namespace scaling;
+
+namespace
+{
+	// Rows of pixels that the workers accumulate, resolve and compare at a time.
+	const int c_bandHeight = 16;
+}
+
+ReferenceRenderer::ReferenceRenderer(int width, int height, int samplesPerSide, JobSystem* jobs)
+	: m_width(width)
+	, m_height(height)
+	, m_samplesPerSide(samplesPerSide)
+	, m_jobs(jobs)
+	, m_device(jobs)
+	, m_sums(static_cast<size_t>(width) * height * 3)
+{
+	assert(samplesPerSide >= 1 && samplesPerSide <= c_maxSamplesPerSide);
+	m_color = m_device.CreateImage(ImageFormat::Bgra8, width, height);
+	m_depth = m_device.CreateImage(ImageFormat::Depth32, width, height);
+}
+
+void ReferenceRenderer::Render(SceneConstants const& constants, ImageBgra8& output)
+{
+	assert(output.GetWidth() == m_width && output.GetHeight() == m_height);
+
+	RenderSize size = { m_width, m_height };
+	SceneConstants sampleConstants = constants;
+	sampleConstants.unjitteredProjection = GetSceneProjection(static_cast<float>(m_width) / static_cast<float>(m_height));
+
+	ImageBgra8 const& color = GetCpuImage<uint32_t>(*m_color);
+
+	std::fill(m_sums.begin(), m_sums.end(), 0u);
+	m_device.BeginFrame();
+	for (int sampleY = 0; sampleY < m_samplesPerSide; ++sampleY)
+	{
+		for (int sampleX = 0; sampleX < m_samplesPerSide; ++sampleX)
+		{
+			// The centers of an even grid of sub-pixels.
+			JitterOffset offset = { (sampleX + 0.5f) / m_samplesPerSide - 0.5f, (sampleY + 0.5f) / m_samplesPerSide - 0.5f };
+			sampleConstants.projection = JitterProjection(sampleConstants.unjitteredProjection, offset, size);
+			m_device.RenderScene(sampleConstants, sampleConstants, size, *m_color, *m_depth, nullptr);
+
+			ForEachTile(m_jobs, m_width, m_height, m_width, c_bandHeight, [&](Tile const& band, int)
+			{
+				for (int y = band.y; y < band.y + band.height; ++y)
+				{
+					uint32_t const* pixels = color.GetRow(y);
+					uint32_t* sums = m_sums.data() + static_cast<size_t>(y) * m_width * 3;
+					for (int x = 0; x < m_width; ++x)
+					{
+						sums[x * 3 + 0] += (pixels[x] >> 16) & 0xff;
+						sums[x * 3 + 1] += (pixels[x] >> 8) & 0xff;
+						sums[x * 3 + 2] += pixels[x] & 0xff;
+					}
+				}
+			});
+		}
+	}
+	m_device.EndFrame();
+
+	// Rounded to the nearest.
+	uint32_t sampleCount = static_cast<uint32_t>(m_samplesPerSide * m_samplesPerSide);
+	ForEachTile(m_jobs, m_width, m_height, m_width, c_bandHeight, [&](Tile const& band, int)
+	{
+		for (int y = band.y; y < band.y + band.height; ++y)
+		{
+			uint32_t const* sums = m_sums.data() + static_cast<size_t>(y) * m_width * 3;
+			uint32_t* pixels = output.GetRow(y);
+			for (int x = 0; x < m_width; ++x)
+			{
+				uint32_t r = (sums[x * 3 + 0] + sampleCount / 2) / sampleCount;
+				uint32_t g = (sums[x * 3 + 1] + sampleCount / 2) / sampleCount;
+				uint32_t b = (sums[x * 3 + 2] + sampleCount / 2) / sampleCount;
+				pixels[x] = 0xff000000u | (r << 16) | (g << 8) | b;
+			}
+		}
+	});
+}
+
+double scaling::ComputePsnr(ImageBgra8 const& image, ImageBgra8 const& reference, JobSystem* jobs)
+{
+	assert(image.GetWidth() == reference.GetWidth() && image.GetHeight() == reference.GetHeight());
+
+	int width = image.GetWidth();
+	int height = image.GetHeight();
+
+	// Summed per band and then added up, so the total doesn't depend on which worker took which band.
+	std::vector<uint64_t> bandErrors((height + c_bandHeight - 1) / c_bandHeight, 0);
+	ForEachTile(jobs, width, height, width, c_bandHeight, [&](Tile const& band, int)
+	{
+		uint64_t bandError = 0;
+		for (int y = band.y; y < band.y + band.height; ++y)
+		{
+			uint32_t const* imageRow = image.GetRow(y);
+			uint32_t const* referenceRow = reference.GetRow(y);
+			for (int x = 0; x < width; ++x)
+			{
+				for (int shift = 0; shift <= 16; shift += 8)
+				{
+					int difference = static_cast<int>((imageRow[x] >> shift) & 0xff) - static_cast<int>((referenceRow[x] >> shift) & 0xff);
+					bandError += static_cast<uint64_t>(difference * difference);
+				}
+			}
+		}
+		bandErrors[band.index] = bandError;
+	});
+
+	uint64_t squaredError = 0;
+	for (uint64_t bandError : bandErrors)
+	{
+		squaredError += bandError;
+	}
+	if (squaredError == 0)
+	{
+		return std::numeric_limits<double>::infinity();
+	}
+
+	double meanSquaredError = static_cast<double>(squaredError) / (static_cast<double>(image.GetPixelCount()) * 3.0);
+	return 10.0 * std::log10(255.0 * 255.0 / meanSquaredError);
+}
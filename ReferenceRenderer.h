@@ -0,0 +1,45 @@
+#pragma once
+
+#include "CpuBackend.h"
+#include "JobSystem.h"
+
+namespace scaling
+{
+	// Renders frames at the output size with samplesPerSide x samplesPerSide ordered-grid supersampling, as
+	// the ground truth that upscalers are measured against. Each sample position is rendered as a whole
+	// frame, with the projection offset so that pixel centers land on it, and the samples are averaged
+	// exactly in integers. So a frame only depends on its scene constants, never on the number of workers.
+	class ReferenceRenderer
+	{
+	public:
+		static const int c_maxSamplesPerSide = 8;
+
+		ReferenceRenderer(int width, int height, int samplesPerSide, JobSystem* jobs = nullptr);
+
+		// The same as the scene that's being upscaled. See IDevice.
+		void SetSceneMesh(SceneMeshView const& mesh) { m_device.SetSceneMesh(mesh); }
+		void SetSceneInstances(std::vector<SceneInstance> const& instances) { m_device.SetSceneInstances(instances); }
+
+		int GetSamplesPerSide() const { return m_samplesPerSide; }
+
+		// Renders the frame without its jitter, with a projection for the output's aspect ratio.
+		void Render(SceneConstants const& constants, ImageBgra8& output);
+
+	private:
+		int m_width;
+		int m_height;
+		int m_samplesPerSide;
+
+		JobSystem* m_jobs;
+		CpuDevice m_device;
+		std::unique_ptr<IImage> m_color;
+		std::unique_ptr<IImage> m_depth;
+
+		// Red, green and blue summed over the samples, for every pixel.
+		std::vector<uint32_t> m_sums;
+	};
+
+	// Peak signal-to-noise ratio of an image against a reference of the same size, over red, green and
+	// blue, in decibels. Higher is closer; identical images give infinity.
+	double ComputePsnr(ImageBgra8 const& image, ImageBgra8 const& reference, JobSystem* jobs = nullptr);
+}
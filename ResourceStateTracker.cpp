@@ -0,0 +1,294 @@
+#include "ResourceStateTracker.h"
+
+#include <algorithm>
+#include <cassert>
+
+using namespace scaling;
+
+ResourceStateTracker::ResourceStateTracker(uint32_t readStates)
+	: m_readStates(readStates)
+	, m_stats()
+{
+}
+
+void ResourceStateTracker::SetState(void const* resource, uint32_t state)
+{
+	Entry& entry = m_entries[resource];
+	if (entry.isPending)
+	{
+		m_pending.erase(std::find(m_pending.begin(), m_pending.end(), resource));
+	}
+	entry = Entry{ state, false, 0, false, false, 0 };
+}
+
+void ResourceStateTracker::Forget(void const* resource)
+{
+	auto found = m_entries.find(resource);
+	if (found == m_entries.end())
+	{
+		return;
+	}
+	if (found->second.isPending)
+	{
+		m_pending.erase(std::find(m_pending.begin(), m_pending.end(), resource));
+	}
+	m_entries.erase(found);
+}
+
+bool ResourceStateTracker::IsTracked(void const* resource) const
+{
+	return m_entries.find(resource) != m_entries.end();
+}
+
+uint32_t ResourceStateTracker::GetState(void const* resource) const
+{
+	auto found = m_entries.find(resource);
+	assert(found != m_entries.end());
+	return found->second.state;
+}
+
+void ResourceStateTracker::Require(void const* resource, uint32_t state)
+{
+	Ask(resource, state, false);
+}
+
+void ResourceStateTracker::BeginTransition(void const* resource, uint32_t state)
+{
+	Ask(resource, state, true);
+}
+
+std::vector<StateTransition> const& ResourceStateTracker::Flush()
+{
+	m_batch.clear();
+
+	for (void const* resource : m_pending)
+	{
+		Entry& entry = GetEntry(resource);
+		entry.isPending = false;
+		uint32_t wanted = entry.pendingState;
+
+		if (entry.isSplit)
+		{
+			if (entry.splitState == wanted)
+			{
+				// Either this ends the split, or it's the same split asked for again.
+				if (!entry.isPendingBegin)
+				{
+					m_batch.push_back(StateTransition{ resource, entry.state, wanted, BarrierPart::End });
+					entry.state = wanted;
+					entry.isSplit = false;
+				}
+				continue;
+			}
+			EndSplit(resource, entry);
+		}
+
+		if (Satisfies(entry.state, wanted))
+		{
+			continue;
+		}
+
+		if (entry.isPendingBegin)
+		{
+			m_batch.push_back(StateTransition{ resource, entry.state, wanted, BarrierPart::Begin });
+			entry.isSplit = true;
+			entry.splitState = wanted;
+		}
+		else
+		{
+			m_batch.push_back(StateTransition{ resource, entry.state, wanted, BarrierPart::Whole });
+			entry.state = wanted;
+		}
+	}
+	m_pending.clear();
+
+	m_stats.transitionCount += m_batch.size();
+	if (!m_batch.empty())
+	{
+		++m_stats.batchCount;
+	}
+	return m_batch;
+}
+
+// COMMON is 0 on Direct3D 12, which every state would otherwise include.
+bool ResourceStateTracker::Satisfies(uint32_t state, uint32_t wanted) const
+{
+	if (state == wanted)
+	{
+		return true;
+	}
+	bool isReadOnly = wanted != 0 && (wanted & ~m_readStates) == 0 && (state & ~m_readStates) == 0;
+	return isReadOnly && (state & wanted) == wanted;
+}
+
+void ResourceStateTracker::EndSplit(void const* resource, Entry& entry)
+{
+	m_batch.push_back(StateTransition{ resource, entry.state, entry.splitState, BarrierPart::End });
+	entry.state = entry.splitState;
+	entry.isSplit = false;
+}
+
+ResourceStateTracker::Entry& ResourceStateTracker::GetEntry(void const* resource)
+{
+	auto found = m_entries.find(resource);
+	assert(found != m_entries.end());
+	return found->second;
+}
+
+void ResourceStateTracker::Ask(void const* resource, uint32_t state, bool isBegin)
+{
+	Entry& entry = GetEntry(resource);
+	++m_stats.requestCount;
+
+	// A transition begun and ended before a flush becomes a whole one.
+	if (!entry.isPending)
+	{
+		entry.isPending = true;
+		m_pending.push_back(resource);
+	}
+	entry.isPendingBegin = isBegin;
+	entry.pendingState = state;
+}
+
+namespace
+{
+	// Made-up states, laid out like D3D12_RESOURCE_STATES: COMMON is 0, and two of them are read states.
+	const uint32_t c_common = 0;
+	const uint32_t c_write = 0x4;
+	const uint32_t c_otherWrite = 0x8;
+	const uint32_t c_nonPixelRead = 0x40;
+	const uint32_t c_pixelRead = 0x80;
+	const uint32_t c_readStates = c_nonPixelRead | c_pixelRead;
+
+	bool IsBatch(std::vector<StateTransition> const& batch, std::vector<StateTransition> const& expected, char const* sequence, std::string& error)
+	{
+		bool isExpected = batch.size() == expected.size() && std::equal(batch.begin(), batch.end(), expected.begin(),
+			[](StateTransition const& a, StateTransition const& b)
+			{
+				return a.resource == b.resource && a.before == b.before && a.after == b.after && a.part == b.part;
+			});
+		if (!isExpected)
+		{
+			error = std::string("The resource state tracker gave the wrong barriers when ") + sequence;
+		}
+		return isExpected;
+	}
+}
+
+bool scaling::CheckResourceStateTracker(std::string& error)
+{
+	int a = 0;
+	int b = 0;
+	int c = 0;
+
+	{
+		ResourceStateTracker tracker(c_readStates);
+		tracker.SetState(&a, c_write);
+		tracker.Require(&a, c_write);
+		if (!IsBatch(tracker.Flush(), {}, "a resource was asked for the state it's in", error))
+		{
+			return false;
+		}
+	}
+
+	{
+		ResourceStateTracker tracker(c_readStates);
+		tracker.SetState(&a, c_pixelRead | c_nonPixelRead);
+		tracker.Require(&a, c_pixelRead);
+		if (!IsBatch(tracker.Flush(), {}, "a resource in two read states was asked for one of them", error))
+		{
+			return false;
+		}
+	}
+
+	{
+		ResourceStateTracker tracker(c_readStates);
+		tracker.SetState(&a, c_common);
+		tracker.SetState(&b, c_pixelRead);
+		tracker.Require(&a, c_pixelRead);
+		tracker.Require(&b, c_common);
+		if (!IsBatch(tracker.Flush(),
+			{ { &a, c_common, c_pixelRead, BarrierPart::Whole }, { &b, c_pixelRead, c_common, BarrierPart::Whole } },
+			"resources went from COMMON to a read state and back", error))
+		{
+			return false;
+		}
+	}
+
+	{
+		ResourceStateTracker tracker(c_readStates);
+		tracker.SetState(&a, c_write);
+		tracker.BeginTransition(&a, c_pixelRead);
+		if (!IsBatch(tracker.Flush(), { { &a, c_write, c_pixelRead, BarrierPart::Begin } }, "a split barrier began", error))
+		{
+			return false;
+		}
+		tracker.Require(&a, c_pixelRead);
+		if (!IsBatch(tracker.Flush(), { { &a, c_write, c_pixelRead, BarrierPart::End } }, "a split barrier was ended by asking for its state", error))
+		{
+			return false;
+		}
+	}
+
+	{
+		ResourceStateTracker tracker(c_readStates);
+		tracker.SetState(&a, c_write);
+		tracker.BeginTransition(&a, c_pixelRead);
+		tracker.Flush();
+		tracker.Require(&a, c_otherWrite);
+		if (!IsBatch(tracker.Flush(),
+			{ { &a, c_write, c_pixelRead, BarrierPart::End }, { &a, c_pixelRead, c_otherWrite, BarrierPart::Whole } },
+			"a split barrier was followed by asking for another state", error))
+		{
+			return false;
+		}
+	}
+
+	{
+		ResourceStateTracker tracker(c_readStates);
+		tracker.SetState(&a, c_write);
+		tracker.BeginTransition(&a, c_pixelRead);
+		tracker.Require(&a, c_pixelRead);
+		if (!IsBatch(tracker.Flush(), { { &a, c_write, c_pixelRead, BarrierPart::Whole } }, "a split barrier began and ended before a flush", error))
+		{
+			return false;
+		}
+	}
+
+	{
+		ResourceStateTracker tracker(c_readStates);
+		tracker.SetState(&a, c_write);
+		tracker.SetState(&b, c_write);
+		tracker.Require(&a, c_pixelRead);
+		tracker.Require(&b, c_pixelRead);
+		tracker.SetState(&a, c_otherWrite);
+		tracker.Forget(&b);
+		if (!IsBatch(tracker.Flush(), {}, "resources were set and forgotten with requests pending", error))
+		{
+			return false;
+		}
+		if (tracker.GetState(&a) != c_otherWrite || tracker.IsTracked(&b))
+		{
+			error = "The resource state tracker lost a state that was set, or kept a resource that was forgotten, with requests pending";
+			return false;
+		}
+	}
+
+	{
+		ResourceStateTracker tracker(c_readStates);
+		tracker.SetState(&a, c_write);
+		tracker.SetState(&b, c_write);
+		tracker.SetState(&c, c_write);
+		tracker.Require(&b, c_pixelRead);
+		tracker.Require(&a, c_pixelRead);
+		tracker.Require(&c, c_pixelRead);
+		tracker.Require(&b, c_nonPixelRead);
+		if (!IsBatch(tracker.Flush(),
+			{ { &b, c_write, c_nonPixelRead, BarrierPart::Whole }, { &a, c_write, c_pixelRead, BarrierPart::Whole }, { &c, c_write, c_pixelRead, BarrierPart::Whole } },
+			"resources were asked for out of order, one of them twice", error))
+		{
+			return false;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace scaling
+{
+	// Which half of a transition a barrier is. D3D12_RESOURCE_BARRIER_FLAG_NONE, BEGIN_ONLY and END_ONLY.
+	enum class BarrierPart
+	{
+		Whole,
+		Begin,
+		End
+	};
+
+	struct StateTransition
+	{
+		void const* resource;
+		uint32_t before;
+		uint32_t after;
+		BarrierPart part;
+	};
+
+	struct ResourceStateStats
+	{
+		uint64_t requestCount;		// Require and BeginTransition calls
+		uint64_t transitionCount;	// Barriers in the batches, counting each half of a split one
+		uint64_t batchCount;		// Flushes that had barriers in them
+	};
+
+	// Keeps track of the state every resource is in on one command list, and turns what's asked for into as
+	// few barriers as it can. States are bit masks that mean whatever the API means by them, such as
+	// D3D12_RESOURCE_STATES; the tracker only needs to know which of the bits are for reading, since a
+	// resource can be in several of those at once. Resources are identified by address.
+	//
+	// Users ask for the states they need, then flush before recording the work that needs them. What's asked
+	// for in between is only settled at the flush, so a pass can put its resources back the way it found
+	// them without flushing, and if the next pass wants them in another state the round trip never happens.
+	class ResourceStateTracker
+	{
+	public:
+		explicit ResourceStateTracker(uint32_t readStates);
+
+		// Starts tracking a resource, or says what state it's been left in by work the tracker didn't see.
+		// Anything pending for the resource is dropped.
+		void SetState(void const* resource, uint32_t state);
+		void Forget(void const* resource);
+
+		bool IsTracked(void const* resource) const;
+
+		// As of the last flush. The resource must be tracked, as for everything below.
+		uint32_t GetState(void const* resource) const;
+
+		// Asks for the resource to be in the state for what's recorded after the next flush. Nothing happens
+		// when it's already in the state, or in a combination of read states that includes it. Of several
+		// states asked for before a flush, only the last counts.
+		void Require(void const* resource, uint32_t state);
+
+		// Starts the transition to the state that a later Require is going to ask for, as the first half of a
+		// split barrier, so that the GPU can get on with it during the work in between. The resource can't be
+		// used until that Require.
+		void BeginTransition(void const* resource, uint32_t state);
+
+		// The barriers for everything asked for since the last flush, in the order the resources were first
+		// asked for, to be recorded in one call. Valid until the next flush.
+		std::vector<StateTransition> const& Flush();
+
+		ResourceStateStats const& GetStats() const { return m_stats; }
+
+	private:
+		struct Entry
+		{
+			uint32_t state;
+			bool isSplit;			// A split barrier to splitState has begun and not ended
+			uint32_t splitState;
+			bool isPending;			// Asked for since the last flush
+			bool isPendingBegin;	// What was asked for is a BeginTransition rather than a Require
+			uint32_t pendingState;
+		};
+
+		bool Satisfies(uint32_t state, uint32_t wanted) const;
+		void EndSplit(void const* resource, Entry& entry);
+		Entry& GetEntry(void const* resource);
+		void Ask(void const* resource, uint32_t state, bool isBegin);
+
+		uint32_t m_readStates;
+		std::unordered_map<void const*, Entry> m_entries;
+		std::vector<void const*> m_pending;
+		std::vector<StateTransition> m_batch;
+		ResourceStateStats m_stats;
+	};
+
+	// Runs trackers through small made-up sequences of requests whose barriers are known: a state that's
+	// already there, a read state within the ones it's in, COMMON, split barriers ended by the state they
+	// began or followed by another, resources set or forgotten with a request pending, and the order of the
+	// batch. On failure, error says which sequence gave the wrong barriers.
+	bool CheckResourceStateTracker(std::string& error);
+}
@@ -3,12 +3,11 @@
 #include "Sample3DSceneRenderer.h"
 
 #include "DirectXHelper.h"
+#include "MeshFile.h"
+#include "ScalingFrameGraph.h"
 
 #include "scaling.h"
 
-#include "Pass1VS.h"
-#include "Pass1PS.h"
-#include "Pass2_RgbToYuvCS.h"
 #include "Pass2_TexturedQuadVS.h"
 #include "Pass2_TexturedQuadPS.h"
 
@@ -17,24 +16,44 @@ using namespace scaling;
 using namespace DirectX;
 using namespace Microsoft::WRL;
 
-// Loads vertex and pixel shaders from files and instantiates the cube geometry.
+// GPU time that dynamic resolution aims to keep each frame under. Leaves some of the 60Hz frame for
+// presentation and for the CPU.
+static const double c_dynamicResolutionBudgetSeconds = 0.9 / 60.0;
+
+// Creates the device and upscalers, and the geometry used to present.
 Sample3DSceneRenderer::Sample3DSceneRenderer(const std::shared_ptr<DX::DeviceResources>& deviceResources) :
 	m_loadingComplete(false),
 	m_radiansPerSecond(XM_PIDIV4),	// rotate 45 degrees per second
 	m_angle(0),
 	m_tracking(false),
-	m_mappedConstantBuffer(nullptr),
 	m_deviceResources(deviceResources),
 	m_scalingType(ScalingType::Point),
 	m_isSpinning(true),
 	m_isUpdating(true),
-	m_dlssSupported(false),
-	m_dlssSharpness(0.5f),
-	m_dlssReset(0)
+	m_instanceCount(1),
+	m_sharpness(0.0f),
+	m_qualityPreset(QualityPreset::UltraQuality),
+	m_dynamicResolution(g_scaling_sourceWidth, g_scaling_sourceHeight, c_dynamicResolutionBudgetSeconds),
+	m_isDynamicResolutionEnabled(true),
+	m_timestampPending{},
+	m_timestampRenderSizes{},
+	m_timestampFrequency(0),
+	m_lastGpuSeconds(0.0),
+	m_titleSecond(0),
+	m_frameTimesText("no frames"),
+	m_jitterSequence(JitterPattern::Halton23, JitterSequence::RecommendedPhaseCount(g_scaling_sourceWidth, g_scaling_destWidth)),
+	m_jitterFrameNumber(0),
+	m_jitterOffset{},
+	m_projection(MatrixIdentity())
 {
-	ZeroMemory(&m_constantBufferData, sizeof(m_constantBufferData));
+	m_sceneConstants.model = MatrixIdentity();
+	m_sceneConstants.view = MatrixIdentity();
+	m_sceneConstants.projection = MatrixIdentity();
+	m_sceneConstants.unjitteredProjection = MatrixIdentity();
+	m_sceneConstants.sceneAngle = 0.0f;
 
 	CreateDeviceDependentResources();
+	ResetRenderSize();
 	CreateTargetSizeDependentResources();
 
 	UpdateWindowTitleText();
@@ -42,380 +61,45 @@ Sample3DSceneRenderer::Sample3DSceneRenderer(const std::shared_ptr<DX::DeviceRes
 
 Sample3DSceneRenderer::~Sample3DSceneRenderer()
 {
-	m_constantBuffer->Unmap(0, nullptr);
-	m_mappedConstantBuffer = nullptr;
+	// The upscalers and images can't be released while the GPU may still be using them.
+	m_deviceResources->WaitForGpuOnDirectQueue();
 }
 
 void Sample3DSceneRenderer::CreateDeviceDependentResources()
 {
 	auto d3dDevice = m_deviceResources->GetD3DDevice();
 
-	// Create command lists
-	DX::ThrowIfFailed(d3dDevice->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, m_deviceResources->GetDirectCommandAllocator(), m_pass1PipelineState.Get(), IID_PPV_ARGS(&m_commandList)));
-	NAME_D3D12_OBJECT(m_commandList);
-
-	if (m_deviceResources->GetVideoQueue())
-	{
-		DX::ThrowIfFailed(d3dDevice->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_VIDEO_ENCODE, m_deviceResources->GetVideoEncodeCommandAllocator(), nullptr, IID_PPV_ARGS(&m_videoEncodeCommandList)));
-		NAME_D3D12_OBJECT(m_videoEncodeCommandList);
-	}
-
-	bool motionEstimationSupported = false;
-	ComPtr<ID3D12VideoDevice1> videoDevice;
-	if (SUCCEEDED(d3dDevice->QueryInterface(IID_PPV_ARGS(&videoDevice))))
-	{
-		D3D12_FEATURE_DATA_VIDEO_MOTION_ESTIMATOR motionEstimatorSupport = { 0u, DXGI_FORMAT_NV12 };
-		if (SUCCEEDED(videoDevice->CheckFeatureSupport(D3D12_FEATURE_VIDEO_MOTION_ESTIMATOR, &motionEstimatorSupport, sizeof(motionEstimatorSupport))))
-		{
-			motionEstimationSupported = true;
-		}
-	}
-
-	if (motionEstimationSupported)
-	{
-		NVSDK_NGX_Result ngxResult{};
-
-		ngxResult = NVSDK_NGX_D3D12_Init(12341234, L"./", d3dDevice);
-		DX::ThrowIfNGXFailed(ngxResult);
-
-		ngxResult = NVSDK_NGX_D3D12_GetCapabilityParameters(&m_ngxParameters);
-		DX::ThrowIfNGXFailed(ngxResult);
-
-		int DLSSAvailable = 0;
-		ngxResult = m_ngxParameters->Get(NVSDK_NGX_Parameter_SuperSampling_Available, &DLSSAvailable);
-		DX::ThrowIfNGXFailed(ngxResult);
-		m_dlssSupported = DLSSAvailable > 0;
-
-		{
-			int DlssCreateFeatureFlags = NVSDK_NGX_DLSS_Feature_Flags_None;
-
-			NVSDK_NGX_DLSS_Create_Params dlssCreateParams{};
-			dlssCreateParams.Feature.InTargetWidth = g_scaling_destWidth;
-			dlssCreateParams.Feature.InTargetHeight = g_scaling_destHeight;
-			dlssCreateParams.Feature.InWidth = g_scaling_sourceWidth;
-			dlssCreateParams.Feature.InHeight = g_scaling_sourceHeight;
-			dlssCreateParams.Feature.InPerfQualityValue = NVSDK_NGX_PerfQuality_Value_MaxQuality;
-			dlssCreateParams.InFeatureCreateFlags = DlssCreateFeatureFlags;
-
-			UINT creationNodeMask = 1;
-			UINT visibilityNodeMask = 1;
-			ngxResult = NGX_D3D12_CREATE_DLSS_EXT(
-				m_commandList.Get(),
-				creationNodeMask,
-				visibilityNodeMask,
-				&m_dlssFeatureHandle,
-				m_ngxParameters,
-				&dlssCreateParams);
-
-			DX::ThrowIfNGXFailed(ngxResult);
-		}
-
-		D3D12_VIDEO_MOTION_ESTIMATOR_DESC motionEstimatorDesc = {
-			0, //NodeIndex
-			DXGI_FORMAT_NV12,
-			D3D12_VIDEO_MOTION_ESTIMATOR_SEARCH_BLOCK_SIZE_16X16,
-			D3D12_VIDEO_MOTION_ESTIMATOR_VECTOR_PRECISION_QUARTER_PEL,
-			{g_scaling_sourceWidth, g_scaling_sourceHeight, g_scaling_sourceWidth, g_scaling_sourceHeight} // D3D12_VIDEO_SIZE_RANGE
-		};
-
-		DX::ThrowIfFailed(videoDevice->CreateVideoMotionEstimator(
-			&motionEstimatorDesc,
-			nullptr,
-			IID_PPV_ARGS(&m_videoMotionEstimator)));
-
-		D3D12_VIDEO_MOTION_VECTOR_HEAP_DESC motionVectorHeapDesc = {
-			0, // NodeIndex 
-			DXGI_FORMAT_NV12,
-			D3D12_VIDEO_MOTION_ESTIMATOR_SEARCH_BLOCK_SIZE_16X16,
-			D3D12_VIDEO_MOTION_ESTIMATOR_VECTOR_PRECISION_QUARTER_PEL,
-			{g_scaling_sourceWidth, g_scaling_sourceHeight, g_scaling_sourceWidth, g_scaling_sourceHeight} // D3D12_VIDEO_SIZE_RANGE
-		};
-
-		videoDevice->CreateVideoMotionVectorHeap(
-			&motionVectorHeapDesc,
-			nullptr,
-			IID_PPV_ARGS(&m_videoMotionVectorHeap));
-	}
-
-	xess_result_t xessResult;
-
-	xessResult = xessD3D12CreateContext(d3dDevice, &m_xessContext);
-	DX::ThrowIfXeSSFailed(xessResult);
-
-	if (XESS_RESULT_WARNING_OLD_DRIVER == xessIsOptimalDriver(m_xessContext))
-	{
-		OutputDebugStringW(L"Please install the latest graphics driver from your vendor for optimal Intel(R) XeSS performance and visual quality");
-	}
-
-	xess_2d_t desiredOutputResolution;
-	desiredOutputResolution.x = g_scaling_destWidth;
-	desiredOutputResolution.y = g_scaling_destHeight;
-
-	xess_properties_t props;
-	xessResult = xessGetProperties(m_xessContext, &desiredOutputResolution, &props);
-	DX::ThrowIfXeSSFailed(xessResult);
-
-	xess_version_t xefx_version;
-	xessResult = xessGetIntelXeFXVersion(m_xessContext, &xefx_version);
-	DX::ThrowIfXeSSFailed(xessResult);
-
-	const xess_quality_settings_t quality = XESS_QUALITY_SETTING_ULTRA_QUALITY;
-
-	desiredOutputResolution.x = g_scaling_destWidth;
-	desiredOutputResolution.y = g_scaling_destHeight;
-
-	xess_d3d12_init_params_t params = {
-		
-		desiredOutputResolution, /* Output width and height. */
-		
-		quality, /* Quality setting */
-
-		XESS_INIT_FLAG_NONE, // Use motion vectors at source resolution
-
-		/* Specfies the node mask for internally created resources on
-		 * multi-adapter systems. */
-		0,
-		/* Specfies the node visibility mask for internally created resources
-		 * on multi-adapter systems. */
-		0,
-		/* Optional externally allocated buffers storage for X<sup>e</sup>SS. If NULL the
-		 * storage is allocated internally. If allocated, the heap type must be
-		 * D3D12_HEAP_TYPE_DEFAULT. This heap is not accessed by the CPU. */
-		nullptr,
-		/* Offset in the externally allocated heap for temporary buffers storage. */
-		0,
-		/* Optional externally allocated textures storage for X<sup>e</sup>SS. If NULL the
-		 * storage is allocated internally. If allocated, the heap type must be
-		 * D3D12_HEAP_TYPE_DEFAULT. This heap is not accessed by the CPU. */
-		nullptr,
-		/* Offset in the externally allocated heap for temporary textures storage. */
-		0,
-		/* No pipeline library */
-		NULL
-	};
+	m_device.reset(new D3D12Device(m_deviceResources));
+	m_pipeline.reset(new ScalingPipeline(*m_device, g_scaling_sourceWidth, g_scaling_sourceHeight, g_scaling_destWidth, g_scaling_destHeight));
 
-	xessResult = xessD3D12Init(m_xessContext, &params);
-	DX::ThrowIfXeSSFailed(xessResult);
+	std::string frameGraphReport = FormatScalingFrameGraphReport(*m_device, g_scaling_sourceWidth, g_scaling_sourceHeight, g_scaling_destWidth, g_scaling_destHeight);
+	OutputDebugStringA((frameGraphReport + "\n").c_str());
 
-	// Get optimal input resolution
-	xess_2d_t recommendedInputResolution;
-	xessResult = xessGetInputResolution(
-		m_xessContext, &desiredOutputResolution, quality, &recommendedInputResolution);
-	DX::ThrowIfXeSSFailed(xessResult);
+	m_dlssUpscaler.reset(new DlssUpscaler(*m_device, g_scaling_destWidth, g_scaling_destHeight));
+	m_xessUpscaler.reset(new XessUpscaler(*m_device, g_scaling_destWidth, g_scaling_destHeight));
 
 	{
-		D3D12_RESOURCE_DESC resourceDesc{};
-		resourceDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
-		resourceDesc.Width = g_scaling_destWidth;
-		resourceDesc.Height = g_scaling_destHeight;
-		resourceDesc.MipLevels = 1;
-		resourceDesc.DepthOrArraySize = 1;
-		resourceDesc.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
-		resourceDesc.SampleDesc.Count = 1;
-		resourceDesc.SampleDesc.Quality = 0;
-		resourceDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
-
-		auto defaultHeapType = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
-		DX::ThrowIfFailed(d3dDevice->CreateCommittedResource(
-			&defaultHeapType,
-			D3D12_HEAP_FLAG_NONE,
-			&resourceDesc,
-			D3D12_RESOURCE_STATE_COPY_SOURCE,
-			nullptr,
-			IID_PPV_ARGS(&m_upscaledTarget)));
-		DX::SetName(m_upscaledTarget.Get(), L"m_upscaledTarget");
-	}
-	{
-		D3D12_RESOURCE_DESC resourceDesc{};
-		resourceDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
-		resourceDesc.Width = g_scaling_sourceWidth;
-		resourceDesc.Height = g_scaling_sourceHeight;
-		resourceDesc.MipLevels = 1;
-		resourceDesc.DepthOrArraySize = 1;
-		resourceDesc.Format = DXGI_FORMAT_R16G16_SINT;
-		resourceDesc.SampleDesc.Count = 1;
-		resourceDesc.SampleDesc.Quality = 0;
-
-		auto defaultHeapType = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
-		DX::ThrowIfFailed(d3dDevice->CreateCommittedResource(
-			&defaultHeapType,
-			D3D12_HEAP_FLAG_NONE,
-			&resourceDesc,
-			D3D12_RESOURCE_STATE_COMMON,
-			nullptr,
-			IID_PPV_ARGS(&m_motionVectors)));
-		DX::SetName(m_motionVectors.Get(), L"m_motionVectors");
-	}
-	{
-		D3D12_RESOURCE_DESC resourceDesc{};
-		resourceDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
-		
-		resourceDesc.Width = g_scaling_sourceWidth;
-		assert(resourceDesc.Width % 2 == 0); // NV12 needs to have multiple-of-two size.
-
-		resourceDesc.Height = g_scaling_sourceHeight;
-		assert(resourceDesc.Height % 2 == 0);
-
-		resourceDesc.MipLevels = 1;
-		resourceDesc.DepthOrArraySize = 1;
-		resourceDesc.Format = DXGI_FORMAT_NV12;
-		resourceDesc.SampleDesc.Count = 1;
-		resourceDesc.SampleDesc.Quality = 0;
-		resourceDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
-
-		auto defaultHeapType = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
-		DX::ThrowIfFailed(d3dDevice->CreateCommittedResource(
-			&defaultHeapType,
-			D3D12_HEAP_FLAG_NONE,
-			&resourceDesc,
-			D3D12_RESOURCE_STATE_COMMON,
-			nullptr,
-			IID_PPV_ARGS(&m_currentYuv)));
-		DX::SetName(m_currentYuv.Get(), L"m_currentYuv");
+		D3D12_QUERY_HEAP_DESC queryHeapDesc{};
+		queryHeapDesc.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+		queryHeapDesc.Count = DX::c_frameCount * 2;
+		DX::ThrowIfFailed(d3dDevice->CreateQueryHeap(&queryHeapDesc, IID_PPV_ARGS(&m_timestampQueryHeap)));
+		NAME_D3D12_OBJECT(m_timestampQueryHeap);
 
+		auto readbackHeapType = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_READBACK);
+		CD3DX12_RESOURCE_DESC readbackDesc = CD3DX12_RESOURCE_DESC::Buffer(queryHeapDesc.Count * sizeof(UINT64));
 		DX::ThrowIfFailed(d3dDevice->CreateCommittedResource(
-			&defaultHeapType,
+			&readbackHeapType,
 			D3D12_HEAP_FLAG_NONE,
-			&resourceDesc,
+			&readbackDesc,
 			D3D12_RESOURCE_STATE_COPY_DEST,
 			nullptr,
-			IID_PPV_ARGS(&m_previousYuv)));
-		DX::SetName(m_previousYuv.Get(), L"m_previousYuv");
-	}
-
-	// Graphics root sig
-	{
-		CD3DX12_DESCRIPTOR_RANGE ranges[2];
-		CD3DX12_ROOT_PARAMETER parameters[2];
+			IID_PPV_ARGS(&m_timestampReadback)));
+		DX::SetName(m_timestampReadback.Get(), L"m_timestampReadback");
 
-		{
-			{
-				UINT numDescriptors = DX::c_frameCount; // constant buffer for each frame
-				UINT baseShaderRegister = 0;
-				ranges[0].Init(D3D12_DESCRIPTOR_RANGE_TYPE_CBV, numDescriptors, baseShaderRegister);
-			}
-			{
-				UINT numDescriptors = 1;
-				UINT baseShaderRegister = 0;
-				ranges[1].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, numDescriptors, baseShaderRegister);
-			}
-			parameters[0].InitAsDescriptorTable(_countof(ranges), ranges, D3D12_SHADER_VISIBILITY_ALL);
-		}
-		{
-			UINT num32BitValues = 1;
-			UINT shaderRegister = 3;
-			UINT registerSpace = 0u;
-			parameters[1].InitAsConstants(num32BitValues, shaderRegister, registerSpace, D3D12_SHADER_VISIBILITY_ALL);
-		}
-
-		D3D12_ROOT_SIGNATURE_FLAGS rootSignatureFlags =
-			D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT | // Only the input assembler stage needs access to the constant buffer.
-			D3D12_ROOT_SIGNATURE_FLAG_DENY_DOMAIN_SHADER_ROOT_ACCESS |
-			D3D12_ROOT_SIGNATURE_FLAG_DENY_GEOMETRY_SHADER_ROOT_ACCESS |
-			D3D12_ROOT_SIGNATURE_FLAG_DENY_HULL_SHADER_ROOT_ACCESS;
-
-		D3D12_STATIC_SAMPLER_DESC samplers[2] = {};
-		{
-			samplers[0].Filter = D3D12_FILTER_MIN_MAG_MIP_POINT;
-			samplers[0].AddressU = D3D12_TEXTURE_ADDRESS_MODE_BORDER;
-			samplers[0].AddressV = D3D12_TEXTURE_ADDRESS_MODE_BORDER;
-			samplers[0].AddressW = D3D12_TEXTURE_ADDRESS_MODE_BORDER;
-			samplers[0].MipLODBias = 0;
-			samplers[0].MaxAnisotropy = 0;
-			samplers[0].ComparisonFunc = D3D12_COMPARISON_FUNC_NEVER;
-			samplers[0].BorderColor = D3D12_STATIC_BORDER_COLOR_TRANSPARENT_BLACK;
-			samplers[0].MinLOD = 0.0f;
-			samplers[0].MaxLOD = D3D12_FLOAT32_MAX;
-			samplers[0].ShaderRegister = 0;
-			samplers[0].RegisterSpace = 0;
-			samplers[0].ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;
-		}
-		{
-			samplers[1].Filter = D3D12_FILTER_MIN_MAG_MIP_LINEAR;
-			samplers[1].AddressU = D3D12_TEXTURE_ADDRESS_MODE_BORDER;
-			samplers[1].AddressV = D3D12_TEXTURE_ADDRESS_MODE_BORDER;
-			samplers[1].AddressW = D3D12_TEXTURE_ADDRESS_MODE_BORDER;
-			samplers[1].MipLODBias = 0;
-			samplers[1].MaxAnisotropy = 0;
-			samplers[1].ComparisonFunc = D3D12_COMPARISON_FUNC_NEVER;
-			samplers[1].BorderColor = D3D12_STATIC_BORDER_COLOR_TRANSPARENT_BLACK;
-			samplers[1].MinLOD = 0.0f;
-			samplers[1].MaxLOD = D3D12_FLOAT32_MAX;
-			samplers[1].ShaderRegister = 1;
-			samplers[1].RegisterSpace = 0;
-			samplers[1].ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;
-		}
-
-		CD3DX12_ROOT_SIGNATURE_DESC descRootSignature;
-		descRootSignature.Init(_countof(parameters), parameters, _countof(samplers), samplers, rootSignatureFlags);
-
-		ComPtr<ID3DBlob> pSignature;
-		ComPtr<ID3DBlob> pError;
-
-		HRESULT serializeRootSignatureHR = D3D12SerializeRootSignature(&descRootSignature, D3D_ROOT_SIGNATURE_VERSION_1, pSignature.GetAddressOf(), pError.GetAddressOf());
-		if (FAILED(serializeRootSignatureHR))
-		{
-			OutputDebugStringA(reinterpret_cast<char*>(pError->GetBufferPointer()));
-			_com_issue_error(serializeRootSignatureHR);
-		}
-		DX::ThrowIfFailed(d3dDevice->CreateRootSignature(0, pSignature->GetBufferPointer(), pSignature->GetBufferSize(), IID_PPV_ARGS(&m_commonGraphicsRootSignature)));
-        NAME_D3D12_OBJECT(m_commonGraphicsRootSignature);
-	}
-
-	// Compute root sig
-	{
-		CD3DX12_DESCRIPTOR_RANGE ranges[1];
-		CD3DX12_ROOT_PARAMETER parameters[2];
-
-		UINT descriptorCount = 3;
-		ranges[0].Init(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, descriptorCount, 0);
-
-		parameters[0].InitAsDescriptorTable(_countof(ranges), ranges);
-		parameters[1].InitAsConstants(2, 0);
-
-		D3D12_ROOT_SIGNATURE_FLAGS rootSignatureFlags = D3D12_ROOT_SIGNATURE_FLAG_DENY_VERTEX_SHADER_ROOT_ACCESS;
-
-		CD3DX12_ROOT_SIGNATURE_DESC descRootSignature;
-		descRootSignature.Init(_countof(parameters), parameters, 0, nullptr, rootSignatureFlags);
-
-		ComPtr<ID3DBlob> pSignature;
-		ComPtr<ID3DBlob> pError;
-
-		HRESULT serializeRootSignatureHR = D3D12SerializeRootSignature(&descRootSignature, D3D_ROOT_SIGNATURE_VERSION_1, pSignature.GetAddressOf(), pError.GetAddressOf());
-		if (FAILED(serializeRootSignatureHR))
-		{
-			OutputDebugStringA(reinterpret_cast<char*>(pError->GetBufferPointer()));
-			_com_issue_error(serializeRootSignatureHR);
-		}
-		DX::ThrowIfFailed(d3dDevice->CreateRootSignature(0, pSignature->GetBufferPointer(), pSignature->GetBufferSize(), IID_PPV_ARGS(&m_commonComputeRootSignature)));
-		NAME_D3D12_OBJECT(m_commonComputeRootSignature);
+		DX::ThrowIfFailed(m_deviceResources->GetCommandQueue()->GetTimestampFrequency(&m_timestampFrequency));
 	}
 
 	// Create the pipeline state once the shaders are loaded.
-	{
-		static const D3D12_INPUT_ELEMENT_DESC inputLayout[] =
-		{
-			{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-			{ "COLOR", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-		};
-
-		D3D12_GRAPHICS_PIPELINE_STATE_DESC state = {};
-		state.InputLayout = { inputLayout, _countof(inputLayout) };
-		state.pRootSignature = m_commonGraphicsRootSignature.Get();
-        state.VS = CD3DX12_SHADER_BYTECODE((void*)(g_Pass1VS), _countof(g_Pass1VS));
-        state.PS = CD3DX12_SHADER_BYTECODE((void*)(g_Pass1PS), _countof(g_Pass1PS));
-		state.RasterizerState = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
-		state.BlendState = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
-		state.DepthStencilState = CD3DX12_DEPTH_STENCIL_DESC(D3D12_DEFAULT);
-		state.SampleMask = UINT_MAX;
-		state.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
-		state.NumRenderTargets = 1;
-		state.RTVFormats[0] = m_deviceResources->GetBackBufferFormat();
-		state.DSVFormat = m_deviceResources->GetDepthBufferFormat();
-		state.SampleDesc.Count = 1;
-
-		DX::ThrowIfFailed(m_deviceResources->GetD3DDevice()->CreateGraphicsPipelineState(&state, IID_PPV_ARGS(&m_pass1PipelineState)));
-	};
 	{
 
 		static const D3D12_INPUT_ELEMENT_DESC inputLayout[] =
@@ -426,7 +110,7 @@ void Sample3DSceneRenderer::CreateDeviceDependentResources()
 
 		D3D12_GRAPHICS_PIPELINE_STATE_DESC state = {};
 		state.InputLayout = { inputLayout, _countof(inputLayout) };
-		state.pRootSignature = m_commonGraphicsRootSignature.Get();
+		state.pRootSignature = m_device->GetGraphicsRootSignature();
 		state.VS = CD3DX12_SHADER_BYTECODE((void*)(g_Pass2_TexturedQuadVS), _countof(g_Pass2_TexturedQuadVS));
 		state.PS = CD3DX12_SHADER_BYTECODE((void*)(g_Pass2_TexturedQuadPS), _countof(g_Pass2_TexturedQuadPS));
 		state.RasterizerState = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
@@ -441,135 +125,18 @@ void Sample3DSceneRenderer::CreateDeviceDependentResources()
 
 		DX::ThrowIfFailed(m_deviceResources->GetD3DDevice()->CreateGraphicsPipelineState(&state, IID_PPV_ARGS(&m_pass2_TexturedQuad_PipelineState)));
 	};
-	{
-		D3D12_COMPUTE_PIPELINE_STATE_DESC pipelineStateDesc{};
-		pipelineStateDesc.pRootSignature = m_commonComputeRootSignature.Get();
-		pipelineStateDesc.CS = CD3DX12_SHADER_BYTECODE((void*)(g_Pass2_RgbToYuvCS), _countof(g_Pass2_RgbToYuvCS));
-		DX::ThrowIfFailed(m_deviceResources->GetD3DDevice()->CreateComputePipelineState(&pipelineStateDesc, IID_PPV_ARGS(&m_pass2_YuvConversion_PipelineState)));
-	}
 
-	// Create and upload cube and quad geometry resources to the GPU.
+	// Create and upload quad geometry resources to the GPU. The upload goes in the device's command list, alongside the cube's.
 	{
+		ID3D12GraphicsCommandList* commandList = m_device->GetCommandList();
+
 		CD3DX12_HEAP_PROPERTIES uploadHeapProperties(D3D12_HEAP_TYPE_UPLOAD);
 		CD3DX12_HEAP_PROPERTIES defaultHeapProperties(D3D12_HEAP_TYPE_DEFAULT);
 
 		// Do not release these until the upload is finished
-		Microsoft::WRL::ComPtr<ID3D12Resource> spinningCubeVertexBufferUpload;
-		Microsoft::WRL::ComPtr<ID3D12Resource> spinningCubeIndexBufferUpload;
 		Microsoft::WRL::ComPtr<ID3D12Resource> texturedQuadVertexBufferUpload;
 		Microsoft::WRL::ComPtr<ID3D12Resource> texturedQuadIndexBufferUpload;
 
-		// Cube
-		{
-			// Cube vertices. Each vertex has a position and a color.
-			VertexPositionColor cubeVertices[] =
-			{
-				{ XMFLOAT3(-0.5f, -0.5f, -0.5f), XMFLOAT3(0.0f, 0.0f, 0.0f) },
-				{ XMFLOAT3(-0.5f, -0.5f,  0.5f), XMFLOAT3(0.0f, 0.0f, 1.0f) },
-				{ XMFLOAT3(-0.5f,  0.5f, -0.5f), XMFLOAT3(0.0f, 1.0f, 0.0f) },
-				{ XMFLOAT3(-0.5f,  0.5f,  0.5f), XMFLOAT3(0.0f, 1.0f, 1.0f) },
-				{ XMFLOAT3(0.5f, -0.5f, -0.5f), XMFLOAT3(1.0f, 0.0f, 0.0f) },
-				{ XMFLOAT3(0.5f, -0.5f,  0.5f), XMFLOAT3(1.0f, 0.0f, 1.0f) },
-				{ XMFLOAT3(0.5f,  0.5f, -0.5f), XMFLOAT3(1.0f, 1.0f, 0.0f) },
-				{ XMFLOAT3(0.5f,  0.5f,  0.5f), XMFLOAT3(1.0f, 1.0f, 1.0f) },
-			};
-			const UINT spinningCubeVertexBufferSize = sizeof(cubeVertices);
-
-			CD3DX12_RESOURCE_DESC spinningCubeVertexBufferDesc = CD3DX12_RESOURCE_DESC::Buffer(spinningCubeVertexBufferSize);
-			DX::ThrowIfFailed(d3dDevice->CreateCommittedResource(
-				&defaultHeapProperties,
-				D3D12_HEAP_FLAG_NONE,
-				&spinningCubeVertexBufferDesc,
-				D3D12_RESOURCE_STATE_COPY_DEST,
-				nullptr,
-				IID_PPV_ARGS(&m_spinningCubeVertexBuffer)));
-			NAME_D3D12_OBJECT(m_spinningCubeVertexBuffer);
-
-			// Create vertex/index buffer views.
-			m_spinningCubeVertexBufferView.BufferLocation = m_spinningCubeVertexBuffer->GetGPUVirtualAddress();
-			m_spinningCubeVertexBufferView.StrideInBytes = sizeof(VertexPositionColor);
-			m_spinningCubeVertexBufferView.SizeInBytes = sizeof(cubeVertices);
-
-			DX::ThrowIfFailed(d3dDevice->CreateCommittedResource(
-				&uploadHeapProperties,
-				D3D12_HEAP_FLAG_NONE,
-				&spinningCubeVertexBufferDesc,
-				D3D12_RESOURCE_STATE_GENERIC_READ,
-				nullptr,
-				IID_PPV_ARGS(&spinningCubeVertexBufferUpload)));
-
-			D3D12_SUBRESOURCE_DATA spinningCubeVertexData = {};
-			spinningCubeVertexData.pData = reinterpret_cast<BYTE*>(cubeVertices);
-			spinningCubeVertexData.RowPitch = spinningCubeVertexBufferSize;
-			spinningCubeVertexData.SlicePitch = spinningCubeVertexData.RowPitch;
-
-			UpdateSubresources(m_commandList.Get(), m_spinningCubeVertexBuffer.Get(), spinningCubeVertexBufferUpload.Get(), 0, 0, 1, &spinningCubeVertexData);
-
-			CD3DX12_RESOURCE_BARRIER barrier =
-				CD3DX12_RESOURCE_BARRIER::Transition(m_spinningCubeVertexBuffer.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER);
-			m_commandList->ResourceBarrier(1, &barrier);
-
-			// Load mesh indices. Each trio of indices represents a triangle to be rendered on the screen.
-			// For example: 0,2,1 means that the vertices with indexes 0, 2 and 1 from the vertex buffer compose the
-			// first triangle of this mesh.
-			unsigned short cubeIndices[] =
-			{
-				0, 2, 1, // -x
-				1, 2, 3,
-
-				4, 5, 6, // +x
-				5, 7, 6,
-
-				0, 1, 5, // -y
-				0, 5, 4,
-
-				2, 6, 7, // +y
-				2, 7, 3,
-
-				0, 4, 6, // -z
-				0, 6, 2,
-
-				1, 3, 7, // +z
-				1, 7, 5,
-			};
-
-			const UINT spinningCubeIndexBufferSize = sizeof(cubeIndices);
-
-			CD3DX12_RESOURCE_DESC indexBufferDesc = CD3DX12_RESOURCE_DESC::Buffer(spinningCubeIndexBufferSize);
-			DX::ThrowIfFailed(d3dDevice->CreateCommittedResource(
-				&defaultHeapProperties,
-				D3D12_HEAP_FLAG_NONE,
-				&indexBufferDesc,
-				D3D12_RESOURCE_STATE_COPY_DEST,
-				nullptr,
-				IID_PPV_ARGS(&m_spinningCubeIndexBuffer)));
-
-			m_spinningCubeIndexBufferView.BufferLocation = m_spinningCubeIndexBuffer->GetGPUVirtualAddress();
-			m_spinningCubeIndexBufferView.SizeInBytes = sizeof(cubeIndices);
-			m_spinningCubeIndexBufferView.Format = DXGI_FORMAT_R16_UINT;
-
-			DX::ThrowIfFailed(d3dDevice->CreateCommittedResource(
-				&uploadHeapProperties,
-				D3D12_HEAP_FLAG_NONE,
-				&indexBufferDesc,
-				D3D12_RESOURCE_STATE_GENERIC_READ,
-				nullptr,
-				IID_PPV_ARGS(&spinningCubeIndexBufferUpload)));
-
-			NAME_D3D12_OBJECT(m_spinningCubeIndexBuffer);
-
-			D3D12_SUBRESOURCE_DATA indexData = {};
-			indexData.pData = reinterpret_cast<BYTE*>(cubeIndices);
-			indexData.RowPitch = spinningCubeIndexBufferSize;
-			indexData.SlicePitch = indexData.RowPitch;
-
-			UpdateSubresources(m_commandList.Get(), m_spinningCubeIndexBuffer.Get(), spinningCubeIndexBufferUpload.Get(), 0, 0, 1, &indexData);
-
-			CD3DX12_RESOURCE_BARRIER indexBufferResourceBarrier =
-				CD3DX12_RESOURCE_BARRIER::Transition(m_spinningCubeIndexBuffer.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_INDEX_BUFFER);
-			m_commandList->ResourceBarrier(1, &indexBufferResourceBarrier);
-		}
-
 		// Quad
 		{
 		VertexUV quadVertices[] =
@@ -609,11 +176,11 @@ void Sample3DSceneRenderer::CreateDeviceDependentResources()
 			quadVertexData.RowPitch = quadVertexBufferSize;
 			quadVertexData.SlicePitch = quadVertexData.RowPitch;
 
-			UpdateSubresources(m_commandList.Get(), m_texturedQuadVertexBuffer.Get(), texturedQuadVertexBufferUpload.Get(), 0, 0, 1, &quadVertexData);
+			UpdateSubresources(commandList, m_texturedQuadVertexBuffer.Get(), texturedQuadVertexBufferUpload.Get(), 0, 0, 1, &quadVertexData);
 
 			CD3DX12_RESOURCE_BARRIER barrier =
 				CD3DX12_RESOURCE_BARRIER::Transition(m_texturedQuadVertexBuffer.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER);
-			m_commandList->ResourceBarrier(1, &barrier);
+			commandList->ResourceBarrier(1, &barrier);
 
 			unsigned short quadIndices[] =
 			{
@@ -651,162 +218,104 @@ void Sample3DSceneRenderer::CreateDeviceDependentResources()
 			indexData.RowPitch = quadIndexBufferSize;
 			indexData.SlicePitch = indexData.RowPitch;
 
-			UpdateSubresources(m_commandList.Get(), m_texturedQuadIndexBuffer.Get(), texturedQuadIndexBufferUpload.Get(), 0, 0, 1, &indexData);
+			UpdateSubresources(commandList, m_texturedQuadIndexBuffer.Get(), texturedQuadIndexBufferUpload.Get(), 0, 0, 1, &indexData);
 
 			CD3DX12_RESOURCE_BARRIER indexBufferResourceBarrier =
 				CD3DX12_RESOURCE_BARRIER::Transition(m_texturedQuadIndexBuffer.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_INDEX_BUFFER);
-			m_commandList->ResourceBarrier(1, &indexBufferResourceBarrier);
-		}
-
-		// Create a descriptor heap for the constant buffers and SRV.
-		{
-			// Descriptor table has these contents:
-
-			// frame 0 graphics constants
-			// frame 1 graphics constants
-			// frame 2 graphics constants
-			// intermediate srv
-			// intermediate uav rgb source
-			// intermediate uav luminance plane
-			// intermediate uav chrominance plane
-
-			D3D12_DESCRIPTOR_HEAP_DESC heapDesc = {};
-			heapDesc.NumDescriptors = DX::c_frameCount + 4;
-			heapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-			// This flag indicates that this descriptor heap can be bound to the pipeline and that descriptors contained in it can be referenced by a root table.
-			heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-			DX::ThrowIfFailed(d3dDevice->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(&m_cbvSrvHeap)));
-
-            NAME_D3D12_OBJECT(m_cbvSrvHeap);
+			commandList->ResourceBarrier(1, &indexBufferResourceBarrier);
 		}
 
-		CD3DX12_RESOURCE_DESC constantBufferDesc = CD3DX12_RESOURCE_DESC::Buffer(DX::c_frameCount * c_alignedConstantBufferSize);
-		DX::ThrowIfFailed(d3dDevice->CreateCommittedResource(
-			&uploadHeapProperties,
-			D3D12_HEAP_FLAG_NONE,
-			&constantBufferDesc,
-			D3D12_RESOURCE_STATE_GENERIC_READ,
-			nullptr,
-			IID_PPV_ARGS(&m_constantBuffer)));
-
-        NAME_D3D12_OBJECT(m_constantBuffer);
+		m_device->FinishUploads();
+	};
 
-		// Create constant buffer views to access the upload buffer.
-		D3D12_GPU_VIRTUAL_ADDRESS cbvGpuAddress = m_constantBuffer->GetGPUVirtualAddress();
-		CD3DX12_CPU_DESCRIPTOR_HANDLE cbvSrvCpuHandle(m_cbvSrvHeap->GetCPUDescriptorHandleForHeapStart());
-		m_cbvDescriptorSize = d3dDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+	m_loadingComplete = true;
+}
 
-		for (int n = 0; n < DX::c_frameCount; n++)
-		{
-			D3D12_CONSTANT_BUFFER_VIEW_DESC desc;
-			desc.BufferLocation = cbvGpuAddress;
-			desc.SizeInBytes = c_alignedConstantBufferSize;
-			d3dDevice->CreateConstantBufferView(&desc, cbvSrvCpuHandle);
+// DLSS and XeSS go through an upscaler. Point and Linear don't, since they happen as part of presenting.
+IUpscaler* Sample3DSceneRenderer::GetUpscaler(ScalingType scalingType) const
+{
+	if (scalingType == ScalingType::DLSS && m_dlssUpscaler && m_dlssUpscaler->IsSupported())
+	{
+		return m_dlssUpscaler.get();
+	}
+	else if (scalingType == ScalingType::XeSS)
+	{
+		return m_xessUpscaler.get();
+	}
+	return nullptr;
+}
 
-			cbvGpuAddress += desc.SizeInBytes;
-			cbvSrvCpuHandle.Offset(m_cbvDescriptorSize);
-		}
+// Asks the given scaling type what it would like to render at for the current quality preset. The result
+// always fits in the color image, which is allocated at g_scaling_sourceWidth x g_scaling_sourceHeight.
+RenderSize Sample3DSceneRenderer::GetOptimalRenderSize(ScalingType scalingType) const
+{
+	IUpscaler* upscaler = GetUpscaler(scalingType);
 
-		// Create SRV
-		{
-			D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
-			srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-			srvDesc.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
-			srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
-			srvDesc.Texture2D.MipLevels = 1;
-			d3dDevice->CreateShaderResourceView(m_deviceResources->GetIntermediateRenderTarget(), &srvDesc, cbvSrvCpuHandle);
-			cbvSrvCpuHandle.Offset(m_cbvDescriptorSize);
-		}
-		// Create UAV for rgb source
-		{
-			D3D12_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
-			uavDesc.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
-			uavDesc.ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2D;
-			d3dDevice->CreateUnorderedAccessView(m_deviceResources->GetIntermediateRenderTarget(), nullptr, &uavDesc, cbvSrvCpuHandle);
-			cbvSrvCpuHandle.Offset(m_cbvDescriptorSize);
-		}
-		{
-			D3D12_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
-			uavDesc.Format = DXGI_FORMAT_R8_UNORM; // Selects the luminance plane
-			uavDesc.ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2D;
-			d3dDevice->CreateUnorderedAccessView(m_currentYuv.Get(), nullptr, &uavDesc, cbvSrvCpuHandle);
-			cbvSrvCpuHandle.Offset(m_cbvDescriptorSize);
-		}
-		{
-			D3D12_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
-			uavDesc.Format = DXGI_FORMAT_R8G8_UNORM; // Selects the chrominance plane
-			uavDesc.ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2D;
-			uavDesc.Texture2D.PlaneSlice = 1;
-			d3dDevice->CreateUnorderedAccessView(m_currentYuv.Get(), nullptr, &uavDesc, cbvSrvCpuHandle);
-			cbvSrvCpuHandle.Offset(m_cbvDescriptorSize);
-		}
+	RenderSize renderSize = upscaler ?
+		upscaler->GetOptimalInputSize(g_scaling_destWidth, g_scaling_destHeight) :
+		GetPresetRenderSize(m_qualityPreset, g_scaling_destWidth, g_scaling_destHeight);
 
-		// Map the constant buffers.
-		CD3DX12_RANGE readRange(0, 0);		// We do not intend to read from this resource on the CPU.
-		DX::ThrowIfFailed(m_constantBuffer->Map(0, &readRange, reinterpret_cast<void**>(&m_mappedConstantBuffer)));
-		ZeroMemory(m_mappedConstantBuffer, DX::c_frameCount * c_alignedConstantBufferSize);
-		// We don't unmap this until the app closes. Keeping things mapped for the lifetime of the resource is okay.
+	return ClampRenderSize(renderSize, g_scaling_sourceWidth, g_scaling_sourceHeight);
+}
 
-		// Close the command list and execute it to begin the vertex/index buffer copy into the GPU's default heap.
-		DX::ThrowIfFailed(m_commandList->Close());
-		ID3D12CommandList* ppCommandLists[] = { m_commandList.Get() };
-		m_deviceResources->GetCommandQueue()->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
+// Has DLSS and XeSS recreate themselves for the current quality preset, and has pass 1 render at what the
+// current scaling type would like. The color image keeps its size, so only the part of it that's rendered to changes.
+void Sample3DSceneRenderer::ApplyQualityPreset()
+{
+	// Nothing can still be using the upscalers.
+	m_deviceResources->WaitForGpuOnDirectQueue();
 
-		// Wait for the command list to finish executing; the vertex/index buffers need to be uploaded to the GPU before the upload resources go out of scope.
-		m_deviceResources->WaitForGpuOnDirectQueue();
+	if (m_dlssUpscaler)
+	{
+		m_dlssUpscaler->SetQualityPreset(m_qualityPreset);
+	}
+	m_xessUpscaler->SetQualityPreset(m_qualityPreset);
 
-		if (m_videoEncodeCommandList)
-		{
-			DX::ThrowIfFailed(m_videoEncodeCommandList->Close());
-		}
-	};
+	ResetRenderSize();
+	UpdateWindowTitleText();
+}
 
-	m_loadingComplete = true;
+// Starts dynamic resolution off from what the current scaling type would like to render at.
+void Sample3DSceneRenderer::ResetRenderSize()
+{
+	RenderSize renderSize = GetOptimalRenderSize(m_scalingType);
+	m_dynamicResolution.SetMaxSize(renderSize.width, renderSize.height);
 }
 
 // Initializes view parameters when the window size changes.
 void Sample3DSceneRenderer::CreateTargetSizeDependentResources()
 {
 	D3D12_VIEWPORT pass1Viewport = m_deviceResources->GetPass1Viewport();
-	m_pass1ScissorRect = { 0, 0, static_cast<LONG>(pass1Viewport.Width), static_cast<LONG>(pass1Viewport.Height)};
 
 	D3D12_VIEWPORT pass2Viewport = m_deviceResources->GetPass2Viewport();
 	m_pass2ScissorRect = { 0, 0, static_cast<LONG>(pass2Viewport.Width), static_cast<LONG>(pass2Viewport.Height) };
 
 	float aspectRatio = static_cast<float>(pass1Viewport.Width) / static_cast<float>(pass1Viewport.Height);
-	float fovAngleY = 70.0f * XM_PI / 180.0f;
-	if (aspectRatio < 1.0f)
-	{
-		fovAngleY *= 2.0f;
-	}
-	
-	// This sample makes use of a right-handed coordinate system using row-major matrices.
-	XMMATRIX perspectiveMatrix = XMMatrixPerspectiveFovRH(
-		fovAngleY,
-		aspectRatio,
-		0.01f,
-		100.0f
-		);
-
-	XMStoreFloat4x4(
-		&m_constantBufferData.projection,
-		XMMatrixTranspose(perspectiveMatrix)
-		);
-
-	// Eye is at (0,0.7,1.5), looking at point (0,-0.1,0) with the up-vector along the y-axis.
-	static const XMVECTORF32 eye = { 0.0f, 0.7f - 0.5, 1.5f, 0.0f };
-	static const XMVECTORF32 at = { 0.0f, -0.1f + 0.1f, 0.0f, 0.0f };
-	static const XMVECTORF32 up = { 0.0f, 1.0f, 0.0f, 0.0f };
-
-	XMStoreFloat4x4(&m_constantBufferData.view, XMMatrixTranspose(XMMatrixLookAtRH(eye, at, up)));
+	m_projection = GetSceneProjection(aspectRatio);
+	UpdateJitteredProjection();
+
+	m_sceneConstants.view = GetSceneView();
 }
 
 // Called once per frame, rotates the cube and calculates the model and view matrices.
 void Sample3DSceneRenderer::Update(DX::StepTimer const& timer)
 {
-	if (m_loadingComplete && m_isSpinning)
+	if (m_loadingComplete)
 	{
-		if (!m_tracking)
+		// The previous frame that used this frame index has finished on the GPU, so its timing is available.
+		// This may change the render size, which the jitter is relative to.
+		ReadFrameTimestamp();
+
+		// The title shows the frame times of the last second, so it changes once a second.
+		uint64 second = timer.GetTotalTicks() / DX::StepTimer::TicksPerSecond;
+		if (second != m_titleSecond)
+		{
+			m_titleSecond = second;
+			m_frameTimesText = FormatFrameTimes(timer.GetLastSecondFrameTimes());
+			UpdateWindowTitleText();
+		}
+
+		if (m_isSpinning && !m_tracking)
 		{
 			// Rotate the cube a small amount.
 			m_angle += static_cast<float>(timer.GetElapsedSeconds()) * m_radiansPerSecond;
@@ -814,186 +323,168 @@ void Sample3DSceneRenderer::Update(DX::StepTimer const& timer)
 			Rotate(m_angle);
 		}
 
-		// Update the constant buffer resource.
-		UINT8* destination = m_mappedConstantBuffer + (m_deviceResources->GetCurrentFrameIndex() * c_alignedConstantBufferSize);
-		memcpy(destination, &m_constantBufferData, sizeof(m_constantBufferData));
+		// Jitter keeps moving while the cube is stopped, since that's when an upscaler can accumulate the most detail.
+		m_jitterOffset = IsTemporalScalingType() ? m_jitterSequence.GetOffset(m_jitterFrameNumber) : JitterOffset{};
+		++m_jitterFrameNumber;
+		UpdateJitteredProjection();
 	}
 }
 
-// Rotate the 3D cube model a set amount of radians.
-void Sample3DSceneRenderer::Rotate(float radians)
+void Sample3DSceneRenderer::UpdateJitteredProjection()
 {
-	// Prepare to pass the updated model matrix to the shader.
-	XMStoreFloat4x4(&m_constantBufferData.model, XMMatrixTranspose(XMMatrixRotationY(radians)));
+	RenderSize renderSize{ m_dynamicResolution.GetRenderWidth(), m_dynamicResolution.GetRenderHeight() };
+	m_sceneConstants.projection = JitterProjection(m_projection, m_jitterOffset, renderSize);
+	m_sceneConstants.unjitteredProjection = m_projection;
 }
 
-void Sample3DSceneRenderer::EvaluateMotionVectors()
+bool Sample3DSceneRenderer::IsTemporalScalingType() const
 {
-	{
-		CD3DX12_RESOURCE_BARRIER barrier =
-			CD3DX12_RESOURCE_BARRIER::Transition(m_currentYuv.Get(), D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
-		m_commandList->ResourceBarrier(1, &barrier);
-	}
+	return m_scalingType == ScalingType::DLSS || m_scalingType == ScalingType::XeSS;
+}
 
-	// Convert Rgb to Yuv because motion estimation requires yuv
-	{
-		m_commandList->SetPipelineState(m_pass2_YuvConversion_PipelineState.Get());
+// Rotate the 3D cube model a set amount of radians.
+void Sample3DSceneRenderer::Rotate(float radians)
+{
+	m_sceneConstants.model = MatrixRotationY(radians);
+	m_sceneConstants.sceneAngle = radians;
+}
 
-		// First half of descriptor table is graphics stuff, second half is compute. Select the compute items
-		CD3DX12_GPU_DESCRIPTOR_HANDLE gpuHandle(m_cbvSrvHeap->GetGPUDescriptorHandleForHeapStart(), 4, m_cbvDescriptorSize);
-		m_commandList->SetComputeRootDescriptorTable(0, gpuHandle);
-		UINT rootConstants[2] = { static_cast<UINT>(g_scaling_sourceWidth), static_cast<UINT>(g_scaling_sourceHeight) };
-		m_commandList->SetComputeRoot32BitConstants(1, 2, rootConstants, 0);
+// Writes the DLSS or XeSS output to the swap chain. With sharpening on, this is a draw that sharpens on the
+// way through rather than a copy, so it still reads and writes the image only once.
+void Sample3DSceneRenderer::WriteUpscaledTargetToSwapchain()
+{
+	ID3D12GraphicsCommandList* commandList = m_device->GetCommandList();
+	D3D12Image& upscaled = static_cast<D3D12Image&>(m_pipeline->GetOutput());
 
-		UINT dispatchX = static_cast<UINT>(g_scaling_sourceWidth) / 64 + 1;
-		UINT dispatchY = g_scaling_sourceHeight;
-		m_commandList->Dispatch(dispatchX, dispatchY, 1);
-	}
+	if (m_sharpness > 0.0f)
 	{
-		CD3DX12_RESOURCE_BARRIER barrier =
-			CD3DX12_RESOURCE_BARRIER::Transition(m_previousYuv.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_COMMON);
-		m_commandList->ResourceBarrier(1, &barrier);
-	}
-	{
-		CD3DX12_RESOURCE_BARRIER barrier =
-			CD3DX12_RESOURCE_BARRIER::Transition(m_currentYuv.Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COMMON);
-		m_commandList->ResourceBarrier(1, &barrier);
+		// The upscaled image rests as a shader resource, so it can be drawn from as it is.
+		DrawConstants drawConstants{};
+		drawConstants.samplerIndex = 0; // The upscaled target is already at output resolution
+		drawConstants.sharpness = m_sharpness;
+		drawConstants.outputTexelSize = XMFLOAT2(1.0f / g_scaling_destWidth, 1.0f / g_scaling_destHeight);
+		drawConstants.inputUvScale = XMFLOAT2(1.0f, 1.0f);
+		drawConstants.inputUvMax = XMFLOAT2(1.0f, 1.0f);
+		DrawTexturedQuadToSwapchain(upscaled.GetSrvDescriptorIndex(), drawConstants);
+		return;
 	}
 
-	DX::ThrowIfFailed(m_commandList->Close());
+	ID3D12Resource* swapChainTarget = m_deviceResources->GetSwapChainRenderTarget();
+	m_device->RequireState(upscaled.GetResource(), D3D12_RESOURCE_STATE_COPY_SOURCE);
+	m_device->RequireState(swapChainTarget, D3D12_RESOURCE_STATE_COPY_DEST);
+	m_device->FlushBarriers();
 
-	{
-		ID3D12CommandList* ppCommandLists[] = { m_commandList.Get() };
-		m_deviceResources->GetCommandQueue()->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
-	}
+	commandList->CopyResource(swapChainTarget, upscaled.GetResource());
 
-	m_deviceResources->WaitForGpuOnDirectQueue(); // Wait for graphics conversion to finish
+	m_device->RequireState(swapChainTarget, D3D12_RESOURCE_STATE_PRESENT);
+	m_device->RequireRestingState(upscaled);
+}
 
-	DX::ThrowIfFailed(m_deviceResources->GetVideoEncodeCommandAllocator()->Reset());
-	DX::ThrowIfFailed(m_videoEncodeCommandList->Reset(m_deviceResources->GetVideoEncodeCommandAllocator()));
+// Draws a full-screen quad into the swap chain, sampling the texture at the given descriptor.
+// Sets all of its own state, since DLSS and XeSS leave the command list's bindings undefined.
+void Sample3DSceneRenderer::DrawTexturedQuadToSwapchain(UINT srvDescriptorIndex, DrawConstants const& drawConstants)
+{
+	ID3D12GraphicsCommandList* commandList = m_device->GetCommandList();
 
-	{
-		CD3DX12_RESOURCE_BARRIER barrier =
-			CD3DX12_RESOURCE_BARRIER::Transition(m_previousYuv.Get(), D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_VIDEO_ENCODE_READ);
-		m_videoEncodeCommandList->ResourceBarrier(1, &barrier);
-	}
-	{
-		CD3DX12_RESOURCE_BARRIER barrier =
-			CD3DX12_RESOURCE_BARRIER::Transition(m_currentYuv.Get(), D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_VIDEO_ENCODE_READ);
-		m_videoEncodeCommandList->ResourceBarrier(1, &barrier);
-	}
-	{
-		CD3DX12_RESOURCE_BARRIER barrier =
-			CD3DX12_RESOURCE_BARRIER::Transition(m_motionVectors.Get(), D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_VIDEO_ENCODE_WRITE);
-		m_videoEncodeCommandList->ResourceBarrier(1, &barrier);
-	}
+	ID3D12DescriptorHeap* ppHeaps[] = { m_device->GetDescriptorHeap() };
+	commandList->SetDescriptorHeaps(_countof(ppHeaps), ppHeaps);
+	commandList->SetGraphicsRootSignature(m_device->GetGraphicsRootSignature());
+	commandList->SetPipelineState(m_pass2_TexturedQuad_PipelineState.Get());
 
-	// Run motion estimation
-	{
-		const D3D12_VIDEO_MOTION_ESTIMATOR_INPUT inputArgs = {
-			m_currentYuv.Get(),
-			0,
-			m_previousYuv.Get(),
-			0,
-			nullptr // pHintMotionVectorHeap
-		};
+	commandList->SetGraphicsRoot32BitConstants(1, sizeof(DrawConstants) / sizeof(UINT), &drawConstants, 0);
+	commandList->SetGraphicsRootDescriptorTable(2, m_device->GetGpuDescriptor(srvDescriptorIndex));
 
-		const D3D12_VIDEO_MOTION_ESTIMATOR_OUTPUT outputArgs = { m_videoMotionVectorHeap.Get() };
+	// Set the viewport and scissor rectangle.
+	D3D12_VIEWPORT pass2Viewport = m_deviceResources->GetPass2Viewport();
+	commandList->RSSetViewports(1, &pass2Viewport);
+	commandList->RSSetScissorRects(1, &m_pass2ScissorRect);
 
-		m_videoEncodeCommandList->EstimateMotion(m_videoMotionEstimator.Get(), &outputArgs, &inputArgs);
-	}
-	// Resolve motion vectors
+	m_device->RequireState(m_deviceResources->GetSwapChainRenderTarget(), D3D12_RESOURCE_STATE_RENDER_TARGET);
+	m_device->FlushBarriers();
 	{
-		D3D12_RESOLVE_VIDEO_MOTION_VECTOR_HEAP_INPUT inputArgs =
-		{
-			m_videoMotionVectorHeap.Get(),
-			g_scaling_sourceWidth,
-			g_scaling_sourceHeight
-		};
+		D3D12_CPU_DESCRIPTOR_HANDLE renderTargetView = m_deviceResources->GetSwapChainRenderTargetCpuDescriptor();
 
-		D3D12_RESOURCE_COORDINATE ouputCoordinate{};
-
-		D3D12_RESOLVE_VIDEO_MOTION_VECTOR_HEAP_OUTPUT outputArgs =
-		{
-			m_motionVectors.Get(),
-			ouputCoordinate
-		};
-
-		m_videoEncodeCommandList->ResolveMotionVectorHeap(&outputArgs, &inputArgs);
-	}
-
-	{
-		CD3DX12_RESOURCE_BARRIER barrier =
-			CD3DX12_RESOURCE_BARRIER::Transition(m_previousYuv.Get(), D3D12_RESOURCE_STATE_VIDEO_ENCODE_READ, D3D12_RESOURCE_STATE_COMMON);
-		m_videoEncodeCommandList->ResourceBarrier(1, &barrier);
-	}
-	{
-		CD3DX12_RESOURCE_BARRIER barrier =
-			CD3DX12_RESOURCE_BARRIER::Transition(m_currentYuv.Get(), D3D12_RESOURCE_STATE_VIDEO_ENCODE_READ, D3D12_RESOURCE_STATE_COMMON);
-		m_videoEncodeCommandList->ResourceBarrier(1, &barrier);
-	}
-	{
-		CD3DX12_RESOURCE_BARRIER barrier =
-			CD3DX12_RESOURCE_BARRIER::Transition(m_motionVectors.Get(), D3D12_RESOURCE_STATE_VIDEO_ENCODE_WRITE, D3D12_RESOURCE_STATE_COMMON);
-		m_videoEncodeCommandList->ResourceBarrier(1, &barrier);
+		float cornflowerBlue[] = { 0.3f, 0.58f, 0.93f, 1.0f };
+		commandList->ClearRenderTargetView(renderTargetView, cornflowerBlue, 0, nullptr);
+		commandList->OMSetRenderTargets(1, &renderTargetView, false, nullptr);
 	}
+	commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	commandList->IASetVertexBuffers(0, 1, &m_texturedQuadVertexBufferView);
+	commandList->IASetIndexBuffer(&m_texturedQuadIndexBufferView);
+	commandList->DrawIndexedInstanced(6, 1, 0, 0, 0);
 
-	DX::ThrowIfFailed(m_videoEncodeCommandList->Close());
+	m_device->RequireState(m_deviceResources->GetSwapChainRenderTarget(), D3D12_RESOURCE_STATE_PRESENT);
+}
 
-	{
-		ID3D12CommandList* ppCommandLists[] = { m_videoEncodeCommandList.Get() };
-		m_deviceResources->GetVideoQueue()->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
-	}
-	m_deviceResources->WaitForGpuOnVideoQueue();
+void Sample3DSceneRenderer::BeginFrameTimestamp()
+{
+	UINT frameIndex = m_deviceResources->GetCurrentFrameIndex();
+	m_device->GetCommandList()->EndQuery(m_timestampQueryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, frameIndex * 2);
+}
 
-	// Reopen the graphics command list
-	DX::ThrowIfFailed(m_deviceResources->GetDirectCommandAllocator()->Reset());
-	DX::ThrowIfFailed(m_commandList->Reset(m_deviceResources->GetDirectCommandAllocator(), nullptr));
+// Records the end of the frame's GPU work, and copies both of its timestamps out to where the CPU can
+// read them. This goes on the last command list of the frame; the start may have been on an earlier one.
+// The size the frame was rendered at is kept with them, since the size may change before they're read.
+void Sample3DSceneRenderer::EndFrameTimestamp(RenderSize renderSize)
+{
+	UINT frameIndex = m_deviceResources->GetCurrentFrameIndex();
+	m_device->GetCommandList()->EndQuery(m_timestampQueryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, frameIndex * 2 + 1);
+	m_device->GetCommandList()->ResolveQueryData(
+		m_timestampQueryHeap.Get(),
+		D3D12_QUERY_TYPE_TIMESTAMP,
+		frameIndex * 2,
+		2,
+		m_timestampReadback.Get(),
+		frameIndex * 2 * sizeof(UINT64));
+	m_timestampPending[frameIndex] = true;
+	m_timestampRenderSizes[frameIndex] = renderSize;
 }
 
-void Sample3DSceneRenderer::CopyCurrentMotionVectorsToPrevious()
+// Keeps the GPU time of the last frame that used the current frame index, and passes it on to dynamic resolution.
+// scalingMain only starts a frame once the frame before it at the index has finished. Does nothing if
+// that frame's time has already been read.
+void Sample3DSceneRenderer::ReadFrameTimestamp()
 {
+	UINT frameIndex = m_deviceResources->GetCurrentFrameIndex();
+	if (!m_timestampPending[frameIndex])
 	{
-		CD3DX12_RESOURCE_BARRIER barrier =
-			CD3DX12_RESOURCE_BARRIER::Transition(m_currentYuv.Get(), D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_COPY_SOURCE);
-		m_commandList->ResourceBarrier(1, &barrier);
-	}
-	{
-		CD3DX12_RESOURCE_BARRIER barrier =
-			CD3DX12_RESOURCE_BARRIER::Transition(m_previousYuv.Get(), D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_COPY_DEST);
-		m_commandList->ResourceBarrier(1, &barrier);
-	}
-	m_commandList->CopyResource(m_previousYuv.Get(), m_currentYuv.Get());
-	{
-		CD3DX12_RESOURCE_BARRIER barrier =
-			CD3DX12_RESOURCE_BARRIER::Transition(m_currentYuv.Get(), D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_COMMON);
-		m_commandList->ResourceBarrier(1, &barrier);
+		return;
 	}
+	m_timestampPending[frameIndex] = false;
+
+	CD3DX12_RANGE readRange(frameIndex * 2 * sizeof(UINT64), (frameIndex * 2 + 2) * sizeof(UINT64));
+	UINT64* timestamps = nullptr;
+	DX::ThrowIfFailed(m_timestampReadback->Map(0, &readRange, reinterpret_cast<void**>(&timestamps)));
+	UINT64 start = timestamps[frameIndex * 2];
+	UINT64 end = timestamps[frameIndex * 2 + 1];
+	CD3DX12_RANGE writeRange(0, 0);
+	m_timestampReadback->Unmap(0, &writeRange);
+
+	if (end <= start || m_timestampFrequency == 0)
 	{
-		CD3DX12_RESOURCE_BARRIER barrier =
-			CD3DX12_RESOURCE_BARRIER::Transition(m_previousYuv.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_COMMON);
-		m_commandList->ResourceBarrier(1, &barrier);
+		return;
 	}
-}
+	m_lastGpuSeconds = static_cast<double>(end - start) / m_timestampFrequency;
 
-void Sample3DSceneRenderer::CopyUpscaledTargetToSwapchain()
-{
+	if (!m_isDynamicResolutionEnabled)
 	{
-		CD3DX12_RESOURCE_BARRIER barrier =
-			CD3DX12_RESOURCE_BARRIER::Transition(m_upscaledTarget.Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_SOURCE);
-		m_commandList->ResourceBarrier(1, &barrier);
+		return;
 	}
 
-	m_commandList->CopyResource(m_deviceResources->GetSwapChainRenderTarget(), m_upscaledTarget.Get());
+	int previousWidth = m_dynamicResolution.GetRenderWidth();
+	int previousHeight = m_dynamicResolution.GetRenderHeight();
+
+	RenderSize renderSize = m_timestampRenderSizes[frameIndex];
+	m_dynamicResolution.OnFrameCompleted(m_lastGpuSeconds, renderSize.width, renderSize.height);
 
+	if (m_dynamicResolution.GetRenderWidth() != previousWidth || m_dynamicResolution.GetRenderHeight() != previousHeight)
 	{
-		CD3DX12_RESOURCE_BARRIER barrier =
-			CD3DX12_RESOURCE_BARRIER::Transition(m_deviceResources->GetSwapChainRenderTarget(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PRESENT);
-		m_commandList->ResourceBarrier(1, &barrier);
+		UpdateWindowTitleText();
 	}
 }
 
-// Renders one frame using the vertex and pixel shaders.
+
+// Renders one frame through the pipeline, and presents it.
 bool Sample3DSceneRenderer::RenderAndPresent()
 {
 	if (!m_loadingComplete)
@@ -1001,281 +492,200 @@ bool Sample3DSceneRenderer::RenderAndPresent()
 		return false;
 	}
 
-	DX::ThrowIfFailed(m_deviceResources->GetDirectCommandAllocator()->Reset());
+	RenderSize renderSize{ m_dynamicResolution.GetRenderWidth(), m_dynamicResolution.GetRenderHeight() };
 
-	// The command list can be reset anytime after ExecuteCommandList() is called.
-	DX::ThrowIfFailed(m_commandList->Reset(m_deviceResources->GetDirectCommandAllocator(), nullptr));
+	m_device->BeginFrame();
 
-	ID3D12DescriptorHeap* ppHeaps[] = { m_cbvSrvHeap.Get() };
-	m_commandList->SetDescriptorHeaps(_countof(ppHeaps), ppHeaps);
+	BeginFrameTimestamp();
 
-	m_commandList->SetGraphicsRootSignature(m_commonGraphicsRootSignature.Get());
-	m_commandList->SetComputeRootSignature(m_commonComputeRootSignature.Get());
-	
-	// Set root params
-	{
-		CD3DX12_GPU_DESCRIPTOR_HANDLE gpuHandle(m_cbvSrvHeap->GetGPUDescriptorHandleForHeapStart(), 0, m_cbvDescriptorSize);
-		m_commandList->SetGraphicsRootDescriptorTable(0, gpuHandle);
-	}
-	{
-		UINT samplerIndex = 0;
-		if (m_scalingType == ScalingType::Point)
-		{
-			samplerIndex = 0;
-		}
-		else if (m_scalingType == ScalingType::Linear)
-		{
-			samplerIndex = 1;
-		}
-		m_commandList->SetGraphicsRoot32BitConstant(1, samplerIndex, 0);
-	}
+	// Without updating, DLSS and XeSS leave what they last presented alone.
+	IUpscaler* upscaler = m_isUpdating ? GetUpscaler(m_scalingType) : nullptr;
 
-	// Pass 1
+	// Nothing writes the swap chain's target until the end of the frame, so its transition is split around
+	// the rest of the frame, which the GPU can run it alongside. Both halves stay in one command list, which
+	// estimating motion would break in two.
+	ID3D12Resource* swapChainTarget = m_deviceResources->GetSwapChainRenderTarget();
+	m_device->TrackResource(swapChainTarget, D3D12_RESOURCE_STATE_PRESENT);
+	bool isEstimatingMotion = upscaler && m_pipeline->GetMotionVectorSource() == MotionVectorSource::Estimated;
+	if ((!IsTemporalScalingType() || upscaler) && !isEstimatingMotion)
 	{
-		m_commandList->SetPipelineState(m_pass1PipelineState.Get());
-
-		// Set the viewport and scissor rectangle.
-		D3D12_VIEWPORT pass1Viewport = m_deviceResources->GetPass1Viewport();
-		m_commandList->RSSetViewports(1, &pass1Viewport);
-		m_commandList->RSSetScissorRects(1, &m_pass1ScissorRect);
-
-		{
-			CD3DX12_RESOURCE_BARRIER barrier =
-				CD3DX12_RESOURCE_BARRIER::Transition(m_deviceResources->GetIntermediateRenderTarget(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
-			m_commandList->ResourceBarrier(1, &barrier);
-		}
-
-		{
-			D3D12_CPU_DESCRIPTOR_HANDLE renderTargetView = m_deviceResources->GetIntermediateRenderTargetCpuDescriptor();
-			D3D12_CPU_DESCRIPTOR_HANDLE depthStencilView = m_deviceResources->GetDepthStencilView();
-
-			float cornflowerBlue[] = { 0.3f, 0.58f, 0.93f, 1.0f };
-			m_commandList->ClearRenderTargetView(renderTargetView, cornflowerBlue, 0, nullptr);
-			m_commandList->ClearDepthStencilView(depthStencilView, D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, nullptr);
-			m_commandList->OMSetRenderTargets(1, &renderTargetView, false, &depthStencilView);
-		}
-
-		m_commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-		m_commandList->IASetVertexBuffers(0, 1, &m_spinningCubeVertexBufferView);
-		m_commandList->IASetIndexBuffer(&m_spinningCubeIndexBufferView);
-		m_commandList->DrawIndexedInstanced(36, 1, 0, 0, 0);
-
+		bool isDrawing = !IsTemporalScalingType() || m_sharpness > 0.0f;
+		m_device->BeginStateTransition(swapChainTarget, isDrawing ? D3D12_RESOURCE_STATE_RENDER_TARGET : D3D12_RESOURCE_STATE_COPY_DEST);
 	}
 
-	// Pass 2
+	m_pipeline->RenderFrame(m_sceneConstants, renderSize, m_jitterOffset, upscaler);
+
 	if (m_scalingType == ScalingType::Point || m_scalingType == ScalingType::Linear)
 	{
-		m_commandList->SetPipelineState(m_pass2_TexturedQuad_PipelineState.Get());
-
-		// Set the viewport and scissor rectangle.
-		D3D12_VIEWPORT pass2Viewport = m_deviceResources->GetPass2Viewport();
-		m_commandList->RSSetViewports(1, &pass2Viewport);
-		m_commandList->RSSetScissorRects(1, &m_pass2ScissorRect);
-
-		{
-			CD3DX12_RESOURCE_BARRIER barrier =
-				CD3DX12_RESOURCE_BARRIER::Transition(m_deviceResources->GetIntermediateRenderTarget(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-			m_commandList->ResourceBarrier(1, &barrier);
-		}
-		{
-			CD3DX12_RESOURCE_BARRIER barrier =
-				CD3DX12_RESOURCE_BARRIER::Transition(m_deviceResources->GetSwapChainRenderTarget(), D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET);
-			m_commandList->ResourceBarrier(1, &barrier);
-		}
-		{
-			D3D12_CPU_DESCRIPTOR_HANDLE renderTargetView = m_deviceResources->GetSwapChainRenderTargetCpuDescriptor();
-
-			float cornflowerBlue[] = { 0.3f, 0.58f, 0.93f, 1.0f };
-			m_commandList->ClearRenderTargetView(renderTargetView, cornflowerBlue, 0, nullptr);
-			m_commandList->OMSetRenderTargets(1, &renderTargetView, false, nullptr);
-		}
-		m_commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-		m_commandList->IASetVertexBuffers(0, 1, &m_texturedQuadVertexBufferView);
-		m_commandList->IASetIndexBuffer(&m_texturedQuadIndexBufferView);
-		m_commandList->DrawIndexedInstanced(6, 1, 0, 0, 0);
-
-		{
-			CD3DX12_RESOURCE_BARRIER barrier =
-				CD3DX12_RESOURCE_BARRIER::Transition(m_deviceResources->GetSwapChainRenderTarget(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT);
-			m_commandList->ResourceBarrier(1, &barrier);
-		}
+		D3D12Image& color = static_cast<D3D12Image&>(m_pipeline->GetColor());
 
-		DX::ThrowIfFailed(m_commandList->Close());
-
-		// Execute the command list.
-		ID3D12CommandList* ppCommandLists[] = { m_commandList.Get() };
-		m_deviceResources->GetCommandQueue()->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
-
-		m_deviceResources->Present();
+		DrawConstants drawConstants{};
+		drawConstants.samplerIndex = m_scalingType == ScalingType::Point ? 0 : 1;
+		drawConstants.sharpness = m_sharpness;
+		drawConstants.outputTexelSize = XMFLOAT2(1.0f / g_scaling_destWidth, 1.0f / g_scaling_destHeight);
+		drawConstants.inputUvScale = XMFLOAT2(
+			static_cast<float>(renderSize.width) / g_scaling_sourceWidth,
+			static_cast<float>(renderSize.height) / g_scaling_sourceHeight);
+		drawConstants.inputUvMax = XMFLOAT2(
+			(renderSize.width - 0.5f) / g_scaling_sourceWidth,
+			(renderSize.height - 0.5f) / g_scaling_sourceHeight);
+		DrawTexturedQuadToSwapchain(color.GetSrvDescriptorIndex(), drawConstants);
 	}
-	else if (m_scalingType == ScalingType::DLSS)
+	else if (upscaler)
 	{
-		{
-			CD3DX12_RESOURCE_BARRIER barrier =
-				CD3DX12_RESOURCE_BARRIER::Transition(m_deviceResources->GetIntermediateRenderTarget(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-			m_commandList->ResourceBarrier(1, &barrier);
-		}
-
-		if (m_isUpdating)
-		{
-			EvaluateMotionVectors();
+		WriteUpscaledTargetToSwapchain();
+	}
 
-			{
-				CD3DX12_RESOURCE_BARRIER barrier =
-					CD3DX12_RESOURCE_BARRIER::Transition(m_upscaledTarget.Get(), D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
-				m_commandList->ResourceBarrier(1, &barrier);
-			}
-
-			NVSDK_NGX_Result Status{};
-
-			NVSDK_NGX_D3D12_DLSS_Eval_Params dlssEvalParams{};
-			dlssEvalParams.Feature.pInColor = m_deviceResources->GetIntermediateRenderTarget();
-			dlssEvalParams.Feature.pInOutput = m_upscaledTarget.Get(); // Looks like you can't upscale directly to a swapchain target.
-			dlssEvalParams.pInDepth = m_deviceResources->GetDepthStencil();
-			dlssEvalParams.Feature.InSharpness = m_dlssSharpness;
-			dlssEvalParams.pInMotionVectors = m_motionVectors.Get();
-			dlssEvalParams.pInExposureTexture = nullptr;
-			dlssEvalParams.pInBiasCurrentColorMask = nullptr;
-			dlssEvalParams.InJitterOffsetX = 0;
-			dlssEvalParams.InJitterOffsetY = 0;
-			dlssEvalParams.Feature.InSharpness = m_dlssSharpness;
-			dlssEvalParams.InReset = m_dlssReset;
-			dlssEvalParams.InMVScaleX = 1.0f;
-			dlssEvalParams.InMVScaleY = 1.0f;
-			dlssEvalParams.InRenderSubrectDimensions.Width = g_scaling_sourceWidth;
-			dlssEvalParams.InRenderSubrectDimensions.Height = g_scaling_sourceHeight;
-
-			Status = NGX_D3D12_EVALUATE_DLSS_EXT(
-				m_commandList.Get(),
-				m_dlssFeatureHandle,
-				m_ngxParameters,
-				&dlssEvalParams);
-
-			DX::ThrowIfNGXFailed(Status);
-
-			CopyUpscaledTargetToSwapchain();
-
-			CopyCurrentMotionVectorsToPrevious();
-		}
+	EndFrameTimestamp(renderSize);
+	m_device->EndFrame();
 
+	m_deviceResources->Present();
 
-		DX::ThrowIfFailed(m_commandList->Close());
+	return true;
+}
 
-		// Execute the command list.
-		ID3D12CommandList* ppCommandLists[] = { m_commandList.Get() };
-		m_deviceResources->GetCommandQueue()->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
+void Sample3DSceneRenderer::UpdateWindowTitleText()
+{
+	wchar_t const* scalingTypeText = L"";
+	switch (m_scalingType)
+	{
+	case ScalingType::Point: scalingTypeText = L"Scaling type: Point"; break;
+	case ScalingType::Linear: scalingTypeText = L"Scaling type: Linear"; break;
+	case ScalingType::DLSS: scalingTypeText = L"Scaling type: DLSS"; break;
+	case ScalingType::XeSS: scalingTypeText = L"Scaling type: XeSS"; break;
+	default:
+		assert(false);
+		scalingTypeText = L"Scaling type: <error>";
+	}
 
-		m_deviceResources->Present();
+	wchar_t sharpnessText[32];
+	if (m_sharpness > 0.0f)
+	{
+		swprintf_s(sharpnessText, L"%.1f", m_sharpness);
 	}
 	else
 	{
-		assert(m_scalingType == ScalingType::XeSS);
-
-		{
-			CD3DX12_RESOURCE_BARRIER barrier =
-				CD3DX12_RESOURCE_BARRIER::Transition(m_deviceResources->GetIntermediateRenderTarget(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
-			m_commandList->ResourceBarrier(1, &barrier);
-		}
+		swprintf_s(sharpnessText, L"off");
+	}
 
-		if (m_isUpdating)
-		{
-			EvaluateMotionVectors();
+	wchar_t const* jitterText = L"";
+	switch (m_jitterSequence.GetPattern())
+	{
+	case JitterPattern::None: jitterText = L"off"; break;
+	case JitterPattern::Halton23: jitterText = L"Halton(2,3)"; break;
+	case JitterPattern::R2: jitterText = L"R2"; break;
+	default:
+		assert(false);
+		jitterText = L"<error>";
+	}
+
+	wchar_t const* motionVectorText = m_pipeline->GetMotionVectorSource() == MotionVectorSource::Rendered ? L"rendered" : L"estimated";
+
+	wchar_t titleText[384];
+	swprintf_s(titleText, L"%s, Preset: %S, Sharpness: %s, Render size: %dx%d%s, Jitter: %s, Motion vectors: %s, Cubes: %d, Frame times: %S",
+		scalingTypeText,
+		GetQualityPresetName(m_qualityPreset),
+		sharpnessText,
+		m_dynamicResolution.GetRenderWidth(),
+		m_dynamicResolution.GetRenderHeight(),
+		m_isDynamicResolutionEnabled ? L" (dynamic)" : L"",
+		jitterText,
+		motionVectorText,
+		m_instanceCount,
+		m_frameTimesText.c_str());
+	SetWindowText(m_deviceResources->GetWindow(), titleText);
+}
 
-			// For XeSS:
-			//     - It wants source RGB in NON_PIXEL_SHADER_RESOURCE state
-			//     - It cares about depth stencil state
-			//     - It wants motion vectors to be in NON_PIXEL_SHADER_RESOURCE state
-			//     - It wants the target to be in UNORDERED_ACCESS state
+void Sample3DSceneRenderer::OnPressSpaceKey()
+{
+	m_isSpinning = !m_isSpinning;
+}
 
-			{
-				CD3DX12_RESOURCE_BARRIER barrier =
-					CD3DX12_RESOURCE_BARRIER::Transition(m_deviceResources->GetDepthStencil(), D3D12_RESOURCE_STATE_DEPTH_WRITE, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
-				m_commandList->ResourceBarrier(1, &barrier);
-			}
-			{
-				CD3DX12_RESOURCE_BARRIER barrier =
-					CD3DX12_RESOURCE_BARRIER::Transition(m_motionVectors.Get(), D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
-				m_commandList->ResourceBarrier(1, &barrier);
-			}
-			{
-				CD3DX12_RESOURCE_BARRIER barrier =
-					CD3DX12_RESOURCE_BARRIER::Transition(m_upscaledTarget.Get(), D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
-				m_commandList->ResourceBarrier(1, &barrier);
-			}
-
-			xess_d3d12_execute_params_t exec_params{};
-			exec_params.inputWidth = g_scaling_sourceWidth;
-			exec_params.inputHeight = g_scaling_sourceHeight;
-			exec_params.jitterOffsetX = 0;
-			exec_params.jitterOffsetY = 0;
-			exec_params.exposureScale = 1.0f;
-			exec_params.pColorTexture = m_deviceResources->GetIntermediateRenderTarget();
-			exec_params.pVelocityTexture = m_motionVectors.Get();
-			exec_params.pOutputTexture = m_upscaledTarget.Get();
-			exec_params.pDepthTexture = m_deviceResources->GetDepthStencil();
-			exec_params.pExposureScaleTexture = 0;
-			xess_result_t status = xessD3D12Execute(m_xessContext, m_commandList.Get(), &exec_params);
-			DX::ThrowIfXeSSFailed(status);
-
-			CopyUpscaledTargetToSwapchain();
-
-			// Set things up for the next frame
-			{
-				CD3DX12_RESOURCE_BARRIER barrier =
-					CD3DX12_RESOURCE_BARRIER::Transition(m_deviceResources->GetDepthStencil(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_DEPTH_WRITE);
-				m_commandList->ResourceBarrier(1, &barrier);
-			}
+void Sample3DSceneRenderer::OnPressUKey()
+{
+	m_isUpdating = !m_isUpdating;
+}
 
-			CopyCurrentMotionVectorsToPrevious();
-			{
-				CD3DX12_RESOURCE_BARRIER barrier =
-					CD3DX12_RESOURCE_BARRIER::Transition(m_motionVectors.Get(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COMMON);
-				m_commandList->ResourceBarrier(1, &barrier);
-			}
-		}
+void Sample3DSceneRenderer::OnPressRKey()
+{
+	m_isDynamicResolutionEnabled = !m_isDynamicResolutionEnabled;
 
-		{ // It is possible to optimize this out
-			CD3DX12_RESOURCE_BARRIER barrier =
-				CD3DX12_RESOURCE_BARRIER::Transition(m_deviceResources->GetIntermediateRenderTarget(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-			m_commandList->ResourceBarrier(1, &barrier);
-		}
+	// Either way, start again from the full size.
+	m_dynamicResolution.Reset();
+	UpdateWindowTitleText();
+}
 
-		DX::ThrowIfFailed(m_commandList->Close());
+void Sample3DSceneRenderer::OnPressJKey()
+{
+	int next = static_cast<int>(m_jitterSequence.GetPattern()) + 1;
+	if (next == static_cast<int>(JitterPattern::NumJitterPatterns))
+	{
+		next = 0;
+	}
+	m_jitterSequence.SetPattern(static_cast<JitterPattern>(next));
 
-		// Execute the command list.
-		ID3D12CommandList* ppCommandLists[] = { m_commandList.Get() };
-		m_deviceResources->GetCommandQueue()->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
+	// Start the new pattern from its first phase.
+	m_jitterFrameNumber = 0;
+	UpdateWindowTitleText();
+}
 
-		m_deviceResources->Present();
+void Sample3DSceneRenderer::OnPressQKey()
+{
+	int next = static_cast<int>(m_qualityPreset) + 1;
+	if (next == static_cast<int>(QualityPreset::NumQualityPresets))
+	{
+		next = 0;
 	}
+	m_qualityPreset = static_cast<QualityPreset>(next);
 
-	return true;
+	ApplyQualityPreset();
 }
 
-void Sample3DSceneRenderer::UpdateWindowTitleText()
+// Estimated motion vectors need the video motion estimator, so they're only offered where it's supported.
+void Sample3DSceneRenderer::OnPressMKey()
 {
-	wchar_t const* titleText = L"";
-	switch (m_scalingType)
+	if (m_pipeline->GetMotionVectorSource() == MotionVectorSource::Rendered && m_device->IsMotionEstimationSupported())
 	{
-	case ScalingType::Point: titleText = L"Scaling type: Point"; break;
-	case ScalingType::Linear: titleText = L"Scaling type: Linear"; break;
-	case ScalingType::DLSS: titleText = L"Scaling type: DLSS"; break;
-	case ScalingType::XeSS: titleText = L"Scaling type: XeSS"; break;
-	default:
-		assert(false);
-		titleText = L"Scaling type: <error>";
+		m_pipeline->SetMotionVectorSource(MotionVectorSource::Estimated);
 	}
-	SetWindowText(m_deviceResources->GetWindow(), titleText);
+	else
+	{
+		m_pipeline->SetMotionVectorSource(MotionVectorSource::Rendered);
+	}
+
+	// DLSS and XeSS are told whether the motion vectors include the jitter when they're set up, which
+	// nothing can still be using.
+	bool areMotionVectorsJittered = m_pipeline->GetMotionVectorSource() == MotionVectorSource::Estimated;
+	m_deviceResources->WaitForGpuOnDirectQueue();
+	if (m_dlssUpscaler)
+	{
+		m_dlssUpscaler->SetMotionVectorsJittered(areMotionVectorsJittered);
+	}
+	m_xessUpscaler->SetMotionVectorsJittered(areMotionVectorsJittered);
+	UpdateWindowTitleText();
 }
 
-void Sample3DSceneRenderer::OnPressSpaceKey()
+// Steps the number of cubes up by a factor of 10, up to the most the scene can have, and then back to one.
+void Sample3DSceneRenderer::OnPressNKey()
 {
-	m_isSpinning = !m_isSpinning;
+	m_instanceCount = m_instanceCount >= c_maxSceneInstanceCount ? 1 : m_instanceCount * 10;
+	m_device->SetSceneInstances(CreateInstancedScene(m_instanceCount));
+
+	// Nothing in the last frame is where it was.
+	m_pipeline->ResetHistory();
+	UpdateWindowTitleText();
 }
 
-void Sample3DSceneRenderer::OnPressUKey()
+bool Sample3DSceneRenderer::LoadSceneMesh(std::string const& path, std::string& error)
 {
-	m_isUpdating = !m_isUpdating;
+	MeshFile meshFile;
+	if (!meshFile.Open(path, error))
+	{
+		return false;
+	}
+	m_device->SetSceneMesh(meshFile.GetView());
+	m_pipeline->ResetHistory();
+	return true;
 }
 
 void Sample3DSceneRenderer::OnPressLeftKey()
@@ -1288,6 +698,7 @@ void Sample3DSceneRenderer::OnPressLeftKey()
 	{
 		m_scalingType = static_cast<ScalingType>((int)m_scalingType - 1);
 	}
+	ResetRenderSize();
 	UpdateWindowTitleText();
 }
 
@@ -1302,5 +713,26 @@ void Sample3DSceneRenderer::OnPressRightKey()
 		m_scalingType = static_cast<ScalingType>((int)m_scalingType + 1);
 	}
 
+	ResetRenderSize();
+	UpdateWindowTitleText();
+}
+
+void Sample3DSceneRenderer::OnPressUpKey()
+{
+	m_sharpness += 0.1f;
+	if (m_sharpness > 1.0f)
+	{
+		m_sharpness = 1.0f;
+	}
+	UpdateWindowTitleText();
+}
+
+void Sample3DSceneRenderer::OnPressDownKey()
+{
+	m_sharpness -= 0.1f;
+	if (m_sharpness < 0.05f)
+	{
+		m_sharpness = 0.0f; // Off. Also keeps float rounding from leaving a tiny non-zero value behind.
+	}
 	UpdateWindowTitleText();
 }
\ No newline at end of file
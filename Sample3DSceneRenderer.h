@@ -1,6 +1,11 @@
 ﻿#pragma once
 
+#include "D3D12Backend.h"
 #include "DeviceResources.h"
+#include "DynamicResolution.h"
+#include "JitterSequence.h"
+#include "QualityPreset.h"
+#include "ScalingPipeline.h"
 #include "ShaderStructures.h"
 #include "StepTimer.h"
 
@@ -16,7 +21,8 @@ namespace scaling
 	};
 
 
-	// This sample renderer instantiates a basic rendering pipeline.
+	// This sample renderer drives a ScalingPipeline on a D3D12Device, and presents its output. Point and
+	// Linear scaling happen as part of presenting, so they don't go through an upscaler.
 	class Sample3DSceneRenderer
 	{
 	public:
@@ -29,41 +35,47 @@ namespace scaling
 		void OnPressSpaceKey();
 		void OnPressLeftKey();
 		void OnPressRightKey();
+		void OnPressUpKey();
+		void OnPressDownKey();
 		void OnPressUKey();
+		void OnPressRKey();
+		void OnPressJKey();
+		void OnPressQKey();
+		void OnPressMKey();
+		void OnPressNKey();
+
+		// Maps the file only for as long as it takes to copy it into an upload buffer.
+		bool LoadSceneMesh(std::string const& path, std::string& error);
+
+		// The GPU time of the most recent frame whose timestamps have been read, a few frames back.
+		double GetLastGpuSeconds() const { return m_lastGpuSeconds; }
 
 	private:
 		void Rotate(float radians);
+		void UpdateJitteredProjection();
+		bool IsTemporalScalingType() const;
+		IUpscaler* GetUpscaler(ScalingType scalingType) const;
 		void UpdateWindowTitleText();
-		void EvaluateMotionVectors();
-		void CopyCurrentMotionVectorsToPrevious();
-		void CopyUpscaledTargetToSwapchain();
+		void WriteUpscaledTargetToSwapchain();
+		void DrawTexturedQuadToSwapchain(UINT srvDescriptorIndex, DrawConstants const& drawConstants);
+		void BeginFrameTimestamp();
+		void EndFrameTimestamp(RenderSize renderSize);
+		void ReadFrameTimestamp();
+		RenderSize GetOptimalRenderSize(ScalingType scalingType) const;
+		void ApplyQualityPreset();
+		void ResetRenderSize();
 
 	private:
-		// Constant buffers must be 256-byte aligned.
-		static const UINT c_alignedConstantBufferSize = (sizeof(ModelViewProjectionConstantBuffer) + 255) & ~255;
-
 		// Cached pointer to device resources.
 		std::shared_ptr<DX::DeviceResources> m_deviceResources;
 
-		// Direct3D resources for cube geometry.
-		Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList>	m_commandList;
-		Microsoft::WRL::ComPtr<ID3D12DescriptorHeap>		m_srvHeap;
-		Microsoft::WRL::ComPtr<ID3D12Resource>				m_constantBuffer;
-		ModelViewProjectionConstantBuffer					m_constantBufferData;
-		UINT8*												m_mappedConstantBuffer;
-		UINT												m_cbvDescriptorSize;
-
-		Microsoft::WRL::ComPtr<ID3D12RootSignature>			m_commonGraphicsRootSignature;
-		Microsoft::WRL::ComPtr<ID3D12RootSignature>			m_commonComputeRootSignature;
-
-		Microsoft::WRL::ComPtr<ID3D12DescriptorHeap>		m_cbvSrvHeap;
+		// Everything before presenting.
+		std::unique_ptr<D3D12Device>						m_device;
+		std::unique_ptr<ScalingPipeline>					m_pipeline;
+		std::unique_ptr<DlssUpscaler>						m_dlssUpscaler;
+		std::unique_ptr<XessUpscaler>						m_xessUpscaler;
 
-		D3D12_RECT											m_pass1ScissorRect;
-		Microsoft::WRL::ComPtr<ID3D12PipelineState>			m_pass1PipelineState;
-		Microsoft::WRL::ComPtr<ID3D12Resource>				m_spinningCubeVertexBuffer;
-		Microsoft::WRL::ComPtr<ID3D12Resource>				m_spinningCubeIndexBuffer;
-		D3D12_VERTEX_BUFFER_VIEW							m_spinningCubeVertexBufferView;
-		D3D12_INDEX_BUFFER_VIEW								m_spinningCubeIndexBufferView;
+		SceneConstants										m_sceneConstants;
 
 		D3D12_RECT											m_pass2ScissorRect;
 		Microsoft::WRL::ComPtr<ID3D12PipelineState>			m_pass2_TexturedQuad_PipelineState;
@@ -82,24 +94,34 @@ namespace scaling
 		bool m_isSpinning;
 		bool m_isUpdating;
 
-		Microsoft::WRL::ComPtr<ID3D12Resource>				 m_upscaledTarget;
-		Microsoft::WRL::ComPtr<ID3D12VideoEncodeCommandList> m_videoEncodeCommandList;
-		Microsoft::WRL::ComPtr<ID3D12VideoMotionEstimator>   m_videoMotionEstimator;
-		Microsoft::WRL::ComPtr<ID3D12VideoMotionVectorHeap>  m_videoMotionVectorHeap;
-		Microsoft::WRL::ComPtr<ID3D12PipelineState>		     m_pass2_YuvConversion_PipelineState;
-		Microsoft::WRL::ComPtr<ID3D12Resource>				 m_motionVectors;
-		Microsoft::WRL::ComPtr<ID3D12Resource>				 m_currentYuv;
-		Microsoft::WRL::ComPtr<ID3D12Resource>				 m_previousYuv;
-
-		// DLSS-related things
-		bool                                                 m_dlssSupported;
-		NVSDK_NGX_Parameter*                                 m_ngxParameters{};
-		NVSDK_NGX_Handle*                                    m_dlssFeatureHandle;
-		float                                                m_dlssSharpness;
-		int												     m_dlssReset;
-
-		// XeSS-related things
-		xess_context_handle_t								 m_xessContext = nullptr;
+		// Cubes in the scene. 1 is the single spinning cube.
+		int m_instanceCount;
+
+		// Applied to the output of every scaling type. 0 turns sharpening off.
+		float m_sharpness;
+
+		// Sizes the part of the intermediate target that pass 1 renders to. Fed with the GPU time of each
+		// frame, measured with a pair of timestamps.
+		QualityPreset										m_qualityPreset;
+		DynamicResolutionController							m_dynamicResolution;
+		bool												m_isDynamicResolutionEnabled;
+		Microsoft::WRL::ComPtr<ID3D12QueryHeap>				m_timestampQueryHeap; // Two per frame: start, end
+		Microsoft::WRL::ComPtr<ID3D12Resource>				m_timestampReadback;
+		bool												m_timestampPending[DX::c_frameCount];
+		RenderSize											m_timestampRenderSizes[DX::c_frameCount];
+		UINT64												m_timestampFrequency;
+		double												m_lastGpuSeconds;
+
+		// For the title, over the last whole second the timer has measured.
+		uint64												m_titleSecond;
+		std::string											m_frameTimesText;
+
+		// Sub-pixel jitter, for the scaling types that accumulate samples over frames. m_projection is
+		// the projection before jitter is applied to it.
+		JitterSequence										m_jitterSequence;
+		uint32_t											m_jitterFrameNumber;
+		JitterOffset										m_jitterOffset;
+		Float4x4											m_projection;
 	};
 }
 
@@ -0,0 +1,351 @@
+#include "ScalingFrameGraph.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <unordered_map>
+
+using namespace scaling;
+
+namespace
+{
+	// Stands for one of ScalingPipeline's images, named after what the first pass to write it writes.
+	class RecordedImage : public IImage
+	{
+	public:
+		RecordedImage(ImageFormat format, int width, int height) : m_format(format), m_width(width), m_height(height), m_name(nullptr) {}
+
+		ImageFormat GetFormat() const override { return m_format; }
+		int GetWidth() const override { return m_width; }
+		int GetHeight() const override { return m_height; }
+
+		char const* GetName() const { return m_name; }
+		void SetName(char const* name) { m_name = m_name ? m_name : name; }
+
+	private:
+		ImageFormat m_format;
+		int m_width;
+		int m_height;
+		char const* m_name;
+	};
+
+	struct RecordedAccess
+	{
+		RecordedImage* image;
+		ImageAccess access;
+		bool isWrite;
+	};
+
+	struct RecordedPass
+	{
+		char const* name;
+		int frame;
+		std::vector<RecordedAccess> accesses;
+	};
+
+	// A device that runs nothing, and only notes the passes ScalingPipeline records into it and the images
+	// they use, for the frame graph to be built from. Footprints and states are the real device's.
+	class FrameGraphRecorder : public IDevice
+	{
+	public:
+		explicit FrameGraphRecorder(IDevice const& device) : m_device(device), m_frame(0) {}
+
+		std::vector<RecordedPass> const& GetPasses() const { return m_passes; }
+
+		// As the caller presents the output after the frame.
+		void WriteToSwapChain(IImage& output)
+		{
+			AddPass("Write to swap chain", { Read(output, ImageAccess::PixelShaderRead) });
+		}
+
+		void Upscale(bool isTemporal, UpscaleInputs const& inputs, IImage& output)
+		{
+			// As DLSS and XeSS read and write them.
+			if (isTemporal)
+			{
+				AddPass("Upscaling", {
+					Read(*inputs.color, ImageAccess::NonPixelShaderRead),
+					Read(*inputs.depth, ImageAccess::NonPixelShaderRead),
+					Read(*inputs.motionVectors, ImageAccess::NonPixelShaderRead),
+					Write(output, ImageAccess::UnorderedAccess, "Output") });
+			}
+			else
+			{
+				AddPass("Upscaling", {
+					Read(*inputs.color, ImageAccess::PixelShaderRead),
+					Write(output, ImageAccess::RenderTarget, "Output") });
+			}
+		}
+
+		std::unique_ptr<IImage> CreateImage(ImageFormat format, int width, int height) override { return std::make_unique<RecordedImage>(format, width, height); }
+		ResourceFootprint GetImageFootprint(ImageFormat format, int width, int height) const override { return m_device.GetImageFootprint(format, width, height); }
+		uint32_t GetRestingState(ImageFormat format) const override { return m_device.GetRestingState(format); }
+		uint32_t GetImageState(ImageAccess access) const override { return m_device.GetImageState(access); }
+		uint32_t GetReadStates() const override { return m_device.GetReadStates(); }
+
+		void SetSceneMesh(SceneMeshView const&) override {}
+		void SetSceneInstances(std::vector<SceneInstance> const&) override {}
+
+		void BeginFrame() override {}
+		void EndFrame() override { ++m_frame; }
+
+		int GetFrameCount() const override { return 1; }
+		int GetFrameIndex() const override { return 0; }
+
+		void RenderScene(SceneConstants const&, SceneConstants const&, RenderSize, IImage& color, IImage& depth, IImage* motionVectors) override
+		{
+			std::vector<RecordedAccess> accesses = { Write(color, ImageAccess::RenderTarget, "Color"), Write(depth, ImageAccess::DepthWrite, "Depth") };
+			if (motionVectors)
+			{
+				accesses.push_back(Write(*motionVectors, ImageAccess::RenderTarget, "Motion vectors"));
+			}
+			AddPass("Pass 1", std::move(accesses));
+		}
+
+		void ConvertToLuma(IImage& color, RenderSize, IImage& luma) override
+		{
+			AddPass("Luma conversion", { Read(color, ImageAccess::UnorderedAccess), Write(luma, ImageAccess::UnorderedAccess, "Luma") });
+		}
+
+		void EstimateMotion(IImage& current, IImage& previous, RenderSize, IImage& motionVectors) override
+		{
+			AddPass("Motion estimation", {
+				Read(current, ImageAccess::VideoEncodeRead),
+				Read(previous, ImageAccess::VideoEncodeRead),
+				Write(motionVectors, ImageAccess::VideoEncodeWrite, "Motion vectors") });
+		}
+
+		// The plan is of one frame, whichever queue its passes run on.
+		bool HasVideoQueue() const override { return false; }
+		void WaitForMotionEstimation() override {}
+
+	private:
+		static RecordedAccess Read(IImage& image, ImageAccess access)
+		{
+			return RecordedAccess{ &static_cast<RecordedImage&>(image), access, false };
+		}
+
+		static RecordedAccess Write(IImage& image, ImageAccess access, char const* name)
+		{
+			RecordedImage& recorded = static_cast<RecordedImage&>(image);
+			recorded.SetName(name);
+			return RecordedAccess{ &recorded, access, true };
+		}
+
+		void AddPass(char const* name, std::vector<RecordedAccess> accesses)
+		{
+			m_passes.push_back(RecordedPass{ name, m_frame, std::move(accesses) });
+		}
+
+		IDevice const& m_device;
+		std::vector<RecordedPass> m_passes;
+		int m_frame;
+	};
+
+	class RecordedUpscaler : public IUpscaler
+	{
+	public:
+		RecordedUpscaler(FrameGraphRecorder& recorder, bool isTemporal) : m_recorder(recorder), m_isTemporal(isTemporal) {}
+
+		bool IsTemporal() const override { return m_isTemporal; }
+		void SetQualityPreset(QualityPreset) override {}
+		RenderSize GetOptimalInputSize(int outputWidth, int outputHeight) override { return RenderSize{ outputWidth, outputHeight }; }
+		void Upscale(UpscaleInputs const& inputs, IImage& output) override { m_recorder.Upscale(m_isTemporal, inputs, output); }
+
+	private:
+		FrameGraphRecorder& m_recorder;
+		bool m_isTemporal;
+	};
+
+	// Whether the passes of the frame read the image before they write it, or write it without reading it,
+	// or don't use it.
+	enum class FirstUse
+	{
+		None,
+		Read,
+		Write
+	};
+
+	FirstUse GetFirstUse(std::vector<RecordedPass> const& passes, int frame, RecordedImage const* image)
+	{
+		for (RecordedPass const& pass : passes)
+		{
+			for (RecordedAccess const& access : pass.accesses)
+			{
+				if (pass.frame == frame && access.image == image)
+				{
+					return access.isWrite ? FirstUse::Write : FirstUse::Read;
+				}
+			}
+		}
+		return FirstUse::None;
+	}
+	double ToMegabytes(uint64_t bytes)
+	{
+		return bytes / (1024.0 * 1024.0);
+	}
+
+	// The first pass, in the plan's order, during which every transient is in use, so that aliasing can't
+	// save anything. -1 if there's none.
+	int FindPassUsingEveryTransient(FrameGraph const& graph, FrameGraphPlan const& plan)
+	{
+		std::vector<FrameGraph::Resource> const& resources = graph.GetResources();
+		for (int position = 0; position < static_cast<int>(plan.passes.size()); ++position)
+		{
+			bool isEveryTransientInUse = true;
+			for (size_t resource = 0; resource < resources.size() && isEveryTransientInUse; ++resource)
+			{
+				PlannedResource const& planned = plan.resources[resource];
+				isEveryTransientInUse = !resources[resource].isTransient || planned.firstPass < 0 ||
+					(planned.firstPass <= position && position <= planned.lastPass);
+			}
+			if (isEveryTransientInUse)
+			{
+				return position;
+			}
+		}
+		return -1;
+	}
+}
+
+FrameGraph scaling::BuildScalingFrameGraph(
+	IDevice const& device,
+	bool isTemporal,
+	MotionVectorSource motionVectorSource,
+	int maxRenderWidth,
+	int maxRenderHeight,
+	int outputWidth,
+	int outputHeight)
+{
+	// Three frames, so that the middle one has history from the first and keeps history for the last.
+	FrameGraphRecorder recorder(device);
+	RecordedUpscaler upscaler(recorder, isTemporal);
+	ScalingPipeline pipeline(recorder, maxRenderWidth, maxRenderHeight, outputWidth, outputHeight);
+	pipeline.SetMotionVectorSource(motionVectorSource);
+	for (int frame = 0; frame < 3; ++frame)
+	{
+		recorder.BeginFrame();
+		pipeline.RenderFrame(SceneConstants(), RenderSize{ maxRenderWidth, maxRenderHeight }, JitterOffset(), &upscaler);
+		recorder.WriteToSwapChain(pipeline.GetOutput());
+		recorder.EndFrame();
+	}
+
+	const int c_frame = 1;
+	std::vector<RecordedPass> const& passes = recorder.GetPasses();
+	std::vector<RecordedImage*> images; // In the order the frame first uses them
+	for (RecordedPass const& pass : passes)
+	{
+		for (RecordedAccess const& access : pass.accesses)
+		{
+			if (pass.frame == c_frame && std::find(images.begin(), images.end(), access.image) == images.end())
+			{
+				images.push_back(access.image);
+			}
+		}
+	}
+
+	// What the frame reads before writing is the last frame's history, and what it writes that the next frame
+	// reads before writing is its own. They pair up by format, as the luma does. Images start the frame in the
+	// states they rest in between passes.
+	FrameGraph graph(device.GetReadStates());
+	std::unordered_map<RecordedImage const*, int> resources;
+	for (RecordedImage* image : images)
+	{
+		ResourceFootprint footprint = device.GetImageFootprint(image->GetFormat(), image->GetWidth(), image->GetHeight());
+		uint32_t restingState = device.GetRestingState(image->GetFormat());
+		if (GetFirstUse(passes, c_frame, image) == FirstUse::Write && GetFirstUse(passes, c_frame + 1, image) == FirstUse::Read)
+		{
+			auto lastFrame = std::find_if(images.begin(), images.end(), [&](RecordedImage const* other)
+			{
+				return other->GetFormat() == image->GetFormat() && !resources.count(other) && GetFirstUse(passes, c_frame, other) == FirstUse::Read;
+			});
+			if (lastFrame != images.end())
+			{
+				FrameGraph::HistoryPair pair = graph.AddHistoryPair(image->GetName(), footprint, restingState);
+				resources[image] = pair.current;
+				resources[*lastFrame] = pair.previous;
+			}
+			else
+			{
+				resources[image] = graph.AddPersistent(image->GetName(), footprint, restingState);
+			}
+		}
+		else if (!resources.count(image))
+		{
+			resources[image] = GetFirstUse(passes, c_frame, image) == FirstUse::Read ?
+				graph.AddPersistent(image->GetName(), footprint, restingState) :
+				graph.AddTransient(image->GetName(), footprint, restingState);
+		}
+	}
+
+	for (RecordedPass const& pass : passes)
+	{
+		if (pass.frame == c_frame)
+		{
+			int graphPass = graph.AddPass(pass.name);
+			for (RecordedAccess const& access : pass.accesses)
+			{
+				if (access.isWrite)
+				{
+					graph.Write(graphPass, resources[access.image], device.GetImageState(access.access));
+				}
+				else
+				{
+					graph.Read(graphPass, resources[access.image], device.GetImageState(access.access));
+				}
+			}
+		}
+	}
+	return graph;
+}
+
+std::string scaling::FormatScalingFrameGraphReport(IDevice const& device, int maxRenderWidth, int maxRenderHeight, int outputWidth, int outputHeight)
+{
+	struct Configuration
+	{
+		char const* name;
+		bool isTemporal;
+		MotionVectorSource motionVectorSource;
+	};
+	const Configuration configurations[] =
+	{
+		{ "Spatial", false, MotionVectorSource::Rendered },
+		{ "Temporal, rendered motion", true, MotionVectorSource::Rendered },
+		{ "Temporal, estimated motion", true, MotionVectorSource::Estimated },
+	};
+
+	std::string report;
+	for (Configuration const& configuration : configurations)
+	{
+		FrameGraph graph = BuildScalingFrameGraph(device, configuration.isTemporal, configuration.motionVectorSource,
+			maxRenderWidth, maxRenderHeight, outputWidth, outputHeight);
+
+		char text[256];
+		FrameGraphPlan plan;
+		std::string error;
+		if (!PlanFrameGraph(graph, plan, error))
+		{
+			snprintf(text, sizeof(text), "Frame graph, %s: %s", configuration.name, error.c_str());
+		}
+		else
+		{
+			int transientCount = 0;
+			size_t barrierCount = plan.finalBarriers.size();
+			for (FrameGraph::Resource const& resource : graph.GetResources())
+			{
+				transientCount += resource.isTransient ? 1 : 0;
+			}
+			for (PlannedPass const& pass : plan.passes)
+			{
+				barrierCount += pass.barriers.size();
+			}
+			int crowdedPass = FindPassUsingEveryTransient(graph, plan);
+			snprintf(text, sizeof(text), "Frame graph, %s: %zu passes, %d transients, %zu barriers, %.2f MB peak, %.2f MB with transients aliased%s%s",
+				configuration.name, plan.passes.size(), transientCount, barrierCount,
+				ToMegabytes(plan.GetPeakBytes()), ToMegabytes(plan.GetAliasedPeakBytes()),
+				crowdedPass >= 0 ? ", since they're all in use during " : "",
+				crowdedPass >= 0 ? graph.GetPasses()[plan.passes[crowdedPass].pass].name.c_str() : "");
+		}
+		report += report.empty() ? text : std::string("\n") + text;
+	}
+	return report;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "Backend.h"
+#include "FrameGraph.h"
+#include "ScalingPipeline.h"
+
+#include <string>
+
+namespace scaling
+{
+	// ScalingPipeline's frame as a frame graph, with the images it creates for the sizes. The passes are the
+	// ones ScalingPipeline records, into a device that only notes them, followed by writing the output to the
+	// swap chain, so the graph follows the pipeline. Without an upscaler, or with a spatial one, isTemporal
+	// is false. States are the device's, so with D3D12Device the plan's barriers are the ones it records.
+	// What a frame reads that the last frame wrote, the luma, is a history pair; the rest are transient.
+	//
+	// The plan is only reported: the pipeline still creates each image with CreateImage and the device works
+	// out its own barriers.
+	FrameGraph BuildScalingFrameGraph(
+		IDevice const& device,
+		bool isTemporal,
+		MotionVectorSource motionVectorSource,
+		int maxRenderWidth,
+		int maxRenderHeight,
+		int outputWidth,
+		int outputHeight);
+
+	// One line for each of spatial upscaling, and temporal upscaling with rendered and estimated motion:
+	// how many passes and transients there are, and the peak memory of the images with every transient in
+	// memory of its own and with them aliased in one heap, and when those are the same, the pass that uses
+	// every transient at once.
+	std::string FormatScalingFrameGraphReport(IDevice const& device, int maxRenderWidth, int maxRenderHeight, int outputWidth, int outputHeight);
+}
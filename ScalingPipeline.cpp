@@ -0,0 +1,121 @@
+#include "ScalingPipeline.h"
+
+using namespace scaling;
+
+ScalingPipeline::ScalingPipeline(IDevice& device, int maxRenderWidth, int maxRenderHeight, int outputWidth, int outputHeight)
+	: m_device(device)
+	, m_frameNumber(0)
+	, m_isUpscalePending(false)
+	, m_pendingUpscaler(nullptr)
+	, m_pendingInputs()
+	, m_pendingFrameNumber(0)
+	, m_outputFrameNumber(-1)
+	, m_previousLumaIndex(0)
+	, m_motionVectorSource(MotionVectorSource::Rendered)
+	, m_hasHistory(false)
+	, m_previousConstants()
+	, m_lastUpscaler(nullptr)
+{
+	m_frames.resize(device.GetFrameCount() + 1);
+	for (FrameImages& frame : m_frames)
+	{
+		frame.color = device.CreateImage(ImageFormat::Bgra8, maxRenderWidth, maxRenderHeight);
+		frame.depth = device.CreateImage(ImageFormat::Depth32, maxRenderWidth, maxRenderHeight);
+		frame.motionVectors = device.CreateImage(ImageFormat::MotionVectors, maxRenderWidth, maxRenderHeight);
+		frame.output = device.CreateImage(ImageFormat::Bgra8, outputWidth, outputHeight);
+	}
+
+	m_luma.resize(m_frames.size() + 1);
+	for (std::unique_ptr<IImage>& luma : m_luma)
+	{
+		luma = device.CreateImage(ImageFormat::Luma, maxRenderWidth, maxRenderHeight);
+	}
+}
+
+void ScalingPipeline::SetMotionVectorSource(MotionVectorSource source)
+{
+	if (source != m_motionVectorSource)
+	{
+		m_motionVectorSource = source;
+		m_hasHistory = false;
+	}
+}
+
+void ScalingPipeline::RenderFrame(SceneConstants const& constants, RenderSize renderSize, JitterOffset jitter, IUpscaler* upscaler)
+{
+	// History left by another upscaler may be from long ago. Changes of render size keep history, since
+	// temporal upscalers expect the size to move around with dynamic resolution.
+	if (upscaler != m_lastUpscaler)
+	{
+		m_hasHistory = false;
+	}
+	m_lastUpscaler = upscaler;
+
+	bool isTemporal = upscaler && upscaler->IsTemporal();
+	bool isRenderingMotion = isTemporal && m_motionVectorSource == MotionVectorSource::Rendered;
+	bool isEstimatingMotion = isTemporal && m_motionVectorSource == MotionVectorSource::Estimated;
+
+	int frameNumber = m_frameNumber++;
+	FrameImages& frame = GetFrame(frameNumber);
+
+	// Without history, measuring motion against this frame itself gives no motion.
+	SceneConstants const& previousConstants = m_hasHistory ? m_previousConstants : constants;
+	m_device.RenderScene(constants, previousConstants, renderSize, *frame.color, *frame.depth, isRenderingMotion ? frame.motionVectors.get() : nullptr);
+	m_previousConstants = constants;
+
+	if (isEstimatingMotion)
+	{
+		int lumaIndex = (m_previousLumaIndex + 1) % static_cast<int>(m_luma.size());
+		m_device.ConvertToLuma(*frame.color, renderSize, *m_luma[lumaIndex]);
+		if (m_hasHistory)
+		{
+			m_device.EstimateMotion(*m_luma[lumaIndex], *m_luma[m_previousLumaIndex], renderSize, *frame.motionVectors);
+		}
+		m_previousLumaIndex = lumaIndex;
+	}
+
+	// The last frame's, now that this frame's pass 1 is ahead of it.
+	FinishUpscaling();
+
+	if (!upscaler)
+	{
+		return;
+	}
+
+	UpscaleInputs inputs = {};
+	inputs.color = frame.color.get();
+	inputs.depth = frame.depth.get();
+	inputs.motionVectors = frame.motionVectors.get();
+	inputs.renderSize = renderSize;
+	inputs.jitter = jitter;
+	inputs.reset = !m_hasHistory;
+	m_hasHistory = isTemporal;
+
+	if (isEstimatingMotion && m_device.HasVideoQueue())
+	{
+		m_isUpscalePending = true;
+		m_pendingUpscaler = upscaler;
+		m_pendingInputs = inputs;
+		m_pendingFrameNumber = frameNumber;
+	}
+	else
+	{
+		Upscale(*upscaler, inputs, frameNumber);
+	}
+}
+
+void ScalingPipeline::FinishUpscaling()
+{
+	if (m_isUpscalePending)
+	{
+		m_isUpscalePending = false;
+		m_device.WaitForMotionEstimation();
+		Upscale(*m_pendingUpscaler, m_pendingInputs, m_pendingFrameNumber);
+	}
+}
+
+void ScalingPipeline::Upscale(IUpscaler& upscaler, UpscaleInputs const& inputs, int frameNumber)
+{
+	upscaler.Upscale(inputs, *GetFrame(frameNumber).output);
+	m_outputFrameNumber = frameNumber;
+}
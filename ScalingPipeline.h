@@ -0,0 +1,102 @@
+#pragma once
+
+#include "Backend.h"
+
+#include <algorithm>
+
+namespace scaling
+{
+	enum class MotionVectorSource
+	{
+		Rendered,	// Pass 1 writes exact motion vectors from this frame's and last frame's transforms.
+		Estimated	// Motion estimation on the luma of the rendered frames.
+	};
+
+	// The order that passes run in each frame, independent of the device that runs them:
+	//
+	//     pass 1 -> [luma conversion -> motion estimation] -> upscaling
+	//
+	// For temporal upscalers, pass 1 writes motion vectors along with color and depth. With estimated motion
+	// vectors instead, luma conversion and motion estimation run after it, and the luma of each frame is kept
+	// for the next frame to estimate motion against.
+	//
+	// Where the device estimates motion on a video queue, a frame's upscaling is recorded in the next frame,
+	// after that frame's pass 1 and motion estimation, and waits for the motion vectors there. The direct
+	// queue then has the next pass 1 to run while the video queue estimates motion, for a frame more latency.
+	//
+	// So that a frame's images outlive the frame when its upscaling is late, color, depth, motion vectors
+	// and output are kept in a ring with one more set than the device can have frames in flight, and each
+	// frame renders into the set after the last frame's. The luma is a ring of its own with one more image
+	// again, since the motion estimation that reads the last two may still be running while the next frame
+	// converts: the frame converts into the image after the last frame's, which then becomes the history,
+	// so nothing is copied.
+	class ScalingPipeline
+	{
+	public:
+		// Images are allocated at the largest render size and the output size, and never reallocated.
+		// Allocates the images for every frame in flight, so the device's frame count has to be final.
+		ScalingPipeline(IDevice& device, int maxRenderWidth, int maxRenderHeight, int outputWidth, int outputHeight);
+
+		// Records one frame into the device, between its BeginFrame and EndFrame, along with the last frame's
+		// upscaling if that was left for this one. With no upscaler, stops after pass 1 and leaves presenting
+		// GetColor() to the caller.
+		void RenderFrame(SceneConstants const& constants, RenderSize renderSize, JitterOffset jitter, IUpscaler* upscaler);
+
+		// Records the upscaling that the last frame left for the next one, if any, for when there's no next
+		// frame to record it in. Between the device's BeginFrame and EndFrame.
+		void FinishUpscaling();
+
+		// Makes the next frame start without history, for instance after a camera cut.
+		void ResetHistory() { m_hasHistory = false; }
+
+		// Rendered unless this is called. Changing it resets history.
+		void SetMotionVectorSource(MotionVectorSource source);
+		MotionVectorSource GetMotionVectorSource() const { return m_motionVectorSource; }
+
+		// Those of the last frame rendered.
+		IImage& GetColor()			{ return *GetFrame(m_frameNumber - 1).color; }
+		IImage& GetDepth()			{ return *GetFrame(m_frameNumber - 1).depth; }
+
+		// Those of the last frame upscaled, which is the one before the last rendered when its upscaling was
+		// left for the next frame. The frames are numbered from 0 in the order they're rendered, and the number
+		// is -1 before any has been upscaled.
+		IImage& GetMotionVectors()	{ return *GetFrame(m_outputFrameNumber).motionVectors; }
+		IImage& GetOutput()			{ return *GetFrame(m_outputFrameNumber).output; }
+		int GetOutputFrameNumber() const { return m_outputFrameNumber; }
+
+	private:
+		struct FrameImages
+		{
+			std::unique_ptr<IImage> color;
+			std::unique_ptr<IImage> depth;
+			std::unique_ptr<IImage> motionVectors;
+			std::unique_ptr<IImage> output;
+		};
+
+		FrameImages& GetFrame(int frameNumber) { return m_frames[std::max(frameNumber, 0) % m_frames.size()]; }
+		void Upscale(IUpscaler& upscaler, UpscaleInputs const& inputs, int frameNumber);
+
+		IDevice& m_device;
+
+		std::vector<FrameImages> m_frames;
+		int m_frameNumber; // Of the next frame to render
+
+		// The last frame's upscaling, when it's left for the next frame.
+		bool m_isUpscalePending;
+		IUpscaler* m_pendingUpscaler;
+		UpscaleInputs m_pendingInputs;
+		int m_pendingFrameNumber;
+		int m_outputFrameNumber;
+
+		std::vector<std::unique_ptr<IImage>> m_luma;
+		int m_previousLumaIndex;
+
+		MotionVectorSource m_motionVectorSource;
+
+		// Whether m_previousConstants and the luma at m_previousLumaIndex hold the last frame, so that motion can be measured
+		// against it.
+		bool m_hasHistory;
+		SceneConstants m_previousConstants;
+		IUpscaler* m_lastUpscaler;
+	};
+}
@@ -0,0 +1,258 @@
+#include "SceneGeometry.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+using namespace scaling;
+
+namespace
+{
+	// A fixed linear congruential generator rather than <random>'s distributions, whose output isn't the
+	// same from one standard library to the next.
+	class SceneRandom
+	{
+	public:
+		explicit SceneRandom(uint32_t seed) : m_state(seed) {}
+
+		// In [minimum, maximum).
+		float Next(float minimum, float maximum)
+		{
+			m_state = m_state * 1664525u + 1013904223u;
+			return minimum + (maximum - minimum) * static_cast<float>(m_state >> 8) / 16777216.0f;
+		}
+
+	private:
+		uint32_t m_state;
+	};
+}
+
+// Cube vertices. Each vertex has a position and a color.
+const SceneVertex scaling::g_cubeVertices[8] =
+{
+	{ { -0.5f, -0.5f, -0.5f }, { 0.0f, 0.0f, 0.0f } },
+	{ { -0.5f, -0.5f,  0.5f }, { 0.0f, 0.0f, 1.0f } },
+	{ { -0.5f,  0.5f, -0.5f }, { 0.0f, 1.0f, 0.0f } },
+	{ { -0.5f,  0.5f,  0.5f }, { 0.0f, 1.0f, 1.0f } },
+	{ {  0.5f, -0.5f, -0.5f }, { 1.0f, 0.0f, 0.0f } },
+	{ {  0.5f, -0.5f,  0.5f }, { 1.0f, 0.0f, 1.0f } },
+	{ {  0.5f,  0.5f, -0.5f }, { 1.0f, 1.0f, 0.0f } },
+	{ {  0.5f,  0.5f,  0.5f }, { 1.0f, 1.0f, 1.0f } },
+};
+
+// Mesh indices. Each trio of indices represents a triangle to be rendered on the screen.
+// For example: 0,2,1 means that the vertices with indexes 0, 2 and 1 from the vertex buffer compose the
+// first triangle of this mesh.
+const uint16_t scaling::g_cubeIndices[36] =
+{
+	0, 2, 1, // -x
+	1, 2, 3,
+
+	4, 5, 6, // +x
+	5, 7, 6,
+
+	0, 1, 5, // -y
+	0, 5, 4,
+
+	2, 6, 7, // +y
+	2, 7, 3,
+
+	0, 4, 6, // -z
+	0, 6, 2,
+
+	1, 3, 7, // +z
+	1, 7, 5,
+};
+
+SceneMeshView scaling::GetMeshView(SceneMesh const& mesh)
+{
+	return SceneMeshView{ mesh.vertices.data(), mesh.vertices.size(), mesh.indices.data(), mesh.indices.size(), mesh.chunks.data(), mesh.chunks.size() };
+}
+
+SceneMesh scaling::CreateCubeMesh()
+{
+	SceneMesh mesh;
+	mesh.vertices.assign(std::begin(g_cubeVertices), std::end(g_cubeVertices));
+	mesh.indices.assign(std::begin(g_cubeIndices), std::end(g_cubeIndices));
+	mesh.chunks.push_back(MeshChunk{ 0, static_cast<uint32_t>(mesh.vertices.size()), 0, static_cast<uint32_t>(mesh.indices.size()) });
+	return mesh;
+}
+
+// A latitude-longitude grid with twice as many segments around as rings down, which gives 4 * rings^2
+// triangles. The triangles at the poles are degenerate, and get culled. Beyond about 130,000 triangles, the
+// grid has more vertices than 16-bit indices can address, and is split into chunks.
+SceneMesh scaling::CreateStressMesh(int triangleCount)
+{
+	const float pi = 3.14159265f;
+	const float radius = 0.6f;
+	const float bumpHeight = 0.08f;
+
+	int rings = std::max(2, static_cast<int>(std::sqrt(triangleCount / 4.0)));
+	int segments = 2 * rings;
+
+	std::vector<SceneVertex> vertices;
+	vertices.reserve(static_cast<size_t>(rings + 1) * (segments + 1));
+	for (int ring = 0; ring <= rings; ++ring)
+	{
+		float theta = pi * ring / rings;
+		for (int segment = 0; segment <= segments; ++segment)
+		{
+			float phi = 2.0f * pi * segment / segments;
+			float r = radius * (1.0f + bumpHeight * std::sin(12.0f * theta) * std::sin(12.0f * phi));
+			Float3 position = { r * std::sin(theta) * std::cos(phi), r * std::cos(theta), r * std::sin(theta) * std::sin(phi) };
+
+			// Colored by position, the way the cube is.
+			float scale = 0.5f / (radius * (1.0f + bumpHeight));
+			Float3 color = { position.x * scale + 0.5f, position.y * scale + 0.5f, position.z * scale + 0.5f };
+			vertices.push_back(SceneVertex{ position, color });
+		}
+	}
+
+	std::vector<uint32_t> indices;
+	indices.reserve(static_cast<size_t>(rings) * segments * 6);
+	for (int ring = 0; ring < rings; ++ring)
+	{
+		for (int segment = 0; segment < segments; ++segment)
+		{
+			uint32_t topLeft = ring * (segments + 1) + segment;
+			uint32_t topRight = topLeft + 1;
+			uint32_t bottomLeft = topLeft + segments + 1;
+			uint32_t bottomRight = bottomLeft + 1;
+
+			uint32_t quad[] = { topLeft, bottomLeft, topRight, topRight, bottomLeft, bottomRight };
+			indices.insert(indices.end(), std::begin(quad), std::end(quad));
+		}
+	}
+	return CreateChunkedMesh(vertices, indices);
+}
+
+SceneMesh scaling::CreateChunkedMesh(std::vector<SceneVertex> const& vertices, std::vector<uint32_t> const& indices)
+{
+	const uint32_t maxChunkVertexCount = 65536;
+	size_t triangleIndexCount = indices.size() - indices.size() % 3;
+
+	SceneMesh mesh;
+	mesh.indices.reserve(triangleIndexCount);
+
+	// Small enough for one chunk as it is.
+	if (vertices.size() <= maxChunkVertexCount)
+	{
+		mesh.vertices = vertices;
+		for (size_t i = 0; i < triangleIndexCount; ++i)
+		{
+			mesh.indices.push_back(static_cast<uint16_t>(indices[i]));
+		}
+		mesh.chunks.push_back(MeshChunk{ 0, static_cast<uint32_t>(vertices.size()), 0, static_cast<uint32_t>(triangleIndexCount) });
+		return mesh;
+	}
+
+	// Where each vertex is in the current chunk, if it's been added to it. A chunk number goes with it, so
+	// that starting a chunk doesn't mean clearing the whole table.
+	std::vector<uint32_t> chunkIndex(vertices.size());
+	std::vector<uint32_t> chunkOfIndex(vertices.size(), UINT32_MAX);
+
+	MeshChunk chunk = {};
+	uint32_t chunkNumber = 0;
+	for (size_t i = 0; i < triangleIndexCount; i += 3)
+	{
+		uint32_t newVertexCount = 0;
+		for (int corner = 0; corner < 3; ++corner)
+		{
+			newVertexCount += chunkOfIndex[indices[i + corner]] != chunkNumber ? 1 : 0;
+		}
+		if (chunk.vertexCount + newVertexCount > maxChunkVertexCount)
+		{
+			mesh.chunks.push_back(chunk);
+			chunk = MeshChunk{ static_cast<uint32_t>(mesh.vertices.size()), 0, static_cast<uint32_t>(mesh.indices.size()), 0 };
+			++chunkNumber;
+		}
+
+		for (int corner = 0; corner < 3; ++corner)
+		{
+			uint32_t vertex = indices[i + corner];
+			if (chunkOfIndex[vertex] != chunkNumber)
+			{
+				chunkOfIndex[vertex] = chunkNumber;
+				chunkIndex[vertex] = chunk.vertexCount++;
+				mesh.vertices.push_back(vertices[vertex]);
+			}
+			mesh.indices.push_back(static_cast<uint16_t>(chunkIndex[vertex]));
+		}
+		chunk.indexCount += 3;
+	}
+	if (chunk.indexCount > 0)
+	{
+		mesh.chunks.push_back(chunk);
+	}
+	return mesh;
+}
+
+std::vector<SceneInstance> scaling::CreateInstancedScene(int instanceCount)
+{
+	assert(instanceCount >= 1 && instanceCount <= c_maxSceneInstanceCount);
+
+	std::vector<SceneInstance> instances(instanceCount);
+	if (instanceCount == 1)
+	{
+		instances[0] = SceneInstance{ { 0.0f, 0.0f, 0.0f }, 1.0f, { 0.0f, 1.0f, 0.0f }, 0.0f, 0.0f };
+		return instances;
+	}
+
+	// Cubes are sized so that together they'd fill about a third of the volume, which leaves plenty of
+	// overlap and open space, whatever the count.
+	const float extent = 1.2f;
+	const float averageScale = 0.7f * extent / std::cbrt(static_cast<float>(instanceCount));
+
+	SceneRandom random(12345);
+	for (SceneInstance& instance : instances)
+	{
+		instance.position = { random.Next(-0.5f, 0.5f) * extent, random.Next(-0.5f, 0.5f) * extent, random.Next(-0.5f, 0.5f) * extent };
+		instance.scale = averageScale * random.Next(0.5f, 1.5f);
+
+		// Uniform over the sphere.
+		float z = random.Next(-1.0f, 1.0f);
+		float angle = random.Next(0.0f, 2.0f * 3.14159265f);
+		float radius = std::sqrt(1.0f - z * z);
+		instance.axis = { radius * std::cos(angle), radius * std::sin(angle), z };
+
+		instance.spinRate = random.Next(-4.0f, 4.0f);
+		instance.phase = random.Next(0.0f, 2.0f * 3.14159265f);
+	}
+	return instances;
+}
+
+Float4x4 scaling::GetInstanceModel(SceneInstance const& instance, float sceneAngle)
+{
+	Float4x4 rotation = MatrixRotationNormal(instance.axis, instance.spinRate * sceneAngle + instance.phase);
+	Float4x4 placement = MatrixMultiply(MatrixScaling(instance.scale), MatrixTranslation(instance.position.x, instance.position.y, instance.position.z));
+	return MatrixMultiply(rotation, placement);
+}
+
+Float4x4 scaling::GetSceneView()
+{
+	// Eye is at (0,0.7,1.5), looking at point (0,-0.1,0) with the up-vector along the y-axis.
+	Float3 eye = { 0.0f, 0.7f - 0.5f, 1.5f };
+	Float3 at = { 0.0f, -0.1f + 0.1f, 0.0f };
+	Float3 up = { 0.0f, 1.0f, 0.0f };
+	return MatrixLookAtRH(eye, at, up);
+}
+
+Float4x4 scaling::GetSceneProjection(float aspectRatio)
+{
+	float fovAngleY = 70.0f * 3.14159265f / 180.0f;
+	if (aspectRatio < 1.0f)
+	{
+		fovAngleY *= 2.0f;
+	}
+
+	// This sample makes use of a right-handed coordinate system using row-major matrices.
+	return MatrixPerspectiveFovRH(fovAngleY, aspectRatio, 0.01f, 100.0f);
+}
+
+// Clip space has y up, hence the sign flip on y.
+Float4x4 scaling::JitterProjection(Float4x4 const& projection, JitterOffset jitter, RenderSize renderSize)
+{
+	float offsetX = -2.0f * jitter.x / renderSize.width;
+	float offsetY = 2.0f * jitter.y / renderSize.height;
+	return MatrixMultiply(projection, MatrixTranslation(offsetX, offsetY, 0.0f));
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "JitterSequence.h"
+#include "QualityPreset.h"
+#include "SceneMath.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace scaling
+{
+	// Matches the input layout of pass 1, so that every backend draws the same cube from the same data.
+	struct SceneVertex
+	{
+		Float3 position;
+		Float3 color;
+	};
+
+	// The spinning cube: 8 vertices and 12 triangles. Front faces are clockwise on screen, which is what the
+	// default D3D12 rasterizer state keeps.
+	extern const SceneVertex g_cubeVertices[8];
+	extern const uint16_t g_cubeIndices[36];
+
+	// A part of a mesh that's drawn with one indexed draw. Its indices are relative to its first vertex, so
+	// that meshes of any size can have 16-bit indices, as long as no chunk has more than 65536 vertices.
+	struct MeshChunk
+	{
+		uint32_t firstVertex;
+		uint32_t vertexCount;
+		uint32_t firstIndex;
+		uint32_t indexCount;	// A multiple of 3
+	};
+
+	// An indexed triangle list in chunks, with the same winding as the cube.
+	struct SceneMesh
+	{
+		std::vector<SceneVertex> vertices;
+		std::vector<uint16_t> indices;
+		std::vector<MeshChunk> chunks;
+	};
+
+	// A mesh that something else owns, such as a SceneMesh or a mapped mesh file.
+	struct SceneMeshView
+	{
+		SceneVertex const* vertices;
+		size_t vertexCount;
+		uint16_t const* indices;
+		size_t indexCount;
+		MeshChunk const* chunks;
+		size_t chunkCount;
+	};
+
+	SceneMeshView GetMeshView(SceneMesh const& mesh);
+
+	SceneMesh CreateCubeMesh();
+
+	// A bumpy sphere about the size of the cube, for loading the rasterizers with many small triangles. Has
+	// close to triangleCount triangles.
+	SceneMesh CreateStressMesh(int triangleCount);
+
+	// Splits a triangle list with 32-bit indices into chunks, keeping the triangles in order. Vertices that
+	// triangles in different chunks share are repeated in each.
+	SceneMesh CreateChunkedMesh(std::vector<SceneVertex> const& vertices, std::vector<uint32_t> const& indices);
+
+	// One copy of the scene's mesh. Each instance turns about its own axis as the scene turns, at its own
+	// rate, and is then scaled and moved to its position. Matches SceneInstance in Pass1VS.hlsl.
+	struct SceneInstance
+	{
+		Float3 position;
+		float scale;
+		Float3 axis;		// Unit length
+		float spinRate;		// Radians per radian that the scene turns
+		float phase;		// Radians
+	};
+
+	const int c_maxSceneInstanceCount = 100000;
+
+	// The stress scene for benchmarks: instanceCount cubes of random sizes, spinning about random axes at
+	// random rates, scattered through the space the single cube takes up. They're the same for every
+	// backend and every run. One instance is the single cube, at the origin and without a spin of its own.
+	std::vector<SceneInstance> CreateInstancedScene(int instanceCount);
+
+	// Transforms an instance into the space of the scene's model matrix.
+	Float4x4 GetInstanceModel(SceneInstance const& instance, float sceneAngle);
+
+	// Matrices used to transform the scene into clip space. Not transposed for HLSL.
+	struct SceneConstants
+	{
+		Float4x4 model;
+		Float4x4 view;
+		Float4x4 projection;
+
+		// The projection before jitter. Motion vectors are measured with it, so that they only hold the
+		// motion of the scene. Same as projection when there's no jitter.
+		Float4x4 unjitteredProjection;
+
+		// How far the scene has turned, in radians, which is what instances spin by.
+		float sceneAngle;
+	};
+
+	inline Float4x4 GetModelViewProjection(SceneConstants const& constants)
+	{
+		return MatrixMultiply(MatrixMultiply(constants.model, constants.view), constants.projection);
+	}
+
+	inline Float4x4 GetUnjitteredModelViewProjection(SceneConstants const& constants)
+	{
+		return MatrixMultiply(MatrixMultiply(constants.model, constants.view), constants.unjitteredProjection);
+	}
+
+	// The camera, shared by every backend so that they all see the same thing.
+	Float4x4 GetSceneView();
+	Float4x4 GetSceneProjection(float aspectRatio);
+
+	// Offsets a projection so that pixel centers land on the jitter offset. The offset is in pixels with y
+	// down, relative to a target of renderSize.
+	Float4x4 JitterProjection(Float4x4 const& projection, JitterOffset jitter, RenderSize renderSize);
+}
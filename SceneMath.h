@@ -0,0 +1,173 @@
+#pragma once
+
+#include <cmath>
+
+namespace scaling
+{
+	// Minimal matrix math for the code that has to build without DirectXMath. Follows the same conventions
+	// as the DirectXMath calls in Sample3DSceneRenderer: row-major storage, row vectors multiplied on the
+	// left (v * M), and a right-handed view space. A Float4x4 has the same layout as an XMFLOAT4X4.
+	struct Float3
+	{
+		float x, y, z;
+	};
+
+	struct Float4
+	{
+		float x, y, z, w;
+	};
+
+	struct Float4x4
+	{
+		float m[4][4];
+	};
+
+	inline Float4x4 MatrixIdentity()
+	{
+		Float4x4 result = {};
+		for (int i = 0; i < 4; ++i)
+		{
+			result.m[i][i] = 1.0f;
+		}
+		return result;
+	}
+
+	inline Float4x4 MatrixMultiply(Float4x4 const& a, Float4x4 const& b)
+	{
+		Float4x4 result;
+		for (int row = 0; row < 4; ++row)
+		{
+			for (int column = 0; column < 4; ++column)
+			{
+				result.m[row][column] =
+					a.m[row][0] * b.m[0][column] +
+					a.m[row][1] * b.m[1][column] +
+					a.m[row][2] * b.m[2][column] +
+					a.m[row][3] * b.m[3][column];
+			}
+		}
+		return result;
+	}
+
+	inline Float4x4 MatrixTranspose(Float4x4 const& a)
+	{
+		Float4x4 result;
+		for (int row = 0; row < 4; ++row)
+		{
+			for (int column = 0; column < 4; ++column)
+			{
+				result.m[row][column] = a.m[column][row];
+			}
+		}
+		return result;
+	}
+
+	inline Float4x4 MatrixTranslation(float x, float y, float z)
+	{
+		Float4x4 result = MatrixIdentity();
+		result.m[3][0] = x;
+		result.m[3][1] = y;
+		result.m[3][2] = z;
+		return result;
+	}
+
+	inline Float4x4 MatrixRotationY(float radians)
+	{
+		float s = std::sin(radians);
+		float c = std::cos(radians);
+
+		Float4x4 result = MatrixIdentity();
+		result.m[0][0] = c;
+		result.m[0][2] = -s;
+		result.m[2][0] = s;
+		result.m[2][2] = c;
+		return result;
+	}
+
+	inline Float4x4 MatrixScaling(float scale)
+	{
+		Float4x4 result = MatrixIdentity();
+		for (int i = 0; i < 3; ++i)
+		{
+			result.m[i][i] = scale;
+		}
+		return result;
+	}
+
+	// Same as XMMatrixRotationNormal: the axis has to be unit length.
+	inline Float4x4 MatrixRotationNormal(Float3 axis, float radians)
+	{
+		float s = std::sin(radians);
+		float c = std::cos(radians);
+		float t = 1.0f - c;
+		float a[3] = { axis.x, axis.y, axis.z };
+
+		Float4x4 result = MatrixIdentity();
+		for (int row = 0; row < 3; ++row)
+		{
+			for (int column = 0; column < 3; ++column)
+			{
+				result.m[row][column] = t * a[row] * a[column] + (row == column ? c : 0.0f);
+			}
+		}
+		result.m[0][1] += s * axis.z;
+		result.m[0][2] -= s * axis.y;
+		result.m[1][0] -= s * axis.z;
+		result.m[1][2] += s * axis.x;
+		result.m[2][0] += s * axis.y;
+		result.m[2][1] -= s * axis.x;
+		return result;
+	}
+
+	// Same as XMMatrixPerspectiveFovRH.
+	inline Float4x4 MatrixPerspectiveFovRH(float fovAngleY, float aspectRatio, float nearZ, float farZ)
+	{
+		float height = 1.0f / std::tan(0.5f * fovAngleY);
+		float width = height / aspectRatio;
+		float range = farZ / (nearZ - farZ);
+
+		Float4x4 result = {};
+		result.m[0][0] = width;
+		result.m[1][1] = height;
+		result.m[2][2] = range;
+		result.m[2][3] = -1.0f;
+		result.m[3][2] = range * nearZ;
+		return result;
+	}
+
+	inline Float3 Subtract(Float3 a, Float3 b) { return Float3{ a.x - b.x, a.y - b.y, a.z - b.z }; }
+	inline float Dot(Float3 a, Float3 b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+	inline Float3 Cross(Float3 a, Float3 b) { return Float3{ a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x }; }
+	inline Float3 Normalize(Float3 a)
+	{
+		float length = std::sqrt(Dot(a, a));
+		return Float3{ a.x / length, a.y / length, a.z / length };
+	}
+
+	// Same as XMMatrixLookAtRH.
+	inline Float4x4 MatrixLookAtRH(Float3 eye, Float3 at, Float3 up)
+	{
+		Float3 zAxis = Normalize(Subtract(eye, at));
+		Float3 xAxis = Normalize(Cross(up, zAxis));
+		Float3 yAxis = Cross(zAxis, xAxis);
+
+		Float4x4 result = {};
+		result.m[0][0] = xAxis.x; result.m[0][1] = yAxis.x; result.m[0][2] = zAxis.x;
+		result.m[1][0] = xAxis.y; result.m[1][1] = yAxis.y; result.m[1][2] = zAxis.y;
+		result.m[2][0] = xAxis.z; result.m[2][1] = yAxis.z; result.m[2][2] = zAxis.z;
+		result.m[3][0] = -Dot(xAxis, eye);
+		result.m[3][1] = -Dot(yAxis, eye);
+		result.m[3][2] = -Dot(zAxis, eye);
+		result.m[3][3] = 1.0f;
+		return result;
+	}
+
+	inline Float4 TransformPoint(Float3 p, Float4x4 const& a)
+	{
+		return Float4{
+			p.x * a.m[0][0] + p.y * a.m[1][0] + p.z * a.m[2][0] + a.m[3][0],
+			p.x * a.m[0][1] + p.y * a.m[1][1] + p.z * a.m[2][1] + a.m[3][1],
+			p.x * a.m[0][2] + p.y * a.m[1][2] + p.z * a.m[2][2] + a.m[3][2],
+			p.x * a.m[0][3] + p.y * a.m[1][3] + p.z * a.m[2][3] + a.m[3][3] };
+	}
+}
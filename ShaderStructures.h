@@ -2,24 +2,31 @@
 
 namespace scaling
 {
-	// Constant buffer used to send MVP matrices to the vertex shader.
+	// Constant buffer used to send MVP matrices to the vertex shader, and the matrices that pass 1 measures
+	// motion vectors with.
 	struct ModelViewProjectionConstantBuffer
 	{
-		DirectX::XMFLOAT4X4 model;
-		DirectX::XMFLOAT4X4 view;
-		DirectX::XMFLOAT4X4 projection;
+		DirectX::XMFLOAT4X4 modelViewProjection;
+		DirectX::XMFLOAT4X4 currentMotion;
+		DirectX::XMFLOAT4X4 previousMotion;
+		DirectX::XMFLOAT2 motionVectorScale;
+		float sceneAngle;
+		float previousSceneAngle;
 	};
 
-	// Used to send per-vertex data to the vertex shader.
-	struct VertexPositionColor
+	struct VertexUV
 	{
 		DirectX::XMFLOAT3 pos;
-		DirectX::XMFLOAT3 color;
+		DirectX::XMFLOAT2 uv;
 	};
 
-	struct VertexUV
+	// Root constants used by pass 2. Matches DrawConstantsType in Bindings.hlsli.
+	struct DrawConstants
 	{
-		DirectX::XMFLOAT3 pos;
-		DirectX::XMFLOAT2 uv;
+		int samplerIndex;
+		float sharpness;
+		DirectX::XMFLOAT2 outputTexelSize;
+		DirectX::XMFLOAT2 inputUvScale;
+		DirectX::XMFLOAT2 inputUvMax;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,1254 @@
+#include "SoftwareRasterizer.h"
+#include "VertexTransform.h"
+
+#include <algorithm>
+#include <bitset>
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+using namespace scaling;
+
+namespace
+{
+	// Vertex positions are snapped to 1/16 of a pixel, like D3D's 4 bits of sub-pixel precision.
+	const int c_subPixelBits = 4;
+	const float c_subPixelScale = static_cast<float>(1 << c_subPixelBits);
+
+	const int c_tileSize = SoftwareRasterizer::c_tileSize;
+	const int c_binSize = SoftwareRasterizer::c_binSize;
+	const int c_tilesPerBin = c_binSize / c_tileSize;
+
+	// Pixels get their depth from a plane evaluated in float, so it can be a little off from the exact
+	// range of the plane. The depth hierarchy's tests leave this much room for that.
+	const float c_depthTolerance = 4e-6f;
+
+	struct ScreenVertex
+	{
+		int64_t x;		// Fixed point, c_subPixelBits of fraction
+		int64_t y;
+		float z;		// NDC depth
+		float invW;
+		Float3 colorOverW;
+
+		// Only when writing motion vectors: x, y and w of the vertex in the current and previous frames'
+		// unjittered clip space, over the w it's drawn with.
+		Float3 currentClipOverW;
+		Float3 previousClipOverW;
+	};
+
+	ScreenVertex ToScreen(Float4 clip, Float3 color, RenderSize viewport)
+	{
+		float invW = 1.0f / clip.w;
+		float ndcX = clip.x * invW;
+		float ndcY = clip.y * invW;
+
+		ScreenVertex result;
+		result.x = static_cast<int64_t>(std::lround((ndcX * 0.5f + 0.5f) * viewport.width * c_subPixelScale));
+		result.y = static_cast<int64_t>(std::lround((0.5f - ndcY * 0.5f) * viewport.height * c_subPixelScale));
+		result.z = clip.z * invW;
+		result.invW = invW;
+		result.colorOverW = Float3{ color.x * invW, color.y * invW, color.z * invW };
+		return result;
+	}
+
+	void SetMotion(ScreenVertex& vertex, Float4 current, Float4 previous)
+	{
+		vertex.currentClipOverW = Float3{ current.x * vertex.invW, current.y * vertex.invW, current.w * vertex.invW };
+		vertex.previousClipOverW = Float3{ previous.x * vertex.invW, previous.y * vertex.invW, previous.w * vertex.invW };
+	}
+
+	// An edge function in pixel units: a * x + b * y + c is twice the signed area of the triangle formed by
+	// the edge and the center of pixel (x, y), in fixed point. It's positive on the inside, which is to the
+	// right of the edge on screen (y down).
+	struct Edge
+	{
+		int64_t a;
+		int64_t b;
+		int64_t c;
+
+		int64_t Evaluate(int64_t x, int64_t y) const { return a * x + b * y + c; }
+	};
+
+	Edge MakeEdge(ScreenVertex const& p, ScreenVertex const& q)
+	{
+		const int64_t half = 1 << (c_subPixelBits - 1);
+
+		int64_t dx = q.x - p.x;
+		int64_t dy = q.y - p.y;
+
+		Edge edge;
+		edge.a = -dy * (1 << c_subPixelBits);
+		edge.b = dx * (1 << c_subPixelBits);
+		edge.c = dy * p.x - dx * p.y - dy * half + dx * half;
+		return edge;
+	}
+
+	// Top-left rule: a pixel center exactly on an edge belongs to the triangle only if the edge is a top
+	// edge or a left edge. Expressed as a bias that makes the inclusive test exclusive for other edges.
+	inline int64_t FillBias(ScreenVertex const& a, ScreenVertex const& b)
+	{
+		bool isTop = a.y == b.y && b.x > a.x;
+		bool isLeft = b.y < a.y;
+		return (isTop || isLeft) ? 0 : -1;
+	}
+
+	// An attribute that's affine in screen space: origin + dx * x + dy * y at pixel (x, y). Kept in double
+	// so that evaluating it far from the origin doesn't lose precision; each tile rebases it to float.
+	struct Plane
+	{
+		double dx;
+		double dy;
+		double origin;
+	};
+
+	// A plane rebased to the top-left pixel of a tile.
+	struct TilePlane
+	{
+		float origin;
+		float dx;
+		float dy;
+	};
+
+	TilePlane RebasePlane(Plane const& plane, int x, int y)
+	{
+		TilePlane result;
+		result.origin = static_cast<float>(plane.origin + plane.dx * x + plane.dy * y);
+		result.dx = static_cast<float>(plane.dx);
+		result.dy = static_cast<float>(plane.dy);
+		return result;
+	}
+
+	struct TriangleSetup
+	{
+		Edge edges[3];		// With the fill bias included
+		Plane z;
+		Plane invW;
+		Plane colorOverW[3];
+		Plane clipOverW[6];		// Only when writing motion vectors. Current x, y, w, then previous x, y, w
+		float minZ;
+		float maxZ;
+
+		// Bounding box in pixels, inclusive, clipped to the viewport.
+		int x0;
+		int y0;
+		int x1;
+		int y1;
+	};
+
+	// Edges that a tile needs tested, with values rebased to its top-left pixel. Those small enough for
+	// 32-bit lanes, since an edge that crosses a tile can't be far from it.
+	struct TileEdges
+	{
+		int count;
+		int32_t origin[3];
+		int32_t dx[3];
+		int32_t dy[3];
+	};
+
+	struct TileAttributes
+	{
+		TilePlane z;
+		TilePlane invW;
+		TilePlane colorOverW[3];
+		TilePlane clipOverW[6];
+	};
+
+	// Where a tile writes motion vectors, and what converts a difference in NDC to quarter pixels.
+	struct TileMotionTarget
+	{
+		ImageMotionVectors* image;
+		float scaleX;
+		float scaleY;
+	};
+
+	// The rasterizer's depth hierarchy, indexed by tile and by bin across the viewport.
+	struct DepthHierarchyView
+	{
+		float* tileNearest;
+		float* tileFarthest;
+		uint64_t* tileCoverage;
+		float* binFarthest;
+		uint8_t* isBinFarthestStale;
+		int tilesX;
+		int binsX;
+	};
+
+	// What triangles are drawn into. The motion target and hierarchy are optional.
+	struct DrawTarget
+	{
+		RenderSize viewport;
+		ImageBgra8* color;
+		ImageD32* depth;
+		TileMotionTarget const* motion;
+		DepthHierarchyView const* hierarchy;
+	};
+
+	// What drawing a tile did to its depth, for keeping the hierarchy up to date without reading the tile
+	// back. Only the farthest depth can't be tracked that way.
+	struct TileDepthUpdate
+	{
+		uint64_t writtenMask;	// A bit per pixel, a byte per row
+		bool isFarthestOverwritten;	// A pixel at the tile's farthest depth was written, or might have been
+		float nearestWritten;
+	};
+
+	inline int CountBits(uint32_t mask)
+	{
+		return static_cast<int>(std::bitset<32>(mask).count());
+	}
+
+	// Returns false for a back-facing, degenerate or off-screen triangle.
+	bool SetUpTriangle(ScreenVertex const (&v)[3], RenderSize viewport, bool hasMotion, TriangleSetup& setup)
+	{
+		const int64_t half = 1 << (c_subPixelBits - 1);
+
+		Edge unbiased[3] = { MakeEdge(v[1], v[2]), MakeEdge(v[2], v[0]), MakeEdge(v[0], v[1]) };
+
+		// Twice the triangle's area, in the same units as the edge functions.
+		int64_t area = unbiased[0].Evaluate(0, 0) + unbiased[1].Evaluate(0, 0) + unbiased[2].Evaluate(0, 0);
+		if (area <= 0)
+		{
+			return false; // Back-facing or degenerate
+		}
+
+		int64_t minX = std::min({ v[0].x, v[1].x, v[2].x });
+		int64_t maxX = std::max({ v[0].x, v[1].x, v[2].x });
+		int64_t minY = std::min({ v[0].y, v[1].y, v[2].y });
+		int64_t maxY = std::max({ v[0].y, v[1].y, v[2].y });
+		setup.x0 = static_cast<int>(std::max<int64_t>((minX - half) >> c_subPixelBits, 0));
+		setup.x1 = static_cast<int>(std::min<int64_t>((maxX - half) >> c_subPixelBits, viewport.width - 1));
+		setup.y0 = static_cast<int>(std::max<int64_t>((minY - half) >> c_subPixelBits, 0));
+		setup.y1 = static_cast<int>(std::min<int64_t>((maxY - half) >> c_subPixelBits, viewport.height - 1));
+		if (setup.x0 > setup.x1 || setup.y0 > setup.y1)
+		{
+			return false;
+		}
+
+		int64_t biases[3] = { FillBias(v[1], v[2]), FillBias(v[2], v[0]), FillBias(v[0], v[1]) };
+		for (int i = 0; i < 3; ++i)
+		{
+			setup.edges[i] = unbiased[i];
+			setup.edges[i].c += biases[i];
+		}
+
+		// The barycentric weight of vertex i is its edge function over the area, so each attribute's plane
+		// is the weighted sum of the edge functions.
+		double invArea = 1.0 / static_cast<double>(area);
+		auto makePlane = [&](float a0, float a1, float a2)
+		{
+			Plane plane;
+			plane.dx = (unbiased[0].a * static_cast<double>(a0) + unbiased[1].a * static_cast<double>(a1) + unbiased[2].a * static_cast<double>(a2)) * invArea;
+			plane.dy = (unbiased[0].b * static_cast<double>(a0) + unbiased[1].b * static_cast<double>(a1) + unbiased[2].b * static_cast<double>(a2)) * invArea;
+			plane.origin = (unbiased[0].c * static_cast<double>(a0) + unbiased[1].c * static_cast<double>(a1) + unbiased[2].c * static_cast<double>(a2)) * invArea;
+			return plane;
+		};
+
+		// Depth is affine in screen space, so it interpolates directly. Color is divided by w first, and
+		// multiplied back per pixel.
+		setup.z = makePlane(v[0].z, v[1].z, v[2].z);
+		setup.minZ = std::min({ v[0].z, v[1].z, v[2].z });
+		setup.maxZ = std::max({ v[0].z, v[1].z, v[2].z });
+		setup.invW = makePlane(v[0].invW, v[1].invW, v[2].invW);
+		setup.colorOverW[0] = makePlane(v[0].colorOverW.x, v[1].colorOverW.x, v[2].colorOverW.x);
+		setup.colorOverW[1] = makePlane(v[0].colorOverW.y, v[1].colorOverW.y, v[2].colorOverW.y);
+		setup.colorOverW[2] = makePlane(v[0].colorOverW.z, v[1].colorOverW.z, v[2].colorOverW.z);
+
+		// Positions are perspective-correct too. Their x and y are divided by their own w per pixel.
+		if (hasMotion)
+		{
+			setup.clipOverW[0] = makePlane(v[0].currentClipOverW.x, v[1].currentClipOverW.x, v[2].currentClipOverW.x);
+			setup.clipOverW[1] = makePlane(v[0].currentClipOverW.y, v[1].currentClipOverW.y, v[2].currentClipOverW.y);
+			setup.clipOverW[2] = makePlane(v[0].currentClipOverW.z, v[1].currentClipOverW.z, v[2].currentClipOverW.z);
+			setup.clipOverW[3] = makePlane(v[0].previousClipOverW.x, v[1].previousClipOverW.x, v[2].previousClipOverW.x);
+			setup.clipOverW[4] = makePlane(v[0].previousClipOverW.y, v[1].previousClipOverW.y, v[2].previousClipOverW.y);
+			setup.clipOverW[5] = makePlane(v[0].previousClipOverW.z, v[1].previousClipOverW.z, v[2].previousClipOverW.z);
+		}
+		return true;
+	}
+
+	// Returns false if the tile at (tileX, tileY) is entirely outside the triangle. Otherwise, fills in
+	// the edges that only cover part of it.
+	bool ClassifyTile(TriangleSetup const& setup, int tileX, int tileY, TileEdges& tileEdges)
+	{
+		const int64_t extent = c_tileSize - 1;
+
+		tileEdges.count = 0;
+		for (int i = 0; i < 3; ++i)
+		{
+			Edge const& edge = setup.edges[i];
+			int64_t origin = edge.Evaluate(tileX, tileY);
+			int64_t minimum = origin + std::min<int64_t>(edge.a, 0) * extent + std::min<int64_t>(edge.b, 0) * extent;
+			int64_t maximum = origin + std::max<int64_t>(edge.a, 0) * extent + std::max<int64_t>(edge.b, 0) * extent;
+
+			if (maximum < 0)
+			{
+				return false;
+			}
+			if (minimum >= 0)
+			{
+				continue; // Covers the whole tile
+			}
+
+			assert(minimum >= INT32_MIN && maximum <= INT32_MAX);
+			int index = tileEdges.count++;
+			tileEdges.origin[index] = static_cast<int32_t>(origin);
+			tileEdges.dx[index] = static_cast<int32_t>(edge.a);
+			tileEdges.dy[index] = static_cast<int32_t>(edge.b);
+		}
+		return true;
+	}
+
+#if defined(__AVX2__)
+	inline __m256i PackBgra8x8(__m256 r, __m256 g, __m256 b)
+	{
+		const __m256 zero = _mm256_setzero_ps();
+		const __m256 one = _mm256_set1_ps(1.0f);
+		const __m256 scale = _mm256_set1_ps(255.0f);
+		const __m256 rounding = _mm256_set1_ps(0.5f);
+
+		auto toUnorm = [&](__m256 value)
+		{
+			value = _mm256_min_ps(_mm256_max_ps(value, zero), one);
+			return _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(value, scale), rounding));
+		};
+
+		__m256i packed = _mm256_set1_epi32(static_cast<int>(0xFF000000u));
+		packed = _mm256_or_si256(packed, _mm256_slli_epi32(toUnorm(r), 16));
+		packed = _mm256_or_si256(packed, _mm256_slli_epi32(toUnorm(g), 8));
+		packed = _mm256_or_si256(packed, toUnorm(b));
+		return packed;
+	}
+
+	// Motion in quarter pixels from the interpolated clip positions, packed the way MotionVector is.
+	inline __m256i QuantizeMotion8(__m256 const (&clipOverW)[6], float scaleX, float scaleY)
+	{
+		auto toQuarterPixels = [](__m256 current, __m256 currentW, __m256 previous, __m256 previousW, float scale)
+		{
+			__m256 difference = _mm256_sub_ps(_mm256_div_ps(previous, previousW), _mm256_div_ps(current, currentW));
+			__m256 rounded = _mm256_floor_ps(_mm256_add_ps(_mm256_mul_ps(difference, _mm256_set1_ps(scale)), _mm256_set1_ps(0.5f)));
+			rounded = _mm256_min_ps(_mm256_max_ps(rounded, _mm256_set1_ps(-32768.0f)), _mm256_set1_ps(32767.0f));
+			return _mm256_cvttps_epi32(rounded);
+		};
+
+		__m256i x = toQuarterPixels(clipOverW[0], clipOverW[2], clipOverW[3], clipOverW[5], scaleX);
+		__m256i y = toQuarterPixels(clipOverW[1], clipOverW[2], clipOverW[4], clipOverW[5], scaleY);
+		return _mm256_or_si256(_mm256_and_si256(x, _mm256_set1_epi32(0xFFFF)), _mm256_slli_epi32(y, 16));
+	}
+
+	// Evaluates a tile a row of 8 pixels at a time. Without a depth test, every pixel inside the triangle
+	// is written, and the caller knows that none of them were at the tile's farthest depth.
+	TileDepthUpdate RasterizeTile(
+		TileEdges const& tileEdges,
+		TileAttributes const& attributes,
+		int tileX,
+		int tileY,
+		bool isDepthTestNeeded,
+		float tileFarthest,
+		DrawTarget const& target,
+		RasterizerStats& stats)
+	{
+		RenderSize viewport = target.viewport;
+		TileMotionTarget const* motion = target.motion;
+		const __m256 farthest = _mm256_set1_ps(tileFarthest);
+		__m256 nearestWritten = _mm256_set1_ps(tileFarthest);
+		__m256 farthestOverwritten = _mm256_setzero_ps();
+		uint64_t writtenMask = 0;
+
+		const __m256i laneIndex = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+		const __m256 laneOffset = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+		const __m256i zeroInt = _mm256_setzero_si256();
+		const __m256 zero = _mm256_setzero_ps();
+		const __m256 one = _mm256_set1_ps(1.0f);
+
+		int columnCount = std::min(c_tileSize, viewport.width - tileX);
+		int rowCount = std::min(c_tileSize, viewport.height - tileY);
+		const __m256i columnMask = _mm256_cmpgt_epi32(_mm256_set1_epi32(columnCount), laneIndex);
+
+		__m256i edgeValues[3];
+		for (int i = 0; i < tileEdges.count; ++i)
+		{
+			edgeValues[i] = _mm256_add_epi32(
+				_mm256_set1_epi32(tileEdges.origin[i]),
+				_mm256_mullo_epi32(_mm256_set1_epi32(tileEdges.dx[i]), laneIndex));
+		}
+
+		auto startRow = [&](TilePlane const& plane)
+		{
+			return _mm256_add_ps(_mm256_set1_ps(plane.origin), _mm256_mul_ps(_mm256_set1_ps(plane.dx), laneOffset));
+		};
+		__m256 z = startRow(attributes.z);
+		__m256 invW = startRow(attributes.invW);
+		__m256 redOverW = startRow(attributes.colorOverW[0]);
+		__m256 greenOverW = startRow(attributes.colorOverW[1]);
+		__m256 blueOverW = startRow(attributes.colorOverW[2]);
+
+		__m256 clipOverW[6];
+		if (motion)
+		{
+			for (int i = 0; i < 6; ++i)
+			{
+				clipOverW[i] = startRow(attributes.clipOverW[i]);
+			}
+		}
+
+		for (int row = 0; row < rowCount; ++row)
+		{
+			__m256i inside = columnMask;
+			for (int i = 0; i < tileEdges.count; ++i)
+			{
+				inside = _mm256_andnot_si256(_mm256_cmpgt_epi32(zeroInt, edgeValues[i]), inside);
+			}
+
+			int insideMask = _mm256_movemask_ps(_mm256_castsi256_ps(inside));
+			if (insideMask != 0)
+			{
+				stats.fragmentsCovered += CountBits(insideMask);
+
+				float* depthRow = target.depth->GetRow(tileY + row) + tileX;
+				__m256 passed = _mm256_castsi256_ps(inside);
+				__m256 stored = farthest;
+				if (isDepthTestNeeded)
+				{
+					stored = _mm256_maskload_ps(depthRow, inside);
+					passed = _mm256_and_ps(passed, _mm256_cmp_ps(z, stored, _CMP_LT_OQ));
+				}
+				passed = _mm256_and_ps(passed, _mm256_cmp_ps(z, zero, _CMP_GE_OQ));
+				passed = _mm256_and_ps(passed, _mm256_cmp_ps(z, one, _CMP_LE_OQ));
+
+				int passedMask = _mm256_movemask_ps(passed);
+				if (passedMask != 0)
+				{
+					stats.fragmentsShaded += CountBits(passedMask);
+					writtenMask |= static_cast<uint64_t>(passedMask) << (row * c_tileSize);
+					nearestWritten = _mm256_min_ps(nearestWritten, _mm256_blendv_ps(farthest, z, passed));
+					farthestOverwritten = _mm256_or_ps(farthestOverwritten, _mm256_and_ps(passed, _mm256_cmp_ps(stored, farthest, _CMP_GE_OQ)));
+
+					__m256i writeMask = _mm256_castps_si256(passed);
+					_mm256_maskstore_ps(depthRow, writeMask, z);
+
+					__m256 w = _mm256_div_ps(one, invW);
+					__m256i packed = PackBgra8x8(
+						_mm256_mul_ps(redOverW, w),
+						_mm256_mul_ps(greenOverW, w),
+						_mm256_mul_ps(blueOverW, w));
+					_mm256_maskstore_epi32(reinterpret_cast<int*>(target.color->GetRow(tileY + row) + tileX), writeMask, packed);
+
+					if (motion)
+					{
+						__m256i vectors = QuantizeMotion8(clipOverW, motion->scaleX, motion->scaleY);
+						_mm256_maskstore_epi32(reinterpret_cast<int*>(motion->image->GetRow(tileY + row) + tileX), writeMask, vectors);
+					}
+				}
+			}
+
+			for (int i = 0; i < tileEdges.count; ++i)
+			{
+				edgeValues[i] = _mm256_add_epi32(edgeValues[i], _mm256_set1_epi32(tileEdges.dy[i]));
+			}
+			z = _mm256_add_ps(z, _mm256_set1_ps(attributes.z.dy));
+			invW = _mm256_add_ps(invW, _mm256_set1_ps(attributes.invW.dy));
+			redOverW = _mm256_add_ps(redOverW, _mm256_set1_ps(attributes.colorOverW[0].dy));
+			greenOverW = _mm256_add_ps(greenOverW, _mm256_set1_ps(attributes.colorOverW[1].dy));
+			blueOverW = _mm256_add_ps(blueOverW, _mm256_set1_ps(attributes.colorOverW[2].dy));
+			if (motion)
+			{
+				for (int i = 0; i < 6; ++i)
+				{
+					clipOverW[i] = _mm256_add_ps(clipOverW[i], _mm256_set1_ps(attributes.clipOverW[i].dy));
+				}
+			}
+		}
+
+		TileDepthUpdate update;
+		update.writtenMask = writtenMask;
+		update.isFarthestOverwritten = writtenMask != 0 && (!isDepthTestNeeded || _mm256_movemask_ps(farthestOverwritten) != 0);
+
+		__m128 nearest = _mm_min_ps(_mm256_castps256_ps128(nearestWritten), _mm256_extractf128_ps(nearestWritten, 1));
+		nearest = _mm_min_ps(nearest, _mm_movehl_ps(nearest, nearest));
+		nearest = _mm_min_ss(nearest, _mm_shuffle_ps(nearest, nearest, 1));
+		update.nearestWritten = _mm_cvtss_f32(nearest);
+		return update;
+	}
+#else
+	inline int32_t ToQuarterPixels(float current, float currentW, float previous, float previousW, float scale)
+	{
+		float difference = previous / previousW - current / currentW;
+		float rounded = std::floor(difference * scale + 0.5f);
+		rounded = std::min(std::max(rounded, -32768.0f), 32767.0f);
+		return static_cast<int32_t>(rounded);
+	}
+
+	// Same as the AVX2 version, with the lanes as arrays. The arithmetic is done in the same order, so both
+	// produce the same images.
+	TileDepthUpdate RasterizeTile(
+		TileEdges const& tileEdges,
+		TileAttributes const& attributes,
+		int tileX,
+		int tileY,
+		bool isDepthTestNeeded,
+		float tileFarthest,
+		DrawTarget const& target,
+		RasterizerStats& stats)
+	{
+		RenderSize viewport = target.viewport;
+		TileMotionTarget const* motion = target.motion;
+
+		TileDepthUpdate update;
+		update.writtenMask = 0;
+		update.isFarthestOverwritten = false;
+		update.nearestWritten = tileFarthest;
+
+		int columnCount = std::min(c_tileSize, viewport.width - tileX);
+		int rowCount = std::min(c_tileSize, viewport.height - tileY);
+
+		int32_t edgeValues[3][c_tileSize];
+		float z[c_tileSize];
+		float invW[c_tileSize];
+		float colorOverW[3][c_tileSize];
+		float clipOverW[6][c_tileSize];
+		for (int column = 0; column < c_tileSize; ++column)
+		{
+			for (int i = 0; i < tileEdges.count; ++i)
+			{
+				edgeValues[i][column] = tileEdges.origin[i] + tileEdges.dx[i] * column;
+			}
+			z[column] = attributes.z.origin + attributes.z.dx * static_cast<float>(column);
+			invW[column] = attributes.invW.origin + attributes.invW.dx * static_cast<float>(column);
+			for (int channel = 0; channel < 3; ++channel)
+			{
+				colorOverW[channel][column] = attributes.colorOverW[channel].origin + attributes.colorOverW[channel].dx * static_cast<float>(column);
+			}
+			for (int i = 0; motion && i < 6; ++i)
+			{
+				clipOverW[i][column] = attributes.clipOverW[i].origin + attributes.clipOverW[i].dx * static_cast<float>(column);
+			}
+		}
+
+		for (int row = 0; row < rowCount; ++row)
+		{
+			float* depthRow = target.depth->GetRow(tileY + row) + tileX;
+			uint32_t* colorRow = target.color->GetRow(tileY + row) + tileX;
+
+			for (int column = 0; column < columnCount; ++column)
+			{
+				bool inside = true;
+				for (int i = 0; i < tileEdges.count; ++i)
+				{
+					inside = inside && edgeValues[i][column] >= 0;
+				}
+				if (!inside)
+				{
+					continue;
+				}
+				++stats.fragmentsCovered;
+
+				if ((isDepthTestNeeded && !(z[column] < depthRow[column])) || z[column] < 0.0f || z[column] > 1.0f)
+				{
+					continue;
+				}
+				++stats.fragmentsShaded;
+				update.writtenMask |= 1ull << (row * c_tileSize + column);
+				update.isFarthestOverwritten = update.isFarthestOverwritten || !isDepthTestNeeded || depthRow[column] >= tileFarthest;
+				update.nearestWritten = std::min(update.nearestWritten, z[column]);
+				depthRow[column] = z[column];
+
+				float w = 1.0f / invW[column];
+				colorRow[column] = PackBgra8(colorOverW[0][column] * w, colorOverW[1][column] * w, colorOverW[2][column] * w, 1.0f);
+
+				if (motion)
+				{
+					MotionVector& vector = motion->image->At(tileX + column, tileY + row);
+					vector.x = static_cast<int16_t>(ToQuarterPixels(clipOverW[0][column], clipOverW[2][column], clipOverW[3][column], clipOverW[5][column], motion->scaleX));
+					vector.y = static_cast<int16_t>(ToQuarterPixels(clipOverW[1][column], clipOverW[2][column], clipOverW[4][column], clipOverW[5][column], motion->scaleY));
+				}
+			}
+
+			for (int column = 0; column < c_tileSize; ++column)
+			{
+				for (int i = 0; i < tileEdges.count; ++i)
+				{
+					edgeValues[i][column] += tileEdges.dy[i];
+				}
+				z[column] += attributes.z.dy;
+				invW[column] += attributes.invW.dy;
+				for (int channel = 0; channel < 3; ++channel)
+				{
+					colorOverW[channel][column] += attributes.colorOverW[channel].dy;
+				}
+				for (int i = 0; motion && i < 6; ++i)
+				{
+					clipOverW[i][column] += attributes.clipOverW[i].dy;
+				}
+			}
+		}
+		return update;
+	}
+#endif
+
+	// The nearest and farthest depth stored in a tile, over the part of it that's in the viewport.
+	void GetStoredDepthRange(ImageD32 const& depth, RenderSize viewport, int tileX, int tileY, float& nearest, float& farthest)
+	{
+		int columnCount = std::min(c_tileSize, viewport.width - tileX);
+		int rowCount = std::min(c_tileSize, viewport.height - tileY);
+
+#if defined(__AVX2__)
+		if (columnCount == c_tileSize && rowCount == c_tileSize)
+		{
+			__m256 nearestRow = _mm256_loadu_ps(depth.GetRow(tileY) + tileX);
+			__m256 farthestRow = nearestRow;
+			for (int row = 1; row < c_tileSize; ++row)
+			{
+				__m256 depthRow = _mm256_loadu_ps(depth.GetRow(tileY + row) + tileX);
+				nearestRow = _mm256_min_ps(nearestRow, depthRow);
+				farthestRow = _mm256_max_ps(farthestRow, depthRow);
+			}
+
+			float nearestLanes[8];
+			float farthestLanes[8];
+			_mm256_storeu_ps(nearestLanes, nearestRow);
+			_mm256_storeu_ps(farthestLanes, farthestRow);
+			nearest = *std::min_element(nearestLanes, nearestLanes + 8);
+			farthest = *std::max_element(farthestLanes, farthestLanes + 8);
+			return;
+		}
+#endif
+
+		nearest = depth.At(tileX, tileY);
+		farthest = nearest;
+		for (int row = 0; row < rowCount; ++row)
+		{
+			float const* depthRow = depth.GetRow(tileY + row) + tileX;
+			for (int column = 0; column < columnCount; ++column)
+			{
+				nearest = std::min(nearest, depthRow[column]);
+				farthest = std::max(farthest, depthRow[column]);
+			}
+		}
+	}
+
+	// Every pixel of a tile that's in the viewport, in the layout of TileDepthUpdate::writtenMask.
+	uint64_t GetFullTileCoverage(RenderSize viewport, int tileX, int tileY)
+	{
+		int columnCount = std::min(c_tileSize, viewport.width - tileX);
+		int rowCount = std::min(c_tileSize, viewport.height - tileY);
+
+		uint64_t coverage = 0;
+		for (int row = 0; row < rowCount; ++row)
+		{
+			coverage |= ((1ull << columnCount) - 1) << (row * c_tileSize);
+		}
+		return coverage;
+	}
+
+	// Where a triangle's depth can be over a rectangle of pixels: within its plane's range over the
+	// rectangle, and within the range of its vertices. Widened by c_depthTolerance.
+	void GetTriangleDepthRange(TriangleSetup const& setup, int x, int y, int width, int height, float& nearest, float& farthest)
+	{
+		Plane const& z = setup.z;
+		double origin = z.origin + z.dx * x + z.dy * y;
+		double extentX = z.dx * (width - 1);
+		double extentY = z.dy * (height - 1);
+		double minimum = origin + std::min(extentX, 0.0) + std::min(extentY, 0.0);
+		double maximum = origin + std::max(extentX, 0.0) + std::max(extentY, 0.0);
+
+		nearest = std::max(static_cast<float>(minimum), setup.minZ) - c_depthTolerance;
+		farthest = std::min(static_cast<float>(maximum), setup.maxZ) + c_depthTolerance;
+	}
+
+	float GetBinFarthestDepth(DepthHierarchyView const& hierarchy, RenderSize viewport, int binX, int binY)
+	{
+		int bin = binY * hierarchy.binsX + binX;
+		if (hierarchy.isBinFarthestStale[bin])
+		{
+			int firstTileX = binX * c_tilesPerBin;
+			int firstTileY = binY * c_tilesPerBin;
+			int endTileX = std::min(firstTileX + c_tilesPerBin, hierarchy.tilesX);
+			int endTileY = std::min(firstTileY + c_tilesPerBin, (viewport.height + c_tileSize - 1) / c_tileSize);
+
+			float farthest = hierarchy.tileFarthest[firstTileY * hierarchy.tilesX + firstTileX];
+			for (int tileY = firstTileY; tileY < endTileY; ++tileY)
+			{
+				for (int tileX = firstTileX; tileX < endTileX; ++tileX)
+				{
+					farthest = std::max(farthest, hierarchy.tileFarthest[tileY * hierarchy.tilesX + tileX]);
+				}
+			}
+			hierarchy.binFarthest[bin] = farthest;
+			hierarchy.isBinFarthestStale[bin] = 0;
+		}
+		return hierarchy.binFarthest[bin];
+	}
+
+	// Draws the 8x8 tiles of a triangle that fall within [x0, x1] x [y0, y1], which are in pixels, inclusive.
+	// The rectangle's left and top have to be on tile boundaries.
+	void DrawTriangleTiles(
+		TriangleSetup const& setup,
+		int x0,
+		int y0,
+		int x1,
+		int y1,
+		DrawTarget const& target,
+		RasterizerStats& stats)
+	{
+		DepthHierarchyView const* hierarchy = target.hierarchy;
+
+		// Tiles are aligned to the target, so that rows of 8 start at the same columns for every triangle.
+		int firstTileX = std::max(x0, setup.x0 - setup.x0 % c_tileSize);
+		int firstTileY = std::max(y0, setup.y0 - setup.y0 % c_tileSize);
+		int lastX = std::min(x1, setup.x1);
+		int lastY = std::min(y1, setup.y1);
+
+		for (int tileY = firstTileY; tileY <= lastY; tileY += c_tileSize)
+		{
+			for (int tileX = firstTileX; tileX <= lastX; tileX += c_tileSize)
+			{
+				TileEdges tileEdges;
+				if (!ClassifyTile(setup, tileX, tileY, tileEdges))
+				{
+					continue;
+				}
+				++stats.tilesTested;
+
+				// Depth passes if it's LESS than what's stored, so a triangle entirely at or behind the farthest
+				// stored depth can't pass anywhere, and one entirely in front of the nearest passes everywhere.
+				bool isDepthTestNeeded = true;
+				int tile = hierarchy ? (tileY / c_tileSize) * hierarchy->tilesX + tileX / c_tileSize : 0;
+				if (hierarchy)
+				{
+					float nearest;
+					float farthest;
+					GetTriangleDepthRange(setup, tileX, tileY, c_tileSize, c_tileSize, nearest, farthest);
+					if (nearest >= hierarchy->tileFarthest[tile])
+					{
+						++stats.tilesRejected;
+						continue;
+					}
+					if (farthest < hierarchy->tileNearest[tile])
+					{
+						++stats.tilesAccepted;
+						isDepthTestNeeded = false;
+					}
+				}
+
+				TileAttributes attributes;
+				attributes.z = RebasePlane(setup.z, tileX, tileY);
+				attributes.invW = RebasePlane(setup.invW, tileX, tileY);
+				for (int channel = 0; channel < 3; ++channel)
+				{
+					attributes.colorOverW[channel] = RebasePlane(setup.colorOverW[channel], tileX, tileY);
+				}
+				for (int i = 0; target.motion && i < 6; ++i)
+				{
+					attributes.clipOverW[i] = RebasePlane(setup.clipOverW[i], tileX, tileY);
+				}
+
+				// Without the hierarchy, the farthest depth is taken to be the far plane, which nothing is at or
+				// behind once it's passed the depth test.
+				float tileFarthest = hierarchy ? hierarchy->tileFarthest[tile] : 1.0f;
+				TileDepthUpdate update = RasterizeTile(tileEdges, attributes, tileX, tileY, isDepthTestNeeded, tileFarthest, target, stats);
+
+				if (hierarchy && update.writtenMask != 0)
+				{
+					hierarchy->tileNearest[tile] = std::min(hierarchy->tileNearest[tile], update.nearestWritten);
+					hierarchy->tileCoverage[tile] |= update.writtenMask;
+
+					// Only reading the tile back says how much nearer its farthest depth got. Until every pixel has
+					// been written, some are still at the cleared depth, which nothing that passed is behind.
+					if (update.isFarthestOverwritten && hierarchy->tileCoverage[tile] == GetFullTileCoverage(target.viewport, tileX, tileY))
+					{
+						float nearest;
+						GetStoredDepthRange(*target.depth, target.viewport, tileX, tileY, nearest, hierarchy->tileFarthest[tile]);
+						if (hierarchy->tileFarthest[tile] != tileFarthest)
+						{
+							hierarchy->isBinFarthestStale[(tileY / c_binSize) * hierarchy->binsX + tileX / c_binSize] = 1;
+						}
+					}
+				}
+			}
+		}
+	}
+
+	// Draws the part of a triangle in one bin, unless it's entirely behind what's been drawn there.
+	void DrawTriangleInBin(TriangleSetup const& setup, int binX, int binY, DrawTarget const& target, RasterizerStats& stats)
+	{
+		int x0 = binX * c_binSize;
+		int y0 = binY * c_binSize;
+		int x1 = std::min(x0 + c_binSize, target.viewport.width) - 1;
+		int y1 = std::min(y0 + c_binSize, target.viewport.height) - 1;
+
+		++stats.triangleBinsTested;
+		if (target.hierarchy)
+		{
+			int left = std::max(x0, setup.x0);
+			int top = std::max(y0, setup.y0);
+			int right = std::min(x1, setup.x1);
+			int bottom = std::min(y1, setup.y1);
+
+			float nearest;
+			float farthest;
+			GetTriangleDepthRange(setup, left, top, right - left + 1, bottom - top + 1, nearest, farthest);
+			if (nearest >= GetBinFarthestDepth(*target.hierarchy, target.viewport, binX, binY))
+			{
+				++stats.triangleBinsRejected;
+				return;
+			}
+		}
+
+		DrawTriangleTiles(setup, x0, y0, x1, y1, target, stats);
+	}
+
+	// There's no near plane clipping. Triangles with a vertex behind the camera are dropped, which is fine
+	// for a scene that stays in front of it. So are triangles entirely outside the view volume, which
+	// couldn't have covered anything.
+	inline bool IsTriangleCulled(uint8_t outcode0, uint8_t outcode1, uint8_t outcode2)
+	{
+		return ((outcode0 | outcode1 | outcode2) & ClipOutcodeBehindCamera) != 0 || (outcode0 & outcode1 & outcode2 & ClipOutcodePlanes) != 0;
+	}
+
+	// Converts the vertices in [first, end) of the transformed vertices to screen space, except the ones
+	// behind the camera. Each is colored with vertex i - colorOffset of the mesh.
+	void ToScreenVertices(
+		int first,
+		int end,
+		int colorOffset,
+		SceneVertex const* vertices,
+		ClipVertices const& clip,
+		ClipVertices const* currentMotion,
+		ClipVertices const* previousMotion,
+		RenderSize viewport,
+		ScreenVertex* screenVertices)
+	{
+		for (int i = first; i < end; ++i)
+		{
+			if (clip.outcodes[i] & ClipOutcodeBehindCamera)
+			{
+				continue;
+			}
+			screenVertices[i] = ToScreen(clip.Get(i), vertices[i - colorOffset].color, viewport);
+			if (currentMotion)
+			{
+				SetMotion(screenVertices[i], currentMotion->Get(i), previousMotion->Get(i));
+			}
+		}
+	}
+
+	DepthHierarchyView MakeDepthHierarchyView(
+		std::vector<float>& tileNearest,
+		std::vector<float>& tileFarthest,
+		std::vector<uint64_t>& tileCoverage,
+		std::vector<float>& binFarthest,
+		std::vector<uint8_t>& isBinFarthestStale,
+		RenderSize viewport)
+	{
+		DepthHierarchyView view;
+		view.tileNearest = tileNearest.data();
+		view.tileFarthest = tileFarthest.data();
+		view.tileCoverage = tileCoverage.data();
+		view.binFarthest = binFarthest.data();
+		view.isBinFarthestStale = isBinFarthestStale.data();
+		view.tilesX = (viewport.width + c_tileSize - 1) / c_tileSize;
+		view.binsX = (viewport.width + c_binSize - 1) / c_binSize;
+		return view;
+	}
+
+	// Screen space is y down, and motion vectors are in quarter pixels.
+	TileMotionTarget GetTileMotionTarget(SoftwareRasterizer::MotionOutput const& motion, RenderSize viewport)
+	{
+		TileMotionTarget target;
+		target.image = motion.motionVectors;
+		target.scaleX = 0.5f * viewport.width * 4.0f;
+		target.scaleY = -0.5f * viewport.height * 4.0f;
+		return target;
+	}
+}
+
+// What drawing keeps between draws, so that it only allocates while the scene grows.
+struct SoftwareRasterizer::DrawState
+{
+	VertexPositions positions;
+
+	// Transformed by the instances' model-view-projections, and for motion vectors, by their current and
+	// previous unjittered transforms.
+	ClipVertices clip;
+	ClipVertices currentMotion;
+	ClipVertices previousMotion;
+
+	std::vector<ScreenVertex> screenVertices;
+
+	// Only for the binned path.
+	std::vector<TriangleSetup> setups;
+
+	// Triangles that touch each bin, one list per chunk of triangles. Bins go through the chunks in order,
+	// so triangles are drawn in the order they were submitted, whatever order the chunks were binned in.
+	std::vector<std::vector<std::vector<uint32_t>>> chunkBins;
+};
+
+RasterizerStats& RasterizerStats::operator+=(RasterizerStats const& other)
+{
+	triangleBinsTested += other.triangleBinsTested;
+	triangleBinsRejected += other.triangleBinsRejected;
+	tilesTested += other.tilesTested;
+	tilesRejected += other.tilesRejected;
+	tilesAccepted += other.tilesAccepted;
+	fragmentsCovered += other.fragmentsCovered;
+	fragmentsShaded += other.fragmentsShaded;
+	return *this;
+}
+
+SoftwareRasterizer::SoftwareRasterizer(JobSystem* jobs)
+	: m_jobs(jobs && jobs->GetWorkerCount() > 1 ? jobs : nullptr)
+	, m_drawState(new DrawState())
+	, m_isHierarchicalDepthEnabled(true)
+	, m_hierarchyDepth(nullptr)
+	, m_hierarchyViewport{}
+	, m_stats{}
+{
+}
+
+SoftwareRasterizer::~SoftwareRasterizer()
+{
+}
+
+int SoftwareRasterizer::GetWorkerCount() const
+{
+	return m_jobs ? m_jobs->GetWorkerCount() : 1;
+}
+
+uint32_t scaling::PackBgra8(float r, float g, float b, float a)
+{
+	auto toUnorm = [](float value)
+	{
+		value = std::min(std::max(value, 0.0f), 1.0f);
+		return static_cast<uint32_t>(value * 255.0f + 0.5f);
+	};
+	return (toUnorm(a) << 24) | (toUnorm(r) << 16) | (toUnorm(g) << 8) | toUnorm(b);
+}
+
+// Sizes the hierarchy for the viewport, and fills it in from the depth target unless it already describes it.
+void SoftwareRasterizer::PrepareDepthHierarchy(ImageD32 const& depth, RenderSize viewport)
+{
+	if (m_hierarchyDepth == &depth && m_hierarchyViewport.width == viewport.width && m_hierarchyViewport.height == viewport.height)
+	{
+		return;
+	}
+
+	int tilesX = (viewport.width + c_tileSize - 1) / c_tileSize;
+	int tilesY = (viewport.height + c_tileSize - 1) / c_tileSize;
+	int binsX = (viewport.width + c_binSize - 1) / c_binSize;
+	int binsY = (viewport.height + c_binSize - 1) / c_binSize;
+	m_tileNearestDepth.resize(tilesX * tilesY);
+	m_tileFarthestDepth.resize(tilesX * tilesY);
+	m_tileCoverage.resize(tilesX * tilesY);
+	m_binFarthestDepth.resize(binsX * binsY);
+	m_isBinFarthestDepthStale.assign(binsX * binsY, 1);
+
+	for (int tileY = 0; tileY < tilesY; ++tileY)
+	{
+		for (int tileX = 0; tileX < tilesX; ++tileX)
+		{
+			int tile = tileY * tilesX + tileX;
+			GetStoredDepthRange(depth, viewport, tileX * c_tileSize, tileY * c_tileSize, m_tileNearestDepth[tile], m_tileFarthestDepth[tile]);
+			m_tileCoverage[tile] = GetFullTileCoverage(viewport, tileX * c_tileSize, tileY * c_tileSize);
+		}
+	}
+
+	m_hierarchyDepth = &depth;
+	m_hierarchyViewport = viewport;
+}
+
+void SoftwareRasterizer::Clear(ImageBgra8& color, ImageD32& depth, RenderSize viewport, uint32_t clearColor, float clearDepth, ImageMotionVectors* motionVectors)
+{
+	m_stats = RasterizerStats{};
+
+	// Cleared along with the target, rather than rebuilt from it.
+	m_hierarchyDepth = nullptr;
+	if (m_isHierarchicalDepthEnabled)
+	{
+		int tilesX = (viewport.width + c_tileSize - 1) / c_tileSize;
+		int tilesY = (viewport.height + c_tileSize - 1) / c_tileSize;
+		int binsX = (viewport.width + c_binSize - 1) / c_binSize;
+		int binsY = (viewport.height + c_binSize - 1) / c_binSize;
+		m_tileNearestDepth.assign(tilesX * tilesY, clearDepth);
+		m_tileFarthestDepth.assign(tilesX * tilesY, clearDepth);
+		m_tileCoverage.assign(tilesX * tilesY, 0);
+		m_binFarthestDepth.assign(binsX * binsY, clearDepth);
+		m_isBinFarthestDepthStale.assign(binsX * binsY, 0);
+		m_hierarchyDepth = &depth;
+		m_hierarchyViewport = viewport;
+	}
+
+	auto clearRows = [&](int firstRow, int endRow)
+	{
+		for (int y = firstRow; y < endRow; ++y)
+		{
+			std::fill(color.GetRow(y), color.GetRow(y) + viewport.width, clearColor);
+			std::fill(depth.GetRow(y), depth.GetRow(y) + viewport.width, clearDepth);
+			if (motionVectors)
+			{
+				std::fill(motionVectors->GetRow(y), motionVectors->GetRow(y) + viewport.width, MotionVector{ 0, 0 });
+			}
+		}
+	};
+
+	if (!m_jobs)
+	{
+		clearRows(0, viewport.height);
+		return;
+	}
+
+	int bandCount = (viewport.height + c_binSize - 1) / c_binSize;
+	m_jobs->ParallelFor(bandCount, [&](int band, int)
+	{
+		clearRows(band * c_binSize, std::min((band + 1) * c_binSize, viewport.height));
+	});
+}
+
+void SoftwareRasterizer::DrawIndexed(
+	SceneVertex const* vertices,
+	int vertexCount,
+	uint16_t const* indices,
+	int indexCount,
+	Float4x4 const& modelViewProjection,
+	RenderSize viewport,
+	ImageBgra8& color,
+	ImageD32& depth,
+	MotionOutput const* motion)
+{
+	DrawIndexedInstanced(vertices, vertexCount, indices, indexCount, &modelViewProjection, 1, viewport, color, depth, motion);
+}
+
+void SoftwareRasterizer::DrawIndexedInstanced(
+	SceneVertex const* vertices,
+	int vertexCount,
+	uint16_t const* indices,
+	int indexCount,
+	Float4x4 const* modelViewProjections,
+	int instanceCount,
+	RenderSize viewport,
+	ImageBgra8& color,
+	ImageD32& depth,
+	MotionOutput const* motion)
+{
+	DrawState& state = *m_drawState;
+	state.positions.Load(vertices, vertexCount);
+
+	if (m_jobs)
+	{
+		int instancesPerBatch = std::max(1, c_trianglesPerBatch / std::max(1, indexCount / 3));
+		for (int first = 0; first < instanceCount; first += instancesPerBatch)
+		{
+			int count = std::min(instancesPerBatch, instanceCount - first);
+			DrawIndexedBinned(vertices, vertexCount, indices, indexCount, modelViewProjections + first, count, viewport, color, depth, motion ? motion + first : nullptr);
+		}
+		return;
+	}
+
+	TileMotionTarget motionTarget = {};
+	if (motion)
+	{
+		motionTarget = GetTileMotionTarget(*motion, viewport);
+	}
+
+	DepthHierarchyView hierarchy = {};
+	if (m_isHierarchicalDepthEnabled)
+	{
+		PrepareDepthHierarchy(depth, viewport);
+		hierarchy = MakeDepthHierarchyView(m_tileNearestDepth, m_tileFarthestDepth, m_tileCoverage, m_binFarthestDepth, m_isBinFarthestDepthStale, viewport);
+	}
+
+	DrawTarget target = { viewport, &color, &depth, motion ? &motionTarget : nullptr, m_isHierarchicalDepthEnabled ? &hierarchy : nullptr };
+
+	// Each vertex is transformed once per instance, however many triangles share it.
+	int batchCount = state.positions.GetBatchCount();
+	state.clip.Reserve(vertexCount);
+	if (motion)
+	{
+		state.currentMotion.Reserve(vertexCount);
+		state.previousMotion.Reserve(vertexCount);
+	}
+	state.screenVertices.resize(vertexCount);
+
+	for (int instance = 0; instance < instanceCount; ++instance)
+	{
+		TransformVertices(state.positions, 0, batchCount, modelViewProjections[instance], state.clip, 0);
+		if (motion)
+		{
+			TransformVertices(state.positions, 0, batchCount, motion[instance].current, state.currentMotion, 0);
+			TransformVertices(state.positions, 0, batchCount, motion[instance].previous, state.previousMotion, 0);
+		}
+		ToScreenVertices(0, vertexCount, 0, vertices, state.clip, motion ? &state.currentMotion : nullptr, &state.previousMotion, viewport, state.screenVertices.data());
+
+		uint8_t const* outcodes = state.clip.outcodes.data();
+		for (int i = 0; i + 2 < indexCount; i += 3)
+		{
+			uint16_t const* corners = indices + i;
+			if (IsTriangleCulled(outcodes[corners[0]], outcodes[corners[1]], outcodes[corners[2]]))
+			{
+				continue;
+			}
+			ScreenVertex v[3] = { state.screenVertices[corners[0]], state.screenVertices[corners[1]], state.screenVertices[corners[2]] };
+
+			// Bin by bin, the way the binned path draws, so that the hierarchy is tested the same way.
+			TriangleSetup setup;
+			if (!SetUpTriangle(v, viewport, motion != nullptr, setup))
+			{
+				continue;
+			}
+			for (int binY = setup.y0 / c_binSize; binY <= setup.y1 / c_binSize; ++binY)
+			{
+				for (int binX = setup.x0 / c_binSize; binX <= setup.x1 / c_binSize; ++binX)
+				{
+					DrawTriangleInBin(setup, binX, binY, target, m_stats);
+				}
+			}
+		}
+	}
+}
+
+void SoftwareRasterizer::DrawIndexedBinned(
+	SceneVertex const* vertices,
+	int vertexCount,
+	uint16_t const* indices,
+	int indexCount,
+	Float4x4 const* modelViewProjections,
+	int instanceCount,
+	RenderSize viewport,
+	ImageBgra8& color,
+	ImageD32& depth,
+	MotionOutput const* motion)
+{
+	DrawState& state = *m_drawState;
+
+	// Vertices and triangles are numbered across the instances, one instance after the other. Each
+	// instance's vertices start on a new batch.
+	const int trianglesPerInstance = indexCount / 3;
+	const int triangleCount = trianglesPerInstance * instanceCount;
+	const int instanceBatchCount = state.positions.GetBatchCount();
+	const int instanceVertexStride = instanceBatchCount * c_vertexBatchSize;
+	const int batchCount = instanceBatchCount * instanceCount;
+	const int binsX = (viewport.width + c_binSize - 1) / c_binSize;
+	const int binsY = (viewport.height + c_binSize - 1) / c_binSize;
+	const int binCount = binsX * binsY;
+
+	// Each vertex is transformed once, however many triangles share it.
+	state.clip.Reserve(batchCount * c_vertexBatchSize);
+	if (motion)
+	{
+		state.currentMotion.Reserve(batchCount * c_vertexBatchSize);
+		state.previousMotion.Reserve(batchCount * c_vertexBatchSize);
+	}
+	state.screenVertices.resize(batchCount * c_vertexBatchSize);
+
+	const int batchesPerChunk = c_verticesPerChunk / c_vertexBatchSize;
+	int vertexChunkCount = (batchCount + batchesPerChunk - 1) / batchesPerChunk;
+	m_jobs->ParallelFor(vertexChunkCount, [&](int chunk, int)
+	{
+		int end = std::min((chunk + 1) * batchesPerChunk, batchCount);
+		for (int batch = chunk * batchesPerChunk; batch < end; )
+		{
+			// Up to the end of the chunk or the instance, whichever comes first.
+			int instance = batch / instanceBatchCount;
+			int instanceBatch = batch - instance * instanceBatchCount;
+			int count = std::min(end - batch, instanceBatchCount - instanceBatch);
+			int first = batch * c_vertexBatchSize;
+
+			TransformVertices(state.positions, instanceBatch, count, modelViewProjections[instance], state.clip, first);
+			if (motion)
+			{
+				TransformVertices(state.positions, instanceBatch, count, motion[instance].current, state.currentMotion, first);
+				TransformVertices(state.positions, instanceBatch, count, motion[instance].previous, state.previousMotion, first);
+			}
+
+			// Not the padding at the end of the instance.
+			int instanceFirst = instance * instanceVertexStride;
+			int last = std::min(first + count * c_vertexBatchSize, instanceFirst + vertexCount);
+			ToScreenVertices(first, last, instanceFirst, vertices, state.clip, motion ? &state.currentMotion : nullptr, &state.previousMotion, viewport, state.screenVertices.data());
+			batch += count;
+		}
+	});
+
+	// Set up triangles and sort them into the bins that their bounding boxes touch.
+	state.setups.resize(triangleCount);
+	int triangleChunkCount = (triangleCount + c_trianglesPerChunk - 1) / c_trianglesPerChunk;
+	if (static_cast<int>(state.chunkBins.size()) < triangleChunkCount)
+	{
+		state.chunkBins.resize(triangleChunkCount);
+	}
+	m_jobs->ParallelFor(triangleChunkCount, [&](int chunk, int)
+	{
+		std::vector<std::vector<uint32_t>>& bins = state.chunkBins[chunk];
+		bins.resize(std::max(static_cast<int>(bins.size()), binCount));
+		for (int bin = 0; bin < binCount; ++bin)
+		{
+			bins[bin].clear();
+		}
+
+		int end = std::min((chunk + 1) * c_trianglesPerChunk, triangleCount);
+		for (int triangle = chunk * c_trianglesPerChunk; triangle < end; ++triangle)
+		{
+			int instance = triangle / trianglesPerInstance;
+			uint16_t const* indexCorners = indices + (triangle - instance * trianglesPerInstance) * 3;
+			int firstVertex = instance * instanceVertexStride;
+			int corners[3] = { firstVertex + indexCorners[0], firstVertex + indexCorners[1], firstVertex + indexCorners[2] };
+			uint8_t const* outcodes = state.clip.outcodes.data();
+			if (IsTriangleCulled(outcodes[corners[0]], outcodes[corners[1]], outcodes[corners[2]]))
+			{
+				continue;
+			}
+
+			ScreenVertex v[3] = { state.screenVertices[corners[0]], state.screenVertices[corners[1]], state.screenVertices[corners[2]] };
+			TriangleSetup& setup = state.setups[triangle];
+			if (!SetUpTriangle(v, viewport, motion != nullptr, setup))
+			{
+				continue;
+			}
+
+			for (int binY = setup.y0 / c_binSize; binY <= setup.y1 / c_binSize; ++binY)
+			{
+				for (int binX = setup.x0 / c_binSize; binX <= setup.x1 / c_binSize; ++binX)
+				{
+					bins[binY * binsX + binX].push_back(static_cast<uint32_t>(triangle));
+				}
+			}
+		}
+	});
+
+	TileMotionTarget motionTarget = {};
+	if (motion)
+	{
+		motionTarget = GetTileMotionTarget(*motion, viewport);
+	}
+
+	DepthHierarchyView hierarchy = {};
+	if (m_isHierarchicalDepthEnabled)
+	{
+		PrepareDepthHierarchy(depth, viewport);
+		hierarchy = MakeDepthHierarchyView(m_tileNearestDepth, m_tileFarthestDepth, m_tileCoverage, m_binFarthestDepth, m_isBinFarthestDepthStale, viewport);
+	}
+
+	DrawTarget target = { viewport, &color, &depth, motion ? &motionTarget : nullptr, m_isHierarchicalDepthEnabled ? &hierarchy : nullptr };
+
+	// Each bin is drawn by one worker, so no two workers write the same pixels, or the same parts of the
+	// hierarchy.
+	m_workerStats.assign(m_jobs->GetWorkerIndexCount(), RasterizerStats{});
+	m_jobs->ParallelForTiles(viewport.width, viewport.height, c_binSize, c_binSize, [&](Tile const& bin, int worker)
+	{
+		for (int chunk = 0; chunk < triangleChunkCount; ++chunk)
+		{
+			for (uint32_t triangle : state.chunkBins[chunk][bin.index])
+			{
+				DrawTriangleInBin(state.setups[triangle], bin.x / c_binSize, bin.y / c_binSize, target, m_workerStats[worker]);
+			}
+		}
+	});
+
+	for (RasterizerStats const& stats : m_workerStats)
+	{
+		m_stats += stats;
+	}
+}
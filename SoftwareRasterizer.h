@@ -0,0 +1,164 @@
+#pragma once
+
+#include "CpuImage.h"
+#include "QualityPreset.h"
+#include "JobSystem.h"
+#include "SceneGeometry.h"
+
+#include <memory>
+#include <vector>
+
+namespace scaling
+{
+	// Work done by a SoftwareRasterizer since it last cleared. Triangles are tested against the depth
+	// hierarchy once for every bin they touch, and then tile by tile.
+	struct RasterizerStats
+	{
+		uint64_t triangleBinsTested;
+		uint64_t triangleBinsRejected;	// Entirely behind everything drawn in the bin so far
+		uint64_t tilesTested;			// Tiles a triangle covers at least part of
+		uint64_t tilesRejected;			// Entirely behind everything drawn in the tile so far
+		uint64_t tilesAccepted;			// Entirely in front, so drawn without reading depth
+		uint64_t fragmentsCovered;		// Pixels inside triangles, in tiles that weren't rejected
+		uint64_t fragmentsShaded;		// Of those, the ones that passed the depth test and were written
+
+		// Fragments shaded per pixel of the viewport.
+		double GetOverdraw(RenderSize viewport) const
+		{
+			return static_cast<double>(fragmentsShaded) / (static_cast<double>(viewport.width) * viewport.height);
+		}
+
+		// The fraction of tiles that a triangle covers but the hierarchy rejected.
+		double GetTileRejectionRate() const
+		{
+			return tilesTested ? static_cast<double>(tilesRejected) / tilesTested : 0.0;
+		}
+
+		RasterizerStats& operator+=(RasterizerStats const& other);
+	};
+
+	// Draws triangles on the CPU the way pass 1's pipeline state does: back faces culled, depth test LESS
+	// against D32, per-vertex color interpolated with perspective correction, and the top-left fill rule.
+	// Only the viewport sub-rect at the top left of the targets is touched.
+	//
+	// Vertices are transformed once per instance, 8 at a time by TransformVertices, and a triangle whose
+	// vertices are all outside the same plane of the view volume is dropped before setup.
+	//
+	// Each triangle is walked in c_tileSize x c_tileSize tiles over its bounding box. A tile that one of the
+	// edges misses entirely is skipped, and an edge that covers a whole tile isn't tested inside it. The rest
+	// is evaluated a row of 8 pixels at a time, with AVX2 when the file is built for it.
+	//
+	// With more than one worker, drawing is sort-middle: vertices are transformed and triangles set up in
+	// parallel chunks, which sort the triangles into c_binSize x c_binSize bins of the target. Then each bin
+	// is drawn by one job, so no two workers write the same pixels. Either way, triangles are drawn in the
+	// order they're submitted, so the images don't depend on the number of workers.
+	//
+	// A depth hierarchy keeps the nearest and farthest depth of every tile, and the farthest of every bin,
+	// up to date as tiles are drawn. A triangle that's entirely behind a bin's farthest depth skips the bin,
+	// and the same goes for tiles; a tile that's entirely in front of its nearest depth is drawn without
+	// reading depth. Both are conservative, so the images are the same with the hierarchy off. It describes
+	// the depth target that was last cleared or drawn to, and is rebuilt from the target when that changes,
+	// so the target shouldn't be written to by anything else in between.
+	class SoftwareRasterizer
+	{
+	public:
+		static const int c_tileSize = 8;
+		static const int c_binSize = 64;
+
+		// Has DrawIndexed write a motion vector for every pixel it draws: from where the pixel's surface is
+		// in the current frame to where it was in the previous one, in quarter pixels. Both transforms are
+		// without jitter, so that the vectors only hold the motion of the scene.
+		struct MotionOutput
+		{
+			Float4x4 current;
+			Float4x4 previous;
+			ImageMotionVectors* motionVectors;
+		};
+
+		// Runs on the calling thread alone without a job system. The job system must outlive the rasterizer.
+		explicit SoftwareRasterizer(JobSystem* jobs = nullptr);
+		~SoftwareRasterizer();
+
+		int GetWorkerCount() const;
+
+		// On unless this is called. Off is for comparing against.
+		void SetHierarchicalDepthEnabled(bool isEnabled) { m_isHierarchicalDepthEnabled = isEnabled; m_hierarchyDepth = nullptr; }
+		bool IsHierarchicalDepthEnabled() const { return m_isHierarchicalDepthEnabled; }
+
+		// Since the last Clear.
+		RasterizerStats const& GetStats() const { return m_stats; }
+
+		// Motion vectors are cleared to no motion.
+		void Clear(ImageBgra8& color, ImageD32& depth, RenderSize viewport, uint32_t clearColor, float clearDepth, ImageMotionVectors* motionVectors = nullptr);
+
+		void DrawIndexed(
+			SceneVertex const* vertices,
+			int vertexCount,
+			uint16_t const* indices,
+			int indexCount,
+			Float4x4 const& modelViewProjection,
+			RenderSize viewport,
+			ImageBgra8& color,
+			ImageD32& depth,
+			MotionOutput const* motion = nullptr);
+
+		// Draws the mesh once for every instance, with the instance's transform, in the order of the instances.
+		// When motion is given, it has an entry for every instance, all with the same motion vector image.
+		void DrawIndexedInstanced(
+			SceneVertex const* vertices,
+			int vertexCount,
+			uint16_t const* indices,
+			int indexCount,
+			Float4x4 const* modelViewProjections,
+			int instanceCount,
+			RenderSize viewport,
+			ImageBgra8& color,
+			ImageD32& depth,
+			MotionOutput const* motion = nullptr);
+
+	private:
+		struct DrawState;
+
+		static const int c_verticesPerChunk = 4096;
+		static const int c_trianglesPerChunk = 2048;
+
+		// The binned path sets up this many triangles at most before drawing them, which bounds the memory
+		// it needs when there are many instances.
+		static const int c_trianglesPerBatch = 128 * 1024;
+
+		// Draws a batch of instances.
+		void DrawIndexedBinned(
+			SceneVertex const* vertices,
+			int vertexCount,
+			uint16_t const* indices,
+			int indexCount,
+			Float4x4 const* modelViewProjections,
+			int instanceCount,
+			RenderSize viewport,
+			ImageBgra8& color,
+			ImageD32& depth,
+			MotionOutput const* motion);
+
+		void PrepareDepthHierarchy(ImageD32 const& depth, RenderSize viewport);
+
+		// Only used with more than one worker.
+		JobSystem* m_jobs;
+
+		std::unique_ptr<DrawState> m_drawState;
+
+		bool m_isHierarchicalDepthEnabled;
+		ImageD32 const* m_hierarchyDepth;	// What the hierarchy describes, if anything
+		RenderSize m_hierarchyViewport;
+		std::vector<float> m_tileNearestDepth;
+		std::vector<float> m_tileFarthestDepth;
+		std::vector<uint64_t> m_tileCoverage;	// Pixels written since the clear, a bit per pixel
+		std::vector<float> m_binFarthestDepth;
+		std::vector<uint8_t> m_isBinFarthestDepthStale; // Recomputed from the tiles when next needed
+
+		RasterizerStats m_stats;
+		std::vector<RasterizerStats> m_workerStats;
+	};
+
+	// Converts a color with channels in [0, 1] to the layout of DXGI_FORMAT_B8G8R8A8_UNORM.
+	uint32_t PackBgra8(float r, float g, float b, float a);
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace scaling
+{
+	// A bounded queue between exactly one producer thread and one consumer thread, without locks: each side
+	// only writes its own index, and publishes it with release so that the other side sees the slot it
+	// covers. The indices are on cache lines of their own so the two threads don't contend for them. A
+	// consumer with nothing to do can sleep on the producer's index until a push changes it.
+	template<typename T>
+	class SpscRing
+	{
+	public:
+		// One slot is left empty, to tell full from empty.
+		explicit SpscRing(size_t capacity)
+			: m_slots(capacity + 1)
+			, m_head(0)
+			, m_tail(0)
+		{
+		}
+
+		SpscRing(SpscRing const&) = delete;
+		SpscRing& operator=(SpscRing const&) = delete;
+
+		size_t GetCapacity() const { return m_slots.size() - 1; }
+
+		// Producer only. False when the ring is full.
+		bool TryPush(T const& value)
+		{
+			size_t tail = m_tail.load(std::memory_order_relaxed);
+			size_t next = Advance(tail);
+			if (next == m_head.load(std::memory_order_acquire))
+			{
+				return false;
+			}
+			m_slots[tail] = value;
+			m_tail.store(next, std::memory_order_release);
+			m_tail.notify_one();
+			return true;
+		}
+
+		// Consumer only. False when the ring is empty.
+		bool TryPop(T& value)
+		{
+			size_t head = m_head.load(std::memory_order_relaxed);
+			if (head == m_tail.load(std::memory_order_acquire))
+			{
+				return false;
+			}
+			value = m_slots[head];
+			m_head.store(Advance(head), std::memory_order_release);
+			return true;
+		}
+
+		// Consumer only. Blocks the thread until there's something to pop.
+		void WaitWhileEmpty() const
+		{
+			size_t head = m_head.load(std::memory_order_relaxed);
+			m_tail.wait(head, std::memory_order_acquire);
+		}
+
+		// Either side. Only a snapshot, since the other side may be moving.
+		size_t GetSize() const
+		{
+			size_t head = m_head.load(std::memory_order_acquire);
+			size_t tail = m_tail.load(std::memory_order_acquire);
+			return tail >= head ? tail - head : tail + m_slots.size() - head;
+		}
+
+	private:
+		size_t Advance(size_t index) const { return index + 1 == m_slots.size() ? 0 : index + 1; }
+
+		std::vector<T> m_slots;
+		alignas(64) std::atomic<size_t> m_head;	// Next slot to pop
+		alignas(64) std::atomic<size_t> m_tail;	// Next slot to push
+	};
+}
@@ -1,10 +1,14 @@
 ﻿#pragma once
 
-#include <wrl.h>
+#include "FrameTimeHistogram.h"
 
-typedef unsigned __int64 uint64;
-typedef __int64 int64;
-typedef unsigned int uint32;
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+
+typedef std::uint64_t uint64;
+typedef std::int64_t int64;
+typedef std::uint32_t uint32;
 
 namespace DX
 {
@@ -13,28 +17,21 @@ namespace DX
 	{
 	public:
 		StepTimer() : 
+			m_lastTime(Clock::now()),
+			m_maxDelta(ClockFrequency / 10), // Initialize max delta to 1/10 of a second.
+			m_isTimingFrames(false),
 			m_elapsedTicks(0),
 			m_totalTicks(0),
 			m_leftOverTicks(0),
 			m_frameCount(0),
 			m_framesPerSecond(0),
 			m_framesThisSecond(0),
-			m_qpcSecondCounter(0),
+			m_secondCounter(0),
+			m_sliceCounter(0),
+			m_sliceIndex(0),
 			m_isFixedTimeStep(false),
 			m_targetElapsedTicks(TicksPerSecond / 60)
 		{
-			if (!QueryPerformanceFrequency(&m_qpcFrequency))
-			{
-				throw std::exception();
-			}
-
-			if (!QueryPerformanceCounter(&m_qpcLastTime))
-			{
-				throw std::exception();
-			}
-
-			// Initialize max delta to 1/10 of a second.
-			m_qpcMaxDelta = m_qpcFrequency.QuadPart / 10;
 		}
 
 		// Get elapsed time since the previous Update call.
@@ -51,6 +48,21 @@ namespace DX
 		// Get the current framerate.
 		uint32 GetFramesPerSecond() const					{ return m_framesPerSecond; }
 
+		// The real time between ticks, since the start of the program, and over the last second. The last
+		// second rolls forward a tenth of a second at a time: it's the frames of the current tenth and the
+		// nine before it, each kept in a histogram of its own, and summed when asked for. The first tick
+		// after a reset isn't counted.
+		scaling::FrameTimeHistogram const& GetFrameTimes() const	{ return m_frameTimes; }
+		scaling::FrameTimeHistogram GetLastSecondFrameTimes() const
+		{
+			scaling::FrameTimeHistogram frameTimes;
+			for (scaling::FrameTimeHistogram const& slice : m_sliceFrameTimes)
+			{
+				frameTimes.Merge(slice);
+			}
+			return frameTimes;
+		}
+
 		// Set whether to use fixed or variable timestep mode.
 		void SetFixedTimeStep(bool isFixedTimestep)			{ m_isFixedTimeStep = isFixedTimestep; }
 
@@ -70,15 +82,18 @@ namespace DX
 
 		void ResetElapsedTime()
 		{
-			if (!QueryPerformanceCounter(&m_qpcLastTime))
-			{
-				throw std::exception();
-			}
+			m_lastTime = Clock::now();
+			m_isTimingFrames = false;
 
 			m_leftOverTicks = 0;
 			m_framesPerSecond = 0;
 			m_framesThisSecond = 0;
-			m_qpcSecondCounter = 0;
+			m_secondCounter = 0;
+			m_sliceCounter = 0;
+			for (scaling::FrameTimeHistogram& slice : m_sliceFrameTimes)
+			{
+				slice.Clear();
+			}
 		}
 
 		// Update timer state, calling the specified Update function the appropriate number of times.
@@ -86,27 +101,41 @@ namespace DX
 		void Tick(const TUpdate& update)
 		{
 			// Query the current time.
-			LARGE_INTEGER currentTime;
+			Clock::time_point currentTime = Clock::now();
 
-			if (!QueryPerformanceCounter(&currentTime))
+			uint64 timeDelta = static_cast<uint64>((currentTime - m_lastTime).count());
+
+			m_lastTime = currentTime;
+			m_secondCounter += timeDelta;
+
+			// Move on to the slice this tick is in, emptying those that have fallen out of the last second.
+			m_sliceCounter += timeDelta;
+			uint64 slicesPassed = m_sliceCounter / SliceTicks;
+			m_sliceCounter %= SliceTicks;
+			for (uint64 slice = 0; slice < slicesPassed && slice < SliceCount; ++slice)
 			{
-				throw std::exception();
+				m_sliceIndex = (m_sliceIndex + 1) % SliceCount;
+				m_sliceFrameTimes[m_sliceIndex].Clear();
 			}
 
-			uint64 timeDelta = currentTime.QuadPart - m_qpcLastTime.QuadPart;
-
-			m_qpcLastTime = currentTime;
-			m_qpcSecondCounter += timeDelta;
+			// Keep the real time, before it's clamped.
+			if (m_isTimingFrames)
+			{
+				double frameSeconds = static_cast<double>(timeDelta) / ClockFrequency;
+				m_frameTimes.Add(frameSeconds);
+				m_sliceFrameTimes[m_sliceIndex].Add(frameSeconds);
+			}
+			m_isTimingFrames = true;
 
 			// Clamp excessively large time deltas (e.g. after paused in the debugger).
-			if (timeDelta > m_qpcMaxDelta)
+			if (timeDelta > m_maxDelta)
 			{
-				timeDelta = m_qpcMaxDelta;
+				timeDelta = m_maxDelta;
 			}
 
-			// Convert QPC units into a canonical tick format. This cannot overflow due to the previous clamp.
+			// Convert clock units into a canonical tick format. This cannot overflow due to the previous clamp.
 			timeDelta *= TicksPerSecond;
-			timeDelta /= m_qpcFrequency.QuadPart;
+			timeDelta /= ClockFrequency;
 
 			uint32 lastFrameCount = m_frameCount;
 
@@ -121,7 +150,7 @@ namespace DX
 				// accumulate enough tiny errors that it would drop a frame. It is better to just round 
 				// small deviations down to zero to leave things running smoothly.
 
-				if (abs(static_cast<int64>(timeDelta - m_targetElapsedTicks)) < TicksPerSecond / 4000)
+				if (std::llabs(static_cast<int64>(timeDelta - m_targetElapsedTicks)) < static_cast<int64>(TicksPerSecond / 4000))
 				{
 					timeDelta = m_targetElapsedTicks;
 				}
@@ -155,19 +184,27 @@ namespace DX
 				m_framesThisSecond++;
 			}
 
-			if (m_qpcSecondCounter >= static_cast<uint64>(m_qpcFrequency.QuadPart))
+			if (m_secondCounter >= ClockFrequency)
 			{
 				m_framesPerSecond = m_framesThisSecond;
 				m_framesThisSecond = 0;
-				m_qpcSecondCounter %= m_qpcFrequency.QuadPart;
+				m_secondCounter %= ClockFrequency;
 			}
 		}
 
 	private:
-		// Source timing data uses QPC units.
-		LARGE_INTEGER m_qpcFrequency;
-		LARGE_INTEGER m_qpcLastTime;
-		uint64 m_qpcMaxDelta;
+		typedef std::chrono::steady_clock Clock;
+
+		// Source timing data uses the clock's units.
+		static const uint64 ClockFrequency = Clock::period::den / Clock::period::num;
+
+		// The last second's frame times are kept in tenths.
+		static const uint64 SliceCount = 10;
+		static const uint64 SliceTicks = ClockFrequency / SliceCount;
+
+		Clock::time_point m_lastTime;
+		uint64 m_maxDelta;
+		bool m_isTimingFrames;	// Whether there's been a tick since the start or a reset
 
 		// Derived timing data uses a canonical tick format.
 		uint64 m_elapsedTicks;
@@ -178,7 +215,13 @@ namespace DX
 		uint32 m_frameCount;
 		uint32 m_framesPerSecond;
 		uint32 m_framesThisSecond;
-		uint64 m_qpcSecondCounter;
+		uint64 m_secondCounter;
+
+		// Members for tracking frame times.
+		scaling::FrameTimeHistogram m_frameTimes;
+		scaling::FrameTimeHistogram m_sliceFrameTimes[SliceCount];	// A ring, of which m_sliceIndex is the current one
+		uint64 m_sliceCounter;	// Clock units into the current slice
+		uint64 m_sliceIndex;
 
 		// Members for configuring fixed timestep mode.
 		bool m_isFixedTimeStep;
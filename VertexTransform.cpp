@@ -0,0 +1,141 @@
+#include "VertexTransform.h"
+
+#include <cassert>
+
+// MSVC has no macro for FMA, which it allows along with AVX2.
+#if defined(__AVX2__) && (defined(__FMA__) || defined(_MSC_VER))
+#define SCALING_VERTEX_TRANSFORM_FMA 1
+#include <immintrin.h>
+#endif
+
+using namespace scaling;
+
+namespace
+{
+	const float c_minimumW = 1e-6f;
+
+#if !SCALING_VERTEX_TRANSFORM_FMA
+	uint8_t GetOutcode(Float4 clip)
+	{
+		uint8_t outcode = 0;
+		outcode |= clip.x < -clip.w ? ClipOutcodeLeft : 0;
+		outcode |= clip.x > clip.w ? ClipOutcodeRight : 0;
+		outcode |= clip.y < -clip.w ? ClipOutcodeBottom : 0;
+		outcode |= clip.y > clip.w ? ClipOutcodeTop : 0;
+		outcode |= clip.z < 0.0f ? ClipOutcodeNear : 0;
+		outcode |= clip.z > clip.w ? ClipOutcodeFar : 0;
+		outcode |= clip.w > c_minimumW ? 0 : ClipOutcodeBehindCamera;
+		return outcode;
+	}
+#endif
+
+#if SCALING_VERTEX_TRANSFORM_FMA
+	inline __m256i OutcodeBit(__m256 mask, int bit)
+	{
+		return _mm256_and_si256(_mm256_castps_si256(mask), _mm256_set1_epi32(bit));
+	}
+
+	// The outcodes of 8 vertices, one byte each.
+	inline void StoreOutcodes(__m256 x, __m256 y, __m256 z, __m256 w, uint8_t* outcodes)
+	{
+		__m256 negativeW = _mm256_sub_ps(_mm256_setzero_ps(), w);
+		__m256i codes = OutcodeBit(_mm256_cmp_ps(x, negativeW, _CMP_LT_OQ), ClipOutcodeLeft);
+		codes = _mm256_or_si256(codes, OutcodeBit(_mm256_cmp_ps(x, w, _CMP_GT_OQ), ClipOutcodeRight));
+		codes = _mm256_or_si256(codes, OutcodeBit(_mm256_cmp_ps(y, negativeW, _CMP_LT_OQ), ClipOutcodeBottom));
+		codes = _mm256_or_si256(codes, OutcodeBit(_mm256_cmp_ps(y, w, _CMP_GT_OQ), ClipOutcodeTop));
+		codes = _mm256_or_si256(codes, OutcodeBit(_mm256_cmp_ps(z, _mm256_setzero_ps(), _CMP_LT_OQ), ClipOutcodeNear));
+		codes = _mm256_or_si256(codes, OutcodeBit(_mm256_cmp_ps(z, w, _CMP_GT_OQ), ClipOutcodeFar));
+		codes = _mm256_or_si256(codes, OutcodeBit(_mm256_cmp_ps(w, _mm256_set1_ps(c_minimumW), _CMP_NGT_UQ), ClipOutcodeBehindCamera));
+
+		__m128i words = _mm_packs_epi32(_mm256_castsi256_si128(codes), _mm256_extracti128_si256(codes, 1));
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(outcodes), _mm_packus_epi16(words, words));
+	}
+#endif
+}
+
+void VertexPositions::Load(SceneVertex const* vertices, int count)
+{
+	m_count = count;
+	size_t paddedCount = static_cast<size_t>(GetBatchCount()) * c_vertexBatchSize;
+	m_x.assign(paddedCount, 0.0f);
+	m_y.assign(paddedCount, 0.0f);
+	m_z.assign(paddedCount, 0.0f);
+	for (int i = 0; i < count; ++i)
+	{
+		m_x[i] = vertices[i].position.x;
+		m_y[i] = vertices[i].position.y;
+		m_z[i] = vertices[i].position.z;
+	}
+}
+
+void ClipVertices::Reserve(int count)
+{
+	size_t paddedCount = static_cast<size_t>((count + c_vertexBatchSize - 1) / c_vertexBatchSize) * c_vertexBatchSize;
+	if (x.size() < paddedCount)
+	{
+		x.resize(paddedCount);
+		y.resize(paddedCount);
+		z.resize(paddedCount);
+		w.resize(paddedCount);
+		outcodes.resize(paddedCount);
+	}
+}
+
+void scaling::TransformVertices(VertexPositions const& positions, int firstBatch, int batchCount, Float4x4 const& transform, ClipVertices& output, int outputFirst)
+{
+	assert(firstBatch >= 0 && firstBatch + batchCount <= positions.GetBatchCount());
+	assert(outputFirst >= 0 && static_cast<size_t>(outputFirst + batchCount * c_vertexBatchSize) <= output.x.size());
+
+	int first = firstBatch * c_vertexBatchSize;
+	int count = batchCount * c_vertexBatchSize;
+	float const* inX = positions.GetX() + first;
+	float const* inY = positions.GetY() + first;
+	float const* inZ = positions.GetZ() + first;
+	float* outX = output.x.data() + outputFirst;
+	float* outY = output.y.data() + outputFirst;
+	float* outZ = output.z.data() + outputFirst;
+	float* outW = output.w.data() + outputFirst;
+	uint8_t* outcodes = output.outcodes.data() + outputFirst;
+
+#if SCALING_VERTEX_TRANSFORM_FMA
+	float const (&m)[4][4] = transform.m;
+	__m256 column[4][4];
+	for (int row = 0; row < 4; ++row)
+	{
+		for (int component = 0; component < 4; ++component)
+		{
+			column[component][row] = _mm256_set1_ps(m[row][component]);
+		}
+	}
+
+	for (int i = 0; i < count; i += c_vertexBatchSize)
+	{
+		__m256 x = _mm256_loadu_ps(inX + i);
+		__m256 y = _mm256_loadu_ps(inY + i);
+		__m256 z = _mm256_loadu_ps(inZ + i);
+
+		__m256 clip[4];
+		for (int component = 0; component < 4; ++component)
+		{
+			__m256 const* c = column[component];
+			clip[component] = _mm256_fmadd_ps(x, c[0], _mm256_fmadd_ps(y, c[1], _mm256_fmadd_ps(z, c[2], c[3])));
+		}
+
+		_mm256_storeu_ps(outX + i, clip[0]);
+		_mm256_storeu_ps(outY + i, clip[1]);
+		_mm256_storeu_ps(outZ + i, clip[2]);
+		_mm256_storeu_ps(outW + i, clip[3]);
+		StoreOutcodes(clip[0], clip[1], clip[2], clip[3], outcodes + i);
+	}
+#else
+	for (int i = 0; i < count; ++i)
+	{
+		Float4 clip = TransformPoint(Float3{ inX[i], inY[i], inZ[i] }, transform);
+		outX[i] = clip.x;
+		outY[i] = clip.y;
+		outZ[i] = clip.z;
+		outW[i] = clip.w;
+		outcodes[i] = GetOutcode(clip);
+	}
+#endif
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "SceneGeometry.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace scaling
+{
+	// Vertices are transformed this many at a time.
+	const int c_vertexBatchSize = 8;
+
+	// Which planes of the view volume a clip-space position is outside of. A triangle whose three vertices
+	// are all outside the same plane can't cover anything.
+	enum ClipOutcode : uint8_t
+	{
+		ClipOutcodeLeft = 1 << 0,		// x < -w
+		ClipOutcodeRight = 1 << 1,		// x > w
+		ClipOutcodeBottom = 1 << 2,		// y < -w
+		ClipOutcodeTop = 1 << 3,		// y > w
+		ClipOutcodeNear = 1 << 4,		// z < 0
+		ClipOutcodeFar = 1 << 5,		// z > w
+		ClipOutcodePlanes = 0x3f,
+
+		// w is too close to 0 to divide by. There's no near plane clipping, so a triangle with any vertex
+		// like this is dropped.
+		ClipOutcodeBehindCamera = 1 << 6
+	};
+
+	// The positions of a mesh's vertices, one array per component, padded to whole batches.
+	class VertexPositions
+	{
+	public:
+		VertexPositions() : m_count(0) {}
+
+		void Load(SceneVertex const* vertices, int count);
+
+		int GetCount() const { return m_count; }
+		int GetBatchCount() const { return (m_count + c_vertexBatchSize - 1) / c_vertexBatchSize; }
+
+		float const* GetX() const { return m_x.data(); }
+		float const* GetY() const { return m_y.data(); }
+		float const* GetZ() const { return m_z.data(); }
+
+	private:
+		std::vector<float> m_x;
+		std::vector<float> m_y;
+		std::vector<float> m_z;
+		int m_count;
+	};
+
+	// Clip-space positions, one array per component, with their outcodes.
+	struct ClipVertices
+	{
+		std::vector<float> x;
+		std::vector<float> y;
+		std::vector<float> z;
+		std::vector<float> w;
+		std::vector<uint8_t> outcodes;
+
+		// Rounded up to whole batches. Only grows.
+		void Reserve(int count);
+
+		Float4 Get(int i) const { return Float4{ x[i], y[i], z[i], w[i] }; }
+	};
+
+	// Transforms batches [firstBatch, firstBatch + batchCount) of positions by a row-vector matrix, and writes
+	// them to output starting at outputFirst, which output must have room for. The matrix is meant to be the
+	// whole model-view-projection, multiplied together once per object.
+	//
+	// With AVX2 and FMA, each batch is a few fused multiply-adds per component. Otherwise, it's the same as
+	// TransformPoint, vertex by vertex.
+	void TransformVertices(VertexPositions const& positions, int firstBatch, int batchCount, Float4x4 const& transform, ClipVertices& output, int outputFirst);
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace scaling
+{
+	// The deque of Chase and Lev's "Dynamic Circular Work-Stealing Deque", with the memory orders of Lê et
+	// al.'s "Correct and Efficient Work-Stealing for Weak Memory Models", at a fixed capacity. It belongs to
+	// one thread, which pushes and pops at the bottom without locking, while any other thread can steal
+	// from the top; they only contend, with a compare-and-swap, over the last item. Items are pointers, so
+	// that a thief reading a slot the owner is reusing gets a stale value rather than a torn one, which the
+	// compare-and-swap then throws away.
+	template<typename T>
+	class WorkStealingDeque
+	{
+	public:
+		// Rounded up to a power of two.
+		explicit WorkStealingDeque(size_t capacity)
+			: m_top(0)
+			, m_bottom(0)
+		{
+			size_t size = 1;
+			while (size < capacity)
+			{
+				size *= 2;
+			}
+			m_mask = size - 1;
+			m_slots.reset(new std::atomic<T*>[size]);
+		}
+
+		WorkStealingDeque(WorkStealingDeque const&) = delete;
+		WorkStealingDeque& operator=(WorkStealingDeque const&) = delete;
+
+		// Owner only. Thieves only ever make room, so a deque that isn't full stays that way until the next Push.
+		bool IsFull() const
+		{
+			return m_bottom.load(std::memory_order_relaxed) - m_top.load(std::memory_order_acquire) > static_cast<int64_t>(m_mask);
+		}
+
+		// Owner only. False when the deque is full.
+		bool Push(T* item)
+		{
+			int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+			int64_t top = m_top.load(std::memory_order_acquire);
+			if (bottom - top > static_cast<int64_t>(m_mask))
+			{
+				return false;
+			}
+			m_slots[bottom & m_mask].store(item, std::memory_order_relaxed);
+			m_bottom.store(bottom + 1, std::memory_order_release);
+			return true;
+		}
+
+		// Owner only. The most recently pushed item, or null.
+		T* Pop()
+		{
+			int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+			m_bottom.store(bottom, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			int64_t top = m_top.load(std::memory_order_relaxed);
+
+			T* item = nullptr;
+			if (top <= bottom)
+			{
+				item = m_slots[bottom & m_mask].load(std::memory_order_relaxed);
+				if (top == bottom)
+				{
+					// The last item, which a thief may be taking at the same time.
+					if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+					{
+						item = nullptr;
+					}
+					m_bottom.store(bottom + 1, std::memory_order_relaxed);
+				}
+			}
+			else
+			{
+				m_bottom.store(bottom + 1, std::memory_order_relaxed);
+			}
+			return item;
+		}
+
+		// Any thread. The least recently pushed item, or null when there's none or another thread got it first.
+		T* Steal()
+		{
+			int64_t top = m_top.load(std::memory_order_acquire);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			int64_t bottom = m_bottom.load(std::memory_order_acquire);
+			if (top >= bottom)
+			{
+				return nullptr;
+			}
+
+			T* item = m_slots[top & m_mask].load(std::memory_order_relaxed);
+			if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			{
+				return nullptr;
+			}
+			return item;
+		}
+
+	private:
+		std::unique_ptr<std::atomic<T*>[]> m_slots;
+		size_t m_mask;
+		alignas(64) std::atomic<int64_t> m_top;
+		alignas(64) std::atomic<int64_t> m_bottom;
+	};
+}
@@ -5,7 +5,9 @@
 #include "framework.h"
 #include "scaling.h"
 #include "scalingMain.h"
+#include "CpuFeatures.h"
 #include "DeviceResources.h"
+#include "Headless.h"
 
 using namespace Microsoft::WRL;
 
@@ -42,6 +44,28 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
     UNREFERENCED_PARAMETER(hPrevInstance);
     UNREFERENCED_PARAMETER(lpCmdLine);
 
+    // With --headless, render without a window and exit.
+    std::vector<std::string> arguments;
+    for (int i = 1; i < __argc; ++i)
+    {
+        int size = WideCharToMultiByte(CP_UTF8, 0, __wargv[i], -1, nullptr, 0, nullptr, nullptr);
+        std::string argument(size, '\0');
+        WideCharToMultiByte(CP_UTF8, 0, __wargv[i], -1, &argument[0], size, nullptr, nullptr);
+        argument.resize(size - 1); // Without the terminator
+        arguments.push_back(argument);
+    }
+    if (scaling::IsHeadlessCommandLine(arguments))
+    {
+        return scaling::scalingMain::RunHeadless(arguments);
+    }
+
+    // Parts of the application are built for AVX2, with nothing to fall back on.
+    if (!scaling::IsAvx2Supported())
+    {
+        MessageBoxA(nullptr, "This application needs a processor with AVX2 and FMA.", "Unsupported processor", MB_OK | MB_ICONERROR);
+        return 1;
+    }
+
     // TODO: Place code here.
 
     // Initialize global strings
@@ -55,26 +79,50 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
         return FALSE;
     }
 
+    // With --mesh, draw a mesh file in place of the cube, and with --pacing, pace frames by a policy other than vsync.
+    for (size_t i = 0; i + 1 < arguments.size(); ++i)
+    {
+        std::string error;
+        scaling::PacingPolicy policy;
+        if (arguments[i] == "--mesh" && !g_spinningCubeMain.LoadSceneMesh(arguments[i + 1], error))
+        {
+            MessageBoxA(g_hwnd, error.c_str(), "Couldn't load the mesh", MB_OK | MB_ICONWARNING);
+        }
+        else if (arguments[i] == "--pacing")
+        {
+            if (scaling::ParsePacingPolicy(arguments[i + 1], policy))
+            {
+                g_spinningCubeMain.SetPacingPolicy(policy);
+            }
+            else
+            {
+                MessageBoxA(g_hwnd, "--pacing takes throughput, vsync or low-latency", "Unknown pacing policy", MB_OK | MB_ICONWARNING);
+            }
+        }
+    }
+
     HACCEL hAccelTable = LoadAccelerators(hInstance, MAKEINTRESOURCE(IDC_SPINNINGCUBE));
 
-    MSG msg;
+    MSG msg = {};
 
+	// Each frame pumps the messages as it starts. RunFrames returns once the window is closed, or the device
+	// is removed, and then GetDeviceResources recreates it.
 	while (!g_done)
 	{
-		while (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE))
+		GetDeviceResources();
+
+		g_spinningCubeMain.RunFrames([&]
 		{
-			if (!TranslateAccelerator(msg.hwnd, hAccelTable, &msg))
+			while (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE))
 			{
-				TranslateMessage(&msg);
-				DispatchMessage(&msg);
+				if (!TranslateAccelerator(msg.hwnd, hAccelTable, &msg))
+				{
+					TranslateMessage(&msg);
+					DispatchMessage(&msg);
+				}
 			}
-		}
-
-		auto deviceResources = GetDeviceResources();
-
-		g_spinningCubeMain.Update();
-
-        g_spinningCubeMain.RenderAndPresent();
+			return !g_done;
+		});
 	}
 
     return (int) msg.wParam;
@@ -144,7 +192,7 @@ BOOL InitInstance(HINSTANCE hInstance, int nCmdShow)
 
    g_hwnd = hWnd;
 
-   g_deviceResources = std::make_shared<DX::DeviceResources>(DXGI_FORMAT_B8G8R8A8_UNORM, DXGI_FORMAT_D32_FLOAT);
+   g_deviceResources = std::make_shared<DX::DeviceResources>(DXGI_FORMAT_B8G8R8A8_UNORM);
    g_deviceResources->SetWindow(hWnd);
    
    g_spinningCubeMain.CreateRenderers(g_deviceResources);
@@ -220,10 +268,38 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
             {
                 g_spinningCubeMain.OnPressRightKey();
             }
+            else if (wParam == 38)
+            {
+                g_spinningCubeMain.OnPressUpKey();
+            }
+            else if (wParam == 40)
+            {
+                g_spinningCubeMain.OnPressDownKey();
+            }
             else if (wParam == 85)
             {
                 g_spinningCubeMain.OnPressUKey();
             }
+            else if (wParam == 82)
+            {
+                g_spinningCubeMain.OnPressRKey();
+            }
+            else if (wParam == 74)
+            {
+                g_spinningCubeMain.OnPressJKey();
+            }
+            else if (wParam == 81)
+            {
+                g_spinningCubeMain.OnPressQKey();
+            }
+            else if (wParam == 77)
+            {
+                g_spinningCubeMain.OnPressMKey();
+            }
+            else if (wParam == 78)
+            {
+                g_spinningCubeMain.OnPressNKey();
+            }
             break;
         }
     case WM_DESTROY:
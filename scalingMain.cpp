@@ -1,13 +1,37 @@
 #include "pch.h"
 #include "scalingMain.h"
 #include "DirectXHelper.h"
+#include "Headless.h"
+
+#include <climits>
 
 using namespace scaling;
 
+// The application has no console of its own, so output goes to wherever standard output was redirected,
+// or else to the console of the process that started it.
+static void WriteHeadlessReport(std::string const& text)
+{
+	OutputDebugStringA(text.c_str());
+
+	HANDLE output = GetStdHandle(STD_OUTPUT_HANDLE);
+	if (!output && AttachConsole(ATTACH_PARENT_PROCESS))
+	{
+		output = GetStdHandle(STD_OUTPUT_HANDLE);
+	}
+	if (output && output != INVALID_HANDLE_VALUE)
+	{
+		DWORD written = 0;
+		WriteFile(output, text.c_str(), static_cast<DWORD>(text.size()), &written, nullptr);
+	}
+}
+
 // The DirectX 12 Application template is documented at https://go.microsoft.com/fwlink/?LinkID=613670&clcid=0x409
 
 // Loads and initializes application assets when the application is loaded.
 scalingMain::scalingMain()
+	: m_pacer(m_pacingClock, PacingPolicy::VsyncLocked, 1.0 / 60.0)
+	, m_frameStartSeconds(0.0)
+	, m_presentCount(0)
 {
 	// TODO: Change the timer settings if you want something other than the default variable timestep mode.
 	// e.g. for 60 FPS fixed timestep update logic, call:
@@ -17,18 +41,82 @@ scalingMain::scalingMain()
 	*/
 }
 
+int scalingMain::RunHeadless(std::vector<std::string> const& arguments)
+{
+	HeadlessOptions options;
+	std::string error;
+	if (!ParseHeadlessOptions(arguments, options, error))
+	{
+		WriteHeadlessReport(error + "\n\n" + GetHeadlessUsage());
+		return 1;
+	}
+
+	std::unique_ptr<IFrameSink> sink = CreateFrameSink(options);
+	HeadlessResult result = scaling::RunHeadless(options, *sink);
+	WriteHeadlessReport(FormatHeadlessResult(result, *sink) + "\n");
+
+	return result.error.empty() && result.frameCount == options.frameCount ? 0 : 1;
+}
+
 // Creates and initializes the renderers.
 void scalingMain::CreateRenderers(const std::shared_ptr<DX::DeviceResources>& deviceResources)
 {
 	// TODO: Replace this with your app's content initialization.
+	m_deviceResources = deviceResources;
+	m_frameFence = std::make_unique<D3D12Fence>(deviceResources->GetFence());
 	m_sceneRenderer = std::unique_ptr<Sample3DSceneRenderer>(new Sample3DSceneRenderer(deviceResources));
 
+	std::string error;
+	if (!m_meshPath.empty() && !m_sceneRenderer->LoadSceneMesh(m_meshPath, error))
+	{
+		m_meshPath.clear();
+	}
+
 	OnWindowSizeChanged();
 }
 
+bool scalingMain::LoadSceneMesh(std::string const& path, std::string& error)
+{
+	if (!m_sceneRenderer->LoadSceneMesh(path, error))
+	{
+		return false;
+	}
+	m_meshPath = path;
+	return true;
+}
+
+void scalingMain::RunFrames(std::function<bool()> const& pumpMessages)
+{
+	FrameScheduler scheduler;
+	scheduler.Run(INT_MAX, DX::c_frameCount, [&](int) { return RunFrame(scheduler, pumpMessages); });
+}
+
+// The scheduler only starts a frame once the one c_frameCount frames before it has finished, so the GPU is
+// done with everything the frame index it gets holds. A removed device's fence reports every value as
+// reached, so the frames in flight then finish too. Messages aren't pumped once the device is removed,
+// since handling them may recreate it while the frames in flight still await the old fence.
+FrameTask scalingMain::RunFrame(FrameScheduler& scheduler, std::function<bool()> const& pumpMessages)
+{
+	if (m_deviceResources->IsDeviceRemoved() || !pumpMessages())
+	{
+		scheduler.Stop();
+		co_return;
+	}
+
+	Update();
+	if (RenderAndPresent() && !m_deviceResources->IsDeviceRemoved())
+	{
+		co_await scheduler.WaitFor(*m_frameFence, m_deviceResources->GetPresentedFenceValue());
+	}
+}
+
 // Updates the application state once per frame.
 void scalingMain::Update()
 {
+	// The scene is updated as late as the pacing policy allows, so that it's as recent as it can be when shown.
+	m_pacer.WaitForFrameStart();
+	m_frameStartSeconds = m_pacingClock.GetSeconds();
+
 	// Update scene objects.
 	m_timer.Tick([&]()
 	{
@@ -49,7 +137,37 @@ bool scalingMain::RenderAndPresent()
 
 	// Render the scene objects.
 	// TODO: Replace this with your app's content rendering functions.
-	return m_sceneRenderer->RenderAndPresent();
+	m_deviceResources->SetSyncInterval(m_pacer.GetSyncInterval());
+	bool isPresented = m_sceneRenderer->RenderAndPresent();
+
+	// The CPU time includes presenting, which only waits when the swap chain is full, and a paced frame
+	// shouldn't find it so.
+	if (isPresented)
+	{
+		m_pacer.OnFrameMeasured(m_pacingClock.GetSeconds() - m_frameStartSeconds, m_sceneRenderer->GetLastGpuSeconds());
+	}
+	ReportVblank();
+	return isPresented;
+}
+
+// Tells the pacer when the display last refreshed, and which frames it has shown since it was last told.
+void scalingMain::ReportVblank()
+{
+	double secondsSinceVblank = 0.0;
+	double refreshSeconds = 0.0;
+	UINT presentCount = 0;
+	if (!m_deviceResources->GetVblankTiming(secondsSinceVblank, refreshSeconds, presentCount))
+	{
+		return;
+	}
+
+	double vblankSeconds = m_pacingClock.GetSeconds() - secondsSinceVblank;
+	m_pacer.OnVblank(vblankSeconds, refreshSeconds);
+	if (m_presentCount != 0 && presentCount > m_presentCount)
+	{
+		m_pacer.OnFramesDisplayed(static_cast<int>(presentCount - m_presentCount), vblankSeconds);
+	}
+	m_presentCount = presentCount;
 }
 
 // Updates application state when the window's size changes (e.g. device orientation change)
@@ -81,7 +199,42 @@ void scalingMain::OnPressRightKey()
 	return m_sceneRenderer->OnPressRightKey();
 }
 
+void scalingMain::OnPressUpKey()
+{
+	return m_sceneRenderer->OnPressUpKey();
+}
+
+void scalingMain::OnPressDownKey()
+{
+	return m_sceneRenderer->OnPressDownKey();
+}
+
 void scalingMain::OnPressUKey()
 {
 	return m_sceneRenderer->OnPressUKey();
+}
+
+void scalingMain::OnPressRKey()
+{
+	return m_sceneRenderer->OnPressRKey();
+}
+
+void scalingMain::OnPressJKey()
+{
+	return m_sceneRenderer->OnPressJKey();
+}
+
+void scalingMain::OnPressQKey()
+{
+	return m_sceneRenderer->OnPressQKey();
+}
+
+void scalingMain::OnPressMKey()
+{
+	return m_sceneRenderer->OnPressMKey();
+}
+
+void scalingMain::OnPressNKey()
+{
+	return m_sceneRenderer->OnPressNKey();
 }
\ No newline at end of file
@@ -2,8 +2,12 @@
 
 #include "StepTimer.h"
 #include "DeviceResources.h"
+#include "FramePacer.h"
+#include "FrameScheduler.h"
 #include "Sample3DSceneRenderer.h"
 
+#include <functional>
+
 // Renders Direct3D content on the screen.
 namespace scaling
 {
@@ -11,22 +15,64 @@ namespace scaling
 	{
 	public:
 		scalingMain();
+
+		// Renders on the CPU backend without a window or swap chain, and returns the exit code. Reports to the
+		// console it was started from, and to the debugger. See Headless.h for the arguments.
+		static int RunHeadless(std::vector<std::string> const& arguments);
+
 		void CreateRenderers(const std::shared_ptr<DX::DeviceResources>& deviceResources);
+
+		// Draws a mesh file in place of the cube, including after the renderers are recreated. On failure,
+		// error says why, and the scene is left as it was.
+		bool LoadSceneMesh(std::string const& path, std::string& error);
+
+		// When each frame starts and how it's presented. Locked to vsync unless set.
+		void SetPacingPolicy(PacingPolicy policy) { m_pacer.SetPolicy(policy); }
+
+		// Runs frames as coroutines on FrameScheduler, with as many in flight as the swap chain has buffers,
+		// until pumpMessages returns false or the device is removed. Each frame pumps the window's messages,
+		// updates, renders and presents, and then awaits the GPU finishing it, so the thread only blocks when
+		// every frame in flight is waiting for the GPU.
+		void RunFrames(std::function<bool()> const& pumpMessages);
+
 		void Update();
 		bool RenderAndPresent();
 		void OnPressSpaceKey();
 		void OnPressLeftKey();
 		void OnPressRightKey();
+		void OnPressUpKey();
+		void OnPressDownKey();
 		void OnPressUKey();
+		void OnPressRKey();
+		void OnPressJKey();
+		void OnPressQKey();
+		void OnPressMKey();
+		void OnPressNKey();
 
 		void OnWindowSizeChanged();
 		void OnDeviceRemoved();
 
 	private:
+		FrameTask RunFrame(FrameScheduler& scheduler, std::function<bool()> const& pumpMessages);
+		void ReportVblank();
+
+		std::shared_ptr<DX::DeviceResources> m_deviceResources;
+
+		// DeviceResources' fence, which Present signals, for the frames to await.
+		std::unique_ptr<D3D12Fence> m_frameFence;
+
 		// TODO: Replace with your own content renderers.
 		std::unique_ptr<Sample3DSceneRenderer> m_sceneRenderer;
 
+		// Empty for the cube.
+		std::string m_meshPath;
+
 		// Rendering loop timer.
 		DX::StepTimer m_timer;
+
+		SteadyPacingClock m_pacingClock;
+		FramePacer m_pacer;
+		double m_frameStartSeconds;
+		UINT m_presentCount;	// As of the last vblank seen
 	};
 }
\ No newline at end of file